@@ -15,6 +15,7 @@
 #include "common/Action.hpp"
 #include "common/PropertyList.hpp"
 #include "common/Timer.hpp"
+#include "common/Tracer.hpp"
 
 namespace cf3 {
 namespace common {
@@ -25,7 +26,7 @@ namespace common {
 
 struct TimedActionImpl::Implementation
 {
-  Implementation(Action& timed_action) : m_timed_component(timed_action)
+  Implementation(Action& timed_action) : m_trace_region(0), m_traced(false), m_timed_component(timed_action)
   {
     m_timed_component.properties().add("timer_count", Uint(0));
     m_timed_component.properties().add("timer_minimum", Real(0.));
@@ -48,6 +49,10 @@ struct TimedActionImpl::Implementation
       boost::accumulators::tag::lazy_variance
     >
   > m_timing_stats;
+
+  /// Tracer region for the action, named after its path
+  Uint m_trace_region;
+  bool m_traced;
   
   Action& m_timed_component;
 };
@@ -65,12 +70,21 @@ TimedActionImpl::~TimedActionImpl()
 
 void TimedActionImpl::start_timing()
 {
+  Tracer& tracer = Tracer::instance();
+  m_implementation->m_traced = tracer.is_enabled();
+  if(m_implementation->m_traced)
+  {
+    m_implementation->m_trace_region = tracer.region(m_implementation->m_timed_component.uri().path());
+    tracer.begin(m_implementation->m_trace_region);
+  }
   m_implementation->m_timer.restart();
 }
 
 void TimedActionImpl::stop_timing()
 {
   m_implementation->m_timing_stats(m_implementation->m_timer.elapsed());
+  if(m_implementation->m_traced)
+    Tracer::instance().end(m_implementation->m_trace_region);
 }
 
 void TimedActionImpl::store_timings()
@@ -38,6 +38,22 @@ struct BinaryDataReader::Implementation
     XmlNode cfbinary(xml_doc->content->first_node("cfbinary"));
     cf3_assert(from_str<Uint>(cfbinary.attribute_value("version")) == version());
 
+    select_rank(rank);
+  }
+
+  /// Open the data of the given rank, using the already parsed XML
+  void select_rank(const Uint rank)
+  {
+    if(my_node.is_valid() && rank == m_rank)
+      return;
+
+    if(binary_file.is_open())
+      binary_file.close();
+    binary_file.clear();
+    my_node = XmlNode();
+    m_rank = rank;
+
+    XmlNode cfbinary(xml_doc->content->first_node("cfbinary"));
     XmlNode nodes(cfbinary.content->first_node(("nodes")));
     XmlNode node(nodes.content->first_node("node"));
     for(; node.is_valid(); node = XmlNode(node.content->next_sibling("node")))
@@ -122,7 +138,7 @@ struct BinaryDataReader::Implementation
   XmlNode my_node;
 
   // Rank to read
-  const Uint m_rank;
+  Uint m_rank;
 };
   
 ////////////////////////////////////////////////////////////////////////////////////////////
@@ -137,7 +153,7 @@ BinaryDataReader::BinaryDataReader ( const std::string& name ) : Component(name)
   options().add("rank", common::PE::Comm::instance().rank())
     .pretty_name("Rank")
     .description("Rank for which to read data")
-    .attach_trigger(boost::bind(&BinaryDataReader::trigger_file, this));
+    .attach_trigger(boost::bind(&BinaryDataReader::trigger_rank, this));
 }
 
 BinaryDataReader::~BinaryDataReader()
@@ -182,6 +198,8 @@ void BinaryDataReader::read_data_block(char *data, const Uint count, const Uint
 void BinaryDataReader::trigger_file()
 {
   const URI file_uri = options().value<URI>("file");
+  if(file_uri.empty()) // Allows setting the rank before the file
+    return;
   if(!boost::filesystem::exists(file_uri.path()))
   {
     throw SetupError(FromHere(), "Input file " + file_uri.path() + " does not exist");
@@ -189,6 +207,15 @@ void BinaryDataReader::trigger_file()
   m_implementation.reset(new Implementation(file_uri, options().value<Uint>("rank")));
 }
 
+void BinaryDataReader::trigger_rank()
+{
+  // Switch to the data of the new rank without parsing the XML again
+  if(is_not_null(m_implementation.get()))
+    m_implementation->select_rank(options().value<Uint>("rank"));
+  else
+    trigger_file();
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////
 
 } // common
@@ -82,6 +82,9 @@ private:
   // Trigger on output file change
   void trigger_file();
 
+  // Trigger on rank change
+  void trigger_rank();
+
   class Implementation;
   boost::scoped_ptr<Implementation> m_implementation;
 };
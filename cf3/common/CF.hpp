@@ -17,6 +17,7 @@
 
 #include <boost/noncopyable.hpp>
 #include <boost/checked_delete.hpp>
+#include <boost/static_assert.hpp>
 
 #include "coolfluid-config.hpp"  // coolfluid system configuration
 
@@ -87,8 +88,13 @@ private:
 namespace cf3 {
 
 /// typedef for unsigned int
+/// Uint is also the local index type: connectivity tables, the sparsity passed to the LSS, comm patterns and global
+/// indices are all stored as Uint. It is kept at 32 bits on 64 bit platforms, since widening it would double the memory
+/// traffic of all index-heavy loops. Values that need 64 bits, such as hashes, use boost::uint64_t explicitly.
 typedef unsigned int Uint;
 
+BOOST_STATIC_ASSERT(sizeof(Uint) == 4);
+
 /// Definition of the default precision
 #ifdef CF3_REAL_IS_FLOAT
 typedef float Real;
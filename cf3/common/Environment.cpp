@@ -12,6 +12,7 @@
 #include "common/Log.hpp"
 #include "common/Environment.hpp"
 #include "common/PropertyList.hpp"
+#include "common/Tracer.hpp"
 
 namespace cf3 {
 namespace common {
@@ -102,6 +103,22 @@ Environment::Environment ( const std::string& name) : Component ( name )
       .mark_basic()
       .attach_trigger(boost::bind(&Environment::trigger_log_level,this));
 
+  options().add("tracing", false)
+      .pretty_name("Tracing")
+      .description("If true, the time spent in instrumented code regions is recorded. Use a WriteTrace action to output the result.")
+      .mark_basic()
+      .attach_trigger(boost::bind(&Environment::trigger_tracing,this));
+
+  options().add("tracing_counters", false)
+      .pretty_name("Tracing Counters")
+      .description("If true, tracing also records the instruction and cycle counters, if the system supports perf_event_open.")
+      .attach_trigger(boost::bind(&Environment::trigger_tracing_counters,this));
+
+  options().add("tracing_events", 0u)
+      .pretty_name("Tracing Events")
+      .description("Number of most recent events that tracing keeps for each thread, for the timeline written by WriteTrace. If 0, only the statistics are kept.")
+      .attach_trigger(boost::bind(&Environment::trigger_tracing_events,this));
+
   trigger_log_level();
 
   // signals
@@ -180,5 +197,27 @@ void Environment::trigger_log_level()
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void Environment::trigger_tracing()
+{
+  Tracer::instance().enable(options().value<bool>("tracing"));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Environment::trigger_tracing_counters()
+{
+  if(!Tracer::instance().enable_counters(options().value<bool>("tracing_counters")))
+    CFwarn << "Hardware counters are not available, tracing will only record times" << CFendl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Environment::trigger_tracing_events()
+{
+  Tracer::instance().set_max_events(options().value<Uint>("tracing_events"));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 } // common
 } // cf3
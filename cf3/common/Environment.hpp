@@ -51,6 +51,12 @@ private: // functions
 
   void trigger_log_level();
 
+  void trigger_tracing();
+
+  void trigger_tracing_counters();
+
+  void trigger_tracing_events();
+
 }; // Environment
 
 ////////////////////////////////////////////////////////////////////////////////
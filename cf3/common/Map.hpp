@@ -9,6 +9,8 @@
 
 ////////////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
+
 #include "common/Component.hpp"
 
 namespace cf3 {
@@ -188,6 +190,23 @@ public: // functions
 
   /// @brief Sort all the pairs in the map by key
   void sort_keys();
+
+  /// @brief Insert a batch of pairs, keeping the map sorted
+  ///
+  /// The batch is sorted and merged with the existing pairs in a single pass, which
+  /// is much cheaper than push_back() followed by sort_keys() for a small batch.
+  /// @param[in] pairs  new pairs, whose keys must not be in the map yet
+  void merge(const std::vector<value_type>& pairs);
+
+  /// @brief Erase all pairs for which the predicate is true
+  ///
+  /// The remaining pairs keep their order, so a sorted map stays sorted.
+  /// @param[in] pred  unary predicate taking a value_type
+  template <typename PredicateT>
+  void erase_if(const PredicateT& pred)
+  {
+    m_vectorMap.erase(std::remove_if(m_vectorMap.begin(), m_vectorMap.end(), pred), m_vectorMap.end());
+  }
   
   /// @return the iterator pointing at the first element
   iterator begin();
@@ -450,6 +469,21 @@ void Map<KEY,DATA>::sort_keys()
   
 //////////////////////////////////////////////////////////////////////////////
 
+template <typename KEY, typename DATA>
+void Map<KEY,DATA>::merge(const std::vector<value_type>& pairs)
+{
+  sort_keys();
+  const size_t old_size = size();
+  m_vectorMap.insert(end(), pairs.begin(), pairs.end());
+  std::sort(begin()+old_size, end(), LessThan());
+  std::inplace_merge(begin(), begin()+old_size, end(), LessThan());
+
+  cf3_assert_desc ("Duplicated keys detected in map "+uri().string(),
+    std::unique (begin(), end(), unique_key ) - begin() == (int) size() );
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
 template <typename KEY, typename DATA>
 inline typename Map<KEY,DATA>::iterator Map<KEY,DATA>::begin()
 {
@@ -15,7 +15,9 @@
 
 #include <boost/any.hpp>
 #include <boost/function/function_fwd.hpp>
+#include <boost/shared_ptr.hpp>
 
+#include "common/Assertions.hpp"
 #include "common/BasicExceptions.hpp"
 #include "common/TaggedObject.hpp"
 #include "common/TypeInfo.hpp"
@@ -31,6 +33,43 @@ namespace XML { class XmlNode; }
 
   //////////////////////////////////////////////////////////////////////////
 
+  /// @brief Typed, pre-resolved read-only access to the value of an option.
+
+  /// An OptionValue is obtained once (usually at configuration time) through
+  /// Option::value_handle() or OptionList::value_handle() and afterwards gives
+  /// direct access to the typed value, without name lookup or boost::any cast.
+  /// The referred value is kept up to date whenever the option is changed or
+  /// reset. Copies are cheap and all refer to the same value.
+  template<typename TYPE>
+  class OptionValue
+  {
+  public:
+    typedef TYPE value_type;
+
+    /// Construct an invalid handle
+    OptionValue() {}
+
+    /// Construct a handle referring to the given storage
+    explicit OptionValue(const boost::shared_ptr<TYPE const>& value) : m_value(value) {}
+
+    /// Access the current option value
+    const TYPE& operator*() const { cf3_assert(is_valid()); return *m_value; }
+
+    /// Access the current option value
+    const TYPE* operator->() const { cf3_assert(is_valid()); return m_value.get(); }
+
+    /// Access the current option value
+    const TYPE& get() const { return **this; }
+
+    /// True if this handle refers to an option value
+    bool is_valid() const { return m_value.get() != nullptr; }
+
+  private:
+    boost::shared_ptr<TYPE const> m_value;
+  };
+
+  //////////////////////////////////////////////////////////////////////////
+
   /// @brief Adds fonctionnalities to @c Property class.
 
   /// An option is a piece of data of which user can modify the value. An option
@@ -110,6 +149,26 @@ namespace XML { class XmlNode; }
       }
     }
 
+    /// @brief Get a typed handle to the value of this option
+    /// The handle is updated each time the option value changes, so it can be
+    /// stored and used in code that is executed often.
+    /// @throw CastingFailed if TYPE is not the type of the option value.
+    template<typename TYPE>
+    OptionValue<TYPE> value_handle()
+    {
+      if(!m_value_cache)
+      {
+        boost::shared_ptr<TYPE> cache(new TYPE(value<TYPE>()));
+        link_to(cache.get());
+        m_value_cache = cache;
+      }
+      else if(m_value.type() != typeid(TYPE))
+      {
+        throw CastingFailed( FromHere(), "Bad value handle type "+common::class_name<TYPE>()+" for option " + name() + " of type " + class_name_from_typeinfo(m_value.type()));
+      }
+      return OptionValue<TYPE>(boost::static_pointer_cast<TYPE const>(m_value_cache));
+    }
+
     template<typename OPTION_TYPE>
     OPTION_TYPE& cast_to ()
     {
@@ -232,7 +291,7 @@ namespace XML { class XmlNode; }
     void trigger() const;
 
     /// restore the default value of the option
-    void restore_default() { m_value = m_default; }
+    void restore_default() { m_value = m_default; copy_to_linked_params(m_linked_params); }
 
   protected:
     /// storage of the value of the option
@@ -243,6 +302,8 @@ namespace XML { class XmlNode; }
     std::vector< Handle<Option> > m_linked_opts;
 
   private: // data
+    /// storage for the value referred to by the handles from value_handle(), linked to this option
+    boost::shared_ptr<void> m_value_cache;
     /// storage of the default value of the option
     boost::any m_default;
     /// option name
@@ -106,6 +106,17 @@ public:
     return option(opt_name).value<TYPE>();
   }
 
+  /// @brief Get a typed handle to the value of the option with given name
+  /// This performs the name lookup only once, so the returned handle
+  /// can be used in performance critical code
+  /// @param [in] opt_name  The option name
+  /// @return handle to the option value, updated whenever the option changes
+  template < typename TYPE >
+    OptionValue<TYPE> value_handle ( const std::string& opt_name )
+  {
+    return option(opt_name).value_handle<TYPE>();
+  }
+
   /// check that a option with the name exists
   /// @param opt_name the property name
   bool check ( const std::string& opt_name ) const
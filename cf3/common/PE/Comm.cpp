@@ -4,6 +4,9 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <cstdlib>
+#include <string>
+
 #include "common/Log.hpp"
 
 #include "common/BasicExceptions.hpp"
@@ -20,6 +23,7 @@ namespace PE {
 Comm::Comm(int argc, char** args)
 {
   m_comm = nullptr;
+  m_nb_sparse_exchanges = 0;
   init(argc,args);
   m_current_status=WorkerStatus::NOT_RUNNING;
 }
@@ -29,6 +33,7 @@ Comm::Comm(int argc, char** args)
 Comm::Comm()
 {
   m_comm = nullptr;
+  m_nb_sparse_exchanges = 0;
   m_current_status = WorkerStatus::NOT_RUNNING;
 }
 
@@ -67,6 +72,15 @@ bool Comm::is_finalized() const
 
 ////////////////////////////////////////////////////////////////////////////////
 
+bool Comm::is_funneled() const
+{
+  int provided = MPI_THREAD_SINGLE;
+  MPI_CHECK_RESULT(MPI_Query_thread,(&provided));
+  return provided >= MPI_THREAD_FUNNELED;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 std::string Comm::version() const
 {
   int version = 0;
@@ -84,7 +98,18 @@ void Comm::init(int argc, char** args)
 
   if( !is_initialized() ) // then initialize
   {
-    MPI_CHECK_RESULT(MPI_Init,(&argc,&args));
+    // Threads that leave the MPI calls to the main thread, as for the concurrent actions of solver::ActionDirector,
+    // need a thread level that not all MPI implementations provide cheaply, so it is only requested on demand
+    const char* threads_env = std::getenv("COOLFLUID_MPI_THREADS");
+    if(threads_env != nullptr && std::string(threads_env) != "" && std::string(threads_env) != "0")
+    {
+      int provided = 0;
+      MPI_CHECK_RESULT(MPI_Init_thread,(&argc,&args,MPI_THREAD_FUNNELED,&provided));
+    }
+    else
+    {
+      MPI_CHECK_RESULT(MPI_Init,(&argc,&args));
+    }
     //  CFinfo << "MPI (version " <<  version() << ") -- initiated" << CFendl;
   }
 
@@ -15,6 +15,7 @@
 
 #include "common/PE/types.hpp"
 #include "common/PE/all_to_all.hpp"
+#include "common/PE/sparse_all_to_all.hpp"
 #include "common/PE/gather.hpp"
 #include "common/PE/all_gather.hpp"
 #include "common/PE/scatter.hpp"
@@ -68,6 +69,8 @@ public:
   std::string version() const;
 
   /// Initialise the PE
+  /// MPI is initialized with support for threads that leave the MPI calls to the main thread (see is_funneled())
+  /// only if the environment variable COOLFLUID_MPI_THREADS is set to a value other than 0
   /// @post will have a valid state
   void init(int argc=0, char** args=0);
   /// Free the PE, careful because some mpi-s fail upon re-init after a proper finalize
@@ -81,6 +84,8 @@ public:
   /// Checks if the PE is in valid state
   /// should be initialized and Communicator pointer is set
   bool is_active() const { return is_initialized() && !is_finalized() && is_not_null(m_comm); }
+  /// Checks if the program may be multi-threaded, as long as only the main thread makes MPI calls
+  bool is_funneled() const;
 
   /// overload the barrier function
   void barrier();
@@ -154,6 +159,15 @@ public:
            PE::all_to_all(communicator(), send, recv);
   }
 
+  /// Sparse variant of the above: only the destinations that are present in send are contacted,
+  /// and recv only contains the ranks that sent something. Prefer this when each rank talks to a few neighbours only.
+  template<typename T> inline void sparse_all_to_all( const std::map< int, std::vector<T> >& send, std::map< int, std::vector<T> >& recv)
+  {
+    // Alternate the tag, since a fast process may already send for the next exchange
+    const int tag = sparse_all_to_all_tag + static_cast<int>(m_nb_sparse_exchanges++ % 2);
+           PE::sparse_all_to_all(communicator(), send, recv, tag);
+  }
+
   //@}
 
   /// @name Collective gather operations
@@ -326,6 +340,11 @@ private:
 
   Communicator m_comm; ///< comm_world
 
+  /// First of the two message tags used by sparse_all_to_all, distinct from the tag of the non-blocking synchronizations in CommPattern
+  static const int sparse_all_to_all_tag = 1000;
+
+  Uint m_nb_sparse_exchanges; ///< Number of sparse_all_to_all calls, to alternate the tag
+
   WorkerStatus::Type m_current_status; ///< Current status, default value is @c #NOT_RUNNING.
 
 }; // Comm
@@ -13,6 +13,7 @@
 #include "common/FindComponents.hpp"
 #include "common/Builder.hpp"
 #include "common/Log.hpp"
+#include "common/Tracer.hpp"
 
 #include "common/PE/Comm.hpp"
 #include "common/PE/CommPattern.hpp"
@@ -595,9 +596,65 @@ void CommPattern::synchronize( const CommWrapper& pobj )
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void CommPattern::synchronize_begin( const std::string& name )
+{
+  if (m_pending_syncs.count(name) != 0)
+    return;
+
+  Handle<CommWrapper> pobj(get_child(name));
+  if (is_null(pobj)) throw common::ValueNotFound(FromHere(),"No parallel object '" + name + "' in commpattern '" + this->name() + "'.");
+  if (!pobj->needs_update())
+    return;
+
+  boost::shared_ptr<PendingSync> pending(new PendingSync());
+  pobj->pack(pending->sndbuf,m_sendMap);
+  const int item_size=pobj->size_of()*pobj->stride();
+  pending->rcvbuf.resize(m_recvMap.size()*item_size);
+
+  const int tag=nonblocking_sync_tag;
+  const int nproc=PE::Comm::instance().size();
+  Communicator comm=PE::Comm::instance().communicator();
+
+  // receives are posted first, so the matching sends can complete right away
+  for (int i=0, offset=0; i<nproc; offset+=m_recvCount[i]*item_size, ++i)
+  {
+    if (m_recvCount[i]==0) continue;
+    pending->requests.push_back(MPI_Request());
+    MPI_CHECK_RESULT(MPI_Irecv,(&pending->rcvbuf[offset], m_recvCount[i]*item_size, MPI_BYTE, i, tag, comm, &pending->requests.back()));
+  }
+  for (int i=0, offset=0; i<nproc; offset+=m_sendCount[i]*item_size, ++i)
+  {
+    if (m_sendCount[i]==0) continue;
+    pending->requests.push_back(MPI_Request());
+    MPI_CHECK_RESULT(MPI_Isend,(&pending->sndbuf[offset], m_sendCount[i]*item_size, MPI_BYTE, i, tag, comm, &pending->requests.back()));
+  }
+
+  m_pending_syncs[name]=pending;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void CommPattern::synchronize_end( const std::string& name )
+{
+  std::map< std::string, boost::shared_ptr<PendingSync> >::iterator it=m_pending_syncs.find(name);
+  if (it==m_pending_syncs.end())
+    return;
+
+  PendingSync& pending=*it->second;
+  if (!pending.requests.empty())
+    MPI_CHECK_RESULT(MPI_Waitall,(pending.requests.size(), &pending.requests[0], MPI_STATUSES_IGNORE));
+
+  Handle<CommWrapper> pobj(get_child(name));
+  pobj->unpack(pending.rcvbuf,m_recvMap);
+  m_pending_syncs.erase(it);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 // having the vectors for the intermediate buf coming from outside allows keeping them and reuse for all synchronize
 void CommPattern::synchronize_this( const CommWrapper& pobj, std::vector<unsigned char>& sndbuf, std::vector<unsigned char>& rcvbuf )
 {
+  CF3_TRACE_SCOPE("synchronize");
 //  std::cout << PERank << pobj.name() << "\n" << std::flush;
 //  std::cout << PERank << pobj.needs_update() << "\n" << std::flush;
   if ( pobj.needs_update() )
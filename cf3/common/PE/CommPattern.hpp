@@ -7,6 +7,10 @@
 #ifndef cf3_common_PE_CommPattern_hpp
 #define cf3_common_PE_CommPattern_hpp
 
+#include <map>
+
+#include <boost/shared_ptr.hpp>
+
 #include "common/Component.hpp"
 #include "common/BoostArray.hpp"
 #include "common/PE/Comm.hpp"
@@ -229,6 +233,18 @@ public:
   /// @param name the name of the parallel object
   void synchronize( const CommWrapper& pobj );
 
+  /// start a non-blocking synchronization of the parallel object designated by its name
+  /// the sent data is packed immediately, the received data overwrites the ghost entries at synchronize_end
+  /// non-blocking synchronizations must be started in the same order on all ranks
+  /// does nothing if a synchronization of the object is already pending
+  /// @param name the name of the parallel object
+  void synchronize_begin( const std::string& name );
+
+  /// wait for the non-blocking synchronization started by synchronize_begin, and unpack the received data
+  /// does nothing if no synchronization of the object is pending
+  /// @param name the name of the parallel object
+  void synchronize_end( const std::string& name );
+
   /// add element to the commpattern
   /// when all changes done, all needs to be committed by calling setup
   /// if global id is not on current rank, then a ghost is automatically created on current rank
@@ -349,6 +365,21 @@ private:
   /// Rank for all the gids in local index space
   std::vector<int> m_ranks;
 
+  /// buffers and requests of a pending non-blocking synchronization
+  struct PendingSync
+  {
+    std::vector<unsigned char> sndbuf;
+    std::vector<unsigned char> rcvbuf;
+    std::vector<MPI_Request> requests;
+  };
+
+  /// pending non-blocking synchronizations, by name of the parallel object
+  std::map< std::string, boost::shared_ptr<PendingSync> > m_pending_syncs;
+
+  /// message tag of the non-blocking synchronizations, reserved so they can't match other point-to-point messages
+  /// the messages of several pending synchronizations are matched in the order they were started
+  static const int nonblocking_sync_tag = 2000;
+
 }; // CommPattern
 
 ////////////////////////////////////////////////////////////////////////////////////////////
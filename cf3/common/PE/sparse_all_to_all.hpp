@@ -0,0 +1,127 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_common_PE_sparse_all_to_all_hpp
+#define cf3_common_PE_sparse_all_to_all_hpp
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include <map>
+#include <vector>
+
+#include "common/PE/types.hpp"
+#include "common/PE/datatype.hpp"
+#include "common/PE/all_to_all.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+  @file sparse_all_to_all.hpp
+  Sparse dynamic data exchange: each process only knows to which processes it sends, and learns from which ones it receives.
+  Unlike the std::vector< std::vector<T> > version of all_to_all, no array of size #processes is communicated or allocated,
+  so the cost only depends on the number of actual neighbours.
+  The implementation uses the non-blocking consensus algorithm (Hoefler et al., "Scalable communication protocols for dynamic sparse data exchange", 2010):
+  synchronous sends are posted to all destinations, incoming messages are probed and received until all sends are matched,
+  after which a non-blocking barrier is entered. The exchange is complete when that barrier completes, while receives continue in the meantime.
+  For MPI versions before 3.0, which lack MPI_Ibarrier, the dense all_to_all is used instead.
+**/
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+  namespace common {
+    namespace PE {
+
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+  Sparse all to all communication.
+  Collective: all processes of the communicator must call this, also those that have nothing to send.
+  Consecutive calls on the same communicator must alternate between two different tags, since a process may start the
+  next exchange before another one has left the current one. Comm::sparse_all_to_all takes care of this.
+  @param comm Comm::Communicator
+  @param send data to send, indexed by destination rank. Empty vectors are not sent.
+  @param recv cleared, and filled with the data received, indexed by source rank. Only ranks that sent something have an entry.
+  @param tag message tag, which must not be used by other point to point communications that can be in flight at the same time
+**/
+template<typename T>
+void sparse_all_to_all(const Communicator& comm, const std::map< int, std::vector<T> >& send, std::map< int, std::vector<T> >& recv, const int tag)
+{
+  typedef typename std::map< int, std::vector<T> >::const_iterator SendIteratorT;
+  recv.clear();
+  Datatype type = get_mpi_datatype<T>();
+
+#if MPI_VERSION >= 3
+  std::vector<MPI_Request> send_requests;
+  send_requests.reserve(send.size());
+  for(SendIteratorT it = send.begin(); it != send.end(); ++it)
+  {
+    if(it->second.empty())
+      continue;
+    send_requests.push_back(MPI_REQUEST_NULL);
+    MPI_CHECK_RESULT(MPI_Issend, (const_cast<T*>(&it->second[0]), static_cast<int>(it->second.size()), type, it->first, tag, comm, &send_requests.back()));
+  }
+
+  MPI_Request barrier_request = MPI_REQUEST_NULL;
+  bool barrier_active = false;
+  while(true)
+  {
+    int has_message = 0;
+    MPI_Status status;
+    MPI_CHECK_RESULT(MPI_Iprobe, (MPI_ANY_SOURCE, tag, comm, &has_message, &status));
+    if(has_message)
+    {
+      int count = 0;
+      MPI_CHECK_RESULT(MPI_Get_count, (&status, type, &count));
+      std::vector<T>& received = recv[status.MPI_SOURCE];
+      received.resize(count);
+      MPI_CHECK_RESULT(MPI_Recv, (&received[0], count, type, status.MPI_SOURCE, tag, comm, MPI_STATUS_IGNORE));
+    }
+
+    if(barrier_active)
+    {
+      int barrier_done = 0;
+      MPI_CHECK_RESULT(MPI_Test, (&barrier_request, &barrier_done, MPI_STATUS_IGNORE));
+      if(barrier_done)
+        break;
+    }
+    else
+    {
+      // Synchronous sends complete only once they are matched by a receive, so all our data has arrived
+      int sends_done = 1;
+      if(!send_requests.empty())
+        MPI_CHECK_RESULT(MPI_Testall, (static_cast<int>(send_requests.size()), &send_requests[0], &sends_done, MPI_STATUSES_IGNORE));
+      if(sends_done)
+      {
+        MPI_CHECK_RESULT(MPI_Ibarrier, (comm, &barrier_request));
+        barrier_active = true;
+      }
+    }
+  }
+#else
+  int nproc;
+  MPI_CHECK_RESULT(MPI_Comm_size, (comm, &nproc));
+  std::vector< std::vector<T> > dense_send(nproc), dense_recv;
+  for(SendIteratorT it = send.begin(); it != send.end(); ++it)
+    dense_send[it->first] = it->second;
+  all_to_all(comm, dense_send, dense_recv);
+  for(int i = 0; i != nproc; ++i)
+  {
+    if(!dense_recv[i].empty())
+      recv[i].swap(dense_recv[i]);
+  }
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace PE
+} // namespace common
+} // namespace cf3
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif // cf3_common_PE_sparse_all_to_all_hpp
@@ -0,0 +1,604 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <sstream>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
+
+#include "common/Assertions.hpp"
+#include "common/BasicExceptions.hpp"
+#include "common/Foreach.hpp"
+#include "common/Tracer.hpp"
+#include "common/URI.hpp"
+
+#include "common/PE/Comm.hpp"
+
+#ifdef CF3_OS_LINUX
+extern "C"
+{
+  #include <time.h>
+}
+#endif
+
+#ifdef CF3_HAVE_PERF_EVENT_H
+extern "C"
+{
+  #include <linux/perf_event.h>
+  #include <sys/syscall.h>
+  #include <unistd.h>
+}
+#endif
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace common {
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+namespace detail
+{
+  /// Hardware counters of one thread
+  struct TraceCounters
+  {
+    TraceCounters() : instructions_fd(-1), cycles_fd(-1)
+    {
+    }
+
+    ~TraceCounters()
+    {
+      close();
+    }
+
+#ifdef CF3_HAVE_PERF_EVENT_H
+    static int open_counter(const boost::uint64_t config)
+    {
+      perf_event_attr attr;
+      std::memset(&attr, 0, sizeof(attr));
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.size = sizeof(attr);
+      attr.config = config;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      // Count for the calling thread, on any CPU
+      return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+
+    static boost::uint64_t read_counter(const int fd)
+    {
+      boost::uint64_t value = 0;
+      if(fd < 0 || ::read(fd, &value, sizeof(value)) != sizeof(value))
+        return 0;
+      return value;
+    }
+
+    bool open()
+    {
+      if(instructions_fd < 0)
+        instructions_fd = open_counter(PERF_COUNT_HW_INSTRUCTIONS);
+      if(cycles_fd < 0)
+        cycles_fd = open_counter(PERF_COUNT_HW_CPU_CYCLES);
+      return instructions_fd >= 0 && cycles_fd >= 0;
+    }
+
+    void close()
+    {
+      if(instructions_fd >= 0)
+        ::close(instructions_fd);
+      if(cycles_fd >= 0)
+        ::close(cycles_fd);
+      instructions_fd = -1;
+      cycles_fd = -1;
+    }
+
+    void read(boost::uint64_t& instructions, boost::uint64_t& cycles) const
+    {
+      instructions = read_counter(instructions_fd);
+      cycles = read_counter(cycles_fd);
+    }
+#else
+    bool open()
+    {
+      return false;
+    }
+
+    void close()
+    {
+    }
+
+    void read(boost::uint64_t& instructions, boost::uint64_t& cycles) const
+    {
+      instructions = 0;
+      cycles = 0;
+    }
+#endif
+
+    int instructions_fd;
+    int cycles_fd;
+  };
+
+  /// One execution of a region
+  struct TraceEvent
+  {
+    Uint region;
+    double begin;
+    double end;
+    boost::uint64_t instructions;
+    boost::uint64_t cycles;
+  };
+
+  /// Escape a string for use in JSON
+  std::string json_escape(const std::string& str)
+  {
+    std::string result;
+    result.reserve(str.size());
+    BOOST_FOREACH(const char c, str)
+    {
+      if(c == '"' || c == '\\')
+        result.push_back('\\');
+      if(static_cast<unsigned char>(c) >= 0x20)
+        result.push_back(c);
+    }
+    return result;
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+TraceStatistics::TraceStatistics() :
+  count(0),
+  total(0.),
+  minimum(0.),
+  maximum(0.),
+  instructions(0),
+  cycles(0)
+{
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+struct Tracer::ThreadData
+{
+  ThreadData(const Uint id) : thread_id(id), next_event(0)
+  {
+  }
+
+  /// Open region, with the start values
+  struct OpenRegion
+  {
+    Uint region;
+    double begin;
+    boost::uint64_t instructions;
+    boost::uint64_t cycles;
+  };
+
+  const Uint thread_id;
+  std::vector<OpenRegion> stack;
+  /// Ring buffer with the most recent events. Once it is full, next_event is the oldest event, which is overwritten next.
+  std::vector<detail::TraceEvent> events;
+  Uint next_event;
+  std::vector<TraceStatistics> statistics;
+  detail::TraceCounters counters;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+struct Tracer::Implementation
+{
+  Implementation() : thread_data(&keep_thread_data), start_time(0.), started(false)
+  {
+  }
+
+  /// Thread data is owned by the Tracer, so nothing needs to happen at thread exit
+  static void keep_thread_data(ThreadData*)
+  {
+  }
+
+  boost::thread_specific_ptr<ThreadData> thread_data;
+
+  /// Protects the registration of regions and threads
+  mutable boost::mutex mutex;
+
+  std::vector< boost::shared_ptr<ThreadData> > threads;
+  std::vector<std::string> region_names;
+  std::map<std::string, Uint> region_ids;
+
+  double start_time;
+  bool started;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+Tracer& Tracer::instance()
+{
+  static Tracer tracer;
+  return tracer;
+}
+
+Tracer::Tracer() :
+  m_implementation(new Implementation()),
+  m_enabled(false),
+  m_counters_enabled(false),
+  m_max_events(0)
+{
+}
+
+Tracer::~Tracer()
+{
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+void Tracer::enable(const bool enabled)
+{
+  if(enabled && !m_implementation->started)
+  {
+    m_implementation->start_time = now();
+    m_implementation->started = true;
+  }
+  m_enabled = enabled;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+bool Tracer::enable_counters(const bool enabled)
+{
+  if(!enabled)
+  {
+    m_counters_enabled = false;
+    return true;
+  }
+
+  // Check if the counters can be opened for the calling thread, other threads open them on first use
+  m_counters_enabled = thread_data().counters.open();
+  return m_counters_enabled;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+void Tracer::set_max_events(const Uint max_events)
+{
+  boost::lock_guard<boost::mutex> lock(m_implementation->mutex);
+  BOOST_FOREACH(const boost::shared_ptr<ThreadData>& data, m_implementation->threads)
+  {
+    std::vector<detail::TraceEvent>().swap(data->events);
+    data->next_event = 0;
+  }
+  m_max_events = max_events;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+Uint Tracer::region(const std::string& name)
+{
+  boost::lock_guard<boost::mutex> lock(m_implementation->mutex);
+  std::map<std::string, Uint>::const_iterator found = m_implementation->region_ids.find(name);
+  if(found != m_implementation->region_ids.end())
+    return found->second;
+
+  const Uint region_id = m_implementation->region_names.size();
+  m_implementation->region_names.push_back(name);
+  m_implementation->region_ids[name] = region_id;
+  return region_id;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+const std::string& Tracer::region_name(const Uint region_id) const
+{
+  boost::lock_guard<boost::mutex> lock(m_implementation->mutex);
+  cf3_assert(region_id < m_implementation->region_names.size());
+  return m_implementation->region_names[region_id];
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+Tracer::ThreadData& Tracer::thread_data()
+{
+  ThreadData* data = m_implementation->thread_data.get();
+  if(is_null(data))
+  {
+    boost::lock_guard<boost::mutex> lock(m_implementation->mutex);
+    m_implementation->threads.push_back(boost::shared_ptr<ThreadData>(new ThreadData(m_implementation->threads.size())));
+    data = m_implementation->threads.back().get();
+    m_implementation->thread_data.reset(data);
+  }
+  return *data;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+Real Tracer::now() const
+{
+#ifdef CF3_OS_LINUX
+  timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return static_cast<double>(time.tv_sec) + 1e-9 * static_cast<double>(time.tv_nsec) - m_implementation->start_time;
+#else
+  static const boost::posix_time::ptime epoch(boost::gregorian::date(1970, 1, 1));
+  return 1e-6 * static_cast<double>((boost::posix_time::microsec_clock::universal_time() - epoch).total_microseconds()) - m_implementation->start_time;
+#endif
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+void Tracer::begin(const Uint region_id)
+{
+  ThreadData& data = thread_data();
+  ThreadData::OpenRegion open_region;
+  open_region.region = region_id;
+  open_region.instructions = 0;
+  open_region.cycles = 0;
+  if(m_counters_enabled && data.counters.open())
+    data.counters.read(open_region.instructions, open_region.cycles);
+  open_region.begin = now();
+  data.stack.push_back(open_region);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+void Tracer::end(const Uint region_id)
+{
+  const double end_time = now();
+  ThreadData& data = thread_data();
+
+  // Find the matching begin. It may be missing if tracing was enabled while the region was running,
+  // and regions above it are left open if an exception skipped their end.
+  Uint stack_idx = data.stack.size();
+  while(stack_idx != 0 && data.stack[stack_idx-1].region != region_id)
+    --stack_idx;
+  if(stack_idx == 0)
+    return;
+  data.stack.resize(stack_idx);
+
+  const ThreadData::OpenRegion& open_region = data.stack.back();
+
+  detail::TraceEvent event;
+  event.region = region_id;
+  event.begin = open_region.begin;
+  event.end = end_time;
+  event.instructions = 0;
+  event.cycles = 0;
+  if(m_counters_enabled && open_region.instructions != 0)
+  {
+    data.counters.read(event.instructions, event.cycles);
+    event.instructions -= open_region.instructions;
+    event.cycles -= open_region.cycles;
+  }
+  data.stack.pop_back();
+
+  if(data.statistics.size() <= region_id)
+    data.statistics.resize(region_id+1);
+  TraceStatistics& stats = data.statistics[region_id];
+  const Real elapsed = event.end - event.begin;
+  stats.minimum = stats.count == 0 ? elapsed : std::min(stats.minimum, elapsed);
+  stats.maximum = stats.count == 0 ? elapsed : std::max(stats.maximum, elapsed);
+  stats.total += elapsed;
+  stats.instructions += event.instructions;
+  stats.cycles += event.cycles;
+  ++stats.count;
+
+  if(data.events.size() < m_max_events)
+  {
+    data.events.push_back(event);
+  }
+  else if(m_max_events != 0)
+  {
+    data.events[data.next_event] = event;
+    data.next_event = (data.next_event + 1) % m_max_events;
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+void Tracer::clear()
+{
+  boost::lock_guard<boost::mutex> lock(m_implementation->mutex);
+  BOOST_FOREACH(const boost::shared_ptr<ThreadData>& data, m_implementation->threads)
+  {
+    data->events.clear();
+    data->next_event = 0;
+    data->statistics.clear();
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<TraceStatistics> Tracer::statistics() const
+{
+  boost::lock_guard<boost::mutex> lock(m_implementation->mutex);
+  std::vector<TraceStatistics> result(m_implementation->region_names.size());
+  BOOST_FOREACH(const boost::shared_ptr<ThreadData>& data, m_implementation->threads)
+  {
+    const Uint nb_regions = data->statistics.size();
+    for(Uint i = 0; i != nb_regions; ++i)
+    {
+      const TraceStatistics& thread_stats = data->statistics[i];
+      if(thread_stats.count == 0)
+        continue;
+      TraceStatistics& stats = result[i];
+      stats.minimum = stats.count == 0 ? thread_stats.minimum : std::min(stats.minimum, thread_stats.minimum);
+      stats.maximum = stats.count == 0 ? thread_stats.maximum : std::max(stats.maximum, thread_stats.maximum);
+      stats.total += thread_stats.total;
+      stats.instructions += thread_stats.instructions;
+      stats.cycles += thread_stats.cycles;
+      stats.count += thread_stats.count;
+    }
+  }
+  return result;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+void Tracer::print_statistics(std::ostream& stream) const
+{
+  const std::vector<TraceStatistics> local_stats = statistics();
+  std::vector<std::string> names;
+  std::map<std::string, Uint> region_ids;
+  {
+    boost::lock_guard<boost::mutex> lock(m_implementation->mutex);
+    names = m_implementation->region_names;
+    region_ids = m_implementation->region_ids;
+  }
+
+  const bool parallel = PE::Comm::instance().is_active() && PE::Comm::instance().size() > 1;
+
+  // Regions are registered in a different order on each rank, and some may be missing, so first agree on the list of names
+  if(parallel)
+  {
+    std::string local_names;
+    BOOST_FOREACH(const std::string& name, names)
+    {
+      local_names += name + '\n';
+    }
+
+    const int nb_procs = PE::Comm::instance().size();
+    const int local_size = local_names.size();
+    std::vector<int> sizes(nb_procs);
+    PE::Comm::instance().all_gather(local_size, sizes);
+    std::vector<char> all_names(std::max(1, std::accumulate(sizes.begin(), sizes.end(), 0)));
+    PE::Comm::instance().all_gather(local_names.c_str(), local_size, &all_names[0], &sizes[0]);
+
+    names.clear();
+    std::string name;
+    const int total_size = std::accumulate(sizes.begin(), sizes.end(), 0);
+    for(int i = 0; i != total_size; ++i)
+    {
+      if(all_names[i] == '\n')
+      {
+        names.push_back(name);
+        name.clear();
+      }
+      else
+      {
+        name.push_back(all_names[i]);
+      }
+    }
+    std::sort(names.begin(), names.end());
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+  }
+  else
+  {
+    std::sort(names.begin(), names.end());
+  }
+
+  const Uint nb_regions = names.size();
+  std::vector<Real> local_totals(nb_regions, 0.), local_max(nb_regions, 0.);
+  std::vector<Real> local_min(nb_regions, std::numeric_limits<Real>::max());
+  std::vector<Uint> local_counts(nb_regions, 0);
+  for(Uint i = 0; i != nb_regions; ++i)
+  {
+    const std::map<std::string, Uint>::const_iterator found = region_ids.find(names[i]);
+    if(found == region_ids.end() || found->second >= local_stats.size() || local_stats[found->second].count == 0)
+      continue;
+    const TraceStatistics& stats = local_stats[found->second];
+    local_totals[i] = stats.total;
+    local_min[i] = stats.minimum;
+    local_max[i] = stats.maximum;
+    local_counts[i] = stats.count;
+  }
+
+  // Total time per region: minimum, sum and maximum over ranks
+  std::vector<Real> min_totals(local_totals), sum_totals(local_totals), max_totals(local_totals);
+  std::vector<Real> global_min(local_min), global_max(local_max);
+  std::vector<Uint> global_counts(local_counts);
+  if(parallel && nb_regions != 0)
+  {
+    PE::Comm::instance().all_reduce(PE::min(), local_totals, min_totals);
+    PE::Comm::instance().all_reduce(PE::plus(), local_totals, sum_totals);
+    PE::Comm::instance().all_reduce(PE::max(), local_totals, max_totals);
+    PE::Comm::instance().all_reduce(PE::min(), local_min, global_min);
+    PE::Comm::instance().all_reduce(PE::max(), local_max, global_max);
+    PE::Comm::instance().all_reduce(PE::plus(), local_counts, global_counts);
+  }
+
+  if(PE::Comm::instance().is_active() && PE::Comm::instance().rank() != 0)
+    return;
+
+  const Real nb_procs = parallel ? static_cast<Real>(PE::Comm::instance().size()) : 1.;
+  stream << "Traced regions, total time in seconds with [min, mean, max] over CPUs, and [min, max] time for one execution\n";
+  for(Uint i = 0; i != nb_regions; ++i)
+  {
+    if(global_counts[i] == 0)
+      continue;
+    stream << names[i]
+           << ": total: [" << min_totals[i] << ", " << sum_totals[i] / nb_procs << ", " << max_totals[i] << "]"
+           << ", per call: [" << global_min[i] << ", " << global_max[i] << "]"
+           << ", count: " << global_counts[i] << "\n";
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+void Tracer::write_chrome_trace(const URI& file) const
+{
+  const bool parallel = PE::Comm::instance().is_active() && PE::Comm::instance().size() > 1;
+  const Uint rank = PE::Comm::instance().is_active() ? PE::Comm::instance().rank() : 0;
+  const Uint nb_procs = parallel ? PE::Comm::instance().size() : 1;
+
+  std::vector<std::string> names;
+  std::vector< boost::shared_ptr<ThreadData> > threads;
+  {
+    boost::lock_guard<boost::mutex> lock(m_implementation->mutex);
+    names = m_implementation->region_names;
+    threads = m_implementation->threads;
+  }
+
+  // Events of this rank, each preceded by a separator except for the very first event in the file
+  std::stringstream events;
+  events << std::setprecision(3) << std::fixed;
+  events << (rank == 0 ? "[\n" : ",\n");
+  events << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << rank << ",\"args\":{\"name\":\"rank " << rank << "\"}}";
+  BOOST_FOREACH(const boost::shared_ptr<ThreadData>& data, threads)
+  {
+    // Oldest event first
+    const Uint nb_events = data->events.size();
+    for(Uint i = 0; i != nb_events; ++i)
+    {
+      const detail::TraceEvent& event = data->events[(data->next_event + i) % nb_events];
+      // Chrome expects microseconds
+      events << ",\n{\"name\":\"" << detail::json_escape(names[event.region]) << "\",\"cat\":\"cf3\",\"ph\":\"X\""
+             << ",\"ts\":" << 1e6 * event.begin << ",\"dur\":" << 1e6 * (event.end - event.begin)
+             << ",\"pid\":" << rank << ",\"tid\":" << data->thread_id;
+      if(m_counters_enabled)
+        events << ",\"args\":{\"instructions\":" << event.instructions << ",\"cycles\":" << event.cycles << "}";
+      events << "}";
+    }
+  }
+  if(rank == nb_procs-1)
+    events << "\n]\n";
+
+  for(Uint proc = 0; proc != nb_procs; ++proc)
+  {
+    if(proc == rank)
+    {
+      std::ofstream output(file.path().c_str(), proc == 0 ? std::ios_base::out : std::ios_base::app);
+      if(!output)
+        throw FileSystemError(FromHere(), "Could not open trace file " + file.path());
+      output << events.str();
+    }
+    if(parallel)
+      PE::Comm::instance().barrier();
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+} // common
+} // cf3
+
+/////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,157 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_common_Tracer_hpp
+#define cf3_common_Tracer_hpp
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/preprocessor/cat.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include "common/CommonAPI.hpp"
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace common {
+
+class URI;
+
+/// Accumulated statistics for one traced region, on one rank
+struct Common_API TraceStatistics
+{
+  TraceStatistics();
+
+  /// Number of times the region was executed
+  Uint count;
+  /// Total, minimum and maximum wall time of one execution, in seconds
+  Real total;
+  Real minimum;
+  Real maximum;
+  /// Hardware counters, zero if not available
+  boost::uint64_t instructions;
+  boost::uint64_t cycles;
+};
+
+/// Records the wall time spent in named code regions, for all threads of this rank.
+/// Each thread writes into its own buffer, so regions can be traced inside threaded loops.
+/// Recording is off by default, in which case an instrumentation point costs only a check of is_enabled().
+/// By default only the statistics are kept, the timeline for write_chrome_trace is only stored if set_max_events is used.
+/// Use CF3_TRACE_SCOPE to instrument a block of code.
+class Common_API Tracer : public boost::noncopyable
+{
+public:
+  /// Singleton access
+  static Tracer& instance();
+
+  ~Tracer();
+
+  /// Turn recording on or off. The timeline starts when recording is first turned on,
+  /// so this should be done at the same point on all ranks.
+  void enable(const bool enabled);
+
+  /// True if recording is on
+  bool is_enabled() const { return m_enabled; }
+
+  /// Also record the instruction and cycle counters, using perf_event_open.
+  /// @return false if hardware counters are not available on this system
+  bool enable_counters(const bool enabled);
+
+  /// True if hardware counters are recorded
+  bool counters_enabled() const { return m_counters_enabled; }
+
+  /// Keep the most recent max_events events of each thread for write_chrome_trace, in a ring buffer.
+  /// If 0, only the statistics are recorded. Events recorded so far are removed.
+  void set_max_events(const Uint max_events);
+
+  /// Number of events kept for each thread
+  Uint max_events() const { return m_max_events; }
+
+  /// Id of the region with the given name, which is registered on first use.
+  /// Meant to be called once for each instrumentation point, the returned id is used for begin and end.
+  Uint region(const std::string& name);
+
+  /// Name of a region
+  const std::string& region_name(const Uint region_id) const;
+
+  /// Start timing the given region on the calling thread
+  void begin(const Uint region_id);
+
+  /// Stop timing the given region on the calling thread. Regions must be properly nested.
+  void end(const Uint region_id);
+
+  /// Remove all recorded events and statistics. Registered regions are kept.
+  void clear();
+
+  /// Statistics for each registered region, indexed by region id and summed over all threads of this rank
+  std::vector<TraceStatistics> statistics() const;
+
+  /// Print the statistics of all regions, with the minimum, mean and maximum over all ranks.
+  /// Collective, only rank 0 prints.
+  void print_statistics(std::ostream& stream) const;
+
+  /// Write the recorded events in the Chrome trace-event JSON format, with the rank as process id.
+  /// Only the events kept according to max_events are written.
+  /// Collective, the ranks append their events to the file in turn.
+  void write_chrome_trace(const URI& file) const;
+
+private:
+  Tracer();
+
+  /// Per-thread storage
+  struct ThreadData;
+  ThreadData& thread_data();
+
+  /// Current wall time in seconds, relative to the start of recording
+  Real now() const;
+
+  struct Implementation;
+  boost::scoped_ptr<Implementation> m_implementation;
+
+  bool m_enabled;
+  bool m_counters_enabled;
+  Uint m_max_events;
+};
+
+/// Traces the region with the given id for the lifetime of the object
+class Common_API ScopedTrace : public boost::noncopyable
+{
+public:
+  ScopedTrace(const Uint region_id) :
+    m_region(region_id),
+    m_active(Tracer::instance().is_enabled())
+  {
+    if(m_active)
+      Tracer::instance().begin(m_region);
+  }
+
+  ~ScopedTrace()
+  {
+    if(m_active)
+      Tracer::instance().end(m_region);
+  }
+
+private:
+  const Uint m_region;
+  const bool m_active;
+};
+
+} // common
+} // cf3
+
+/// Trace the rest of the enclosing block as a region with the given name
+#define CF3_TRACE_SCOPE(name) \
+  static const cf3::Uint BOOST_PP_CAT(cf3_trace_region_, __LINE__) = cf3::common::Tracer::instance().region(name); \
+  const cf3::common::ScopedTrace BOOST_PP_CAT(cf3_trace_scope_, __LINE__)(BOOST_PP_CAT(cf3_trace_region_, __LINE__))
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+#endif // cf3_common_Tracer_hpp
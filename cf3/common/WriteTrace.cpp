@@ -0,0 +1,56 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <iostream>
+
+#include "common/Builder.hpp"
+#include "common/OptionList.hpp"
+#include "common/Tracer.hpp"
+#include "common/URI.hpp"
+
+#include "WriteTrace.hpp"
+
+namespace cf3 {
+namespace common {
+
+ComponentBuilder < WriteTrace, Action, LibCommon > WriteTrace_Builder;
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+WriteTrace::WriteTrace(const std::string& name): Action(name)
+{
+  options().add("file", URI("trace.json"))
+    .description("File to write the events to, in Chrome trace-event format. Can be opened in chrome://tracing")
+    .pretty_name("File")
+    .mark_basic();
+
+  options().add("print_statistics", true)
+    .description("Print the statistics of the traced regions")
+    .pretty_name("Print Statistics");
+
+  options().add("clear", false)
+    .description("Clear the recorded events after writing them")
+    .pretty_name("Clear");
+}
+
+void WriteTrace::execute()
+{
+  Tracer& tracer = Tracer::instance();
+
+  if(options().value<bool>("print_statistics"))
+    tracer.print_statistics(std::cout);
+
+  if(tracer.max_events() != 0)
+    tracer.write_chrome_trace(options().value<URI>("file"));
+
+  if(options().value<bool>("clear"))
+    tracer.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+} // common
+} // cf3
@@ -0,0 +1,45 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_common_WriteTrace_hpp
+#define cf3_common_WriteTrace_hpp
+
+#include "common/Action.hpp"
+
+#include "LibCommon.hpp"
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace common {
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+/// Prints the statistics of the traced regions and writes the recorded events to a Chrome trace file.
+/// Tracing is turned on using the "tracing" option of the environment. The trace file is only written if the
+/// "tracing_events" option of the environment is set, otherwise only the statistics are recorded.
+class Common_API WriteTrace : public Action
+{
+public: // functions
+
+  /// Contructor
+  /// @param name of the component
+  WriteTrace ( const std::string& name );
+
+  /// Get the class name
+  static std::string type_name () { return "WriteTrace"; }
+
+  virtual void execute();
+};
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+} // common
+} // cf3
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+#endif // cf3_common_WriteTrace_hpp
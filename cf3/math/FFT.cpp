@@ -0,0 +1,132 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <algorithm>
+#include <cmath>
+
+#include "common/BasicExceptions.hpp"
+
+#include "math/Consts.hpp"
+#include "math/FFT.hpp"
+
+//////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace math {
+
+//////////////////////////////////////////////////////////////////////////////
+
+FFT::FFT(const Uint n) :
+  m_size(n)
+{
+  if(n == 0)
+    throw common::BadValue(FromHere(), "FFT size must be at least 1");
+
+  Uint remainder = n;
+  for(Uint p = 2; p*p <= remainder; ++p)
+  {
+    while(remainder % p == 0)
+    {
+      m_factors.push_back(p);
+      remainder /= p;
+    }
+  }
+  if(remainder > 1)
+    m_factors.push_back(remainder);
+
+  m_twiddles.resize(n);
+  for(Uint k = 0; k != n; ++k)
+  {
+    const Real angle = -2.*Consts::pi()*static_cast<Real>(k)/static_cast<Real>(n);
+    m_twiddles[k] = ComplexT(::cos(angle), ::sin(angle));
+  }
+
+  m_input.resize(n);
+  m_output.resize(n);
+  m_butterfly.resize(m_factors.empty() ? 1 : *std::max_element(m_factors.begin(), m_factors.end()));
+}
+
+void FFT::forward(ComplexT* data) const
+{
+  transform(data, false);
+}
+
+void FFT::inverse(ComplexT* data) const
+{
+  transform(data, true);
+}
+
+void FFT::add_power_spectra(const Real* a, const Real* b, const Uint stride, Real* result) const
+{
+  for(Uint j = 0; j != m_size; ++j)
+    m_input[j] = ComplexT(a[j*stride], b[j*stride]);
+
+  recurse(&m_input[0], &m_output[0], m_size, 1, 0, false);
+
+  // With z = a + ib: A_k = (Z_k + conj(Z_{n-k}))/2 and B_k = (Z_k - conj(Z_{n-k}))/2i, so |A_k|^2 + |B_k|^2 = (|Z_k|^2 + |Z_{n-k}|^2)/2
+  for(Uint k = 0; k != m_size; ++k)
+    result[k] += 0.5*(std::norm(m_output[k]) + std::norm(m_output[(m_size - k) % m_size]));
+}
+
+void FFT::add_power_spectrum(const Real* a, const Uint stride, Real* result) const
+{
+  for(Uint j = 0; j != m_size; ++j)
+    m_input[j] = ComplexT(a[j*stride], 0.);
+
+  recurse(&m_input[0], &m_output[0], m_size, 1, 0, false);
+
+  for(Uint k = 0; k != m_size; ++k)
+    result[k] += std::norm(m_output[k]);
+}
+
+void FFT::transform(ComplexT* data, const bool inverse) const
+{
+  // The recursion is out-of-place, so it reads from a copy of the input
+  std::copy(data, data + m_size, m_input.begin());
+  recurse(&m_input[0], data, m_size, 1, 0, inverse);
+}
+
+void FFT::recurse(const ComplexT* in, ComplexT* out, const Uint n, const Uint stride, const Uint factor_idx, const bool inverse) const
+{
+  if(n == 1)
+  {
+    out[0] = in[0];
+    return;
+  }
+
+  const Uint p = m_factors[factor_idx];
+  const Uint m = n / p;
+
+  // Transform the p interleaved subsequences of length m, storing them one after the other
+  for(Uint q = 0; q != p; ++q)
+    recurse(in + q*stride, out + q*m, m, stride*p, factor_idx+1, inverse);
+
+  // Radix-p butterflies: X_{k+um} = sum_q W_n^{q(k+um)} F_q(k), with W_n = W_N^stride
+  for(Uint k = 0; k != m; ++k)
+  {
+    for(Uint q = 0; q != p; ++q)
+      m_butterfly[q] = out[q*m + k];
+
+    for(Uint u = 0; u != p; ++u)
+    {
+      const Uint out_idx = k + u*m;
+      ComplexT sum = m_butterfly[0];
+      for(Uint q = 1; q != p; ++q)
+      {
+        const ComplexT& twiddle = m_twiddles[(q*out_idx*stride) % m_size];
+        sum += m_butterfly[q] * (inverse ? std::conj(twiddle) : twiddle);
+      }
+      out[out_idx] = sum;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // math
+} // cf3
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,85 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_math_FFT_hpp
+#define cf3_math_FFT_hpp
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include <complex>
+#include <vector>
+
+#include "math/LibMath.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace math {
+
+//////////////////////////////////////////////////////////////////////////////
+
+/// @brief Discrete Fourier transform of a fixed size, computed with a mixed-radix FFT
+///
+/// The size is factored into primes, and the transform is computed with the recursive
+/// decimation-in-time Cooley-Tukey algorithm, using a radix-p butterfly for each prime factor p.
+/// The cost is O(n * sum of the prime factors of n), so O(n log n) for sizes with only small factors.
+/// Sizes with large prime factors are supported, but degrade towards the O(n^2) direct transform.
+///
+/// The twiddle factors are computed once, on construction, so an FFT object should be reused for
+/// all transforms of the same size. It holds work storage, so it must not be shared between threads.
+class Math_API FFT
+{
+public:
+  typedef std::complex<Real> ComplexT;
+
+  /// Set up the transform for sequences of length n
+  FFT(const Uint n);
+
+  /// Length of the transformed sequences
+  Uint size() const { return m_size; }
+
+  /// In-place forward transform: X_k = sum_j x_j exp(-2 pi i j k / n)
+  void forward(ComplexT* data) const;
+
+  /// In-place inverse transform, without the 1/n normalization: x_j = sum_k X_k exp(2 pi i j k / n)
+  void inverse(ComplexT* data) const;
+
+  /// Power spectra |A_k|^2 and |B_k|^2 of two real sequences a and b, computed with a single complex transform.
+  /// The sum of both spectra is added to result, which must have size() entries.
+  /// @param [in] a, b  size() values, read with the given stride
+  void add_power_spectra(const Real* a, const Real* b, const Uint stride, Real* result) const;
+
+  /// Power spectrum |A_k|^2 of a single real sequence, added to result
+  void add_power_spectrum(const Real* a, const Uint stride, Real* result) const;
+
+private:
+  void transform(ComplexT* data, const bool inverse) const;
+
+  /// Transform the n values starting at in, with the given stride, into out, using the factors starting at factor_idx
+  void recurse(const ComplexT* in, ComplexT* out, const Uint n, const Uint stride, const Uint factor_idx, const bool inverse) const;
+
+  Uint m_size;
+
+  /// Prime factors of the size, in ascending order
+  std::vector<Uint> m_factors;
+
+  /// exp(-2 pi i k / n) for k = 0 .. n-1
+  std::vector<ComplexT> m_twiddles;
+
+  /// Work storage
+  mutable std::vector<ComplexT> m_input;
+  mutable std::vector<ComplexT> m_output;
+  mutable std::vector<ComplexT> m_butterfly;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // math
+} // cf3
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif // cf3_math_FFT_hpp
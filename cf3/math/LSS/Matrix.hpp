@@ -12,6 +12,7 @@
 #include <boost/utility.hpp>
 
 #include "math/LSS/LibLSS.hpp"
+#include "common/Assertions.hpp"
 #include "common/PE/CommPattern.hpp"
 #include "common/Log.hpp"
 #include "math/LSS/BlockAccumulator.hpp"
@@ -107,6 +108,17 @@ public:
   /// @warning Structural symmetry is not checked, incorrect results will appear if you use this on a non structurally symmetric matrix
   virtual void symmetric_dirichlet(const Uint blockrow, const Uint ieq, const Real value, LSS::Vector& rhs) = 0;
 
+  /// Apply a set of symmetric dirichlet boundary conditions at once, entry i fixing equation ieqs[i] of blockrows[i] to values[i].
+  /// The default implementation applies them one by one.
+  /// @pre The matrix must be structurally symmetric
+  virtual void symmetric_dirichlet_batch(const std::vector<Uint>& blockrows, const std::vector<Uint>& ieqs, const std::vector<Real>& values, LSS::Vector& rhs)
+  {
+    cf3_assert(blockrows.size() == ieqs.size() && blockrows.size() == values.size());
+    const Uint nb_bcs = blockrows.size();
+    for(Uint i = 0; i != nb_bcs; ++i)
+      symmetric_dirichlet(blockrows[i], ieqs[i], values[i], rhs);
+  }
+
   /// Add one line to another and tie to it via dirichlet-style (applying periodicity)
   virtual void tie_blockrow_pairs (const Uint iblockrow_to, const Uint iblockrow_from) = 0;
 
@@ -16,6 +16,7 @@
 #include "common/OptionT.hpp"
 #include "common/PE/CommPattern.hpp"
 #include "common/Signal.hpp"
+#include "common/Tracer.hpp"
 
 #include "common/XML/Protocol.hpp"
 #include "common/XML/SignalOptions.hpp"
@@ -79,7 +80,7 @@ LSS::System::System(const std::string& name) :
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
-void LSS::System::create(cf3::common::PE::CommPattern& cp, Uint neq, std::vector<Uint>& node_connectivity, std::vector<Uint>& starting_indices, const std::vector<Uint>& periodic_links_nodes, const std::vector<bool>& periodic_links_active)
+void LSS::System::create(cf3::common::PE::CommPattern& cp, Uint neq, const std::vector<Uint>& node_connectivity, const std::vector<Uint>& starting_indices, const std::vector<Uint>& periodic_links_nodes, const std::vector<bool>& periodic_links_active)
 {
   if (is_created())
     destroy();
@@ -111,7 +112,7 @@ void LSS::System::create(cf3::common::PE::CommPattern& cp, Uint neq, std::vector
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
-void LSS::System::create_blocked(common::PE::CommPattern& cp, const VariablesDescriptor& vars, std::vector< Uint >& node_connectivity, std::vector< Uint >& starting_indices, const std::vector<Uint>& periodic_links_nodes, const std::vector<bool>& periodic_links_active)
+void LSS::System::create_blocked(common::PE::CommPattern& cp, const VariablesDescriptor& vars, const std::vector< Uint >& node_connectivity, const std::vector< Uint >& starting_indices, const std::vector<Uint>& periodic_links_nodes, const std::vector<bool>& periodic_links_active)
 {
   if (is_created())
     destroy();
@@ -202,6 +203,7 @@ void LSS::System::destroy()
 void LSS::System::solve()
 {
   cf3_assert(is_created());
+  CF3_TRACE_SCOPE("lss_solve");
   m_solution_strategy->solve();
 }
 
@@ -256,6 +258,31 @@ void LSS::System::dirichlet(const Uint iblockrow, const Uint ieq, const Real val
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+void LSS::System::dirichlet(const std::vector<Uint>& blockrows, const std::vector<Uint>& ieqs, const std::vector<Real>& values, const bool preserve_symmetry)
+{
+  cf3_assert(is_created());
+  cf3_assert(blockrows.size() == ieqs.size() && blockrows.size() == values.size());
+
+  const Uint nb_bcs = blockrows.size();
+  if (preserve_symmetry)
+  {
+    m_mat->symmetric_dirichlet_batch(blockrows, ieqs, values, *m_rhs);
+  }
+  else
+  {
+    for(Uint i = 0; i != nb_bcs; ++i)
+    {
+      m_mat->set_row(blockrows[i],ieqs[i],1.,0.);
+      m_rhs->set_value(blockrows[i],ieqs[i],values[i]);
+    }
+  }
+
+  for(Uint i = 0; i != nb_bcs; ++i)
+    m_sol->set_value(blockrows[i],ieqs[i],values[i]);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
 void LSS::System::periodicity (const Uint iblockrow_to, const Uint iblockrow_from)
 {
   cf3_assert(is_created());
@@ -70,11 +70,11 @@ public:
 
   /// Setup sparsity structure
   /// @todo action for it
-  void create(cf3::common::PE::CommPattern& cp, Uint neq, std::vector<Uint>& node_connectivity, std::vector<Uint>& starting_indices, const std::vector<Uint>& periodic_links_nodes = std::vector<Uint>(), const std::vector<bool>& periodic_links_active = std::vector<bool>());
+  void create(cf3::common::PE::CommPattern& cp, Uint neq, const std::vector<Uint>& node_connectivity, const std::vector<Uint>& starting_indices, const std::vector<Uint>& periodic_links_nodes = std::vector<Uint>(), const std::vector<bool>& periodic_links_active = std::vector<bool>());
 
   /// Create a blocked system, where the unknowns for each physical variable are stored together. Note that this only changes the internal ordering,
   /// the interface is not affected.
-  void create_blocked(cf3::common::PE::CommPattern& cp, const VariablesDescriptor& vars, std::vector<Uint>& node_connectivity, std::vector<Uint>& starting_indices, const std::vector<Uint>& periodic_links_nodes = std::vector<Uint>(), const std::vector<bool>& periodic_links_active = std::vector<bool>());
+  void create_blocked(cf3::common::PE::CommPattern& cp, const VariablesDescriptor& vars, const std::vector<Uint>& node_connectivity, const std::vector<Uint>& starting_indices, const std::vector<Uint>& periodic_links_nodes = std::vector<Uint>(), const std::vector<bool>& periodic_links_active = std::vector<bool>());
 
   /// Exchange to existing matrix and vectors
   /// @todo action for it
@@ -110,6 +110,11 @@ public:
   /// When preserve_symmetry is true than blockrow*numequations+eq column is is zeroed by moving it to the right hand side (however this usually results in performance penalties).
   void dirichlet(const Uint iblockrow, const Uint ieq, const Real value, const bool preserve_symmetry=false);
 
+  /// Apply a set of dirichlet-type boundary conditions at once, entry i fixing equation ieqs[i] of blockrows[i] to values[i].
+  /// With preserve_symmetry, the matrix applies all conditions in a single pass over the affected rows, and can keep the positions
+  /// of the eliminated entries for each distinct set of conditions (e.g. one per boundary patch), as long as the sparsity does not change.
+  void dirichlet(const std::vector<Uint>& blockrows, const std::vector<Uint>& ieqs, const std::vector<Real>& values, const bool preserve_symmetry=false);
+
   /// Applying periodicity by adding one line to another and dirichlet-style fixing it to
   /// Note that prerequisite for this is to work that the matrix sparsity should be compatible (same nonzero pattern for the two block rows).
   /// Note that only structural symmetry can be preserved (again, if sparsity input was symmetric).
@@ -0,0 +1,493 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "Amesos.h"
+
+#include "Epetra_CrsMatrix.h"
+#include "Epetra_Import.h"
+#include "Epetra_Vector.h"
+
+#include "ml_include.h"
+#include "ml_MultiLevelPreconditioner.h"
+
+#include "Teuchos_RCP.hpp"
+
+#include "common/Builder.hpp"
+#include "common/Log.hpp"
+#include "common/OptionList.hpp"
+
+#include "math/Checks.hpp"
+
+#include "ParameterList.hpp"
+#include "TrilinosVector.hpp"
+#include "TrilinosCrsMatrix.hpp"
+#include "MixedPrecisionStrategy.hpp"
+
+namespace cf3 {
+namespace math {
+namespace LSS {
+
+common::ComponentBuilder<MixedPrecisionStrategy, SolutionStrategy, LibLSS> MixedPrecisionStrategy_builder;
+
+struct MixedPrecisionStrategy::Implementation
+{
+  Implementation(common::Component& self) :
+    m_self(self),
+    m_ml_parameter_list(Teuchos::createParameterList()),
+    m_residual(-1.),
+    m_single_iterations(0),
+    m_double_iterations(0),
+    m_copied_matrix(0),
+    m_copied_version(0),
+    m_float_copy_valid(false)
+  {
+    m_self.options().add("tolerance", 1e-8)
+      .pretty_name("Tolerance")
+      .description("Relative residual norm at which the outer double precision iterations stop")
+      .mark_basic();
+
+    m_self.options().add("max_iterations", 30u)
+      .pretty_name("Max Iterations")
+      .description("Maximum number of outer iterations")
+      .mark_basic();
+
+    m_self.options().add("inner_tolerance", 1e-3)
+      .pretty_name("Inner Tolerance")
+      .description("Relative residual reduction for each inner solve")
+      .mark_basic();
+
+    m_self.options().add("max_inner_iterations", 500u)
+      .pretty_name("Max Inner Iterations")
+      .description("Maximum number of BiCGStab iterations for each inner solve");
+
+    m_self.options().add("stall_ratio", 0.5)
+      .pretty_name("Stall Ratio")
+      .description("Switch to double precision inner solves when an outer iteration reduces the residual by less than this factor");
+
+    m_self.options().add("single_precision", true)
+      .pretty_name("Single Precision")
+      .description("Start with single precision inner solves. If false, all inner solves use double precision")
+      .mark_basic();
+
+    // ML default parameters
+    ML_Epetra::SetDefaults("SA", *m_ml_parameter_list);
+    m_ml_parameter_list->set("ML output", 0);
+    m_ml_parameter_list->set("max levels",3);
+    m_ml_parameter_list->set("smoother: type","Chebyshev");
+    m_ml_parameter_list->set("smoother: sweeps",2);
+    m_ml_parameter_list->set("smoother: pre or post", "both");
+
+    Amesos amesos;
+    if(amesos.Query("Amesos_Mumps"))
+    {
+      m_ml_parameter_list->set("coarse: type","Amesos-MUMPS");
+    }
+    else
+    {
+      m_ml_parameter_list->set("coarse: type","Amesos-KLU");
+    }
+
+    m_ml_parameters = m_self.create_component<ParameterList>("MLParameters");
+    m_ml_parameters->mark_basic();
+    m_ml_parameters->set_parameter_list(*m_ml_parameter_list);
+  }
+
+  /// Read-only access to the matrix, which leaves its version unchanged
+  const Epetra_CrsMatrix& matrix() const
+  {
+    const TrilinosCrsMatrix& mat = *m_matrix;
+    return *mat.epetra_matrix();
+  }
+
+  /// Rebuild the ML preconditioner and, for single precision solves, the single precision copy of the owned rows of the matrix,
+  /// with the columns numbered as in its column map. Nothing is done if the matrix did not change since the last update.
+  void update_matrix_copy(const bool single_precision)
+  {
+    const Epetra_CrsMatrix& mat = matrix();
+    const bool changed = m_copied_matrix != &mat || m_copied_version != m_matrix->values_version();
+    if(!changed && (m_float_copy_valid || !single_precision))
+      return;
+
+    const int nb_rows = mat.NumMyRows();
+    if(changed)
+    {
+      m_ml_prec = Teuchos::rcp(new ML_Epetra::MultiLevelPreconditioner(mat, *m_ml_parameter_list, true));
+      m_preconditioner_in = Teuchos::rcp(new Epetra_Vector(m_ml_prec->OperatorDomainMap()));
+      m_preconditioner_out = Teuchos::rcp(new Epetra_Vector(m_ml_prec->OperatorRangeMap()));
+
+      m_domain_vector = Teuchos::rcp(new Epetra_Vector(mat.DomainMap()));
+      m_column_vector = Teuchos::rcp(new Epetra_Vector(mat.ColMap()));
+
+      m_copied_matrix = &mat;
+      m_copied_version = m_matrix->values_version();
+      m_float_copy_valid = false;
+    }
+
+    if(!single_precision)
+    {
+      // Release the single precision copy of an older matrix
+      std::vector<int>().swap(m_row_starts);
+      std::vector<int>().swap(m_columns);
+      std::vector<float>().swap(m_values_float);
+      return;
+    }
+
+    m_row_starts.resize(nb_rows+1);
+    m_columns.resize(mat.NumMyNonzeros());
+    m_values_float.resize(mat.NumMyNonzeros());
+    m_row_starts[0] = 0;
+    for(int i = 0; i != nb_rows; ++i)
+    {
+      int nb_entries;
+      double* values;
+      int* indices;
+      TRILINOS_THROW(mat.ExtractMyRowView(i, nb_entries, values, indices));
+      const int row_start = m_row_starts[i];
+      std::copy(indices, indices+nb_entries, m_columns.begin()+row_start);
+      std::copy(values, values+nb_entries, m_values_float.begin()+row_start);
+      m_row_starts[i+1] = row_start + nb_entries;
+    }
+    m_float_copy_valid = true;
+  }
+
+  /// Global dot product, accumulated in double precision
+  template<typename ScalarT>
+  Real dot(const std::vector<ScalarT>& a, const std::vector<ScalarT>& b) const
+  {
+    Real local = 0.;
+    const Uint n = a.size();
+    for(Uint i = 0; i != n; ++i)
+      local += static_cast<Real>(a[i]) * static_cast<Real>(b[i]);
+    Real global = local;
+    matrix().Comm().SumAll(&local, &global, 1);
+    return global;
+  }
+
+  /// y = A x in single precision, using the single precision copy of the matrix.
+  /// In parallel, x is converted to double precision for the ghost exchange, since the Epetra importer only handles doubles.
+  void multiply(const std::vector<float>& x, std::vector<float>& y)
+  {
+    const Epetra_CrsMatrix& mat = matrix();
+    const int nb_rows = x.size();
+    const float* column_values = &x[0];
+    if(mat.Importer() != 0)
+    {
+      Epetra_Vector& domain = *m_domain_vector;
+      Epetra_Vector& column = *m_column_vector;
+      for(int i = 0; i != nb_rows; ++i)
+        domain[i] = x[i];
+      TRILINOS_THROW(column.Import(domain, *mat.Importer(), Insert));
+      const int nb_cols = column.MyLength();
+      m_column_values.resize(nb_cols);
+      for(int i = 0; i != nb_cols; ++i)
+        m_column_values[i] = column[i];
+      column_values = &m_column_values[0];
+    }
+
+    y.resize(nb_rows);
+    for(int i = 0; i != nb_rows; ++i)
+    {
+      float sum = 0;
+      const int row_end = m_row_starts[i+1];
+      for(int j = m_row_starts[i]; j != row_end; ++j)
+        sum += m_values_float[j] * column_values[m_columns[j]];
+      y[i] = sum;
+    }
+  }
+
+  /// y = A x in double precision, using the Trilinos matrix directly
+  void multiply(const std::vector<double>& x, std::vector<double>& y)
+  {
+    const Epetra_CrsMatrix& mat = matrix();
+    y.resize(x.size());
+    const Epetra_Vector x_view(View, mat.DomainMap(), const_cast<double*>(&x[0]));
+    Epetra_Vector y_view(View, mat.RangeMap(), &y[0]);
+    TRILINOS_THROW(mat.Multiply(false, x_view, y_view));
+  }
+
+  /// y = M^-1 x, with the ML preconditioner in double precision
+  void precondition(const std::vector<double>& x, std::vector<double>& y)
+  {
+    y.resize(x.size());
+    const Epetra_Vector x_view(View, m_ml_prec->OperatorDomainMap(), const_cast<double*>(&x[0]));
+    Epetra_Vector y_view(View, m_ml_prec->OperatorRangeMap(), &y[0]);
+    TRILINOS_THROW(m_ml_prec->ApplyInverse(x_view, y_view));
+  }
+
+  /// y = M^-1 x for single precision vectors, converted to double precision for the ML preconditioner
+  void precondition(const std::vector<float>& x, std::vector<float>& y)
+  {
+    Epetra_Vector& in = *m_preconditioner_in;
+    Epetra_Vector& out = *m_preconditioner_out;
+    const int n = x.size();
+    for(int i = 0; i != n; ++i)
+      in[i] = x[i];
+    TRILINOS_THROW(m_ml_prec->ApplyInverse(in, out));
+    y.resize(n);
+    for(int i = 0; i != n; ++i)
+      y[i] = out[i];
+  }
+
+  /// Right-preconditioned BiCGStab for A x = b, starting from x = 0
+  /// @return false if the method broke down or did not reach the tolerance
+  template<typename ScalarT>
+  bool inner_solve(const std::vector<ScalarT>& b, std::vector<ScalarT>& x, Uint& nb_iterations)
+  {
+    const Uint n = b.size();
+    const Real tolerance = m_self.options().value<Real>("inner_tolerance");
+    const Uint max_iterations = m_self.options().value<Uint>("max_inner_iterations");
+
+    x.assign(n, 0);
+    std::vector<ScalarT> r(b), r_hat(b), p(n, 0), v(n, 0), p_hat(n), s(n), s_hat(n), t(n);
+
+    const Real b_norm = std::sqrt(dot(b, b));
+    if(b_norm == 0.)
+      return true;
+
+    Real rho = 1., alpha = 1., omega = 1.;
+    for(nb_iterations = 0; nb_iterations != max_iterations; ++nb_iterations)
+    {
+      const Real rho_new = dot(r_hat, r);
+      if(rho_new == 0. || !Checks::is_finite(rho_new))
+        return false;
+      const ScalarT beta = (rho_new / rho) * (alpha / omega);
+      for(Uint i = 0; i != n; ++i)
+        p[i] = r[i] + beta * (p[i] - static_cast<ScalarT>(omega) * v[i]);
+      precondition(p, p_hat);
+      multiply(p_hat, v);
+
+      const Real r_hat_v = dot(r_hat, v);
+      if(r_hat_v == 0. || !Checks::is_finite(r_hat_v))
+        return false;
+      alpha = rho_new / r_hat_v;
+      for(Uint i = 0; i != n; ++i)
+        s[i] = r[i] - static_cast<ScalarT>(alpha) * v[i];
+
+      if(std::sqrt(dot(s, s)) <= tolerance * b_norm)
+      {
+        for(Uint i = 0; i != n; ++i)
+          x[i] += static_cast<ScalarT>(alpha) * p_hat[i];
+        ++nb_iterations;
+        return true;
+      }
+
+      precondition(s, s_hat);
+      multiply(s_hat, t);
+
+      const Real t_t = dot(t, t);
+      if(t_t == 0. || !Checks::is_finite(t_t))
+        return false;
+      omega = dot(t, s) / t_t;
+      if(!Checks::is_finite(omega))
+        return false;
+      for(Uint i = 0; i != n; ++i)
+      {
+        x[i] += static_cast<ScalarT>(alpha) * p_hat[i] + static_cast<ScalarT>(omega) * s_hat[i];
+        r[i] = s[i] - static_cast<ScalarT>(omega) * t[i];
+      }
+
+      if(std::sqrt(dot(r, r)) <= tolerance * b_norm)
+      {
+        ++nb_iterations;
+        return true;
+      }
+      if(omega == 0.)
+        return false;
+      rho = rho_new;
+    }
+
+    return false;
+  }
+
+  /// Compute a correction for the residual in the given precision, and add it to the solution
+  template<typename ScalarT>
+  bool correct(const Epetra_Vector& residual, Epetra_Vector& solution, Uint& nb_iterations)
+  {
+    const int n = residual.MyLength();
+    std::vector<ScalarT> b(n), x;
+    for(int i = 0; i != n; ++i)
+      b[i] = residual[i];
+    const bool success = inner_solve(b, x, nb_iterations);
+    for(int i = 0; i != n; ++i)
+      solution[i] += x[i];
+    return success;
+  }
+
+  /// r = b - A x, in double precision
+  Real update_residual(const Epetra_Vector& x, const Epetra_Vector& b, Epetra_Vector& r)
+  {
+    TRILINOS_THROW(matrix().Multiply(false, x, r));
+    TRILINOS_THROW(r.Update(1., b, -1.));
+    Real norm;
+    TRILINOS_THROW(r.Norm2(&norm));
+    return norm;
+  }
+
+  void solve()
+  {
+    if(is_null(m_matrix))
+      throw common::SetupError(FromHere(), "Null matrix for " + m_self.uri().path());
+
+    if(is_null(m_rhs))
+      throw common::SetupError(FromHere(), "Null RHS for " + m_self.uri().path());
+
+    if(is_null(m_solution))
+      throw common::SetupError(FromHere(), "Null solution vector for " + m_self.uri().path());
+
+    const Real tolerance = m_self.options().value<Real>("tolerance");
+    const Uint max_iterations = m_self.options().value<Uint>("max_iterations");
+    const Real stall_ratio = m_self.options().value<Real>("stall_ratio");
+    bool single_precision = m_self.options().value<bool>("single_precision");
+
+    update_matrix_copy(single_precision);
+    m_single_iterations = 0;
+    m_double_iterations = 0;
+
+    Epetra_Vector& x = *m_solution->epetra_vector();
+    const Epetra_Vector& b = *m_rhs->epetra_vector();
+    Epetra_Vector r(b.Map());
+
+    Real b_norm;
+    TRILINOS_THROW(b.Norm2(&b_norm));
+    if(b_norm == 0.)
+      b_norm = 1.;
+
+    m_residual = update_residual(x, b, r) / b_norm;
+    Uint outer = 0;
+    for(; outer != max_iterations && m_residual > tolerance; ++outer)
+    {
+      Uint nb_inner = 0;
+      m_previous_solution.resize(x.MyLength());
+      for(int i = 0; i != x.MyLength(); ++i)
+        m_previous_solution[i] = x[i];
+      const bool success = single_precision ? correct<float>(r, x, nb_inner) : correct<double>(r, x, nb_inner);
+      (single_precision ? m_single_iterations : m_double_iterations) += nb_inner;
+
+      const Real previous_residual = m_residual;
+      m_residual = update_residual(x, b, r) / b_norm;
+      if(!(m_residual < previous_residual))
+      {
+        // Discard corrections that did not help, which also catches overflow in single precision
+        for(int i = 0; i != x.MyLength(); ++i)
+          x[i] = m_previous_solution[i];
+        m_residual = update_residual(x, b, r) / b_norm;
+        if(!single_precision)
+          break;
+      }
+      if(single_precision && (!success || m_residual > stall_ratio * previous_residual))
+      {
+        CFinfo << m_self.uri().path() << ": single precision correction reduced the residual from " << previous_residual << " to " << m_residual << ", continuing in double precision" << CFendl;
+        single_precision = false;
+      }
+    }
+
+    if(m_residual > tolerance)
+      CFwarn << m_self.uri().path() << ": relative residual " << m_residual << " did not reach tolerance " << tolerance << " after " << outer << " outer iterations" << CFendl;
+    else
+      CFdebug << m_self.uri().path() << ": converged to relative residual " << m_residual << " in " << outer << " outer, " << m_single_iterations << " single precision and " << m_double_iterations << " double precision inner iterations" << CFendl;
+  }
+
+  common::Component& m_self;
+
+  /// ML preconditioner, built from the double precision matrix
+  Teuchos::RCP<Teuchos::ParameterList> m_ml_parameter_list;
+  Teuchos::RCP<ML_Epetra::MultiLevelPreconditioner> m_ml_prec;
+  Handle<ParameterList> m_ml_parameters;
+
+  Handle<TrilinosCrsMatrix> m_matrix;
+  Handle<TrilinosVector> m_rhs;
+  Handle<TrilinosVector> m_solution;
+
+  /// Relative residual after the last solve
+  Real m_residual;
+
+  /// Number of inner iterations in each precision during the last solve
+  Uint m_single_iterations;
+  Uint m_double_iterations;
+
+  /// Matrix and version from which the preconditioner and the single precision copy were computed
+  const Epetra_CrsMatrix* m_copied_matrix;
+  Uint m_copied_version;
+  bool m_float_copy_valid;
+
+  /// Single precision copy of the matrix in compressed row format
+  std::vector<int> m_row_starts;
+  std::vector<int> m_columns;
+  std::vector<float> m_values_float;
+
+  /// Solution before the last correction
+  std::vector<Real> m_previous_solution;
+
+  /// Double precision work vectors for applying the preconditioner to single precision vectors
+  Teuchos::RCP<Epetra_Vector> m_preconditioner_in;
+  Teuchos::RCP<Epetra_Vector> m_preconditioner_out;
+
+  /// Work vectors for the ghost exchange
+  Teuchos::RCP<Epetra_Vector> m_domain_vector;
+  Teuchos::RCP<Epetra_Vector> m_column_vector;
+  std::vector<float> m_column_values;
+};
+
+MixedPrecisionStrategy::MixedPrecisionStrategy(const std::string& name) :
+  SolutionStrategy(name),
+  m_implementation(new Implementation(*this))
+{
+}
+
+MixedPrecisionStrategy::~MixedPrecisionStrategy()
+{
+}
+
+Real MixedPrecisionStrategy::compute_residual()
+{
+  return m_implementation->m_residual;
+}
+
+Uint MixedPrecisionStrategy::single_precision_iterations() const
+{
+  return m_implementation->m_single_iterations;
+}
+
+Uint MixedPrecisionStrategy::double_precision_iterations() const
+{
+  return m_implementation->m_double_iterations;
+}
+
+void MixedPrecisionStrategy::set_rhs(const Handle< Vector >& rhs)
+{
+  m_implementation->m_rhs = Handle<TrilinosVector>(rhs);
+}
+
+void MixedPrecisionStrategy::set_solution(const Handle< Vector >& solution)
+{
+  m_implementation->m_solution = Handle<TrilinosVector>(solution);
+}
+
+void MixedPrecisionStrategy::set_matrix(const Handle< Matrix >& matrix)
+{
+  m_implementation->m_matrix = Handle<TrilinosCrsMatrix>(matrix);
+}
+
+void MixedPrecisionStrategy::solve()
+{
+  m_implementation->solve();
+}
+
+void MixedPrecisionStrategy::set_coordinates(common::PE::CommPattern& cp, const common::Table< Real >& coords, const common::List< Uint >& used_nodes, const std::vector< bool >& periodic_links_active)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace LSS
+} // namespace math
+} // namespace cf3
@@ -0,0 +1,72 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_Math_LSS_MixedPrecisionStrategy_hpp
+#define cf3_Math_LSS_MixedPrecisionStrategy_hpp
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <boost/scoped_ptr.hpp>
+
+#include "math/LSS/SolutionStrategy.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ *  @file MixedPrecisionStrategy.hpp Iterative refinement with a partly single precision inner Krylov solver
+ **/
+////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace math {
+namespace LSS {
+
+/// Solve a TrilinosCrsMatrix system by defect correction in double precision, where each correction is obtained by a
+/// BiCGStab solve that only needs to reduce the residual by inner_tolerance. The inner solve is right preconditioned
+/// with ML, which is built and applied in double precision (see the MLParameters child).
+/// In the single precision inner solves, only the Krylov vectors and the matrix values used in the matrix-vector products
+/// are stored in single precision. The column indices are unchanged, and the vectors are converted to double precision to
+/// apply the preconditioner and, in parallel, for the ghost exchange.
+/// The preconditioner and the single precision copy are only updated when the matrix changes. If an outer iteration reduces
+/// the residual by less than stall_ratio, or the inner solver breaks down, the remaining corrections are computed in double
+/// precision, using the Trilinos matrix directly.
+class LSS_API MixedPrecisionStrategy : public SolutionStrategy
+{
+public:
+  MixedPrecisionStrategy(const std::string& name);
+  ~MixedPrecisionStrategy();
+
+  /// name of the type
+  static std::string type_name () { return "MixedPrecisionStrategy"; }
+
+  void set_matrix(const Handle<LSS::Matrix>& matrix);
+  void set_rhs(const Handle<LSS::Vector>& rhs);
+  void set_solution(const Handle<LSS::Vector>& solution);
+  void solve();
+
+  /// Relative residual norm reached by the last solve
+  Real compute_residual();
+
+  /// Number of inner iterations in single precision during the last solve
+  Uint single_precision_iterations() const;
+
+  /// Number of inner iterations in double precision during the last solve
+  Uint double_precision_iterations() const;
+
+  /// Coordinates are not used by this strategy
+  virtual void set_coordinates(common::PE::CommPattern& cp, const common::Table< Real >& coords, const common::List< Uint >& used_nodes, const std::vector< bool >& periodic_links_active);
+
+private:
+  /// Hide the implementation to avoid pulling in lots of Trilinos headers
+  struct Implementation;
+  boost::scoped_ptr<Implementation> m_implementation;
+};
+
+} // namespace LSS
+} // namespace math
+} // namespace cf3
+
+#endif // cf3_Math_LSS_MixedPrecisionStrategy_hpp
@@ -6,6 +6,7 @@
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
 #include <iostream>
 #include <set>
 
@@ -66,6 +67,7 @@ TrilinosCrsMatrix::TrilinosCrsMatrix(const std::string& name) :
   LSS::Matrix(name),
   m_mat(0),
   m_is_created(false),
+  m_values_version(0),
   m_neq(0),
   m_num_my_elements(0),
   m_p2m(0),
@@ -89,6 +91,7 @@ void TrilinosCrsMatrix::create(cf3::common::PE::CommPattern& cp, const Uint neq,
 
 void TrilinosCrsMatrix::create_blocked(common::PE::CommPattern& cp, const VariablesDescriptor& vars, const std::vector< Uint >& node_connectivity, const std::vector< Uint >& starting_indices, Vector& solution, Vector& rhs, const std::vector<Uint>& periodic_links_nodes, const std::vector<bool>& periodic_links_active)
 {
+  ++m_values_version;
   // if already created
   if (m_is_created) destroy();
 
@@ -140,6 +143,8 @@ void TrilinosCrsMatrix::create_blocked(common::PE::CommPattern& cp, const Variab
   TRILINOS_THROW(m_mat->FillComplete());
   TRILINOS_THROW(m_mat->OptimizeStorage());
 
+  m_dirichlet_plans.clear();
+
   // set class properties
   m_is_created=true;
   m_neq=total_nb_eq;
@@ -150,6 +155,7 @@ void TrilinosCrsMatrix::create_blocked(common::PE::CommPattern& cp, const Variab
 
 void TrilinosCrsMatrix::destroy()
 {
+  ++m_values_version;
   if (m_is_created)
   {
     m_mat.reset();
@@ -165,6 +171,7 @@ void TrilinosCrsMatrix::destroy()
 
 void TrilinosCrsMatrix::set_value(const Uint icol, const Uint irow, const Real value)
 {
+  ++m_values_version;
   cf3_assert(m_is_created);
   TRILINOS_THROW(m_mat->ReplaceMyValues(m_p2m[irow], 1, &value, &m_p2m[icol]));
 }
@@ -173,6 +180,7 @@ void TrilinosCrsMatrix::set_value(const Uint icol, const Uint irow, const Real v
 
 void TrilinosCrsMatrix::add_value(const Uint icol, const Uint irow, const Real value)
 {
+  ++m_values_version;
   cf3_assert(m_is_created);
   TRILINOS_THROW(m_mat->SumIntoMyValues(m_p2m[irow], 1, &value, &m_p2m[icol]));
 }
@@ -201,6 +209,7 @@ void TrilinosCrsMatrix::get_value(const Uint icol, const Uint irow, Real& value)
 
 void TrilinosCrsMatrix::set_values(const BlockAccumulator& values)
 {
+  ++m_values_version;
   cf3_assert(m_is_created);
   const Uint nb_nodes = values.indices.size();
   const int num_entries = nb_nodes*m_neq;
@@ -227,6 +236,7 @@ void TrilinosCrsMatrix::set_values(const BlockAccumulator& values)
 
 void TrilinosCrsMatrix::add_values(const BlockAccumulator& values)
 {
+  ++m_values_version;
   cf3_assert(m_is_created);
   const Uint nb_nodes = values.indices.size();
   const int num_entries = nb_nodes*m_neq;
@@ -294,6 +304,7 @@ void TrilinosCrsMatrix::get_values(BlockAccumulator& values)
 
 void TrilinosCrsMatrix::set_row(const Uint iblockrow, const Uint ieq, Real diagval, Real offdiagval)
 {
+  ++m_values_version;
   cf3_assert(m_is_created);
   int num_entries;
   Real* extracted_values;
@@ -317,6 +328,7 @@ void TrilinosCrsMatrix::set_row(const Uint iblockrow, const Uint ieq, Real diagv
 
 void TrilinosCrsMatrix::get_column_and_replace_to_zero(const Uint iblockcol, Uint ieq, std::vector<Real>& values)
 {
+  ++m_values_version;
   throw common::NotImplemented(FromHere(), "get_column_and_replace_to_zero is not implemented for TrilinosCrsMatrix");
 }
 
@@ -324,6 +336,7 @@ void TrilinosCrsMatrix::get_column_and_replace_to_zero(const Uint iblockcol, Uin
 
 void TrilinosCrsMatrix::symmetric_dirichlet(const Uint blockrow, const Uint ieq, const Real value, Vector& rhs)
 {
+  ++m_values_version;
   // We assume that we have an epetra RHS with the same storage structure as the matrix!
   Epetra_Vector& epetra_rhs = *dynamic_cast<TrilinosVector&>(rhs).epetra_vector();
 
@@ -403,6 +416,126 @@ void TrilinosCrsMatrix::symmetric_dirichlet(const Uint blockrow, const Uint ieq,
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+void TrilinosCrsMatrix::build_dirichlet_plan(const std::vector<Uint>& blockrows, const std::vector<int>& bc_cols, DirichletPlan& plan)
+{
+  const Uint nb_bcs = bc_cols.size();
+  std::vector<int> col_to_bc(m_p2m.size(), -1);
+  for(Uint i = 0; i != nb_bcs; ++i)
+    col_to_bc[bc_cols[i]] = i;
+
+  // Only the rows connected to a constrained node can have an entry in a constrained column
+  std::vector<int> rows;
+  for(Uint i = 0; i != nb_bcs; ++i)
+  {
+    if(bc_cols[i] < m_num_my_elements)
+      rows.push_back(bc_cols[i]);
+    const Uint conn_end = m_starting_indices[blockrows[i]+1];
+    for(Uint c = m_starting_indices[blockrows[i]]; c != conn_end; ++c)
+    {
+      for(Uint j = 0; j != m_neq; ++j)
+      {
+        const int row = m_p2m[m_node_connectivity[c]*m_neq+j];
+        if(row < m_num_my_elements)
+          rows.push_back(row);
+      }
+    }
+  }
+  std::sort(rows.begin(), rows.end());
+  rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+
+  int num_entries;
+  Real* extracted_values;
+  int* extracted_indices;
+  BOOST_FOREACH(const int row, rows)
+  {
+    if(col_to_bc[row] >= 0)
+    {
+      plan.bc_rows.push_back(row);
+      continue;
+    }
+
+    TRILINOS_THROW(m_mat->ExtractMyRowView(row, num_entries, extracted_values, extracted_indices));
+    for(int k = 0; k != num_entries; ++k)
+    {
+      const int bc = col_to_bc[extracted_indices[k]];
+      if(bc >= 0)
+      {
+        plan.entry_rows.push_back(row);
+        plan.entry_offsets.push_back(k);
+        plan.entry_bcs.push_back(bc);
+      }
+    }
+  }
+
+  plan.entry_values.resize(plan.entry_rows.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrilinosCrsMatrix::symmetric_dirichlet_batch(const std::vector<Uint>& blockrows, const std::vector<Uint>& ieqs, const std::vector<Real>& values, Vector& rhs)
+{
+  ++m_values_version;
+  cf3_assert(m_is_created);
+  cf3_assert(blockrows.size() == ieqs.size() && blockrows.size() == values.size());
+
+  // We assume that we have an epetra RHS with the same storage structure as the matrix!
+  Epetra_Vector& epetra_rhs = *dynamic_cast<TrilinosVector&>(rhs).epetra_vector();
+
+  const Uint nb_bcs = blockrows.size();
+  std::vector<int> bc_cols(nb_bcs);
+  for(Uint i = 0; i != nb_bcs; ++i)
+  {
+    bc_cols[i] = m_p2m[blockrows[i]*m_neq+ieqs[i]];
+    m_dirichlet_nodes.push_back(std::make_pair(blockrows[i], ieqs[i]));
+  }
+
+  DirichletPlansT::iterator plan_it = m_dirichlet_plans.find(bc_cols);
+  if(plan_it == m_dirichlet_plans.end())
+  {
+    plan_it = m_dirichlet_plans.insert(std::make_pair(bc_cols, DirichletPlan())).first;
+    build_dirichlet_plan(blockrows, bc_cols, plan_it->second);
+  }
+
+  DirichletPlan& plan = plan_it->second;
+  const Uint nb_entries = plan.entry_rows.size();
+
+  // Move the constrained columns out of the matrix, unless this was done already since the last reset
+  if(!plan.values_valid)
+  {
+    int num_entries;
+    Real* extracted_values;
+    int* extracted_indices;
+    for(Uint i = 0; i != nb_entries; )
+    {
+      const int row = plan.entry_rows[i];
+      TRILINOS_THROW(m_mat->ExtractMyRowView(row, num_entries, extracted_values, extracted_indices));
+      for(; i != nb_entries && plan.entry_rows[i] == row; ++i)
+      {
+        Real& entry = extracted_values[plan.entry_offsets[i]];
+        plan.entry_values[i] = entry;
+        entry = 0.;
+      }
+    }
+
+    BOOST_FOREACH(const int row, plan.bc_rows)
+    {
+      TRILINOS_THROW(m_mat->ExtractMyRowView(row, num_entries, extracted_values, extracted_indices));
+      for(int k = 0; k != num_entries; ++k)
+        extracted_values[k] = extracted_indices[k] == row ? 1. : 0.;
+    }
+
+    plan.values_valid = true;
+  }
+
+  for(Uint i = 0; i != nb_entries; ++i)
+    epetra_rhs[plan.entry_rows[i]] -= plan.entry_values[i] * values[plan.entry_bcs[i]];
+
+  for(Uint i = 0; i != nb_bcs; ++i)
+    rhs.set_value(blockrows[i], ieqs[i], values[i]);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
 const std::vector<std::pair<Uint, Uint> >& TrilinosCrsMatrix::get_dirichlet_nodes() const
 {
   return m_dirichlet_nodes;
@@ -412,6 +545,7 @@ const std::vector<std::pair<Uint, Uint> >& TrilinosCrsMatrix::get_dirichlet_node
 
 void TrilinosCrsMatrix::tie_blockrow_pairs (const Uint iblockrow_to, const Uint iblockrow_from)
 {
+  ++m_values_version;
   cf3_assert(m_is_created);
   int num_entries_from;
   Real* extracted_values_from;
@@ -465,6 +599,7 @@ void TrilinosCrsMatrix::tie_blockrow_pairs (const Uint iblockrow_to, const Uint
 
 void TrilinosCrsMatrix::set_diagonal(const std::vector<Real>& diag)
 {
+  ++m_values_version;
   cf3_assert(m_is_created);
   cf3_assert(diag.size() == m_p2m.size());
   Epetra_Vector new_diag(m_mat->RowMap());
@@ -476,6 +611,7 @@ void TrilinosCrsMatrix::set_diagonal(const std::vector<Real>& diag)
 
 void TrilinosCrsMatrix::add_diagonal(const std::vector<Real>& diag)
 {
+  ++m_values_version;
   cf3_assert(m_is_created);
   cf3_assert(diag.size() == m_p2m.size());
   Epetra_Vector new_diag(m_mat->RowMap());
@@ -505,12 +641,15 @@ void TrilinosCrsMatrix::get_diagonal(std::vector<Real>& diag)
 
 void TrilinosCrsMatrix::reset(Real reset_to)
 {
+  ++m_values_version;
   cf3_assert(m_is_created);
   CFdebug << "Resetting CrsMatrix to " << reset_to << CFendl;
   TRILINOS_THROW(m_mat->PutScalar(reset_to));
 
   m_symmetric_dirichlet_values.clear();
   m_dirichlet_nodes.clear();
+  for(DirichletPlansT::iterator it = m_dirichlet_plans.begin(); it != m_dirichlet_plans.end(); ++it)
+    it->second.values_valid = false;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
@@ -533,13 +672,17 @@ void TrilinosCrsMatrix::clone_to(Matrix &other)
   other_ptr->m_node_connectivity = m_node_connectivity;
   other_ptr->m_starting_indices = m_starting_indices;
   other_ptr->m_symmetric_dirichlet_values = m_symmetric_dirichlet_values;
+  other_ptr->m_dirichlet_plans = m_dirichlet_plans;
+  ++other_ptr->m_values_version;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
 void TrilinosCrsMatrix::read_native(const common::URI& file)
-{  
+{
+  ++m_values_version;
   EpetraExt::readEpetraLinearSystem(file.path(), m_comm, &m_mat);
+  m_dirichlet_plans.clear();
   
   m_is_created = true;
 }
@@ -721,6 +864,7 @@ Teuchos::RCP< const Thyra::LinearOpBase< Real > > TrilinosCrsMatrix::thyra_opera
 
 Teuchos::RCP< Thyra::LinearOpBase< Real > > TrilinosCrsMatrix::thyra_operator()
 {
+  ++m_values_version;
   return Thyra::nonconstEpetraLinearOp(m_mat);
 }
 
@@ -101,6 +101,11 @@ public:
 
   virtual void symmetric_dirichlet(const Uint blockrow, const Uint ieq, const Real value, Vector& rhs);
 
+  /// Apply all conditions in one pass over the sorted affected rows.
+  /// The positions of the eliminated entries are kept, and only recomputed when a different set of conditions is applied or the matrix is recreated.
+  /// Their values are kept until the next reset, so the conditions can be applied multiple times to the same matrix.
+  virtual void symmetric_dirichlet_batch(const std::vector<Uint>& blockrows, const std::vector<Uint>& ieqs, const std::vector<Real>& values, Vector& rhs);
+
   /// Get the nodes and equations for all dirichlet boundary conditions that have been applied so far
   const std::vector< std::pair< Uint, Uint > >& get_dirichlet_nodes( ) const;
 
@@ -147,9 +152,10 @@ public:
   /// Accessor to the number of block columns
   const Uint blockcol_size() {  cf3_assert(m_is_created); return m_p2m.size()/neq(); }
 
-  /// Get the matrix in native format
+  /// Get the matrix in native format. The caller may modify the matrix, so this counts as a change of the values.
   Teuchos::RCP<Epetra_CrsMatrix> epetra_matrix()
   {
+    ++m_values_version;
     return m_mat;
   }
 
@@ -162,8 +168,12 @@ public:
   /// Replace the internal matrix with the supplied one
   void replace_epetra_matrix(const Teuchos::RCP<Epetra_CrsMatrix>& mat)
   {
+    ++m_values_version;
     m_mat = mat;
   }
+
+  /// Counter that changes each time the matrix may have been modified, so solvers can tell if data derived from it is stale
+  Uint values_version() const { return m_values_version; }
   
   /// Store the local matrix GIDs belonging to each variable in the given vector
   /// @param var_descriptor Descriptor for the variables that are used in the matrix
@@ -204,6 +214,29 @@ public:
 
 private:
 
+  /// Matrix entries eliminated by symmetric_dirichlet_batch
+  struct DirichletPlan
+  {
+    DirichletPlan() : values_valid(false) {}
+
+    /// Local rows of the conditions, which are replaced by an identity row
+    std::vector<int> bc_rows;
+
+    /// Row, offset in the row and condition index of each eliminated entry, sorted by row
+    std::vector<int> entry_rows;
+    std::vector<int> entry_offsets;
+    std::vector<Uint> entry_bcs;
+
+    /// Values of the eliminated entries, from before they were zeroed
+    std::vector<Real> entry_values;
+
+    /// False if the matrix was reset since the entries were eliminated
+    bool values_valid;
+  };
+
+  /// Find the entries to eliminate for the given conditions
+  void build_dirichlet_plan(const std::vector<Uint>& blockrows, const std::vector<int>& bc_cols, DirichletPlan& plan);
+
   /// teuchos style smart pointer wrapping the matrix
   Teuchos::RCP<Epetra_CrsMatrix> m_mat;
 
@@ -213,6 +246,9 @@ private:
   /// state of creation
   bool m_is_created;
 
+  /// incremented by each call that may modify the matrix
+  Uint m_values_version;
+
   /// number of equations
   Uint m_neq;
 
@@ -233,6 +269,11 @@ private:
   typedef std::map<int, DirichletEntryT> DirichletMapT;
   DirichletMapT m_symmetric_dirichlet_values;
 
+  /// Plans for symmetric_dirichlet_batch, one for each set of conditions (e.g. one for each boundary patch),
+  /// keyed by the matrix columns of the conditions in the order they were applied
+  typedef std::map<std::vector<int>, DirichletPlan> DirichletPlansT;
+  DirichletPlansT m_dirichlet_plans;
+
   std::vector< std::pair<Uint,Uint> > m_dirichlet_nodes;
 }; // end of class Matrix
 
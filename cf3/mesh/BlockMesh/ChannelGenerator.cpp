@@ -4,16 +4,23 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 #include <boost/assign.hpp>
+#include <boost/cstdint.hpp>
 
 #include "common/Builder.hpp"
 #include "common/Core.hpp"
 #include "common/Exception.hpp"
 #include "common/EventHandler.hpp"
+#include "common/Foreach.hpp"
 #include "common/Log.hpp"
 #include "common/OptionComponent.hpp"
 #include "common/OptionList.hpp"
 #include "common/OptionT.hpp"
+#include "common/List.hpp"
 #include "common/Table.hpp"
 #include "common/XML/SignalFrame.hpp"
 #include "common/XML/SignalOptions.hpp"
@@ -21,9 +28,17 @@
 
 #include "common/PE/Comm.hpp"
 
+#include "mesh/Connectivity.hpp"
+#include "mesh/Dictionary.hpp"
+#include "mesh/Elements.hpp"
+#include "mesh/Field.hpp"
 #include "mesh/Mesh.hpp"
+#include "mesh/Region.hpp"
+#include "mesh/Space.hpp"
 #include "mesh/BlockMesh/ChannelGenerator.hpp"
 
+#include "mesh/LagrangeP1/Hexa3D.hpp"
+
 namespace cf3 {
 namespace mesh {
 namespace BlockMesh {
@@ -35,6 +50,86 @@ using namespace boost::assign;
 
 ComponentBuilder < ChannelGenerator, Component, LibBlockMesh > ChannelGenerator_Builder;
 
+namespace detail
+{
+  /// Contiguous partitioning of the cells along one direction. Each node belongs to the partition of the cell that
+  /// follows it, except for the last node, which belongs to the last partition.
+  struct Partitioning
+  {
+    Partitioning(const Uint cells, const Uint parts) :
+      nb_cells(cells),
+      nb_parts(parts)
+    {
+    }
+
+    /// First cell (and node) of partition p
+    Uint begin(const Uint p) const
+    {
+      return static_cast<Uint>(static_cast<boost::uint64_t>(p)*nb_cells / nb_parts);
+    }
+
+    /// Number of cells or nodes in partition p
+    Uint size(const Uint p, const bool nodes) const
+    {
+      return begin(p+1) - begin(p) + (nodes && p == nb_parts-1 ? 1 : 0);
+    }
+
+    /// Partition that owns cell or node i
+    Uint owner(const Uint i) const
+    {
+      return std::min(static_cast<Uint>((static_cast<boost::uint64_t>(i+1)*nb_parts - 1) / nb_cells), nb_parts-1);
+    }
+
+    Uint nb_cells;
+    Uint nb_parts;
+  };
+
+  /// Global index of the entity at (i, j, k) in a box of pencils, split along i and k but not along j.
+  /// The entities of each pencil are numbered contiguously, in order of the partition rank (x_part*z_parts + z_part),
+  /// so the global indices on a rank form a single range.
+  /// @param ny Number of entities along j
+  /// @param nodes True if (i, j, k) refers to a node, false if it refers to a cell
+  Uint pencil_index(const Partitioning& x, const Partitioning& z, const Uint ny, const bool nodes, const Uint i, const Uint j, const Uint k)
+  {
+    const Uint a = x.owner(i);
+    const Uint b = z.owner(k);
+    const boost::uint64_t nz = z.nb_cells + (nodes ? 1 : 0);
+    const boost::uint64_t offset = (static_cast<boost::uint64_t>(x.begin(a))*nz + static_cast<boost::uint64_t>(x.size(a, nodes))*z.begin(b))*ny;
+    return static_cast<Uint>(offset + (static_cast<boost::uint64_t>(i - x.begin(a))*z.size(b, nodes) + (k - z.begin(b)))*ny + j);
+  }
+
+  /// Mapped coordinate of node i along a graded edge, using the same expansion as BlockArrays
+  Real mapped_coord(const Uint i, const Uint segments, const Real grading)
+  {
+    if(i == 0)
+      return -1.;
+    if(i == segments)
+      return 1.;
+    if(fabs(grading-1.) > 1.e-6)
+    {
+      const Real r = pow(grading, 1. / static_cast<Real>(segments - 1));
+      return 2. * (1. - pow(r, (int)i)) / (1. - grading*r) - 1.;
+    }
+    return 2.*static_cast<Real>(i) / static_cast<Real>(segments) - 1.;
+  }
+
+  /// Boundary faces of the local cells for one patch
+  struct PatchFaces
+  {
+    PatchFaces(const std::string& patch_name, const Uint hexa_face) :
+      name(patch_name),
+      face(hexa_face)
+    {
+    }
+
+    std::string name;
+    Uint face;
+    std::vector<Uint> nodes;
+    std::vector<Uint> ranks;
+    std::vector<Uint> gids;
+  };
+}
+
 ChannelGenerator::ChannelGenerator(const std::string& name): MeshGenerator(name)
 {
   options().add("nb_parts", PE::Comm::instance().size())
@@ -72,6 +167,14 @@ ChannelGenerator::ChannelGenerator(const std::string& name): MeshGenerator(name)
   options().add("grading", 0.2)
     .description("Grading ratio. Values smaller than one refine towards the wall")
     .pretty_name("Grading Ratio");
+
+  options().add("z_parts", 1u)
+    .description("Number of partitions in the Z direction. The number of partitions must be a multiple of this")
+    .pretty_name("Z Partitions");
+
+  options().add("direct", false)
+    .description("Let each rank create only its own partition and overlap, numbering nodes and elements from their structured indices instead of partitioning blocks")
+    .pretty_name("Direct");
 }
 
 void ChannelGenerator::execute()
@@ -91,6 +194,17 @@ void ChannelGenerator::execute()
   const Real width = options().value<Real>("width");
   const Real ratio = options().value<Real>("grading");
 
+  const Uint nb_parts = options().value<Uint>("nb_parts");
+  const Uint z_parts = options().value<Uint>("z_parts");
+  if(z_parts == 0 || nb_parts % z_parts != 0)
+    throw SetupError(FromHere(), "Number of partitions " + to_str(nb_parts) + " is not a multiple of z_parts " + to_str(z_parts) + " in " + uri().path());
+
+  if(options().value<bool>("direct"))
+  {
+    create_direct(*m_mesh);
+    return;
+  }
+
   BlockArrays& blocks = *create_component<BlockArrays>("BlockArrays");
 
   Table<Real>& points = *blocks.create_points(3, 12);
@@ -126,8 +240,6 @@ void ChannelGenerator::execute()
   *blocks.create_patch("left", 2) << 0 << 6 << 8 << 2 << 2 << 8 << 10 << 4;
   *blocks.create_patch("right", 2) << 1 << 3 << 9 << 7 << 3 << 5 << 11 << 9;
 
-  const Uint nb_parts = options().value<Uint>("nb_parts");
-
   Mesh& mesh = *m_mesh;
 
   if(PE::Comm::instance().is_active() && nb_parts > 1)
@@ -136,10 +248,208 @@ void ChannelGenerator::execute()
     blocks.options().set("overlap", cell_overlap);
   }
 
-  blocks.partition_blocks(nb_parts, XX);
+  blocks.partition_blocks(nb_parts / z_parts, XX);
+  if(z_parts > 1)
+    blocks.partition_blocks(z_parts, ZZ);
   blocks.create_mesh(mesh); //--> raises mesh_loaded event inside
 }
 
+void ChannelGenerator::create_direct(Mesh& mesh)
+{
+  const Uint x_segs = options().value<Uint>("x_segments");
+  const Uint y_segs_half = options().value<Uint>("y_segments_half");
+  const Uint z_segs = options().value<Uint>("z_segments");
+  const Uint y_segs = 2*y_segs_half;
+
+  const Real length = options().value<Real>("length");
+  const Real half_height = options().value<Real>("half_height");
+  const Real width = options().value<Real>("width");
+  const Real ratio = options().value<Real>("grading");
+
+  const bool is_parallel = PE::Comm::instance().is_active();
+  const Uint nb_procs = is_parallel ? PE::Comm::instance().size() : 1;
+  const Uint rank = is_parallel ? PE::Comm::instance().rank() : 0;
+
+  const Uint nb_parts = options().value<Uint>("nb_parts");
+  const Uint z_parts = options().value<Uint>("z_parts");
+  const Uint x_parts = nb_parts / z_parts;
+  if(nb_parts != nb_procs)
+    throw SetupError(FromHere(), "Direct generation in " + uri().path() + " needs one partition per process, but nb_parts is " + to_str(nb_parts) + " for " + to_str(nb_procs) + " processes");
+  if(x_segs < x_parts || z_segs < z_parts)
+    throw SetupError(FromHere(), "Channel of " + to_str(x_segs) + "x" + to_str(z_segs) + " segments can't be split in " + to_str(x_parts) + "x" + to_str(z_parts) + " partitions");
+
+  const boost::uint64_t nb_cells = static_cast<boost::uint64_t>(x_segs)*y_segs*z_segs;
+  const boost::uint64_t nb_faces = 2*(static_cast<boost::uint64_t>(x_segs)*z_segs + static_cast<boost::uint64_t>(x_segs)*y_segs + static_cast<boost::uint64_t>(y_segs)*z_segs);
+  const boost::uint64_t nb_nodes = static_cast<boost::uint64_t>(x_segs+1)*(y_segs+1)*(z_segs+1);
+  if(nb_cells + nb_faces > std::numeric_limits<Uint>::max() || nb_nodes > std::numeric_limits<Uint>::max())
+    throw NotSupported(FromHere(), "Channel mesh of " + uri().path() + " has too many entities for 32 bit global indices");
+
+  const detail::Partitioning x_partitioning(x_segs, x_parts);
+  const detail::Partitioning z_partitioning(z_segs, z_parts);
+  const Uint x_part = rank / z_parts;
+  const Uint z_part = rank % z_parts;
+
+  // Cells to create: the owned cells plus cell_overlap layers in X and Z, clamped to the channel
+  const Uint overlap = nb_parts > 1 ? options().value<Uint>("cell_overlap") : 0;
+  const Uint x_begin = x_partitioning.begin(x_part) > overlap ? x_partitioning.begin(x_part) - overlap : 0;
+  const Uint x_end = std::min(x_partitioning.begin(x_part+1) + overlap, x_segs);
+  const Uint z_begin = z_partitioning.begin(z_part) > overlap ? z_partitioning.begin(z_part) - overlap : 0;
+  const Uint z_end = std::min(z_partitioning.begin(z_part+1) + overlap, z_segs);
+
+  // Local node index of the first node of each (i, k) column, owned nodes first
+  const Uint nb_x_nodes = x_end - x_begin + 1;
+  const Uint nb_z_nodes = z_end - z_begin + 1;
+  const Uint nb_y_nodes = y_segs + 1;
+  const Uint nb_owned_nodes = x_partitioning.size(x_part, true)*z_partitioning.size(z_part, true)*nb_y_nodes;
+  const Uint owned_offset = detail::pencil_index(x_partitioning, z_partitioning, nb_y_nodes, true, x_partitioning.begin(x_part), 0, z_partitioning.begin(z_part));
+  std::vector<Uint> column_start(nb_x_nodes*nb_z_nodes);
+  Uint nb_local_nodes = nb_owned_nodes;
+  for(Uint i = x_begin; i <= x_end; ++i)
+  {
+    for(Uint k = z_begin; k <= z_end; ++k)
+    {
+      Uint& start = column_start[(i - x_begin)*nb_z_nodes + k - z_begin];
+      if(x_partitioning.owner(i) == x_part && z_partitioning.owner(k) == z_part)
+      {
+        start = detail::pencil_index(x_partitioning, z_partitioning, nb_y_nodes, true, i, 0, k) - owned_offset;
+      }
+      else
+      {
+        start = nb_local_nodes;
+        nb_local_nodes += nb_y_nodes;
+      }
+    }
+  }
+
+  // Node coordinates along each direction, graded towards the walls in Y
+  std::vector<Real> x_coords(x_segs+1), y_coords(y_segs+1), z_coords(z_segs+1);
+  for(Uint i = 0; i <= x_segs; ++i)
+    x_coords[i] = length * static_cast<Real>(i) / static_cast<Real>(x_segs);
+  for(Uint k = 0; k <= z_segs; ++k)
+    z_coords[k] = width * static_cast<Real>(k) / static_cast<Real>(z_segs);
+  for(Uint j = 0; j <= y_segs_half; ++j)
+  {
+    y_coords[j] = -half_height + 0.5*half_height*(detail::mapped_coord(j, y_segs_half, 1./ratio) + 1.);
+    y_coords[y_segs_half + j] = 0.5*half_height*(detail::mapped_coord(j, y_segs_half, ratio) + 1.);
+  }
+
+  mesh.initialize_nodes(nb_local_nodes, 3);
+  Dictionary& geometry_dict = mesh.geometry_fields();
+  Field& coordinates = geometry_dict.coordinates();
+  common::List<Uint>& node_gids = geometry_dict.glb_idx(); node_gids.resize(nb_local_nodes);
+  common::List<Uint>& node_ranks = geometry_dict.rank(); node_ranks.resize(nb_local_nodes);
+  for(Uint i = x_begin; i <= x_end; ++i)
+  {
+    for(Uint k = z_begin; k <= z_end; ++k)
+    {
+      const Uint start = column_start[(i - x_begin)*nb_z_nodes + k - z_begin];
+      const Uint node_rank = x_partitioning.owner(i)*z_parts + z_partitioning.owner(k);
+      const Uint start_gid = detail::pencil_index(x_partitioning, z_partitioning, nb_y_nodes, true, i, 0, k);
+      for(Uint j = 0; j != nb_y_nodes; ++j)
+      {
+        Field::Row node_coords = coordinates[start + j];
+        node_coords[XX] = x_coords[i];
+        node_coords[YY] = y_coords[j];
+        node_coords[ZZ] = z_coords[k];
+        node_gids[start + j] = start_gid + j;
+        node_ranks[start + j] = node_rank;
+      }
+    }
+  }
+
+  // Patches in the order of the block definition, with the face of the adjacent hexahedron
+  std::vector<detail::PatchFaces> patches;
+  patches.push_back(detail::PatchFaces("bottom", LagrangeP1::Hexa::ETA_NEG));
+  patches.push_back(detail::PatchFaces("top", LagrangeP1::Hexa::ETA_POS));
+  patches.push_back(detail::PatchFaces("front", LagrangeP1::Hexa::ZTA_NEG));
+  patches.push_back(detail::PatchFaces("back", LagrangeP1::Hexa::ZTA_POS));
+  patches.push_back(detail::PatchFaces("left", LagrangeP1::Hexa::KSI_NEG));
+  patches.push_back(detail::PatchFaces("right", LagrangeP1::Hexa::KSI_POS));
+
+  // Face global indices follow the cells, numbered per patch
+  const Uint xz_faces = x_segs*z_segs;
+  const Uint xy_faces = x_segs*y_segs;
+  const detail::Partitioning y_unpartitioned(y_segs, 1);
+  const detail::Partitioning x_unpartitioned(1, 1);
+  const Uint cells_offset = static_cast<Uint>(nb_cells);
+
+  Elements& cells = mesh.topology().create_region("interior").create_elements("cf3.mesh.LagrangeP1.Hexa3D", geometry_dict);
+  cells.resize((x_end - x_begin)*y_segs*(z_end - z_begin));
+  cells.rank().resize(cells.size());
+  cells.glb_idx().resize(cells.size());
+  Connectivity& cell_connectivity = cells.geometry_space().connectivity();
+  const ElementType::FaceConnectivity& hexa_faces = LagrangeP1::Hexa3D::faces();
+  Uint cell_idx = 0;
+  for(Uint i = x_begin; i != x_end; ++i)
+  {
+    for(Uint k = z_begin; k != z_end; ++k)
+    {
+      const Uint cell_rank = x_partitioning.owner(i)*z_parts + z_partitioning.owner(k);
+      const Uint column = (i - x_begin)*nb_z_nodes + k - z_begin;
+      const Uint c00 = column_start[column];
+      const Uint c10 = column_start[column + nb_z_nodes];
+      const Uint c01 = column_start[column + 1];
+      const Uint c11 = column_start[column + nb_z_nodes + 1];
+      for(Uint j = 0; j != y_segs; ++j)
+      {
+        Connectivity::Row nodes = cell_connectivity[cell_idx];
+        nodes[0] = c00 + j;
+        nodes[1] = c10 + j;
+        nodes[2] = c10 + j + 1;
+        nodes[3] = c00 + j + 1;
+        nodes[4] = c01 + j;
+        nodes[5] = c11 + j;
+        nodes[6] = c11 + j + 1;
+        nodes[7] = c01 + j + 1;
+        cells.rank()[cell_idx] = cell_rank;
+        cells.glb_idx()[cell_idx] = detail::pencil_index(x_partitioning, z_partitioning, y_segs, false, i, j, k);
+
+        // Boundary faces, with the global index offset by the cells and the preceding patches
+        bool on_patch[6] = { j == 0, j == y_segs-1, k == 0, k == z_segs-1, i == 0, i == x_segs-1 };
+        Uint face_gids[6];
+        face_gids[0] = cells_offset + detail::pencil_index(x_partitioning, z_partitioning, 1, false, i, 0, k);
+        face_gids[1] = face_gids[0] + xz_faces;
+        face_gids[2] = cells_offset + 2*xz_faces + detail::pencil_index(x_partitioning, y_unpartitioned, 1, false, i, 0, j);
+        face_gids[3] = face_gids[2] + xy_faces;
+        face_gids[4] = cells_offset + 2*xz_faces + 2*xy_faces + detail::pencil_index(x_unpartitioned, z_partitioning, y_segs, false, 0, j, k);
+        face_gids[5] = face_gids[4] + y_segs*z_segs;
+        for(Uint p = 0; p != 6; ++p)
+        {
+          if(!on_patch[p])
+            continue;
+          detail::PatchFaces& patch = patches[p];
+          BOOST_FOREACH(const Uint face_node, hexa_faces.nodes_range(patch.face))
+          {
+            patch.nodes.push_back(nodes[face_node]);
+          }
+          patch.ranks.push_back(cell_rank);
+          patch.gids.push_back(face_gids[p]);
+        }
+        ++cell_idx;
+      }
+    }
+  }
+
+  BOOST_FOREACH(const detail::PatchFaces& patch, patches)
+  {
+    Elements& faces = mesh.topology().create_region(patch.name).create_elements("cf3.mesh.LagrangeP1.Quad3D", geometry_dict);
+    const Uint patch_nb_faces = patch.ranks.size();
+    faces.resize(patch_nb_faces);
+    faces.rank().resize(patch_nb_faces);
+    faces.glb_idx().resize(patch_nb_faces);
+    Connectivity& face_connectivity = faces.geometry_space().connectivity();
+    for(Uint f = 0; f != patch_nb_faces; ++f)
+    {
+      std::copy(patch.nodes.begin() + 4*f, patch.nodes.begin() + 4*(f+1), face_connectivity[f].begin());
+      faces.rank()[f] = patch.ranks[f];
+      faces.glb_idx()[f] = patch.gids[f];
+    }
+  }
+
+  mesh.update_structures();
+  mesh.raise_mesh_loaded();
+}
+
 } // BlockMesh
 } // mesh
 } // cf3
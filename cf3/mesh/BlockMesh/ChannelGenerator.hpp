@@ -25,7 +25,12 @@ namespace BlockMesh {
 
 ////////////////////////////////////////////////////////////////////////////////
 
-/// Generate parallel 3D channels with grading towards the wall
+/// Generate parallel 3D channels with grading towards the wall.
+/// The partitions are pencils along the wall-normal (Y) direction, with z_parts partitions in the Z direction and
+/// nb_parts / z_parts partitions in the X direction.
+/// By default, the mesh is built from two blocks using BlockArrays. If the option "direct" is set, each rank creates only
+/// the nodes and elements of its own pencil and of the cell_overlap layers around it. Global indices and owning ranks
+/// are then computed from the structured (i, j, k) indices, so no global data structure and no communication are needed.
 class BlockMesh_API ChannelGenerator : public MeshGenerator
 {
 public:
@@ -37,6 +42,10 @@ public:
   static std::string type_name () { return "ChannelGenerator"; }
   
   virtual void execute();
+
+private:
+  /// Create the pencil of the current rank directly into the mesh
+  void create_direct(Mesh& mesh);
 };
 
 } // BlockMesh
@@ -421,6 +421,46 @@ void Dictionary::rebuild_map_glb_to_loc()
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void Dictionary::extend_map_glb_to_loc(const Uint first_new_row)
+{
+  cf3_assert(m_glb_to_loc->size() == first_new_row);
+  std::vector< std::pair<boost::uint64_t,Uint> > new_entries;
+  new_entries.reserve(size()-first_new_row);
+  for (Uint n=first_new_row; n<size(); ++n)
+    new_entries.push_back(std::make_pair(glb_idx()[n],n));
+  m_glb_to_loc->merge(new_entries);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace detail
+{
+
+/// Predicate for the map entries of removed rows
+struct IsRemovedRow
+{
+  IsRemovedRow(const std::vector<Uint>& new_idx) : m_new_idx(new_idx) {}
+
+  bool operator()(const std::pair<boost::uint64_t,Uint>& entry) const
+  {
+    return m_new_idx[entry.second] == math::Consts::uint_max();
+  }
+
+  const std::vector<Uint>& m_new_idx;
+};
+
+} // detail
+
+void Dictionary::renumber_map_glb_to_loc(const std::vector<Uint>& new_idx)
+{
+  m_glb_to_loc->erase_if(detail::IsRemovedRow(new_idx));
+  for (common::Map<boost::uint64_t,Uint>::iterator it=m_glb_to_loc->begin(); it!=m_glb_to_loc->end(); ++it)
+    it->second = new_idx[it->second];
+  cf3_assert(m_glb_to_loc->size() == size());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 bool Dictionary::defined_for_entities(const Handle<Entities const>& entities) const
 {
   return ( m_spaces_map.find(entities) != m_spaces_map.end() );
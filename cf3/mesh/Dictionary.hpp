@@ -138,6 +138,13 @@ public: // functions
 
   void rebuild_map_glb_to_loc();
 
+  /// Add the rows from first_new_row on to the glb_to_loc map, which must be up to date for the rows before it
+  void extend_map_glb_to_loc(const Uint first_new_row);
+
+  /// Update the glb_to_loc map after rows were moved, without sorting it again
+  /// @param [in] new_idx  new index of every old row, or math::Consts::uint_max() for removed rows
+  void renumber_map_glb_to_loc(const std::vector<Uint>& new_idx);
+
   void build();
 
   /// @note This is a function only for non-geometry spaces.
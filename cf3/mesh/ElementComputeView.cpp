@@ -0,0 +1,92 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <algorithm>
+#include <limits>
+
+#include "common/BasicExceptions.hpp"
+#include "common/StringConversion.hpp"
+
+#include "mesh/ElementComputeView.hpp"
+#include "mesh/Elements.hpp"
+#include "mesh/Connectivity.hpp"
+#include "mesh/Dictionary.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/Space.hpp"
+
+namespace cf3 {
+namespace mesh {
+
+////////////////////////////////////////////////////////////////////////////////
+
+const Uint ElementComputeView::block_size;
+
+////////////////////////////////////////////////////////////////////////////////
+
+ElementComputeView::ElementComputeView() :
+  m_nb_elements(0),
+  m_nb_blocks(0),
+  m_nb_nodes(0),
+  m_dimension(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ElementComputeView::build(const Elements& elements)
+{
+  const Connectivity& connectivity = elements.geometry_space().connectivity();
+  const Dictionary& geometry = elements.geometry_fields();
+
+  if(geometry.size() > std::numeric_limits<IndexT>::max())
+    throw common::NotSupported(FromHere(), "Compute view of " + elements.uri().path() + " needs 32 bit node indices, but the geometry has " + common::to_str(geometry.size()) + " nodes");
+
+  m_nb_elements = elements.size();
+  m_nb_blocks = (m_nb_elements + block_size - 1) / block_size;
+  m_nb_nodes = connectivity.row_size();
+  m_dimension = geometry.coordinates().row_size();
+
+  m_connectivity.resize(m_nb_blocks*m_nb_nodes*block_size);
+  for(Uint block = 0; block != m_nb_blocks; ++block)
+  {
+    for(Uint lane = 0; lane != block_size; ++lane)
+    {
+      const Uint element = std::min(block*block_size + lane, m_nb_elements - 1);
+      const Connectivity::ConstRow row = connectivity[element];
+      for(Uint n = 0; n != m_nb_nodes; ++n)
+        m_connectivity[(block*m_nb_nodes + n)*block_size + lane] = static_cast<IndexT>(row[n]);
+    }
+  }
+
+  update_coordinates(elements);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ElementComputeView::update_coordinates(const Elements& elements)
+{
+  const Field& coords = elements.geometry_fields().coordinates();
+  cf3_assert(coords.row_size() == m_dimension);
+
+  m_coordinates.resize(m_nb_blocks*m_nb_nodes*m_dimension*block_size);
+  const Uint nb_node_rows = m_nb_blocks*m_nb_nodes;
+  for(Uint node_row = 0; node_row != nb_node_rows; ++node_row)
+  {
+    const IndexT* nodes = &m_connectivity[node_row*block_size];
+    Real* row_coords = &m_coordinates[node_row*m_dimension*block_size];
+    for(Uint lane = 0; lane != block_size; ++lane)
+    {
+      const Field::ConstRow node_coords = coords[nodes[lane]];
+      for(Uint d = 0; d != m_dimension; ++d)
+        row_coords[d*block_size + lane] = node_coords[d];
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // mesh
+} // cf3
@@ -0,0 +1,132 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_mesh_ElementComputeView_hpp
+#define cf3_mesh_ElementComputeView_hpp
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include <vector>
+
+#include <boost/cstdint.hpp>
+
+#include <Eigen/StdVector>
+
+#include "common/Assertions.hpp"
+
+#include "mesh/LibMesh.hpp"
+
+namespace cf3 {
+namespace mesh {
+
+  class Elements;
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Blocked copy of the geometry connectivity and node coordinates of a set of elements
+///
+/// The elements are grouped in blocks of block_size consecutive elements. Within a block, the connectivity is stored node by node,
+/// with the node indices of all elements of the block next to each other, as 32 bit integers. The coordinates of the element nodes are
+/// gathered in the same order, one component at a time, so the coordinate d of node n of all elements in a block is a contiguous
+/// and aligned row of block_size values. Looping over the elements then reads memory sequentially, without the indirection
+/// from the connectivity table to the coordinates field, and kernels can process a block of elements with vector loads.
+/// The last block is padded by repeating the last element.
+///
+/// The view is a copy: it must be rebuilt when the coordinates are changed, i.e. after moving the mesh.
+class Mesh_API ElementComputeView
+{
+public:
+  /// Number of elements in a block
+  static const Uint block_size = 4;
+
+  typedef boost::uint32_t IndexT;
+  typedef std::vector<Real, Eigen::aligned_allocator<Real> > CoordinatesT;
+
+  ElementComputeView();
+
+  /// Build the view from the geometry space of the given elements
+  void build(const Elements& elements);
+
+  /// Gather the coordinates again, keeping the connectivity
+  void update_coordinates(const Elements& elements);
+
+  /// Number of elements, excluding the padding
+  Uint nb_elements() const { return m_nb_elements; }
+
+  /// Number of blocks
+  Uint nb_blocks() const { return m_nb_blocks; }
+
+  /// Number of nodes per element
+  Uint nb_nodes() const { return m_nb_nodes; }
+
+  /// Number of coordinates per node
+  Uint dimension() const { return m_dimension; }
+
+  /// Node indices of the given element node, for all elements of a block
+  const IndexT* connectivity(const Uint block, const Uint node) const
+  {
+    cf3_assert(block < m_nb_blocks && node < m_nb_nodes);
+    return &m_connectivity[(block*m_nb_nodes + node)*block_size];
+  }
+
+  /// Coordinate d of the given element node, for all elements of a block
+  const Real* coordinates(const Uint block, const Uint node, const Uint d) const
+  {
+    cf3_assert(block < m_nb_blocks && node < m_nb_nodes && d < m_dimension);
+    return &m_coordinates[((block*m_nb_nodes + node)*m_dimension + d)*block_size];
+  }
+
+  /// Node index of the given node of an element
+  IndexT node(const Uint element, const Uint node) const
+  {
+    return connectivity(element / block_size, node)[element % block_size];
+  }
+
+  /// Copy the node indices of an element to a row, which must have nb_nodes() entries
+  template<typename RowT>
+  void put_connectivity(const Uint element, RowT& row) const
+  {
+    const Uint block = element / block_size;
+    const Uint lane = element % block_size;
+    for(Uint n = 0; n != m_nb_nodes; ++n)
+      row[n] = connectivity(block, n)[lane];
+  }
+
+  /// Copy the node coordinates of an element to a matrix with one row per node, as done by mesh::fill
+  template<typename MatrixT>
+  void put_coordinates(const Uint element, MatrixT& nodes) const
+  {
+    const Uint block = element / block_size;
+    const Uint lane = element % block_size;
+    const Real* block_coords = &m_coordinates[block*m_nb_nodes*m_dimension*block_size + lane];
+    for(Uint n = 0; n != m_nb_nodes; ++n)
+    {
+      for(Uint d = 0; d != m_dimension; ++d)
+      {
+        nodes(n, d) = *block_coords;
+        block_coords += block_size;
+      }
+    }
+  }
+
+private:
+  Uint m_nb_elements;
+  Uint m_nb_blocks;
+  Uint m_nb_nodes;
+  Uint m_dimension;
+
+  std::vector<IndexT> m_connectivity;
+  CoordinatesT m_coordinates;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // mesh
+} // cf3
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif // cf3_mesh_ElementComputeView_hpp
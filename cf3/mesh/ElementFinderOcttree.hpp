@@ -46,8 +46,6 @@ private:
 
   std::vector<Uint> m_octtree_idx;
 
-  std::vector<Entity> m_elements_pool;
-
   RealMatrix m_coordinates;
 
 
@@ -0,0 +1,91 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+/// @file
+/// @brief Dispatch from the dynamic element type of an Entities block to a statically typed kernel
+///
+/// The concrete type is looked up once for the whole block, after which the kernel can use the
+/// static, fixed-size API of the element type (e.g. LagrangeP1::Triag2D::jacobian_determinant)
+/// for all elements, instead of the virtual ElementType interface with dynamically sized matrices.
+
+#ifndef cf3_mesh_ElementTypeDispatch_hpp
+#define cf3_mesh_ElementTypeDispatch_hpp
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include <boost/mpl/for_each.hpp>
+#include <boost/ref.hpp>
+
+#include "mesh/ElementType.hpp"
+#include "mesh/Entities.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace mesh {
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace detail
+{
+
+/// Calls the functor for the first type of the list that matches the element type of the entities
+template<typename FunctorT>
+struct ElementTypeDispatcher
+{
+  ElementTypeDispatcher(const Entities& entities, FunctorT& functor) :
+    m_entities(entities),
+    m_functor(functor),
+    found(false)
+  {
+  }
+
+  template<typename ETYPE>
+  void operator()(const ETYPE& etype)
+  {
+    if(found || !IsElementType<ETYPE>()(m_entities))
+      return;
+
+    found = true;
+    m_functor(etype, m_entities);
+  }
+
+  const Entities& m_entities;
+  FunctorT& m_functor;
+  bool found;
+};
+
+} // detail
+
+/// Call functor(ETYPE(), entities), with ETYPE the concrete element type of the entities, looked up in ETypesT.
+/// The functor must have a templated operator()(const ETYPE&, const Entities&), which is instantiated for each
+/// type in ETypesT, and is expected to loop over all elements itself.
+/// @return false if the element type of the entities is not in ETypesT, in which case the functor is not called
+template<typename ETypesT, typename FunctorT>
+bool dispatch_element_type(const Entities& entities, FunctorT& functor)
+{
+  detail::ElementTypeDispatcher<FunctorT> dispatcher(entities, functor);
+  boost::mpl::for_each<ETypesT>(boost::ref(dispatcher));
+  return dispatcher.found;
+}
+
+/// Same as dispatch_element_type, but calls functor(entities) if the element type of the entities is not in ETypesT
+/// (e.g. LagrangeP2B, or element types from plugins). That overload must use the virtual ElementType interface.
+template<typename ETypesT, typename FunctorT>
+void dispatch_element_type_with_fallback(const Entities& entities, FunctorT& functor)
+{
+  if(!dispatch_element_type<ETypesT>(entities, functor))
+    functor(entities);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // mesh
+} // cf3
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif // cf3_mesh_ElementTypeDispatch_hpp
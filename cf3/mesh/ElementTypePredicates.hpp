@@ -36,13 +36,13 @@ struct IsCellType
   };
 };
 
-/// Compile-time predicate to determine if the given shape function represents a volume element, i.e. dimensions == dimensionality
+/// Compile-time predicate to determine if the given shape function represents a face element, i.e. dimensions == dimensionality+1
 struct IsFaceType
 {
   template<typename ETYPE>
   struct apply
   {
-    typedef typename boost::mpl::equal_to<boost::mpl::int_<ETYPE::dimension>,boost::mpl::int_<ETYPE::dimensionality> >::type type;
+    typedef typename boost::mpl::equal_to<boost::mpl::int_<ETYPE::dimension>,boost::mpl::int_<ETYPE::dimensionality+1> >::type type;
   };
 };
 
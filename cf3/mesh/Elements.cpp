@@ -14,6 +14,7 @@
 #include "common/PropertyList.hpp"
 
 #include "mesh/Elements.hpp"
+#include "mesh/ElementComputeView.hpp"
 #include "mesh/Connectivity.hpp"
 #include "common/List.hpp"
 #include "mesh/ElementData.hpp"
@@ -33,7 +34,9 @@ common::ComponentBuilder < Elements, Entities, LibMesh > Elements_Builder;
 ////////////////////////////////////////////////////////////////////////////////
 
 Elements::Elements ( const std::string& name ) :
-  Entities ( name )
+  Entities ( name ),
+  m_has_halo_partition(false),
+  m_nb_halo_elements(0)
 {
   properties()["brief"] = std::string("Holds information of elements of one type");
   properties()["description"] = std::string("Container component that stores the element to node connectivity,\n")
@@ -48,5 +51,86 @@ Elements::~Elements()
 
 ////////////////////////////////////////////////////////////////////////////////
 
+namespace
+{
+  /// Returned by halo_first_order() when the partition is out of date
+  const std::vector<Uint> empty_halo_first_order;
+}
+
+bool Elements::has_current_halo_partition() const
+{
+  return m_has_halo_partition && m_halo_first_order.size() == size();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const std::vector<Uint>& Elements::halo_first_order() const
+{
+  return has_current_halo_partition() ? m_halo_first_order : empty_halo_first_order;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Uint Elements::nb_halo_elements() const
+{
+  return has_current_halo_partition() ? m_nb_halo_elements : size();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Elements::update_halo_partition(const std::vector<bool>& shared_nodes)
+{
+  cf3_assert(shared_nodes.size() == geometry_fields().size());
+
+  const Connectivity& connectivity = geometry_space().connectivity();
+  const Uint nb_elems = size();
+  std::vector<Uint> interior_elements;
+  m_halo_first_order.clear();
+  m_halo_first_order.reserve(nb_elems);
+  for(Uint elem = 0; elem != nb_elems; ++elem)
+  {
+    bool is_halo = is_ghost(elem);
+    const Connectivity::ConstRow row = connectivity[elem];
+    for(Connectivity::ConstRow::const_iterator node = row.begin(); !is_halo && node != row.end(); ++node)
+      is_halo = shared_nodes[*node];
+
+    if(is_halo)
+      m_halo_first_order.push_back(elem);
+    else
+      interior_elements.push_back(elem);
+  }
+
+  m_nb_halo_elements = m_halo_first_order.size();
+  m_halo_first_order.insert(m_halo_first_order.end(), interior_elements.begin(), interior_elements.end());
+  m_has_halo_partition = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Elements::clear_halo_partition()
+{
+  m_has_halo_partition = false;
+  std::vector<Uint>().swap(m_halo_first_order);
+  m_nb_halo_elements = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Elements::update_compute_view()
+{
+  if(!has_compute_view())
+    m_compute_view.reset(new ElementComputeView());
+  m_compute_view->build(*this);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Elements::clear_compute_view()
+{
+  m_compute_view.reset();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 } // mesh
 } // cf3
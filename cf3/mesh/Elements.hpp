@@ -10,6 +10,8 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 
+#include <boost/scoped_ptr.hpp>
+
 #include "mesh/Entities.hpp"
 #include "mesh/ElementType.hpp"
 
@@ -21,6 +23,7 @@ namespace cf3 {
 namespace mesh {
 
   class Connectivity;
+  class ElementComputeView;
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -41,6 +44,47 @@ public: // functions
   /// Get the class name
   static std::string type_name () { return "Elements"; }
 
+  /// True if the elements are split into halo and interior elements. This is the case for meshes distributed over more
+  /// than one rank, once the mesh was loaded or changed.
+  bool has_halo_partition() const { return m_has_halo_partition; }
+
+  /// Element indices ordered with the halo elements first. Halo elements are ghosts or have a node that is shared
+  /// with another rank, so looping over them first allows starting communication before the interior elements are done.
+  /// Empty if the number of elements changed since the partition was built. Loops must then visit the elements in their
+  /// plain order, see nb_halo_elements().
+  const std::vector<Uint>& halo_first_order() const;
+
+  /// Number of halo elements at the start of halo_first_order(). If the partition is out of date, all elements count as
+  /// halo elements, so the ranks still visit the same halo and interior passes.
+  Uint nb_halo_elements() const;
+
+  /// Rebuild the halo partition
+  /// @param shared_nodes Flags the geometry nodes that are shared with another rank
+  void update_halo_partition(const std::vector<bool>& shared_nodes);
+
+  /// Remove the halo partition, i.e. for a mesh that is not distributed
+  void clear_halo_partition();
+
+  /// True if a compute view of the geometry was built for these elements
+  bool has_compute_view() const { return m_compute_view.get() != 0; }
+
+  /// Blocked copy of the geometry connectivity and coordinates, see ElementComputeView. Only valid if has_compute_view() is true.
+  const ElementComputeView& compute_view() const { cf3_assert(has_compute_view()); return *m_compute_view; }
+
+  /// Build the compute view, or rebuild it after the connectivity or the coordinates changed
+  void update_compute_view();
+
+  /// Remove the compute view
+  void clear_compute_view();
+
+private:
+  /// True if the halo partition was built for the current number of elements
+  bool has_current_halo_partition() const;
+
+  bool m_has_halo_partition;
+  std::vector<Uint> m_halo_first_order;
+  Uint m_nb_halo_elements;
+  boost::scoped_ptr<ElementComputeView> m_compute_view;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
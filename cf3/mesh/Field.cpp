@@ -180,6 +180,35 @@ void Field::synchronize()
   m_comm_pattern->synchronize( name() );
 }
 
+////////////////////////////////////////////////////////////////////////////////
+
+void Field::synchronize_begin()
+{
+  if(!common::PE::Comm::instance().is_active())
+    return;
+
+  if(is_null(m_comm_pattern))
+  {
+    CFdebug << "Applying default parallelization from dict for field " << uri().path() << CFendl;
+    parallelize();
+  }
+
+  cf3_assert(is_not_null(m_comm_pattern));
+
+  CFdebug << "Starting synchronization of field " << uri().path() << CFendl;
+  m_comm_pattern->synchronize_begin( name() );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Field::synchronize_end()
+{
+  if(is_null(m_comm_pattern))
+    return;
+
+  m_comm_pattern->synchronize_end( name() );
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////
 
 void Field::set_descriptor(math::VariablesDescriptor& descriptor)
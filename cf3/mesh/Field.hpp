@@ -124,6 +124,12 @@ public: // functions
 
   void synchronize();
 
+  /// Start a non-blocking synchronize. The ghost rows are overwritten when synchronize_end is called
+  void synchronize_begin();
+
+  /// Complete a synchronize started with synchronize_begin
+  void synchronize_end();
+
   math::VariablesDescriptor& descriptor() const { return *m_descriptor; }
 
   void set_descriptor(math::VariablesDescriptor& descriptor);
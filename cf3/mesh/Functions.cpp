@@ -4,6 +4,14 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <map>
+
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "common/ConnectionManager.hpp"
+#include "common/Core.hpp"
+#include "common/EventHandler.hpp"
 #include "common/FindComponents.hpp"
 #include "common/List.hpp"
 
@@ -11,6 +19,7 @@
 #include "mesh/Dictionary.hpp"
 #include "mesh/Space.hpp"
 #include "mesh/Entities.hpp"
+#include "mesh/Tags.hpp"
 
 namespace cf3 {
 namespace mesh {
@@ -128,5 +137,137 @@ boost::shared_ptr< common::List< Uint > > build_used_nodes_list( const Component
 
 ////////////////////////////////////////////////////////////////////////////////
 
+namespace detail
+{
+
+/// Used nodes lists that were built before, cleared on each mesh_loaded and mesh_changed event.
+/// Loops may run concurrently (see solver::ActionDirector), so all access to the entries is guarded by a mutex.
+class UsedNodesCache : public common::ConnectionManager
+{
+public:
+  static UsedNodesCache& instance()
+  {
+    static UsedNodesCache cache;
+    return cache;
+  }
+
+  boost::shared_ptr< List<Uint> const > get( const std::vector< Handle<Entities const> >& entities_vector, const Dictionary& dictionary, const bool include_ghost_elems, const bool follow_periodic_links)
+  {
+    Key key;
+    key.dictionary = &dictionary;
+    key.include_ghost_elems = include_ghost_elems;
+    key.follow_periodic_links = follow_periodic_links;
+    key.entities.reserve(entities_vector.size());
+    Uint nb_elems = 0;
+    boost_foreach(const Handle<Entities const>& entities, entities_vector)
+    {
+      key.entities.push_back(entities.get());
+      nb_elems += entities->size();
+    }
+    std::sort(key.entities.begin(), key.entities.end());
+
+    boost::lock_guard<boost::mutex> lock(m_mutex);
+
+    // The components are compared by address, so also check that they still exist and did not change size
+    Entry& entry = m_entries[key];
+    bool valid = is_not_null(entry.nodes) && entry.dictionary.get() == &dictionary && entry.dict_size == dictionary.size() && entry.nb_elems == nb_elems;
+    for(Uint i = 0; valid && i != entry.entities.size(); ++i)
+      valid = is_not_null(entry.entities[i]);
+
+    if(!valid)
+    {
+      entry.nodes = build_used_nodes_list(entities_vector, dictionary, include_ghost_elems, follow_periodic_links);
+      entry.entities = entities_vector;
+      entry.dictionary = dictionary.handle<Dictionary>();
+      entry.dict_size = dictionary.size();
+      entry.nb_elems = nb_elems;
+    }
+
+    return entry.nodes;
+  }
+
+  void clear()
+  {
+    boost::lock_guard<boost::mutex> lock(m_mutex);
+    m_entries.clear();
+  }
+
+private:
+  UsedNodesCache()
+  {
+    Core::instance().event_handler().connect_to_event(mesh::Tags::event_mesh_loaded(), this, &UsedNodesCache::on_mesh_changed_event);
+    Core::instance().event_handler().connect_to_event(mesh::Tags::event_mesh_changed(), this, &UsedNodesCache::on_mesh_changed_event);
+  }
+
+  void on_mesh_changed_event(SignalArgs& args)
+  {
+    clear();
+  }
+
+  struct Key
+  {
+    std::vector<const Entities*> entities;
+    const Dictionary* dictionary;
+    bool include_ghost_elems;
+    bool follow_periodic_links;
+
+    bool operator<(const Key& other) const
+    {
+      if(dictionary != other.dictionary)
+        return dictionary < other.dictionary;
+      if(include_ghost_elems != other.include_ghost_elems)
+        return include_ghost_elems < other.include_ghost_elems;
+      if(follow_periodic_links != other.follow_periodic_links)
+        return follow_periodic_links < other.follow_periodic_links;
+      return entities < other.entities;
+    }
+  };
+
+  struct Entry
+  {
+    Entry() : dict_size(0), nb_elems(0) {}
+
+    boost::shared_ptr< List<Uint> > nodes;
+    std::vector< Handle<Entities const> > entities;
+    Handle<Dictionary const> dictionary;
+    Uint dict_size;
+    Uint nb_elems;
+  };
+
+  std::map<Key, Entry> m_entries;
+  boost::mutex m_mutex;
+};
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+boost::shared_ptr< common::List< Uint > const > cached_used_nodes_list( const std::vector< Handle<Entities const> >& entities, const Dictionary& dictionary, const bool include_ghost_elems, const bool follow_periodic_links)
+{
+  return detail::UsedNodesCache::instance().get(entities, dictionary, include_ghost_elems, follow_periodic_links);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+boost::shared_ptr< common::List< Uint > const > cached_used_nodes_list( const common::Component& node_user, const Dictionary& dictionary, const bool include_ghost_elems, const bool follow_periodic_links)
+{
+  std::vector< Handle<Entities const> > entities_vector;
+  if (Handle<Entities const> entities_h = node_user.handle<Entities>())
+    entities_vector.push_back(entities_h);
+  else
+    entities_vector = range_to_const_vector( find_components_recursively<Entities>(node_user) );
+
+  return cached_used_nodes_list(entities_vector,dictionary,include_ghost_elems, follow_periodic_links);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void clear_used_nodes_cache()
+{
+  detail::UsedNodesCache::instance().clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 } // mesh
 } // cf3
@@ -39,6 +39,22 @@ boost::shared_ptr< common::List< Uint > > build_used_nodes_list( const std::vect
 /// @return used_nodes  List of used nodes
 boost::shared_ptr< common::List< Uint > > build_used_nodes_list( const common::Component& node_user, const Dictionary& dictionary, const bool include_ghost_elems, const bool follow_periodic_links = true);
 
+/// cached_used_nodes_list
+/// @brief Same as build_used_nodes_list, but the list is kept and returned again by subsequent calls with the same arguments.
+/// This avoids the O(dictionary size) cost of building the list for code that is executed each iteration.
+/// All lists are discarded on the mesh_loaded and mesh_changed events, and a list is also rebuilt if the size of the dictionary or
+/// the number of elements changed, or if one of the entities was removed.
+/// @return used_nodes  List of used nodes, shared with other callers, so it must not be modified
+boost::shared_ptr< common::List< Uint > const > cached_used_nodes_list( const std::vector< Handle<Entities const> >& entities, const Dictionary& dictionary, const bool include_ghost_elems, const bool follow_periodic_links = true);
+
+/// cached_used_nodes_list
+/// @brief Same as build_used_nodes_list, but the list is kept and returned again by subsequent calls with the same arguments.
+/// @see cached_used_nodes_list( const std::vector< Handle<Entities const> >&, const Dictionary&, const bool, const bool )
+boost::shared_ptr< common::List< Uint > const > cached_used_nodes_list( const common::Component& node_user, const Dictionary& dictionary, const bool include_ghost_elems, const bool follow_periodic_links = true);
+
+/// Discard all lists stored by cached_used_nodes_list, e.g. after changing the connectivity of a mesh without raising the mesh_changed event
+void clear_used_nodes_cache();
+
 ////////////////////////////////////////////////////////////////////////////////
 
 } // mesh
@@ -81,11 +81,6 @@ private:
 
   static bool is_orientation_inside(const CoordsT& coord, const NodesT& nodes, const Uint face);
 
-  static Eigen::Matrix<Real,nb_nodes,1> m_shapeFunc;
-  static Eigen::Matrix<Real,nb_nodes,dimensionality> m_shapeFuncDerivs;
-  static Eigen::Matrix<Real,dimension,1> m_vec1;
-  static Eigen::Matrix<Real,dimension,1> m_vec2;
-
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -73,6 +73,8 @@ Real scp(const Quad2D::CoordsT& P0, const Quad2D::CoordsT& P1, const Quad2D::Coo
 
 bool Quad2D::is_coord_in_element(const CoordsT& coord, const NodesT& nodes)
 {
+  RealVector2 extent;
+  Real scale;
   // Description found in http://hal.archives-ouvertes.fr/docs/00/12/27/30/PDF/exact_interpolation.pdf
 
   static const Real tolerance = 1e-6;
@@ -87,19 +89,19 @@ bool Quad2D::is_coord_in_element(const CoordsT& coord, const NodesT& nodes)
     return false;
 
 
-  m_D <<
+  extent <<
       nodes.col(XX).maxCoeff()-nodes.col(XX).minCoeff(),
       nodes.col(YY).maxCoeff()-nodes.col(YY).minCoeff();
-  m_scale = 1./m_D.minCoeff();
+  scale = 1./extent.minCoeff();
 
-  if (scp(nodes.row(0),nodes.row(Quad2D::nb_nodes-1),coord,m_scale) * scp(nodes.row(0),coord,nodes.row(1),m_scale) < -tolerance)
+  if (scp(nodes.row(0),nodes.row(Quad2D::nb_nodes-1),coord,scale) * scp(nodes.row(0),coord,nodes.row(1),scale) < -tolerance)
       return false;
   for (Uint i=1; i<Quad2D::nb_nodes-1; ++i)
   {
-    if (scp(nodes.row(i),nodes.row(i-1),coord,m_scale) * scp(nodes.row(i),coord,nodes.row(i+1),m_scale) < -tolerance)
+    if (scp(nodes.row(i),nodes.row(i-1),coord,scale) * scp(nodes.row(i),coord,nodes.row(i+1),scale) < -tolerance)
         return false;
   }
-  if (scp(nodes.row(Quad2D::nb_nodes-1),nodes.row(Quad2D::nb_nodes-2),coord,m_scale) * scp(nodes.row(Quad2D::nb_nodes-1),coord,nodes.row(0),m_scale) < -tolerance)
+  if (scp(nodes.row(Quad2D::nb_nodes-1),nodes.row(Quad2D::nb_nodes-2),coord,scale) * scp(nodes.row(Quad2D::nb_nodes-1),coord,nodes.row(0),scale) < -tolerance)
       return false;
 
   return true;
@@ -108,25 +110,27 @@ bool Quad2D::is_coord_in_element(const CoordsT& coord, const NodesT& nodes)
 
 void Quad2D::compute_mapped_coordinate(const CoordsT& coord, const NodesT& nodes, MappedCoordsT& mapped_coord)
 {
+  RealVector2 extent;
+  Real scale;
 
   // Description found in http://hal.archives-ouvertes.fr/docs/00/12/27/30/PDF/exact_interpolation.pdf
 
-  m_D <<
+  extent <<
       nodes.col(XX).maxCoeff()-nodes.col(XX).minCoeff(),
       nodes.col(YY).maxCoeff()-nodes.col(YY).minCoeff();
-  m_scale = 1./m_D.minCoeff();
+  scale = 1./extent.minCoeff();
 
-  const Real x = coord[XX] * m_scale;
-  const Real y = coord[YY] * m_scale;
+  const Real x = coord[XX] * scale;
+  const Real y = coord[YY] * scale;
 
-  const Real xn1 = nodes(0, XX)  * m_scale ;
-  const Real yn1 = nodes(0, YY)  * m_scale ;
-  const Real xn2 = nodes(1, XX)  * m_scale ;
-  const Real yn2 = nodes(1, YY)  * m_scale ;
-  const Real xn3 = nodes(2, XX)  * m_scale ;
-  const Real yn3 = nodes(2, YY)  * m_scale ;
-  const Real xn4 = nodes(3, XX)  * m_scale ;
-  const Real yn4 = nodes(3, YY)  * m_scale ;
+  const Real xn1 = nodes(0, XX)  * scale ;
+  const Real yn1 = nodes(0, YY)  * scale ;
+  const Real xn2 = nodes(1, XX)  * scale ;
+  const Real yn2 = nodes(1, YY)  * scale ;
+  const Real xn3 = nodes(2, XX)  * scale ;
+  const Real yn3 = nodes(2, YY)  * scale ;
+  const Real xn4 = nodes(3, XX)  * scale ;
+  const Real yn4 = nodes(3, YY)  * scale ;
 
   const Real a0 = 0.25*( (xn1+xn2) + (xn3+xn4) );
   const Real a1 = 0.25*( (xn2-xn1) + (xn3-xn4) );
@@ -349,11 +353,6 @@ void Quad2D::compute_plane_jacobian_normal(const MappedCoordsT& mapped_coord, co
 
 ////////////////////////////////////////////////////////////////////////////////
 
-RealVector2 Quad2D::m_D;
-Real Quad2D::m_scale;
-
-////////////////////////////////////////////////////////////////////////////////
-
 } // LagrangeP1
 } // mesh
 } // cf3
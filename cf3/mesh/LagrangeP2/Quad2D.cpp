@@ -24,9 +24,6 @@ namespace LagrangeP2 {
 
 ////////////////////////////////////////////////////////////////////////////////
 
-Eigen::Matrix<Real,Quad2D::nb_nodes,1> Quad2D::m_shapeFunc;
-Eigen::Matrix<Real,Quad2D::nb_nodes,Quad2D::dimensionality> Quad2D::m_shapeFuncDerivs;
-
 common::ComponentBuilder < ElementTypeT<Quad2D>, ElementType , LibLagrangeP2 >
    Quad2D_Builder(LibLagrangeP2::library_namespace()+"."+Quad2D::type_name());
 
@@ -109,6 +106,7 @@ Real Quad2D::jacobian_determinant(const MappedCoordsT& mapped_coord, const Nodes
 template <>
 void Quad2D::compute_jacobian<Quad2D::JacobianT>(const MappedCoordsT& mapped_coord, const NodesT& nodes, JacobianT& result)
 {
+  Eigen::Matrix<Real,nb_nodes,dimensionality> shape_func_derivs;
   // get mapped coordinates
 
   const Real ksi = mapped_coord[KSI];
@@ -121,35 +119,35 @@ void Quad2D::compute_jacobian<Quad2D::JacobianT>(const MappedCoordsT& mapped_coo
   const Real ksi_eta2 = ksi*eta2;
 
   // set shape function derivatives
-  m_shapeFuncDerivs(0,KSI) =  0.25 * (eta - 2.*ksi_eta - eta2 + 2.*ksi_eta2);
-  m_shapeFuncDerivs(1,KSI) = -0.25 * (eta + 2.*ksi_eta - eta2 - 2.*ksi_eta2);
-  m_shapeFuncDerivs(2,KSI) =  0.25 * (eta + 2.*ksi_eta + eta2 + 2.*ksi_eta2);
-  m_shapeFuncDerivs(3,KSI) = -0.25 * (eta - 2.*ksi_eta + eta2 - 2.*ksi_eta2);
-  m_shapeFuncDerivs(4,KSI) = -0.5  * (-2.*ksi_eta + 2.*ksi_eta2);
-  m_shapeFuncDerivs(5,KSI) =  0.5  * (1. - eta2 + 2.*ksi - 2.*ksi_eta2);
-  m_shapeFuncDerivs(6,KSI) =  0.5  * (-2.*ksi_eta - 2.*ksi_eta2);
-  m_shapeFuncDerivs(7,KSI) = -0.5  * (1. - eta2 - 2.*ksi + 2.*ksi_eta2);
-  m_shapeFuncDerivs(8,KSI) =  2.*ksi_eta2 - 2.*ksi;
-
-  m_shapeFuncDerivs(0,ETA) =  0.25 * (ksi - ksi2 - 2.*ksi_eta + 2.*ksi2_eta);
-  m_shapeFuncDerivs(1,ETA) = -0.25 * (ksi + ksi2 - 2.*ksi_eta - 2.*ksi2_eta);
-  m_shapeFuncDerivs(2,ETA) =  0.25 * (ksi + ksi2 + 2.*ksi_eta + 2.*ksi2_eta);
-  m_shapeFuncDerivs(3,ETA) = -0.25 * (ksi - ksi2 + 2.*ksi_eta - 2.*ksi2_eta);
-  m_shapeFuncDerivs(4,ETA) = -0.5 * (1. - ksi2 - 2.*eta + 2.*ksi2_eta);
-  m_shapeFuncDerivs(5,ETA) =  0.5 * (-2.*ksi_eta - 2.*ksi2_eta);
-  m_shapeFuncDerivs(6,ETA) =  0.5 * (1. - ksi2 + 2.*eta - 2.*ksi2_eta);
-  m_shapeFuncDerivs(7,ETA) = -0.5 * (-2.*ksi_eta + 2.*ksi2_eta);
-  m_shapeFuncDerivs(8,ETA) =  2.*ksi2_eta - 2.*eta;
+  shape_func_derivs(0,KSI) =  0.25 * (eta - 2.*ksi_eta - eta2 + 2.*ksi_eta2);
+  shape_func_derivs(1,KSI) = -0.25 * (eta + 2.*ksi_eta - eta2 - 2.*ksi_eta2);
+  shape_func_derivs(2,KSI) =  0.25 * (eta + 2.*ksi_eta + eta2 + 2.*ksi_eta2);
+  shape_func_derivs(3,KSI) = -0.25 * (eta - 2.*ksi_eta + eta2 - 2.*ksi_eta2);
+  shape_func_derivs(4,KSI) = -0.5  * (-2.*ksi_eta + 2.*ksi_eta2);
+  shape_func_derivs(5,KSI) =  0.5  * (1. - eta2 + 2.*ksi - 2.*ksi_eta2);
+  shape_func_derivs(6,KSI) =  0.5  * (-2.*ksi_eta - 2.*ksi_eta2);
+  shape_func_derivs(7,KSI) = -0.5  * (1. - eta2 - 2.*ksi + 2.*ksi_eta2);
+  shape_func_derivs(8,KSI) =  2.*ksi_eta2 - 2.*ksi;
+
+  shape_func_derivs(0,ETA) =  0.25 * (ksi - ksi2 - 2.*ksi_eta + 2.*ksi2_eta);
+  shape_func_derivs(1,ETA) = -0.25 * (ksi + ksi2 - 2.*ksi_eta - 2.*ksi2_eta);
+  shape_func_derivs(2,ETA) =  0.25 * (ksi + ksi2 + 2.*ksi_eta + 2.*ksi2_eta);
+  shape_func_derivs(3,ETA) = -0.25 * (ksi - ksi2 + 2.*ksi_eta - 2.*ksi2_eta);
+  shape_func_derivs(4,ETA) = -0.5 * (1. - ksi2 - 2.*eta + 2.*ksi2_eta);
+  shape_func_derivs(5,ETA) =  0.5 * (-2.*ksi_eta - 2.*ksi2_eta);
+  shape_func_derivs(6,ETA) =  0.5 * (1. - ksi2 + 2.*eta - 2.*ksi2_eta);
+  shape_func_derivs(7,ETA) = -0.5 * (-2.*ksi_eta + 2.*ksi2_eta);
+  shape_func_derivs(8,ETA) =  2.*ksi2_eta - 2.*eta;
 
   // evaluate Jacobian
   result.setZero();
   for (Uint n = 0; n < 9; ++n)
   {
-    result(KSI,XX) += m_shapeFuncDerivs(n,KSI)*nodes(n,XX);
-    result(ETA,XX) += m_shapeFuncDerivs(n,ETA)*nodes(n,XX);
+    result(KSI,XX) += shape_func_derivs(n,KSI)*nodes(n,XX);
+    result(ETA,XX) += shape_func_derivs(n,ETA)*nodes(n,XX);
 
-    result(KSI,YY) += m_shapeFuncDerivs(n,KSI)*nodes(n,YY);
-    result(ETA,YY) += m_shapeFuncDerivs(n,ETA)*nodes(n,YY);
+    result(KSI,YY) += shape_func_derivs(n,KSI)*nodes(n,YY);
+    result(ETA,YY) += shape_func_derivs(n,ETA)*nodes(n,YY);
   }
 }
 
@@ -177,6 +175,7 @@ Quad2D::CoordsT Quad2D::plane_jacobian_normal(const CoordsT& mapped_coords,
 
 void Quad2D::compute_plane_jacobian_normal(const MappedCoordsT& mapped_coord, const NodesT& nodes, const CoordRef orientation, CoordsT& result)
 {
+  Eigen::Matrix<Real,nb_nodes,1> shape_func;
   // get mapped coordinates
   const Real ksi =  mapped_coord[KSI];
   const Real eta = mapped_coord[ETA];
@@ -189,22 +188,22 @@ void Quad2D::compute_plane_jacobian_normal(const MappedCoordsT& mapped_coord, co
     const Real ksi2_eta = ksi2*eta;
 
     /// @note below, the derivatives of shapefunctions are computed, not the shapefunctions themselves
-    m_shapeFunc[0] =  (ksi - ksi2 - 2.*(ksi_eta - ksi2_eta));
-    m_shapeFunc[1] = -(ksi + ksi2 - 2.*(ksi_eta + ksi2_eta));
-    m_shapeFunc[2] =  (ksi + ksi2 + 2.*(ksi_eta + ksi2_eta));
-    m_shapeFunc[3] = -(ksi - ksi2 + 2.*(ksi_eta - ksi2_eta));
-    m_shapeFunc[4] = -2. * (1. - ksi2 - 2.*(eta - ksi2_eta));
-    m_shapeFunc[5] =  4. * (-ksi_eta - ksi2_eta);
-    m_shapeFunc[6] =  2. * (1. - ksi2 + 2.*(eta - ksi2_eta));
-    m_shapeFunc[7] = -4. * (-ksi_eta + ksi2_eta);
-    m_shapeFunc[8] =  8. * (ksi2_eta - eta);
-
-    result[XX] = +nodes(0,YY)*m_shapeFunc[0];
-    result[YY] = -nodes(0,XX)*m_shapeFunc[0];
+    shape_func[0] =  (ksi - ksi2 - 2.*(ksi_eta - ksi2_eta));
+    shape_func[1] = -(ksi + ksi2 - 2.*(ksi_eta + ksi2_eta));
+    shape_func[2] =  (ksi + ksi2 + 2.*(ksi_eta + ksi2_eta));
+    shape_func[3] = -(ksi - ksi2 + 2.*(ksi_eta - ksi2_eta));
+    shape_func[4] = -2. * (1. - ksi2 - 2.*(eta - ksi2_eta));
+    shape_func[5] =  4. * (-ksi_eta - ksi2_eta);
+    shape_func[6] =  2. * (1. - ksi2 + 2.*(eta - ksi2_eta));
+    shape_func[7] = -4. * (-ksi_eta + ksi2_eta);
+    shape_func[8] =  8. * (ksi2_eta - eta);
+
+    result[XX] = +nodes(0,YY)*shape_func[0];
+    result[YY] = -nodes(0,XX)*shape_func[0];
     for (Uint n = 1; n < 9; ++n)
     {
-      result[XX] += nodes(n,YY)*m_shapeFunc[n];
-      result[YY] -= nodes(n,XX)*m_shapeFunc[n];
+      result[XX] += nodes(n,YY)*shape_func[n];
+      result[YY] -= nodes(n,XX)*shape_func[n];
     }
   }
   else
@@ -212,22 +211,22 @@ void Quad2D::compute_plane_jacobian_normal(const MappedCoordsT& mapped_coord, co
     const Real ksi_eta2 = ksi*eta2;
 
     /// @note below, the derivatives of shapefunctions are computed, not the shapefunctions themselves
-    m_shapeFunc[0] =  (eta - eta2 - 2.*(ksi_eta - ksi_eta2));
-    m_shapeFunc[1] = -(eta - eta2 + 2.*(ksi_eta - ksi_eta2));
-    m_shapeFunc[2] =  (eta + eta2 + 2.*(ksi_eta + ksi_eta2));
-    m_shapeFunc[3] = -(eta + eta2 - 2.*(ksi_eta + ksi_eta2));
-    m_shapeFunc[4] = -4. * (-ksi_eta + ksi_eta2);
-    m_shapeFunc[5] =  2. * (1. - eta2 + 2.*(ksi - ksi_eta2));
-    m_shapeFunc[6] =  4. * (-ksi_eta - ksi_eta2);
-    m_shapeFunc[7] = -2. * (1. - eta2 - 2.*(ksi - ksi_eta2));
-    m_shapeFunc[8] =  8. * (ksi_eta2 - ksi);
-
-    result[XX] = -nodes(0,YY)*m_shapeFunc[0];
-    result[YY] = +nodes(0,XX)*m_shapeFunc[0];
+    shape_func[0] =  (eta - eta2 - 2.*(ksi_eta - ksi_eta2));
+    shape_func[1] = -(eta - eta2 + 2.*(ksi_eta - ksi_eta2));
+    shape_func[2] =  (eta + eta2 + 2.*(ksi_eta + ksi_eta2));
+    shape_func[3] = -(eta + eta2 - 2.*(ksi_eta + ksi_eta2));
+    shape_func[4] = -4. * (-ksi_eta + ksi_eta2);
+    shape_func[5] =  2. * (1. - eta2 + 2.*(ksi - ksi_eta2));
+    shape_func[6] =  4. * (-ksi_eta - ksi_eta2);
+    shape_func[7] = -2. * (1. - eta2 - 2.*(ksi - ksi_eta2));
+    shape_func[8] =  8. * (ksi_eta2 - ksi);
+
+    result[XX] = -nodes(0,YY)*shape_func[0];
+    result[YY] = +nodes(0,XX)*shape_func[0];
     for (Uint n = 1; n < 9; ++n)
     {
-      result[XX] -= nodes(n,YY)*m_shapeFunc[n];
-      result[YY] += nodes(n,XX)*m_shapeFunc[n];
+      result[XX] -= nodes(n,YY)*shape_func[n];
+      result[YY] += nodes(n,XX)*shape_func[n];
     }
   }
   result *= 0.25;
@@ -245,6 +244,8 @@ Real scp(const Quad2D::CoordsT& P0, const Quad2D::CoordsT& P1, const Quad2D::Coo
 
 bool Quad2D::is_coord_in_element(const CoordsT& coord, const NodesT& nodes)
 {
+  RealVector2 extent;
+  Real scale;
 
   static const Real tolerance = 1e-6;
 
@@ -258,26 +259,26 @@ bool Quad2D::is_coord_in_element(const CoordsT& coord, const NodesT& nodes)
     return false;
 
 
-  m_D <<
+  extent <<
       nodes.col(XX).maxCoeff()-nodes.col(XX).minCoeff(),
       nodes.col(YY).maxCoeff()-nodes.col(YY).minCoeff();
-  m_scale = 1./m_D.minCoeff();
+  scale = 1./extent.minCoeff();
 
-  if (scp(nodes.row(0),nodes.row(7),coord,m_scale) * scp(nodes.row(0),coord,nodes.row(4),m_scale) < -tolerance)
+  if (scp(nodes.row(0),nodes.row(7),coord,scale) * scp(nodes.row(0),coord,nodes.row(4),scale) < -tolerance)
       return false;
-  if (scp(nodes.row(4),nodes.row(0),coord,m_scale) * scp(nodes.row(4),coord,nodes.row(1),m_scale) < -tolerance)
+  if (scp(nodes.row(4),nodes.row(0),coord,scale) * scp(nodes.row(4),coord,nodes.row(1),scale) < -tolerance)
       return false;
-  if (scp(nodes.row(1),nodes.row(4),coord,m_scale) * scp(nodes.row(1),coord,nodes.row(5),m_scale) < -tolerance)
+  if (scp(nodes.row(1),nodes.row(4),coord,scale) * scp(nodes.row(1),coord,nodes.row(5),scale) < -tolerance)
       return false;
-  if (scp(nodes.row(5),nodes.row(1),coord,m_scale) * scp(nodes.row(5),coord,nodes.row(2),m_scale) < -tolerance)
+  if (scp(nodes.row(5),nodes.row(1),coord,scale) * scp(nodes.row(5),coord,nodes.row(2),scale) < -tolerance)
       return false;
-  if (scp(nodes.row(2),nodes.row(5),coord,m_scale) * scp(nodes.row(2),coord,nodes.row(6),m_scale) < -tolerance)
+  if (scp(nodes.row(2),nodes.row(5),coord,scale) * scp(nodes.row(2),coord,nodes.row(6),scale) < -tolerance)
       return false;
-  if (scp(nodes.row(6),nodes.row(2),coord,m_scale) * scp(nodes.row(6),coord,nodes.row(3),m_scale) < -tolerance)
+  if (scp(nodes.row(6),nodes.row(2),coord,scale) * scp(nodes.row(6),coord,nodes.row(3),scale) < -tolerance)
       return false;
-  if (scp(nodes.row(3),nodes.row(6),coord,m_scale) * scp(nodes.row(3),coord,nodes.row(7),m_scale) < -tolerance)
+  if (scp(nodes.row(3),nodes.row(6),coord,scale) * scp(nodes.row(3),coord,nodes.row(7),scale) < -tolerance)
       return false;
-  if (scp(nodes.row(7),nodes.row(3),coord,m_scale) * scp(nodes.row(7),coord,nodes.row(0),m_scale) < -tolerance)
+  if (scp(nodes.row(7),nodes.row(3),coord,scale) * scp(nodes.row(7),coord,nodes.row(0),scale) < -tolerance)
       return false;
 
   return true;
@@ -310,11 +311,6 @@ Quad2D::MappedCoordsT Quad2D::mapped_coordinate(const CoordsT& coord, const Node
 
 ////////////////////////////////////////////////////////////////////////////////
 
-RealVector2 Quad2D::m_D;
-Real Quad2D::m_scale;
-
-////////////////////////////////////////////////////////////////////////////////
-
 } // LagrangeP2
 } // mesh
 } // cf3
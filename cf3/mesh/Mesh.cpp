@@ -481,6 +481,8 @@ void Mesh::raise_mesh_loaded()
   update_structures();
   update_statistics();
 
+  clear_caches();
+
   for (Uint dict_idx=0; dict_idx<m_dictionaries.size(); ++dict_idx)
   {
     m_dictionaries[dict_idx]->update_structures();
@@ -488,6 +490,9 @@ void Mesh::raise_mesh_loaded()
     m_dictionaries[dict_idx]->rebuild_node_to_element_connectivity();
   }
 
+  update_halo_partitions();
+  update_compute_views();
+
   check_sanity();
 
   // Raise an event to indicate that this mesh was loaded
@@ -502,6 +507,80 @@ void Mesh::raise_mesh_loaded()
 }
 
 
+////////////////////////////////////////////////////////////////////////////////
+
+void Mesh::clear_caches()
+{
+  for (Uint dict_idx=0; dict_idx<m_dictionaries.size(); ++dict_idx)
+  {
+    std::vector< Handle<Component> > caches;
+    boost_foreach(Component& child, *m_dictionaries[dict_idx])
+    {
+      if(child.has_tag(Tags::cache()))
+        caches.push_back(child.handle());
+    }
+    boost_foreach(const Handle<Component>& cache, caches)
+      m_dictionaries[dict_idx]->remove_component(*cache);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Mesh::update_halo_partitions()
+{
+  if(!PE::Comm::instance().is_active() || PE::Comm::instance().size() == 1)
+  {
+    boost_foreach(Elements& elements, find_components_recursively<Elements>(topology()))
+    {
+      elements.clear_halo_partition();
+    }
+    return;
+  }
+
+  const Dictionary& geometry = geometry_fields();
+  const Uint nb_nodes = geometry.size();
+  std::vector<bool> shared_nodes(nb_nodes, false);
+
+  // Ghost nodes are shared, and their owners are told about them so they can flag their copy
+  std::map< int, std::vector<Uint> > send_gids, recv_gids;
+  for(Uint node = 0; node != nb_nodes; ++node)
+  {
+    if(geometry.is_ghost(node))
+    {
+      shared_nodes[node] = true;
+      send_gids[geometry.rank()[node]].push_back(geometry.glb_idx()[node]);
+    }
+  }
+  PE::Comm::instance().sparse_all_to_all(send_gids, recv_gids);
+
+  const common::Map<boost::uint64_t,Uint>& glb_to_loc = geometry.glb_to_loc();
+  for(std::map< int, std::vector<Uint> >::const_iterator it = recv_gids.begin(); it != recv_gids.end(); ++it)
+  {
+    boost_foreach(const Uint gid, it->second)
+    {
+      common::Map<boost::uint64_t,Uint>::const_iterator found = glb_to_loc.find(gid);
+      if(found != glb_to_loc.end())
+        shared_nodes[found->second] = true;
+    }
+  }
+
+  boost_foreach(Elements& elements, find_components_recursively<Elements>(topology()))
+  {
+    elements.update_halo_partition(shared_nodes);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Mesh::update_compute_views()
+{
+  boost_foreach(Elements& elements, find_components_recursively<Elements>(topology()))
+  {
+    if(elements.has_compute_view())
+      elements.update_compute_view();
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 void Mesh::raise_mesh_changed()
@@ -509,12 +588,17 @@ void Mesh::raise_mesh_changed()
   update_structures();
   update_statistics();
 
+  clear_caches();
+
   for (Uint dict_idx=0; dict_idx<m_dictionaries.size(); ++dict_idx)
   {
     m_dictionaries[dict_idx]->rebuild_map_glb_to_loc();
     m_dictionaries[dict_idx]->rebuild_node_to_element_connectivity();
   }
 
+  update_halo_partitions();
+  update_compute_views();
+
   check_sanity();
 
   // Raise an event to indicate that this mesh was changed
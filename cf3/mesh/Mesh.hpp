@@ -103,6 +103,18 @@ public: // functions
   const Handle<BoundingBox>& local_bounding_box()  const { return m_local_bounding_box; }
   const Handle<BoundingBox>& global_bounding_box() const { return m_global_bounding_box; }
 
+  /// Rebuild the existing compute views of the elements, see Elements::compute_view()
+  /// Actions that move the nodes without raising the mesh changed event must call this, as done by actions::Translate and actions::Rotate
+  void update_compute_views();
+
+private: // functions
+
+  /// Remove the components tagged with Tags::cache() from the dictionaries, since they depend on the old mesh
+  void clear_caches();
+
+  /// Split the elements into halo and interior elements, see Elements::halo_first_order()
+  void update_halo_partitions();
+
 private: // data
 
   Uint m_dimension;
@@ -4,10 +4,14 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <algorithm>
+#include <map>
 #include <set>
 #include <mpi.h>
 #include <boost/algorithm/string/replace.hpp>
 #include <boost/tokenizer.hpp>
+#include <boost/tuple/tuple.hpp>
+#include <boost/tuple/tuple_comparison.hpp>
 
 #include "common/Log.hpp"
 #include "common/FindComponents.hpp"
@@ -168,6 +172,143 @@ void PackedNode::pack(PE::Buffer& buf)
 ////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
 
+namespace detail
+{
+
+/// Exchange one contiguous buffer per destination rank, with only the ranks that have data to exchange.
+/// Without an active communicator the only rank is 0, which receives what it sends to itself.
+template <typename T>
+void exchange_buffers(const std::map< int, std::vector<T> >& send, std::map< int, std::vector<T> >& recv)
+{
+  if (PE::Comm::instance().is_active())
+  {
+    PE::Comm::instance().sparse_all_to_all(send, recv);
+  }
+  else
+  {
+    recv.clear();
+    typename std::map< int, std::vector<T> >::const_iterator self = send.find(0);
+    if (self != send.end() && !self->second.empty())
+      recv[0] = self->second;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Spaces of the entities indexed by dictionary, so that both sides of an exchange agree on their order
+std::vector< Handle<Space> > spaces_by_dict(const Entities& entities, const Uint nb_dicts)
+{
+  std::vector< Handle<Space> > spaces(nb_dicts);
+  boost_foreach (const Handle<Space>& space, entities.spaces())
+    spaces[space->dict_idx()] = space;
+  return spaces;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Check if add_element() or add_node() left rows in the buffers that are not flushed yet
+bool has_buffered_rows(const std::vector< std::set<boost::uint64_t> >& added)
+{
+  boost_foreach (const std::set<boost::uint64_t>& added_rows, added)
+  {
+    if (!added_rows.empty())
+      return true;
+  }
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Find the first arrival of every received global index
+/// @param [in]  received_glb_idx  global indices in order of arrival, possibly with duplicates
+/// @param [out] unique_glb_idx    sorted unique global indices
+/// @param [out] first_arrival     for each unique global index, the position of its first arrival
+void first_arrivals(const std::vector<Uint>& received_glb_idx, std::vector<Uint>& unique_glb_idx, std::vector<Uint>& first_arrival)
+{
+  std::vector< std::pair<Uint,Uint> > sorted(received_glb_idx.size());
+  for (Uint i=0; i<received_glb_idx.size(); ++i)
+    sorted[i] = std::make_pair(received_glb_idx[i], i);
+  std::sort(sorted.begin(), sorted.end());
+
+  unique_glb_idx.clear();
+  first_arrival.clear();
+  for (Uint i=0; i<sorted.size(); ++i)
+  {
+    if (i == 0 || sorted[i].first != sorted[i-1].first)
+    {
+      unique_glb_idx.push_back(sorted[i].first);
+      first_arrival.push_back(sorted[i].second);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Sorted copy of a range of global indices, without duplicates
+std::vector<boost::uint64_t> sorted_unique(const Uint* begin, const Uint* end)
+{
+  std::vector<boost::uint64_t> result(begin, end);
+  std::sort(result.begin(), result.end());
+  result.erase(std::unique(result.begin(), result.end()), result.end());
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Move the kept rows to the front of an array, keeping their order
+/// @param [in] kept_rows  rows to keep, in increasing order
+template <typename ArrayT>
+void compact_rows(ArrayT& array, const std::vector<Uint>& kept_rows)
+{
+  for (Uint row=0; row<kept_rows.size(); ++row)
+  {
+    if (kept_rows[row] != row)
+      array[row] = array[kept_rows[row]];
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Remove the elements that are not flagged to be kept, in one pass that keeps the order of the others
+/// @param [in] keep  flag per element, elements beyond its size are kept
+void compact_entities(Entities& entities, const std::vector<bool>& keep)
+{
+  std::vector<Uint> kept_rows;
+  kept_rows.reserve(entities.size());
+  for (Uint elem=0; elem<entities.size(); ++elem)
+  {
+    if (elem >= keep.size() || keep[elem])
+      kept_rows.push_back(elem);
+  }
+  if (kept_rows.size() == entities.size())
+    return;
+
+  compact_rows(entities.glb_idx().array(), kept_rows);
+  compact_rows(entities.rank().array(), kept_rows);
+  boost_foreach (const Handle<Space>& space, entities.spaces())
+    compact_rows(space->connectivity().array(), kept_rows);
+  entities.resize(kept_rows.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Keep only the given nodes of a dictionary, in one pass that keeps their order
+/// @param [in] kept_rows  nodes to keep, in increasing order
+void compact_dictionary(Dictionary& dict, const std::vector<Uint>& kept_rows)
+{
+  compact_rows(dict.glb_idx().array(), kept_rows);
+  compact_rows(dict.rank().array(), kept_rows);
+  boost_foreach (const Handle<Field>& field, dict.fields())
+    compact_rows(field->array(), kept_rows);
+  dict.resize(kept_rows.size());
+}
+
+} // detail
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+
 MeshAdaptor::MeshAdaptor(mesh::Mesh &mesh)
 {
   has_node_buffers = false;
@@ -256,8 +397,8 @@ void MeshAdaptor::clear_element_buffers()
   element_rank.resize(m_mesh->elements().size());
   element_connected_nodes.resize(m_mesh->elements().size());
 
-  added_elements.resize(m_mesh->elements().size());
   added_elements.clear();
+  added_elements.resize(m_mesh->elements().size());
 
   has_element_buffers = false;
 }
@@ -301,8 +442,8 @@ void MeshAdaptor::clear_node_buffers()
   node_rank.resize(m_mesh->dictionaries().size());
   node_field_values.resize(m_mesh->dictionaries().size());
 
-  added_nodes.resize(m_mesh->dictionaries().size());
   added_nodes.clear();
+  added_nodes.resize(m_mesh->dictionaries().size());
 
   has_node_buffers = false;
 }
@@ -481,7 +622,8 @@ void MeshAdaptor::flush_elements()
           element_connected_nodes[c][s]->flush();
       }
     }
-    added_elements.clear();
+    boost_foreach (std::set<boost::uint64_t>& added, added_elements)
+      added.clear();
     elem_flush_required = false;
     node_elem_connectivity_needs_rebuild = true;
   }
@@ -505,8 +647,9 @@ void MeshAdaptor::flush_nodes()
         if (node_field_values[c][f])
           node_field_values[c][f]->flush();
       }
-      added_nodes.clear();
     }
+    boost_foreach (std::set<boost::uint64_t>& added, added_nodes)
+      added.clear();
     node_flush_required = false;
     node_elem_connectivity_needs_rebuild = true;
     node_glb_to_loc_needs_rebuild = true;
@@ -622,102 +765,156 @@ void MeshAdaptor::send_elements(const std::vector< std::vector< std::vector<Uint
 {
   CFdebug << "MeshAdaptor: send elements" << CFendl;
 
-  cf3_assert(exported_elements_loc_id.size() == PE::Comm::instance().size());
+  const Uint nb_procs = PE::Comm::instance().size();
+  cf3_assert(exported_elements_loc_id.size() == nb_procs);
   const Uint nb_dicts = m_mesh->dictionaries().size();
   const Uint nb_entities = m_mesh->elements().size();
-  rebuild_node_glb_to_loc_map();
-  for (Uint dict_idx=0; dict_idx<nb_dicts; ++dict_idx)
-  {
-    Dictionary& dict = *m_mesh->dictionaries()[dict_idx];
-    cf3_assert(dict.glb_to_loc().size() == dict.size());
-  }
-
-  // Declaration of send/receive buffers
-  PE::Buffer send_buffer, receive_buffer;
 
   // Element-node connectivity tables must be GLOBAL
   make_element_node_connectivity_global();
 
-  // 1) Sending elements, and building nodes_to_send change set
-  for (Uint pid=0; pid<PE::Comm::instance().size(); ++pid)
+  // Layout of the elements of one Entities in a buffer: the number of elements, their global indices,
+  // their ranks, and then per dictionary the connectivity of the elements
+  std::vector< std::vector< Handle<Space> > > spaces(nb_entities);
+  std::vector<Uint> row_size(nb_entities);
+  for (Uint entities_idx=0; entities_idx<nb_entities; ++entities_idx)
   {
-    // Mark in the buffer that following will be sent to a new processor
-    send_buffer.mark_pid_start();
-
-    cf3_assert(exported_elements_loc_id[pid].size() == m_mesh->elements().size());
-    for (Uint entities_idx=0; entities_idx<m_mesh->elements().size(); ++entities_idx)
+    spaces[entities_idx] = detail::spaces_by_dict(*m_mesh->elements()[entities_idx], nb_dicts);
+    row_size[entities_idx] = 2;
+    boost_foreach (const Handle<Space>& space, spaces[entities_idx])
     {
+      if (is_not_null(space))
+        row_size[entities_idx] += space->connectivity().row_size();
+    }
+  }
 
-      Entities& entities = *m_mesh->elements()[entities_idx];
+  // 1) Pack all elements for one destination in one contiguous buffer
+  std::map< int, std::vector<Uint> > send_buffers, receive_buffers;
+  for (Uint pid=0; pid<nb_procs; ++pid)
+  {
+    cf3_assert(exported_elements_loc_id[pid].size() == nb_entities);
+    Uint buffer_size = 0;
+    for (Uint entities_idx=0; entities_idx<nb_entities; ++entities_idx)
+      buffer_size += exported_elements_loc_id[pid][entities_idx].size() * row_size[entities_idx];
+    if (buffer_size == 0)
+      continue;
 
-      boost_foreach (const Uint loc_elem_idx, exported_elements_loc_id[pid][entities_idx])
+    std::vector<Uint>& buffer = send_buffers[pid];
+    buffer.reserve(buffer_size + nb_entities);
+    for (Uint entities_idx=0; entities_idx<nb_entities; ++entities_idx)
+    {
+      const Entities& entities = *m_mesh->elements()[entities_idx];
+      const std::vector<Uint>& elems = exported_elements_loc_id[pid][entities_idx];
+      buffer.push_back(elems.size());
+      boost_foreach (const Uint elem, elems)
+        buffer.push_back(entities.glb_idx()[elem]);
+      boost_foreach (const Uint elem, elems)
+        buffer.push_back(entities.rank()[elem]);
+      boost_foreach (const Handle<Space>& space, spaces[entities_idx])
       {
-        // Pack element in buffer to send
-        PackedElement packed_elem(*m_mesh, entities_idx, loc_elem_idx );
-        send_buffer << packed_elem;
+        if (is_null(space))
+          continue;
+        const Connectivity& connectivity = space->connectivity();
+        boost_foreach (const Uint elem, elems)
+          buffer.insert(buffer.end(), connectivity[elem].begin(), connectivity[elem].end());
       }
     }
   }
 
-  //////PECheckArrivePoint(100,"Send/receive elements");
-
-  // Send/Receive the elements.
-  send_buffer.all_to_all(receive_buffer);
+  // Send/Receive the elements, only to and from the ranks that have elements to exchange
+  detail::exchange_buffers(send_buffers, receive_buffers);
+  send_buffers.clear();
 
-  // 2) Add the elements
+  // Rows added through add_element() would be lost when resizing the tables directly
+  if (detail::has_buffered_rows(added_elements))
+    flush_elements();
 
-  std::set< boost::uint64_t > mesh_elems;
-  boost_foreach (const Handle<Entities>& entities, m_mesh->elements())
+  // Start of the data of each Entities in the received buffers
+  typedef std::map< int, std::vector<Uint> >::const_iterator BufferIterator;
+  std::map< int, std::vector<Uint> > entities_begin;
+  for (BufferIterator it=receive_buffers.begin(); it!=receive_buffers.end(); ++it)
   {
-    boost_foreach (const boost::uint64_t glb_elem, entities->glb_idx().array())
+    std::vector<Uint>& begin = entities_begin[it->first];
+    begin.resize(nb_entities);
+    Uint pos = 0;
+    for (Uint entities_idx=0; entities_idx<nb_entities; ++entities_idx)
     {
-      mesh_elems.insert(glb_elem);
+      begin[entities_idx] = pos;
+      pos += 1 + it->second[pos] * row_size[entities_idx];
     }
+    cf3_assert(pos == it->second.size());
   }
 
-  // Unpack elements from the receive_buffer on the receiving side
-  std::vector< std::vector< std::set<boost::uint64_t> > > received_glb_elements_pid(PE::Comm::instance().size(), std::vector< std::set<boost::uint64_t> >(m_mesh->elements().size()));
-
-  // Scope this
+  // 2) Append the elements that are new to this rank, per Entities in one resize
+  imported_elements_glb_id.assign(nb_procs, std::vector< std::vector<boost::uint64_t> >(nb_entities));
+  for (Uint entities_idx=0; entities_idx<nb_entities; ++entities_idx)
   {
-    PackedElement unpacked_elem(*m_mesh);
-    Uint recv_pid=0;
-    cf3_assert(receive_buffer.size() == receive_buffer.displs().back()+receive_buffer.strides().back());
-    while (receive_buffer.more_to_unpack())
-    {
-      cf3_assert(receive_buffer.displs().size() == PE::Comm::instance().size());
-      cf3_assert(receive_buffer.strides().size() == PE::Comm::instance().size());
-      cf3_assert(recv_pid < PE::Comm::instance().size());
-      cf3_assert(receive_buffer.unpacked_idx() <= receive_buffer.displs()[recv_pid] + receive_buffer.strides()[recv_pid]);
-      if (receive_buffer.unpacked_idx() == receive_buffer.displs()[recv_pid] + receive_buffer.strides()[recv_pid])
-      {
-        do { ++recv_pid; } while(receive_buffer.strides()[recv_pid]==0);
-      }
-      cf3_assert(receive_buffer.strides().size() == PE::Comm::instance().size());
-      cf3_assert(receive_buffer.displs().size()  == PE::Comm::instance().size());
-      cf3_assert(recv_pid<receive_buffer.strides().size());
-      receive_buffer >> unpacked_elem;
+    Entities& entities = *m_mesh->elements()[entities_idx];
 
-      received_glb_elements_pid[recv_pid][unpacked_elem.entities_idx()].insert( unpacked_elem.glb_idx() );
+    std::vector<Uint> received_glb_idx;
+    for (BufferIterator it=receive_buffers.begin(); it!=receive_buffers.end(); ++it)
+    {
+      const Uint* block = &it->second[entities_begin[it->first][entities_idx]];
+      const Uint nb_elems = block[0];
+      received_glb_idx.insert(received_glb_idx.end(), block+1, block+1+nb_elems);
+      imported_elements_glb_id[it->first][entities_idx] = detail::sorted_unique(block+1, block+1+nb_elems);
+    }
+    if (received_glb_idx.empty())
+      continue;
 
-      if (mesh_elems.count(unpacked_elem.glb_idx()) == 0)
-        add_element(unpacked_elem);
+    // An element is added once, and only if it is not present yet
+    std::vector<Uint> unique_glb_idx, first_arrival;
+    detail::first_arrivals(received_glb_idx, unique_glb_idx, first_arrival);
+    std::vector<bool> present(unique_glb_idx.size(), false);
+    boost_foreach (const Uint glb_elem, entities.glb_idx().array())
+    {
+      std::vector<Uint>::const_iterator found = std::lower_bound(unique_glb_idx.begin(), unique_glb_idx.end(), glb_elem);
+      if (found != unique_glb_idx.end() && *found == glb_elem)
+        present[found-unique_glb_idx.begin()] = true;
     }
-  }
+    std::vector<bool> add(received_glb_idx.size(), false);
+    Uint nb_added = 0;
+    for (Uint i=0; i<unique_glb_idx.size(); ++i)
+    {
+      if (!present[i])
+      {
+        add[first_arrival[i]] = true;
+        ++nb_added;
+      }
+    }
+    if (nb_added == 0)
+      continue;
 
-  // Fill imported_elements_glb_id
-  imported_elements_glb_id.resize(PE::Comm::instance().size(), std::vector< std::vector<boost::uint64_t> >(nb_entities));
-  for (Uint pid=0; pid<PE::Comm::instance().size(); ++pid)
-  {
-    for (Uint entities_idx=0; entities_idx<nb_entities; ++entities_idx)
+    Uint elem = entities.size();
+    entities.resize(elem+nb_added);
+    Uint arrival = 0;
+    for (BufferIterator it=receive_buffers.begin(); it!=receive_buffers.end(); ++it)
     {
-      imported_elements_glb_id[pid][entities_idx].clear();
-      imported_elements_glb_id[pid][entities_idx].reserve(received_glb_elements_pid[pid][entities_idx].size());
-      boost_foreach (const boost::uint64_t& glb_elem, received_glb_elements_pid[pid][entities_idx])
+      const Uint* block = &it->second[entities_begin[it->first][entities_idx]];
+      const Uint nb_elems = block[0];
+      const Uint* glb_idx = block+1;
+      const Uint* rank = glb_idx+nb_elems;
+      for (Uint e=0; e<nb_elems; ++e, ++arrival)
       {
-        imported_elements_glb_id[pid][entities_idx].push_back(glb_elem);
+        if (!add[arrival])
+          continue;
+        entities.glb_idx()[elem] = glb_idx[e];
+        entities.rank()[elem] = rank[e];
+        const Uint* nodes = rank+nb_elems;
+        boost_foreach (const Handle<Space>& space, spaces[entities_idx])
+        {
+          if (is_null(space))
+            continue;
+          Connectivity& connectivity = space->connectivity();
+          const Uint nb_nodes = connectivity.row_size();
+          std::copy(nodes+e*nb_nodes, nodes+(e+1)*nb_nodes, connectivity[elem].begin());
+          nodes += nb_elems*nb_nodes;
+        }
+        ++elem;
       }
     }
+    cf3_assert(elem == entities.size());
+    node_elem_connectivity_needs_rebuild = true;
   }
 }
 
@@ -728,81 +925,157 @@ void MeshAdaptor::send_nodes(const std::vector< std::vector< std::vector<Uint> >
 {
   CFdebug << "MeshAdaptor: send nodes" << CFendl;
 
+  const Uint nb_procs = PE::Comm::instance().size();
+  cf3_assert(exported_nodes_loc_id.size() == nb_procs);
   const Uint nb_dicts = m_mesh->dictionaries().size();
+
+  // Layout of the nodes in the buffers: per dictionary the number of nodes, their global indices and ranks,
+  // and separately per dictionary and field the values of the nodes
+  std::vector<Uint> values_size(nb_dicts, 0);
   for (Uint dict_idx=0; dict_idx<nb_dicts; ++dict_idx)
   {
-    Dictionary& dict = *m_mesh->dictionaries()[dict_idx];
-    cf3_assert(dict.glb_to_loc().size() == dict.size());
+    boost_foreach (const Handle<Field>& field, m_mesh->dictionaries()[dict_idx]->fields())
+      values_size[dict_idx] += field->row_size();
   }
 
-  // Declaration of send/receive buffers
-  PE::Buffer send_buffer, receive_buffer;
-
-  // 3) Send nodes
-  // Prepare send-buffer to be used again, now for nodes
-
-  for (Uint pid=0; pid<PE::Comm::instance().size(); ++pid)
+  // 3) Pack all nodes for one destination in one buffer of indices and one of values
+  std::map< int, std::vector<Uint> > send_indices, receive_indices;
+  std::map< int, std::vector<Real> > send_values, receive_values;
+  for (Uint pid=0; pid<nb_procs; ++pid)
   {
-    send_buffer.mark_pid_start();
+    cf3_assert(exported_nodes_loc_id[pid].size() == nb_dicts);
+    Uint nb_nodes = 0;
+    Uint nb_values = 0;
     for (Uint dict_idx=0; dict_idx<nb_dicts; ++dict_idx)
     {
-      Dictionary& dict = *m_mesh->dictionaries()[dict_idx];
-      boost_foreach (Uint loc_node, exported_nodes_loc_id[pid][dict_idx])
+      nb_nodes += exported_nodes_loc_id[pid][dict_idx].size();
+      nb_values += exported_nodes_loc_id[pid][dict_idx].size() * values_size[dict_idx];
+    }
+    if (nb_nodes == 0)
+      continue;
+
+    std::vector<Uint>& indices = send_indices[pid];
+    indices.reserve(nb_dicts + 2*nb_nodes);
+    std::vector<Real>& values = send_values[pid];
+    values.reserve(nb_values);
+    for (Uint dict_idx=0; dict_idx<nb_dicts; ++dict_idx)
+    {
+      const Dictionary& dict = *m_mesh->dictionaries()[dict_idx];
+      const std::vector<Uint>& nodes = exported_nodes_loc_id[pid][dict_idx];
+      indices.push_back(nodes.size());
+      boost_foreach (const Uint node, nodes)
+        indices.push_back(dict.glb_idx()[node]);
+      boost_foreach (const Uint node, nodes)
+        indices.push_back(dict.rank()[node]);
+      boost_foreach (const Handle<Field>& field, dict.fields())
       {
-        PackedNode packed_node(*m_mesh,dict_idx,loc_node);
-        send_buffer << packed_node;
+        boost_foreach (const Uint node, nodes)
+          values.insert(values.end(), (*field)[node].begin(), (*field)[node].end());
       }
     }
   }
 
-  //////PECheckArrivePoint(100,"nodes packed");
-
   // Send/Receive buffers
-  send_buffer.all_to_all(receive_buffer);
+  detail::exchange_buffers(send_indices, receive_indices);
+  detail::exchange_buffers(send_values, receive_values);
+  send_indices.clear();
+  send_values.clear();
 
-  //////PECheckArrivePoint(100,"nodes sent/received");
+  // Rows added through add_node() would be lost when resizing the tables directly
+  if (detail::has_buffered_rows(added_nodes))
+    flush_nodes();
+  rebuild_node_glb_to_loc_map();
 
-  // 4) Add nodes on receiving side
-  std::vector< std::vector<std::set<boost::uint64_t> > > received_glb_nodes_pid(PE::Comm::instance().size(),std::vector<std::set<boost::uint64_t> >(nb_dicts));
-  // Scope this
+  // Start of the data of each dictionary in the received buffers
+  typedef std::map< int, std::vector<Uint> >::const_iterator BufferIterator;
+  std::map< int, std::vector<Uint> > dict_begin, dict_values_begin;
+  for (BufferIterator it=receive_indices.begin(); it!=receive_indices.end(); ++it)
   {
-    PackedNode unpacked_node(*m_mesh);
-    Uint recv_pid=0;
-    while (receive_buffer.more_to_unpack())
+    std::vector<Uint>& begin = dict_begin[it->first];
+    std::vector<Uint>& values_begin = dict_values_begin[it->first];
+    begin.resize(nb_dicts);
+    values_begin.resize(nb_dicts);
+    Uint pos = 0;
+    Uint values_pos = 0;
+    for (Uint dict_idx=0; dict_idx<nb_dicts; ++dict_idx)
     {
-      cf3_assert(receive_buffer.unpacked_idx() <= receive_buffer.displs()[recv_pid] + receive_buffer.strides()[recv_pid]);
-      if (receive_buffer.unpacked_idx() == receive_buffer.displs()[recv_pid] + receive_buffer.strides()[recv_pid])
-      {
-        do { ++recv_pid; } while(receive_buffer.strides()[recv_pid]==0);
-      }
-      receive_buffer >> unpacked_node;
+      begin[dict_idx] = pos;
+      values_begin[dict_idx] = values_pos;
+      pos += 1 + 2*it->second[pos];
+      values_pos += it->second[begin[dict_idx]] * values_size[dict_idx];
+    }
+    cf3_assert(pos == it->second.size());
+    cf3_assert(values_pos == receive_values[it->first].size());
+  }
+
+  // 4) Append the nodes that are new to this rank, per dictionary in one resize
+  imported_nodes_glb_id.assign(nb_procs, std::vector< std::vector<boost::uint64_t> >(nb_dicts));
+  for (Uint dict_idx=0; dict_idx<nb_dicts; ++dict_idx)
+  {
+    Dictionary& dict = *m_mesh->dictionaries()[dict_idx];
+    const common::Map<boost::uint64_t,Uint>& glb_to_loc = dict.glb_to_loc();
+    cf3_assert(glb_to_loc.size() == dict.size());
 
-      received_glb_nodes_pid[recv_pid][unpacked_node.dict_idx()].insert( unpacked_node.glb_idx() );
+    std::vector<Uint> received_glb_idx;
+    for (BufferIterator it=receive_indices.begin(); it!=receive_indices.end(); ++it)
+    {
+      const Uint* block = &it->second[dict_begin[it->first][dict_idx]];
+      const Uint nb_nodes = block[0];
+      received_glb_idx.insert(received_glb_idx.end(), block+1, block+1+nb_nodes);
+      imported_nodes_glb_id[it->first][dict_idx] = detail::sorted_unique(block+1, block+1+nb_nodes);
+    }
+    if (received_glb_idx.empty())
+      continue;
 
-      // Component to check if a node is already existing. If so, the unpacked node doesn't need to be added anymore
-      const common::Map<boost::uint64_t,Uint>& glb_to_loc = m_mesh->dictionaries()[unpacked_node.dict_idx()]->glb_to_loc();
-      if (!glb_to_loc.exists(unpacked_node.glb_idx()))
+    // A node is added once, and only if it is not present yet
+    std::vector<Uint> unique_glb_idx, first_arrival;
+    detail::first_arrivals(received_glb_idx, unique_glb_idx, first_arrival);
+    std::vector<bool> add(received_glb_idx.size(), false);
+    Uint nb_added = 0;
+    for (Uint i=0; i<unique_glb_idx.size(); ++i)
+    {
+      if (!glb_to_loc.exists(unique_glb_idx[i]))
       {
-        add_node(unpacked_node);
+        add[first_arrival[i]] = true;
+        ++nb_added;
       }
     }
-  }
-
-  //////PECheckArrivePoint(100,"nodes added");
+    if (nb_added == 0)
+      continue;
 
-  // Fill imported_nodes_glb_id
-  imported_nodes_glb_id.resize(PE::Comm::instance().size(), std::vector< std::vector<boost::uint64_t> >(nb_dicts));
-  for (Uint pid=0; pid<PE::Comm::instance().size(); ++pid)
-  {
-    for (Uint dict_idx=0; dict_idx<nb_dicts; ++dict_idx)
+    const Uint first_added = dict.size();
+    Uint node = first_added;
+    dict.resize(first_added+nb_added);
+    Uint arrival = 0;
+    for (BufferIterator it=receive_indices.begin(); it!=receive_indices.end(); ++it)
     {
-      imported_nodes_glb_id[pid][dict_idx].clear();
-      imported_nodes_glb_id[pid][dict_idx].reserve(received_glb_nodes_pid[pid][dict_idx].size());
-      boost_foreach (const boost::uint64_t& glb_node, received_glb_nodes_pid[pid][dict_idx])
+      const Uint* block = &it->second[dict_begin[it->first][dict_idx]];
+      const Uint nb_nodes = block[0];
+      const Uint* glb_idx = block+1;
+      const Uint* rank = glb_idx+nb_nodes;
+      const std::vector<Real>& values = receive_values[it->first];
+      for (Uint n=0; n<nb_nodes; ++n, ++arrival)
       {
-        imported_nodes_glb_id[pid][dict_idx].push_back(glb_node);
+        if (!add[arrival])
+          continue;
+        dict.glb_idx()[node] = glb_idx[n];
+        dict.rank()[node] = rank[n];
+        Uint values_pos = dict_values_begin[it->first][dict_idx];
+        boost_foreach (const Handle<Field>& field, dict.fields())
+        {
+          const Uint row_size = field->row_size();
+          const Real* row = &values[0] + values_pos + n*row_size;
+          std::copy(row, row+row_size, (*field)[node].begin());
+          values_pos += nb_nodes*row_size;
+        }
+        ++node;
       }
     }
+    cf3_assert(node == dict.size());
+
+    // The map stays valid for the existing nodes, so only the added ones are merged in
+    dict.extend_map_glb_to_loc(first_added);
+    node_elem_connectivity_needs_rebuild = true;
   }
 }
 
@@ -846,197 +1119,109 @@ void MeshAdaptor::move_elements(const std::vector< std::vector< std::vector<Uint
   cf3_assert(exported_elements_loc_id.size() == PE::Comm::instance().size());
 
   // Procedure:
-  // 0) mark elements for removal
-  // 1) send elements in meantime building a set of nodes_to_send
-  // 2) add/remove elements, flush elements
-  // 3) send nodes
-  // 4) add nodes
-  // 5) flush nodes
-  // 6) remove unused nodes
-  // 7) flush nodes, rebuild glb_to_local node map
-  // 8) fix rank of nodes: lowest rank that is found is assigned
+  // 1) change rank of elements to where they need to be moved, and flag them for removal
+  // 2) find the nodes of the moved elements
+  // 3) send elements and nodes, which are appended on the receiving side
+  // 4) remove moved elements, in one pass per Entities
+  // 5) remove unused nodes, in one pass per dictionary
+  // 6) fix rank of nodes: lowest rank that is found is assigned
 
   const Uint nb_dicts = m_mesh->dictionaries().size();
   const Uint nb_entities = m_mesh->elements().size();
+  const Uint my_rank = PE::Comm::instance().rank();
+
+  // Changes given through the elementary operations are applied first,
+  // as the tables are modified directly from here on
+  flush_elements();
+  flush_nodes();
 
   // 1) - Change rank of elements to where they need to be moved,
-  //    - Mark elements for removal
+  //    - Flag elements for removal
+  std::vector< std::vector<bool> > keep_element(nb_entities);
+  for (Uint entities_idx=0; entities_idx<nb_entities; ++entities_idx)
+    keep_element[entities_idx].assign(m_mesh->elements()[entities_idx]->size(), true);
+
   for (Uint pid=0; pid<PE::Comm::instance().size(); ++pid)
   {
-    cf3_assert(exported_elements_loc_id[pid].size() == m_mesh->elements().size());
-    for (Uint entities_idx=0; entities_idx<m_mesh->elements().size(); ++entities_idx)
+    if (pid == my_rank)
+      continue;
+    cf3_assert(exported_elements_loc_id[pid].size() == nb_entities);
+    for (Uint entities_idx=0; entities_idx<nb_entities; ++entities_idx)
     {
       Entities& entities = *m_mesh->elements()[entities_idx];
 
       boost_foreach (const Uint loc_elem_idx, exported_elements_loc_id[pid][entities_idx])
       {
-        // Change rank to where it needs to be moved
         entities.rank()[loc_elem_idx] = pid;
-
-        // Mark element for removal
-        remove_element(entities_idx,loc_elem_idx);
+        keep_element[entities_idx][loc_elem_idx] = false;
       }
     }
   }
 
-  ////PECheckArrivePoint(100,"Sending elements");
-
-  // 2) send elements and nodes belonging to the elements
-  std::vector< std::vector< std::vector<boost::uint64_t> > > imported_elements_glb_id;
-  send_elements(exported_elements_loc_id,imported_elements_glb_id);
-
-
-  ////PECheckArrivePoint(100,"Finding nodes to export");
+  // 2) Find nodes to send along, while the connectivity is still local
   std::vector< std::vector< std::vector<Uint> > > exported_nodes_loc_id;
   find_nodes_to_export(exported_elements_loc_id,exported_nodes_loc_id);
 
-//  if (nb_dicts==2)
-//  {
-//    PEProcessSortedExecute(-1,
-//    for (Uint pid=0; pid<PE::Comm::instance().size(); ++pid)
-//    {
-//      if (pid != PE::Comm::instance().rank())
-//      {
-//        for (Uint entities_idx=0; entities_idx<nb_entities; ++entities_idx)
-//        {
-//          std::vector<Uint> exported_glb_elems; exported_glb_elems.reserve(exported_elements_loc_id[pid][entities_idx].size());
-//          boost_foreach (const Uint elem, exported_elements_loc_id[pid][entities_idx] )
-//          {
-//            exported_glb_elems.push_back( m_mesh->elements()[entities_idx]->glb_idx()[elem]+1 );
-//          }
-//          std::cout << PERank << m_mesh->elements()[entities_idx]->uri() << "  :  " << to_str(exported_glb_elems) << std::endl;
-//        }
-//      }
-//    }
-
-//    for (Uint pid=0; pid<PE::Comm::instance().size(); ++pid)
-//    {
-//      if (pid != PE::Comm::instance().rank())
-//      {
-//        std::vector<Real> exported_glb_nodes; exported_glb_nodes.reserve(exported_nodes_loc_id[pid][1].size());
-//        boost_foreach (const Uint node, exported_nodes_loc_id[pid][1] )
-//        {
-//          exported_glb_nodes.push_back( m_mesh->dictionaries()[1]->field("glb_elem")[node][0] );
-//        }
-//        std::cout << PERank << to_str(exported_glb_nodes) << std::endl;
-//      }
-//    }
-//    )
-//  }
-
-
-
-  ////PECheckArrivePoint(100,"Sending nodes");
+  // 3) Send elements and nodes
+  std::vector< std::vector< std::vector<boost::uint64_t> > > imported_elements_glb_id;
+  send_elements(exported_elements_loc_id,imported_elements_glb_id);
 
   std::vector< std::vector< std::vector<boost::uint64_t> > > imported_nodes_glb_id;
   send_nodes(exported_nodes_loc_id,imported_nodes_glb_id);
 
-  flush_elements();
-
-  // 6) Remove unused nodes
-  ////PECheckArrivePoint(100,"removing unused nodes");
+  // 4) Remove moved elements. Received elements were appended, and are kept.
+  for (Uint entities_idx=0; entities_idx<nb_entities; ++entities_idx)
+    detail::compact_entities(*m_mesh->elements()[entities_idx], keep_element[entities_idx]);
+  node_elem_connectivity_needs_rebuild = true;
 
+  // 5) Remove unused nodes. The glb_to_loc maps are up to date, so the
+  //    connectivity can be made local to find the used nodes.
+  restore_element_node_connectivity();
   for (Uint dict_idx=0; dict_idx<nb_dicts; ++dict_idx)
   {
-    //std::cout << PERank << "removing unused nodes " << std::endl;
-
     Dictionary& dict = *m_mesh->dictionaries()[dict_idx];
 
-    // Assemble set of used nodes, that will be checked for later
-    std::set<boost::uint64_t> used_nodes;
-
     // check in dict.entities_range(), in case perhaps other meshes use the same dictionary (future?)
     cf3_assert(dict.entities_range().size() != 0);
+    std::vector<bool> used(dict.size(), false);
     boost_foreach (const Handle<Entities>& entities, dict.entities_range())
     {
-      //std::cout << entities->uri() << std::endl;
-      Space& space = entities->space(dict);
-      for (Uint elem=0; elem<space.size(); ++elem)
+      boost_foreach (Connectivity::Row nodes, entities->space(dict).connectivity().array())
       {
-        // Element-node connectivity tables must be GLOBAL
-        boost_foreach( Uint glb_node, space.connectivity()[elem] )
-        {
-          used_nodes.insert(glb_node);
-        }
+        boost_foreach (const Uint node, nodes)
+          used[node] = true;
       }
     }
 
-    // Remove unused nodes
-    for (Uint node_idx=0; node_idx<dict.size(); ++node_idx)
+    std::vector<Uint> kept_rows;
+    kept_rows.reserve(dict.size());
+    std::vector<Uint> new_idx(dict.size(), uint_max());
+    for (Uint node=0; node<dict.size(); ++node)
     {
-      if ( used_nodes.count(dict.glb_idx()[node_idx]) == 0 )
+      if (used[node])
       {
-        remove_node(dict_idx,node_idx);
+        new_idx[node] = kept_rows.size();
+        kept_rows.push_back(node);
       }
     }
-  }
+    if (kept_rows.size() == dict.size())
+      continue;
 
-  // 7) Flush nodes and rebuild glb_to_loc map
-//  CFdebug << "Flush nodes and rebuild glb_to_loc map" << CFendl;
-  flush_nodes();
-//  CFdebug << "Flushed nodes" << CFendl;
+    detail::compact_dictionary(dict, kept_rows);
+    boost_foreach (const Handle<Entities>& entities, dict.entities_range())
+    {
+      boost_foreach (Connectivity::Row nodes, entities->space(dict).connectivity().array())
+      {
+        boost_foreach (Uint& node, nodes)
+          node = new_idx[node];
+      }
+    }
 
-  // 8) Fix node ranks
+    dict.renumber_map_glb_to_loc(new_idx);
+  }
 
-  // call function to fix the ranks
+  // 6) Fix node ranks
   fix_node_ranks();
-
-
-//  cf3_assert(added_elements.empty());
-//  cf3_assert(added_nodes.empty());
-//  finish();
-//  if (nb_dicts==2)
-//  {
-//    typedef std::map<boost::uint64_t,Uint> Map_t;
-//    PEProcessSortedExecute(-1,
-//    for (Uint pid=0; pid<PE::Comm::instance().size(); ++pid)
-//    {
-//      if (pid != PE::Comm::instance().rank())
-//      {
-//        for (Uint entities_idx=0; entities_idx<nb_entities; ++entities_idx)
-//        {
-//          Map_t glb_to_loc;
-//          for (Uint e=0; e<m_mesh->elements()[entities_idx]->size(); ++e)
-//          {
-//            glb_to_loc[ m_mesh->elements()[entities_idx]->glb_idx()[e] ] = e;
-//          }
-
-//          const Space& space = m_mesh->elements()[entities_idx]->space(*m_mesh->dictionaries()[1]);
-//          std::vector<Uint> imported_glb_elems; imported_glb_elems.reserve(imported_elements_glb_id[pid][entities_idx].size());
-//          boost_foreach (const Uint glb_elem, imported_elements_glb_id[pid][entities_idx] )
-//          {
-//            imported_glb_elems.push_back( glb_elem+1 );
-//            Uint loc_node;
-//            if (is_node_connectivity_global)
-//              loc_node = m_mesh->dictionaries()[1]->glb_to_loc()[ space.connectivity()[glb_to_loc[glb_elem]][0] ];
-//            else
-//              loc_node = space.connectivity()[glb_to_loc[glb_elem]][0];
-//            Real field_val = m_mesh->dictionaries()[1]->field("glb_elem")[loc_node][0];
-//            std::cout << PERank << "glb_elem " << glb_elem+1 << "  value " << m_mesh->dictionaries()[1]->field("glb_elem")[loc_node][0] << std::endl;
-//            cf3_assert_desc(to_str(field_val)+"=="+to_str(glb_elem+1),field_val == glb_elem+1);
-//          }
-//          std::cout << PERank << m_mesh->elements()[entities_idx]->uri() << "  :  " << to_str(imported_glb_elems) << std::endl;
-
-//        }
-//      }
-//    }
-
-//    for (Uint pid=0; pid<PE::Comm::instance().size(); ++pid)
-//    {
-//      if (pid != PE::Comm::instance().rank())
-//      {
-//        std::vector<Real> imported_glb_nodes; imported_glb_nodes.reserve(imported_nodes_glb_id[pid][1].size());
-//        boost_foreach (const Uint glb_node, imported_nodes_glb_id[pid][1] )
-//        {
-//          imported_glb_nodes.push_back( m_mesh->dictionaries()[1]->field("glb_elem")[m_mesh->dictionaries()[1]->glb_to_loc()[glb_node]][0] );
-//        }
-//        std::cout << PERank << to_str(imported_glb_nodes) << std::endl;
-//      }
-//    }
-//    )
-//  }
-
-
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1044,59 +1229,53 @@ void MeshAdaptor::move_elements(const std::vector< std::vector< std::vector<Uint
 void MeshAdaptor::fix_node_ranks()
 {
   CFdebug << "MeshAdaptor: fix node ranks" << CFendl;
-  ////PECheckArrivePoint(100,"fix node ranks");
-  const Uint nb_dicts = m_mesh->dictionaries().size();
+  const Uint nb_procs = PE::Comm::instance().size();
 
   flush_nodes();
-  rebuild_node_glb_to_loc_map();
   boost_foreach (const Handle<Dictionary>& dict, m_mesh->dictionaries())
   {
-    // nodes to send to other cpu's
-    std::vector<boost::uint64_t> glb_nodes(dict->size());
-    for (Uint n=0; n<glb_nodes.size(); ++n)
+    // Every node is looked up at the rank given by its global index modulo the number of ranks.
+    // That rank hears from all ranks that have the node, and answers with the lowest one.
+    std::map< int, std::vector<Uint> > requested_glb_nodes, received_glb_nodes;
+    std::map< int, std::vector<Uint> > requested_loc_nodes;
+    for (Uint node=0; node<dict->size(); ++node)
     {
-      // fill the nodes to send to other cpu's
-      glb_nodes[n] = dict->glb_idx()[n];
-
-      // assign the rank to be ourself to start with. The rank can only become lower.
-      cf3_assert(n<dict->rank().size());
-      dict->rank()[n] = PE::Comm::instance().rank();
+      const Uint glb_node = dict->glb_idx()[node];
+      requested_glb_nodes[glb_node % nb_procs].push_back(glb_node);
+      requested_loc_nodes[glb_node % nb_procs].push_back(node);
     }
+    detail::exchange_buffers(requested_glb_nodes, received_glb_nodes);
+    requested_glb_nodes.clear();
 
-    // Every cpu broadcasts to cpu's with higher rank
-    for (Uint root=0; root<PE::Comm::instance().size(); ++root)
+    // Sorting on the global node puts the lowest rank that has it first
+    typedef std::map< int, std::vector<Uint> >::const_iterator BufferIterator;
+    std::vector< std::pair<Uint,Uint> > glb_node_ranks;
+    for (BufferIterator it=received_glb_nodes.begin(); it!=received_glb_nodes.end(); ++it)
     {
-      //    CFinfo << "broadcasting from root " << root << CFendl;
-      PE::Comm::instance().barrier();
-
-      std::vector<boost::uint64_t> glb_nodes_from_root(0);
-      PE::Comm::instance().broadcast(glb_nodes,glb_nodes_from_root,root);
+      boost_foreach (const Uint glb_node, it->second)
+        glb_node_ranks.push_back(std::make_pair(glb_node, static_cast<Uint>(it->first)));
+    }
+    std::sort(glb_node_ranks.begin(), glb_node_ranks.end());
 
-      // cpu's with higher rank will adapt the ranks of the nodes
-      if (PE::Comm::instance().rank() > root)
-      {
+    std::map< int, std::vector<Uint> > owners, received_owners;
+    for (BufferIterator it=received_glb_nodes.begin(); it!=received_glb_nodes.end(); ++it)
+    {
+      std::vector<Uint>& pid_owners = owners[it->first];
+      pid_owners.reserve(it->second.size());
+      boost_foreach (const Uint glb_node, it->second)
+        pid_owners.push_back(std::lower_bound(glb_node_ranks.begin(), glb_node_ranks.end(), std::make_pair(glb_node, 0u))->second);
+    }
+    detail::exchange_buffers(owners, received_owners);
 
-        boost_foreach(const boost::uint64_t& glb_node, glb_nodes_from_root)
-        {
-          if (dict->glb_to_loc().exists(glb_node))
-          {
-            Uint loc_node = dict->glb_to_loc()[glb_node];
-            cf3_assert(dict->glb_idx()[loc_node]==glb_node);
-            cf3_assert(loc_node<dict->rank().size());
-            // if the rank is yourself, it means that the glb_node has not been found
-            // before. Change then the rank to the broacasting cpu.
-            if (dict->rank()[loc_node] == PE::Comm::instance().rank())
-            {
-              dict->rank()[loc_node] = std::min(root,dict->rank()[loc_node]);
-            }
-          }
-        }
-      }
+    // The answers are in the order of the requests
+    for (BufferIterator it=requested_loc_nodes.begin(); it!=requested_loc_nodes.end(); ++it)
+    {
+      const std::vector<Uint>& pid_owners = received_owners[it->first];
+      cf3_assert(pid_owners.size() == it->second.size());
+      for (Uint i=0; i<it->second.size(); ++i)
+        dict->rank()[it->second[i]] = pid_owners[i];
     }
   }
-
-//  ////PECheckArrivePoint(100,"fix node ranks done");
-
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1179,12 +1358,12 @@ void MeshAdaptor::grow_overlap()
 {
 
   PE::Comm& comm = PE::Comm::instance();
-  
+  const Uint my_rank = comm.rank();
+  const Uint nb_procs = comm.size();
+
   flush_nodes();
   flush_elements();
 
-  const Uint nb_dicts = m_mesh->dictionaries().size();
-
   CFdebug << "MeshAdaptor: finding bdry nodes" << CFendl;
 
   // It is assumed element-node connectivity is LOCAL to find the face2cell connectivity
@@ -1194,12 +1373,9 @@ void MeshAdaptor::grow_overlap()
   face2cell->setup(m_mesh->topology());
 
   Dictionary& geometry_dict = m_mesh->geometry_fields();
-//  geometry_dict.rebuild_node_to_element_connectivity();
-//  geometry_dict.rebuild_map_glb_to_loc();
+  const Uint nb_nodes = geometry_dict.size();
 
-  cf3_assert(geometry_dict.connectivity().size() == geometry_dict.size());
-
-  std::set<boost::uint64_t> bdry_nodes;
+  std::vector<bool> is_bdry_node(nb_nodes, false);
   for (Uint f=0; f<face2cell->size(); ++f)
   {
     cf3_assert(f < face2cell->is_bdry_face().size());
@@ -1207,7 +1383,7 @@ void MeshAdaptor::grow_overlap()
     {
       boost_foreach(const Uint node, face2cell->face_nodes(f))
       {
-        bdry_nodes.insert(node);
+        is_bdry_node[node] = true;
       }
     }
   }
@@ -1218,9 +1394,8 @@ void MeshAdaptor::grow_overlap()
   Handle< List<Uint> const > periodic_links_nodes_h(geometry_dict.get_child("periodic_links_nodes"));
   if(is_not_null(periodic_links_nodes_h))
   {
-    std::set<boost::uint64_t> periodic_nodes;
     const Uint nb_links = periodic_links_nodes_h->size();
-    cf3_assert(nb_links == geometry_dict.size());
+    cf3_assert(nb_links == nb_nodes);
 
     // Get the periodic data structures
     const List<Uint>& periodic_links_nodes = *periodic_links_nodes_h;
@@ -1231,7 +1406,7 @@ void MeshAdaptor::grow_overlap()
     // Add periodic boundary nodes
     for(Uint i = 0; i != nb_links; ++i)
     {
-      if(periodic_links_active[i] && geometry_dict.rank()[i] == comm.rank())
+      if(periodic_links_active[i] && geometry_dict.rank()[i] == my_rank)
       {
         Uint final_target_node = periodic_links_nodes[i];
         Uint count = 0;
@@ -1240,74 +1415,136 @@ void MeshAdaptor::grow_overlap()
           cf3_assert(++count < 10);
           final_target_node = periodic_links_nodes[final_target_node];
         }
-        bdry_nodes.insert(i);
-        bdry_nodes.insert(final_target_node);
+        is_bdry_node[i] = true;
+        is_bdry_node[final_target_node] = true;
       }
     }
   }
-  
-  //////PECheckArrivePoint(100, "boundary nodes found");
 
-  // Copy set into vector and convert to global indices
-  std::vector<boost::uint64_t> glb_boundary_nodes;
-  glb_boundary_nodes.reserve(bdry_nodes.size());
-  boost_foreach (Uint node, bdry_nodes)
+  rebuild_node_to_element_connectivity();
+  rebuild_node_glb_to_loc_map();
+  cf3_assert(geometry_dict.connectivity().size() == nb_nodes);
+
+  // Every rank needs the elements that other ranks have around its boundary nodes.
+  // Instead of sending all boundary nodes to all ranks, the nodes are registered at the rank
+  // given by their global index modulo the number of ranks, which matches the ranks that have
+  // the same node. Registered are the boundary nodes, and the nodes of ghost elements, as a
+  // boundary node of another rank can be inside the overlap of this rank.
+  std::vector<bool> is_registered(is_bdry_node);
+  boost_foreach (const Handle<Entities>& entities, geometry_dict.entities_range())
   {
-    glb_boundary_nodes.push_back(geometry_dict.glb_idx()[node]);
+    const Connectivity& connectivity = entities->space(geometry_dict).connectivity();
+    for (Uint elem=0; elem<entities->size(); ++elem)
+    {
+      if (entities->rank()[elem] != my_rank)
+      {
+        boost_foreach (const Uint node, connectivity[elem])
+          is_registered[node] = true;
+      }
+    }
   }
-  bdry_nodes.clear();
-
-  rebuild_node_to_element_connectivity();
-  //std::cout << PERank << geometry_dict.connectivity() << std::endl;
-
 
-  // We now have a vector of nodes that lie at the boundary of each pid's mesh
-  // Now find on other pid's the elements that share these nodes, and create
-  // a elements_changeset.
+  std::map< int, std::vector<Uint> > registrations, received_registrations;
+  for (Uint node=0; node<nb_nodes; ++node)
+  {
+    if (is_registered[node])
+    {
+      const Uint glb_node = geometry_dict.glb_idx()[node];
+      std::vector<Uint>& registration = registrations[glb_node % nb_procs];
+      registration.push_back(glb_node);
+      registration.push_back(is_bdry_node[node]);
+    }
+  }
+  detail::exchange_buffers(registrations, received_registrations);
+  registrations.clear();
+
+  // For a node registered by several ranks, every rank that has it on its boundary
+  // must receive the elements around it from every other rank
+  typedef std::map< int, std::vector<Uint> >::const_iterator BufferIterator;
+  std::vector< boost::tuple<Uint,Uint,bool> > registered;
+  for (BufferIterator it=received_registrations.begin(); it!=received_registrations.end(); ++it)
+  {
+    for (Uint i=0; i<it->second.size(); i+=2)
+      registered.push_back(boost::make_tuple(it->second[i], static_cast<Uint>(it->first), it->second[i+1] != 0));
+  }
+  received_registrations.clear();
+  std::sort(registered.begin(), registered.end());
 
-  std::vector< std::vector<boost::uint64_t> > recv_elem_glb_nodes;
-  PE::Comm::instance().all_gather(glb_boundary_nodes, recv_elem_glb_nodes);
-  cf3_assert(recv_elem_glb_nodes.size() == PE::Comm::instance().size());
+  // Requests are pairs of a global node and the rank that needs the elements around it
+  std::map< int, std::vector<Uint> > requests, received_requests;
+  for (Uint begin=0, end=0; begin<registered.size(); begin=end)
+  {
+    end = begin+1;
+    while (end<registered.size() && registered[end].get<0>() == registered[begin].get<0>())
+      ++end;
+    for (Uint target=begin; target<end; ++target)
+    {
+      if (!registered[target].get<2>())
+        continue;
+      for (Uint holder=begin; holder<end; ++holder)
+      {
+        if (holder == target)
+          continue;
+        std::vector<Uint>& request = requests[registered[holder].get<1>()];
+        request.push_back(registered[holder].get<0>());
+        request.push_back(registered[target].get<1>());
+      }
+    }
+  }
+  registered.clear();
 
-  //////PECheckArrivePoint(100, "boundary nodes allgathered");
+  // Ranks that own all elements around a boundary node of this rank may not have registered it,
+  // but are known from the ghost elements around the node
+  for (Uint node=0; node<nb_nodes; ++node)
+  {
+    if (!is_bdry_node[node])
+      continue;
+    std::set<Uint> owners;
+    boost_foreach(const SpaceElem& elem, geometry_dict.connectivity()[node])
+    {
+      const Uint owner = elem.comp->support().rank()[elem.idx];
+      if (owner != my_rank)
+        owners.insert(owner);
+    }
+    boost_foreach (const Uint owner, owners)
+    {
+      std::vector<Uint>& request = requests[owner];
+      request.push_back(geometry_dict.glb_idx()[node]);
+      request.push_back(my_rank);
+    }
+  }
+  detail::exchange_buffers(requests, received_requests);
+  requests.clear();
 
-  std::vector< std::vector< std::vector< Uint > > > exported_elements_loc_id (PE::Comm::instance().size(),
+  // Export all elements around the requested nodes
+  std::vector< std::vector< std::vector< Uint > > > exported_elements_loc_id (nb_procs,
                                                                               std::vector< std::vector<Uint> > (m_mesh->elements().size()));
-
-  PE::Buffer send_buffer, receive_buffer;
-
-  rebuild_node_glb_to_loc_map();
-
-  for (Uint pid=0; pid<PE::Comm::instance().size(); ++pid)
+  for (BufferIterator it=received_requests.begin(); it!=received_requests.end(); ++it)
   {
-    if (pid != PE::Comm::instance().rank())
+    for (Uint i=0; i<it->second.size(); i+=2)
     {
-      boost_foreach (const boost::uint64_t& glb_node, recv_elem_glb_nodes[pid])
+      const boost::uint64_t glb_node = it->second[i];
+      const Uint pid = it->second[i+1];
+      if (!geometry_dict.glb_to_loc().exists(glb_node))
+        continue;
+      const Uint loc_node = geometry_dict.glb_to_loc()[glb_node];
+      cf3_assert(loc_node<nb_nodes);
+      boost_foreach(const SpaceElem& elem, geometry_dict.connectivity()[loc_node])
       {
-        if (geometry_dict.glb_to_loc().exists(glb_node))
-        {
-          const Uint loc_node = geometry_dict.glb_to_loc()[glb_node];
-          cf3_assert(loc_node<geometry_dict.size());
-//          CFdebug << "[0] found glb_node " << glb_node+1 <<      "   :";
-          boost_foreach(const SpaceElem& elem, geometry_dict.connectivity()[loc_node])
-          {
-//            CFdebug << " " << elem.glb_idx()+1;
-            //if (elem.rank() == PE::Comm::instance().rank())
-            {
-              const Uint entities_idx = elem.comp->support().entities_idx();
-              exported_elements_loc_id[pid][entities_idx].push_back(elem.idx);
-            }
-          }
-//          CFdebug << CFendl;
-        }
+        const Uint entities_idx = elem.comp->support().entities_idx();
+        exported_elements_loc_id[pid][entities_idx].push_back(elem.idx);
       }
     }
   }
-
-  //////PECheckArrivePoint(100, "exported_elements_loc_id assembled");
-
-
-
+  received_requests.clear();
+  for (Uint pid=0; pid<nb_procs; ++pid)
+  {
+    boost_foreach (std::vector<Uint>& elems, exported_elements_loc_id[pid])
+    {
+      std::sort(elems.begin(), elems.end());
+      elems.erase(std::unique(elems.begin(), elems.end()), elems.end());
+    }
+  }
 
   std::vector< std::vector< std::vector<Uint> > >            exported_nodes_loc_id;
   find_nodes_to_export(exported_elements_loc_id,exported_nodes_loc_id);
@@ -1315,13 +1552,10 @@ void MeshAdaptor::grow_overlap()
   std::vector< std::vector< std::vector<boost::uint64_t> > > imported_elems_glb_id;
   send_elements(exported_elements_loc_id,imported_elems_glb_id);
 
-  flush_elements();
-
   std::vector< std::vector< std::vector<boost::uint64_t> > > imported_nodes_glb_id;
   send_nodes(exported_nodes_loc_id,imported_nodes_glb_id);
 
-  flush_nodes();
-  // nodes and elements should be flushed now, as well as dict.glb_to_loc rebuilt.
+  // received nodes and elements are appended, and dict.glb_to_loc is kept up to date.
   // A call to finish() should restore the element-node connectivity tables and update statistics
 }
 
@@ -14,6 +14,7 @@
 #include "common/OptionArray.hpp"
 #include "common/OptionURI.hpp"
 #include "common/FindComponents.hpp"
+#include "common/Tracer.hpp"
 
 
 #include "common/PE/Comm.hpp"
@@ -129,6 +130,7 @@ void MeshReader::signal_read( SignalArgs& node  )
 
 void MeshReader::read_mesh_into(const URI& path, Mesh& mesh)
 {
+  CF3_TRACE_SCOPE("read_mesh");
   options().set("file",path);
   options().set("mesh",mesh.handle<Mesh>());
 
@@ -4,10 +4,12 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <algorithm>
 #include <set>
 
 #include <boost/function.hpp>
 #include <boost/bind.hpp>
+#include <boost/cstdint.hpp>
 
 #include "common/Foreach.hpp"
 #include "common/Log.hpp"
@@ -49,8 +51,51 @@ cf3::common::ComponentBuilder < Octtree, Component, LibMesh > Octtree_Builder;
 
 ////////////////////////////////////////////////////////////////////////////////
 
+namespace detail
+{
+
+/// Morton key of a coordinate, interleaving the bits of its cell index in a uniform grid of 2^bits cells per direction
+boost::uint64_t morton_key(const RealVector& coord, const math::BoundingBox& box, const Uint dim)
+{
+  const Uint bits = 63 / dim;
+  const Real nb_cells = static_cast<Real>(boost::uint64_t(1) << bits);
+  boost::uint64_t cell[3] = {0, 0, 0};
+  for(Uint d = 0; d != dim; ++d)
+  {
+    const Real extent = box.max()[d] - box.min()[d];
+    const Real relative = extent > 0. ? (coord[d] - box.min()[d]) / extent : 0.;
+    cell[d] = static_cast<boost::uint64_t>(std::max(0., std::min(nb_cells - 1., relative * nb_cells)));
+  }
+  boost::uint64_t key = 0;
+  for(Uint b = 0; b != bits; ++b)
+    for(Uint d = 0; d != dim; ++d)
+      key |= ((cell[d] >> b) & 1u) << (b*dim + d);
+  return key;
+}
+
+/// Orders coordinate indices by their Morton key
+struct MortonLess
+{
+  MortonLess(const std::vector<boost::uint64_t>& keys) : m_keys(keys) {}
+  bool operator()(const Uint a, const Uint b) const { return m_keys[a] < m_keys[b]; }
+  const std::vector<boost::uint64_t>& m_keys;
+};
+
+/// Orders element indices by the coordinate of their centroid in one direction
+struct CentroidLess
+{
+  CentroidLess(const std::vector<Real>& centroids, const Uint d) : m_centroids(centroids), m_d(d) {}
+  bool operator()(const Uint a, const Uint b) const { return m_centroids[3*a+m_d] < m_centroids[3*b+m_d]; }
+  const std::vector<Real>& m_centroids;
+  const Uint m_d;
+};
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 Octtree::Octtree( const std::string& name )
-  : Component(name), m_dim(0), m_N(3), m_D(3), m_octtree_idx(3)
+  : Component(name), m_dim(0), m_N(3), m_D(3)
 {
 
   options().add("mesh", m_mesh)
@@ -68,6 +113,10 @@ Octtree::Octtree( const std::string& name )
       .description("The number of cells in each direction of the comb. "
                         "Takes precedence over \"Number of Elements per Octtree Cell\". ")
       .pretty_name("Number of Cells");
+
+  options().add( "nb_elems_per_leaf", 8u )
+      .description("Maximum number of elements in a leaf of the bounding volume hierarchy")
+      .pretty_name("Number of Elements per Leaf");
 }
 
 
@@ -96,6 +145,7 @@ void Octtree::create_octtree()
   if (options().value<std::vector<Uint> >("nb_cells").size() > 0)
   {
     m_N = options().value<std::vector<Uint> >("nb_cells");
+    m_N.resize(3, 1u);
     for (Uint d=0; d<m_dim; ++d)
       m_D[d] = (L[d])/static_cast<Real>(m_N[d]);
   }
@@ -106,10 +156,15 @@ void Octtree::create_octtree()
 
     for (Uint d=0; d<m_dim; ++d)
     {
-      m_N[d] = (Uint) std::ceil(L[d]/D1);
+      m_N[d] = std::max(Uint(1), (Uint) std::ceil(L[d]/D1));
       m_D[d] = (L[d])/static_cast<Real>(m_N[d]);
     }
   }
+  for (Uint d=m_dim; d<3; ++d)
+  {
+    m_N[d] = 1;
+    m_D[d] = 1.;
+  }
 
   CFdebug << "Octtree:" << CFendl;
   CFdebug << "--------" << CFendl;
@@ -119,68 +174,165 @@ void Octtree::create_octtree()
   }
   CFdebug << "V = " << V << CFendl;
 
-  // initialize the octtree
-  m_octtree.resize(boost::extents[std::max(Uint(1),m_N[XX])][std::max(Uint(1),m_N[YY])][std::max(Uint(1),m_N[ZZ])]);
-
-  RealVector centroid(m_dim);
-  std::vector<Uint> octtree_idx(3);
+  // Bounding box and centroid of each element. The element loops are independent, and run in parallel if OpenMP is enabled.
+  m_elements.clear();
+  m_elements.reserve(nb_elems);
+  std::vector<Real> centroids;
+  m_element_boxes.clear();
   boost_foreach (Elements& elements, find_components_recursively_with_filter<Elements>(*m_mesh,IsElementsVolume()))
   {
-    Uint nb_nodes_per_element = elements.geometry_space().connectivity().row_size();
-    RealMatrix coordinates;
-    elements.geometry_space().allocate_coordinates(coordinates);
+    const Uint nb_block_elems = elements.size();
+    const Uint first = m_elements.size();
+    for (Uint elem_idx=0; elem_idx<nb_block_elems; ++elem_idx)
+      m_elements.push_back(Entity(elements,elem_idx));
+    centroids.resize(3*m_elements.size(), 0.);
+    m_element_boxes.resize(6*m_elements.size(), 0.);
+
+    const Space& geometry_space = elements.geometry_space();
+    const ElementType& element_type = elements.element_type();
+    const Uint dim = m_dim;
+    #pragma omp parallel
+    {
+      RealMatrix coordinates;
+      geometry_space.allocate_coordinates(coordinates);
+      RealVector centroid(dim);
+      #pragma omp for
+      for (int elem_idx=0; elem_idx<static_cast<int>(nb_block_elems); ++elem_idx)
+      {
+        const Uint e = first + elem_idx;
+        geometry_space.put_coordinates(coordinates,elem_idx);
+        element_type.compute_centroid(coordinates,centroid);
+        for (Uint d=0; d<dim; ++d)
+        {
+          const Real box_min = coordinates.col(d).minCoeff();
+          const Real box_max = coordinates.col(d).maxCoeff();
+          // Small margin, so points on a face are not missed due to round-off
+          const Real margin = 1e-8*(box_max - box_min) + 100*math::Consts::eps();
+          m_element_boxes[6*e+d] = box_min - margin;
+          m_element_boxes[6*e+3+d] = box_max + margin;
+          centroids[3*e+d] = centroid[d];
+        }
+      }
+    }
+  }
+
+  // Build the hierarchy on a permutation of the elements, then store the elements in leaf order
+  std::vector<Uint> permutation(m_elements.size());
+  for (Uint e=0; e<permutation.size(); ++e)
+    permutation[e] = e;
+
+  m_nodes.clear();
+  m_nodes.reserve(2*(m_elements.size()/std::max(Uint(1),options().value<Uint>("nb_elems_per_leaf")) + 1));
+  m_nodes.push_back(Node());
+  build_node(0, 0, permutation.size(), permutation, centroids);
+
+  std::vector<Entity> sorted_elements(m_elements.size());
+  std::vector<Real> sorted_boxes(m_element_boxes.size());
+  m_element_cells.resize(3*m_elements.size());
+  for (Uint e=0; e<permutation.size(); ++e)
+  {
+    const Uint old_e = permutation[e];
+    sorted_elements[e] = m_elements[old_e];
+    std::copy(m_element_boxes.begin()+6*old_e, m_element_boxes.begin()+6*(old_e+1), sorted_boxes.begin()+6*e);
+    for (Uint d=0; d<3; ++d)
+      m_element_cells[3*e+d] = d < m_dim ? cell_index(centroids[3*old_e+d], d) : 0u;
+  }
+  m_elements.swap(sorted_elements);
+  m_element_boxes.swap(sorted_boxes);
+
+  CFdebug << "Octtree: bounding volume hierarchy with " << m_nodes.size() << " nodes for " << m_elements.size() << " elements" << CFendl;
+}
+
+//////////////////////////////////////////////////////////////////////////////
 
-    for (Uint elem_idx=0; elem_idx<elements.size(); ++elem_idx)
+void Octtree::build_node(const Uint node_idx, const Uint begin, const Uint end, std::vector<Uint>& permutation, const std::vector<Real>& centroids)
+{
+  Real centroid_min[3];
+  Real centroid_max[3];
+  {
+    Node& node = m_nodes[node_idx];
+    node.begin = begin;
+    node.end = end;
+    node.children[0] = node.children[1] = 0;
+    for (Uint d=0; d<3; ++d)
+    {
+      node.min[d] = d < m_dim ? math::Consts::real_max() : 0.;
+      node.max[d] = d < m_dim ? -math::Consts::real_max() : 0.;
+      centroid_min[d] = math::Consts::real_max();
+      centroid_max[d] = -math::Consts::real_max();
+    }
+    for (Uint i=begin; i<end; ++i)
     {
-      elements.geometry_space().put_coordinates(coordinates,elem_idx);
-      elements.element_type().compute_centroid(coordinates,centroid);
+      const Uint e = permutation[i];
       for (Uint d=0; d<m_dim; ++d)
       {
-        cf3_assert((centroid[d] - m_bounding_box.min()[d])/m_D[d] >= 0);
-        octtree_idx[d]=std::min((Uint) std::floor( (centroid[d] - m_bounding_box.min()[d])/m_D[d]), m_N[d]-1 );
+        node.min[d] = std::min(node.min[d], m_element_boxes[6*e+d]);
+        node.max[d] = std::max(node.max[d], m_element_boxes[6*e+3+d]);
+        centroid_min[d] = std::min(centroid_min[d], centroids[3*e+d]);
+        centroid_max[d] = std::max(centroid_max[d], centroids[3*e+d]);
       }
-      m_octtree[octtree_idx[XX]][octtree_idx[YY]][octtree_idx[ZZ]].push_back(Entity(elements,elem_idx));
     }
   }
 
+  // A leaf holds at least one element, otherwise the splitting would never end
+  if (end - begin <= std::max(Uint(1),options().value<Uint>("nb_elems_per_leaf")))
+    return;
+
+  // Split at the median centroid in the direction with the largest spread of the centroids
+  Uint split_dim = 0;
+  for (Uint d=1; d<m_dim; ++d)
+  {
+    if (centroid_max[d] - centroid_min[d] > centroid_max[split_dim] - centroid_min[split_dim])
+      split_dim = d;
+  }
+  const Uint middle = begin + (end - begin)/2;
+  std::nth_element(permutation.begin()+begin, permutation.begin()+middle, permutation.begin()+end, detail::CentroidLess(centroids, split_dim));
+
+  // m_nodes may be reallocated by the recursion, so the node is accessed by index
+  const Uint left = m_nodes.size();
+  m_nodes.push_back(Node());
+  const Uint right = m_nodes.size();
+  m_nodes.push_back(Node());
+  m_nodes[node_idx].children[0] = left;
+  m_nodes[node_idx].children[1] = right;
+  build_node(left, begin, middle, permutation, centroids);
+  build_node(right, middle, end, permutation, centroids);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+bool Octtree::box_contains(const Real* box_min, const Real* box_max, const RealVector& coord) const
+{
+  for (Uint d=0; d<m_dim; ++d)
+  {
+    if (coord[d] < box_min[d] || coord[d] > box_max[d])
+      return false;
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
 
-  // Uint total=0;
-  //
-  // switch (m_dim)
-  // {
-  //   case DIM_2D:
-  //     for (Uint i=0; i<m_N[0]; ++i)
-  //       for (Uint j=0; j<m_N[1]; ++j)
-  //       {
-  //         Uint k=0;
-  //         // CFinfo << "("<<i<<","<<j<<") has elems ";
-  //         // if (m_octtree[i][j][k].size())
-  //         //   CFinfo << mesh::to_vector(m_octtree[i][j][k]).transpose() << CFendl;
-  //         // else
-  //         //   CFinfo << CFendl;
-  //         total += m_octtree[i][j][k].size();
-  //       }
-  //     break;
-  //   case DIM_3D:
-  //     for (Uint i=0; i<m_N[0]; ++i)
-  //       for (Uint j=0; j<m_N[1]; ++j)
-  //         for (Uint k=0; k<m_N[2]; ++k)
-  //         {
-  //           // CFinfo << "("<<i<<","<<j<<","<<k<<") has elems ";
-  //           // if (m_octtree[i][j][k].size())
-  //           //   CFinfo << mesh::to_vector(m_octtree[i][j][k]).transpose() << CFendl;
-  //           // else
-  //           //   CFinfo << CFendl;
-  //           total += m_octtree[i][j][k].size();
-  //         }
-  //     break;
-  //   default:
-  //     break;
-  // }
-  //
-  // CFinfo << "total = " << total << " of " << m_nb_elems << CFendl;
+Real Octtree::box_distance2(const Real* box_min, const Real* box_max, const RealVector& coord) const
+{
+  Real result = 0.;
+  for (Uint d=0; d<m_dim; ++d)
+  {
+    const Real outside = std::max(0., std::max(box_min[d] - coord[d], coord[d] - box_max[d]));
+    result += outside*outside;
+  }
+  return result;
 }
 
+//////////////////////////////////////////////////////////////////////////////
+
+Uint Octtree::cell_index(const Real coord, const Uint d) const
+{
+  const Real relative = (coord - m_bounding_box.min()[d])/m_D[d];
+  if (relative <= 0.)
+    return 0;
+  return std::min((Uint) std::floor(relative), m_N[d]-1);
+}
 
 //////////////////////////////////////////////////////////////////////////////
 
@@ -188,16 +340,14 @@ void Octtree::find_cell_ranks( const boost::multi_array<Real,2>& coordinates, st
 {
   ranks.resize(coordinates.size());
 
-  Entity dummy;
+  std::vector<Entity> found_elements;
   std::deque<Uint> missing_cells;
 
-  RealVector coord(m_dim);
+  find_elements(coordinates, found_elements);
 
   for(Uint i=0; i<coordinates.size(); ++i)
   {
-    for (Uint d=0; d<m_dim; ++d)
-      coord[d] = coordinates[i][d];
-    if( find_element(coord,dummy) ) // if element is found on this rank
+    if( is_not_null(found_elements[i].comp) ) // if element is found on this rank
     {
       ranks[i] = Comm::instance().rank();
     }
@@ -229,21 +379,20 @@ void Octtree::find_cell_ranks( const boost::multi_array<Real,2>& coordinates, st
 
     if (root!=Comm::instance().rank())
     {
-      std::vector<RealVector> recv_coordinates(recv_coords.size()/m_dim) ;
-      boost_foreach(RealVector& realvec, recv_coordinates)
-          realvec.resize(m_dim);
-
+      const Uint nb_recv = recv_coords.size()/m_dim;
+      boost::multi_array<Real,2> recv_coordinates(boost::extents[nb_recv][m_dim]);
       c=0;
-      for (Uint i=0; i<recv_coordinates.size(); ++i)
+      for (Uint i=0; i<nb_recv; ++i)
       {
         for(Uint d=0; d<m_dim; ++d)
           recv_coordinates[i][d]=recv_coords[c++];
       }
 
-      send_found.resize(recv_coordinates.size());
-      for (Uint i=0; i<recv_coordinates.size(); ++i)
+      find_elements(recv_coordinates, found_elements);
+      send_found.resize(nb_recv);
+      for (Uint i=0; i<nb_recv; ++i)
       {
-        if( find_element(recv_coordinates[i],dummy) ) // if element found on this rank
+        if( is_not_null(found_elements[i].comp) ) // if element found on this rank
         {
           send_found[i] = Comm::instance().rank();
         }
@@ -273,7 +422,7 @@ void Octtree::find_cell_ranks( const boost::multi_array<Real,2>& coordinates, st
 
 bool Octtree::find_octtree_cell(const RealVector& coordinate, std::vector<Uint>& octtree_idx)
 {
-  if (m_octtree.num_elements() == 0)
+  if ( !is_created() )
     create_octtree();
 
   static const Real tolerance = 100*math::Consts::eps();
@@ -288,10 +437,11 @@ bool Octtree::find_octtree_cell(const RealVector& coordinate, std::vector<Uint>&
       CFdebug << "coord " << coordinate.transpose() << " not found in bounding box" << CFendl;
       return false; // no index found
     }
-    octtree_idx[d] = std::min((Uint) std::floor( (coordinate[d] - m_bounding_box.min()[d])/m_D[d]), m_N[d]-1 );
+    octtree_idx[d] = cell_index(coordinate[d], d);
   }
+  for (Uint d=m_dim; d<octtree_idx.size(); ++d)
+    octtree_idx[d] = 0;
 
-  //CFinfo << " should be in box ("<<m_point_idx[0]<<","<<m_point_idx[1]<<","<<m_point_idx[2]<<")" << CFendl;
   return true;
 }
 
@@ -299,105 +449,66 @@ bool Octtree::find_octtree_cell(const RealVector& coordinate, std::vector<Uint>&
 
 void Octtree::gather_elements_around_idx(const std::vector<Uint>& octtree_idx, const Uint ring, std::vector<Entity>& elements)
 {
-  int i(0), j(0), k(0);
-  int imin, jmin, kmin;
-  int imax, jmax, kmax;
-
-  int irmin, jrmin, krmin;
-  int irmax, jrmax, krmax;
+  if ( !is_created() )
+    create_octtree();
 
-  if (ring == 0)
+  // Cells within the outer bounds of the ring, and the part of those bounds that is strictly inside the ring
+  int outer_min[3], outer_max[3];
+  for (Uint d=0; d<3; ++d)
   {
-    boost_foreach(const Entity& element, m_octtree[octtree_idx[XX]][octtree_idx[YY]][octtree_idx[ZZ]])
-    {
-      cf3_assert(element.comp);
-      elements.push_back(element);
-    }
-    return;
+    outer_min[d] = d < m_dim ? int(octtree_idx[d])-int(ring) : 0;
+    outer_max[d] = d < m_dim ? int(octtree_idx[d])+int(ring) : 0;
   }
-  else
-  {
-    switch (m_dim)
-    {
-      case DIM_3D:
-      irmin = int(octtree_idx[XX])-int(ring);  irmax = int(octtree_idx[XX])+int(ring);
-      jrmin = int(octtree_idx[YY])-int(ring);  jrmax = int(octtree_idx[YY])+int(ring);
-      krmin = int(octtree_idx[ZZ])-int(ring);  krmax = int(octtree_idx[ZZ])+int(ring);
-
-      imin = std::max(irmin, 0);  imax = std::min(irmax,int(m_N[XX])-1);
-      jmin = std::max(jrmin, 0);  jmax = std::min(jrmax,int(m_N[YY])-1);
-      kmin = std::max(krmin, 0);  kmax = std::min(krmax,int(m_N[ZZ])-1);
-
-        // imin:
-        i = imin;
-        for (i = imin; i <= imax; ++i)
-        {
-          for (j = jmin; j <= jmax; ++j)
-          {
-            for (k = kmin; k <= kmax; ++k)
-            {
-              if ( i == irmin || i == irmax || j == jrmin || j == jrmax || k == krmin || k == krmax)
-              {
-                boost_foreach(const Entity& element, m_octtree[i][j][k])
-                {
-                  cf3_assert(element.comp);
-                  elements.push_back(element);
-                }
-              }
-            }
-          }
-        }
-
-        break;
-      case DIM_2D:
-
-        irmin = int(octtree_idx[XX])-int(ring);  irmax = int(octtree_idx[XX])+int(ring);
-        jrmin = int(octtree_idx[YY])-int(ring);  jrmax = int(octtree_idx[YY])+int(ring);
-
-        imin = std::max(irmin, 0);  imax = std::min(irmax,int(m_N[XX])-1);
-        jmin = std::max(jrmin, 0);  jmax = std::min(jrmax,int(m_N[YY])-1);
 
-        for (i = imin; i <= imax; ++i)
-        {
-          for (j = jmin; j <= jmax; ++j)
-          {
-            if ( i == irmin || i == irmax || j == jrmin || j == jrmax )
-            {
-              boost_foreach(const Entity& element, m_octtree[i][j][k])
-              {
-                cf3_assert(element.comp);
-                elements.push_back(element);
-              }
-            }
-          }
-        }
-
-        break;
-
-      case DIM_1D:
-        irmin = int(octtree_idx[XX])-int(ring);  irmax = int(octtree_idx[XX])+int(ring);
-        imin = std::max(int(octtree_idx[XX])-int(ring), 0);  imax = std::min(int(octtree_idx[XX])+int(ring),int(m_N[XX])-1);
+  m_stack.clear();
+  m_stack.push_back(0);
+  while (!m_stack.empty())
+  {
+    const Node& node = m_nodes[m_stack.back()];
+    m_stack.pop_back();
 
-        for (i = imin; i <= imax; ++i)
-        {
-          if ( i == irmin || i == irmax)
-          {
-            boost_foreach(const Entity& element, m_octtree[i][j][k])
-            {
-              cf3_assert(element.comp);
-              elements.push_back(element);
-            }
-          }
-        }
+    // Range of cells touched by the node. Element centroids lie inside the node box, so their cells are inside this range.
+    bool overlaps = true;
+    bool inside_ring = ring > 0;
+    for (Uint d=0; d<m_dim; ++d)
+    {
+      const int lo = int(cell_index(node.min[d], d));
+      const int hi = int(cell_index(node.max[d], d));
+      if (hi < outer_min[d] || lo > outer_max[d])
+        overlaps = false;
+      if (lo <= outer_min[d] || hi >= outer_max[d])
+        inside_ring = false;
+    }
+    if (!overlaps || inside_ring)
+      continue;
 
+    if (!node.is_leaf())
+    {
+      m_stack.push_back(node.children[1]);
+      m_stack.push_back(node.children[0]);
+      continue;
+    }
 
-        break;
+    for (Uint e=node.begin; e<node.end; ++e)
+    {
+      const Uint* cell = &m_element_cells[3*e];
+      bool in_box = true;
+      bool on_ring = false;
+      for (Uint d=0; d<m_dim; ++d)
+      {
+        const int c = int(cell[d]);
+        if (c < outer_min[d] || c > outer_max[d])
+          in_box = false;
+        if (c == outer_min[d] || c == outer_max[d])
+          on_ring = true;
+      }
+      if (in_box && on_ring)
+      {
+        cf3_assert(m_elements[e].comp);
+        elements.push_back(m_elements[e]);
+      }
     }
   }
-
-
-  //CFinfo << m_pointcloud.size() << " points in the pointcloud " << CFendl;
-
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -417,55 +528,183 @@ bool Octtree::find_element(const RealVector& target_coord, Entity& element)
     create_octtree();
 
   cf3_assert(target_coord.size() <= (long)m_dim);
-  RealVector t_coord(m_dim);
+  RealVector t_coord = RealVector::Zero(m_dim);
   for (Uint d=0; d<target_coord.size(); ++d)
     t_coord[d] = target_coord[d];
 
-  for (Uint t=0; t<target_coord.size(); ++t)
+  if (find_element(t_coord, element, m_stack))
+    return true;
+
+  // if arrived here, it means no element contains the coordinate. Give up.
+  element = Entity();
+  CFdebug << "coord";
+  for(Uint i = 0; i != m_dim; ++i)
+  {
+    CFdebug << " " << common::to_str(t_coord[i]);
+  }
+  CFdebug << " has not been found in the octtree" << CFendl;
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
 
-  if (find_octtree_cell(t_coord,m_octtree_idx))
+bool Octtree::find_element(const RealVector& target_coord, Entity& element, std::vector<Uint>& stack) const
+{
+  stack.clear();
+  stack.push_back(0);
+  while (!stack.empty())
   {
-    m_elements_pool.clear();
-    Uint pool_size = 0;
-    Uint rings=0;
-    for ( ; pool_size==0 ; ++rings)
+    const Node& node = m_nodes[stack.back()];
+    stack.pop_back();
+    if (!box_contains(node.min, node.max, target_coord))
+      continue;
+
+    if (!node.is_leaf())
     {
-      pool_size=m_elements_pool.size();
-      gather_elements_around_idx(m_octtree_idx,rings,m_elements_pool);
-      boost_foreach(const Entity& pool_elem, boost::make_iterator_range(m_elements_pool.begin()+pool_size,m_elements_pool.end()))
+      stack.push_back(node.children[1]);
+      stack.push_back(node.children[0]);
+      continue;
+    }
+
+    for (Uint e=node.begin; e<node.end; ++e)
+    {
+      if (!box_contains(&m_element_boxes[6*e], &m_element_boxes[6*e+3], target_coord))
+        continue;
+      const Entity& candidate = m_elements[e];
+      cf3_assert(is_not_null(candidate.comp));
+      if (candidate.element_type().is_coord_in_element(target_coord,candidate.get_coordinates()))
       {
-        cf3_assert(is_not_null(pool_elem.comp));
-        const RealMatrix elem_coordinates = pool_elem.get_coordinates();
-        if (pool_elem.element_type().is_coord_in_element(t_coord,elem_coordinates))
-        {
-          element = pool_elem;
-          return true;
-        }
+        element = candidate;
+        return true;
       }
     }
-    // if arrived here, keep searching
-    // it means no element has been found. The search is enlarged with one more ring, for possible misses.
-    gather_elements_around_idx(m_octtree_idx,rings,m_elements_pool);
-    boost_foreach(const Entity& pool_elem, boost::make_iterator_range(m_elements_pool.begin()+pool_size,m_elements_pool.end()))
+  }
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool Octtree::find_nearest_element(const RealVector& target_coord, Entity& element)
+{
+  if ( !is_created() )
+    create_octtree();
+
+  RealVector t_coord = RealVector::Zero(m_dim);
+  for (Uint d=0; d<target_coord.size() && d<m_dim; ++d)
+    t_coord[d] = target_coord[d];
+
+  return find_nearest_element(t_coord, element, m_stack);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool Octtree::find_nearest_element(const RealVector& target_coord, Entity& element, std::vector<Uint>& stack) const
+{
+  if (m_elements.empty())
+    return false;
+
+  // Branch and bound on the distance to the element centroids. The distance to a box is a lower bound for the
+  // distance to the centroids inside it, so nodes that are farther away than the best element so far are skipped.
+  Real best_distance2 = math::Consts::real_max();
+  Uint best = 0;
+  RealVector centroid(m_dim);
+  stack.clear();
+  stack.push_back(0);
+  while (!stack.empty())
+  {
+    const Node& node = m_nodes[stack.back()];
+    stack.pop_back();
+    if (box_distance2(node.min, node.max, target_coord) >= best_distance2)
+      continue;
+
+    if (!node.is_leaf())
     {
-      cf3_assert(is_not_null(pool_elem.comp));
-      const RealMatrix elem_coordinates = pool_elem.get_coordinates();
-      if (pool_elem.element_type().is_coord_in_element(t_coord,elem_coordinates))
+      // Visit the closest child first, so it is on top of the stack
+      const Node& left = m_nodes[node.children[0]];
+      const Node& right = m_nodes[node.children[1]];
+      if (box_distance2(left.min, left.max, target_coord) <= box_distance2(right.min, right.max, target_coord))
       {
-        element = pool_elem;
-        return true;
+        stack.push_back(node.children[1]);
+        stack.push_back(node.children[0]);
+      }
+      else
+      {
+        stack.push_back(node.children[0]);
+        stack.push_back(node.children[1]);
+      }
+      continue;
+    }
+
+    for (Uint e=node.begin; e<node.end; ++e)
+    {
+      if (box_distance2(&m_element_boxes[6*e], &m_element_boxes[6*e+3], target_coord) >= best_distance2)
+        continue;
+      const Entity& candidate = m_elements[e];
+      candidate.element_type().compute_centroid(candidate.get_coordinates(), centroid);
+      const Real distance2 = (centroid - target_coord).squaredNorm();
+      if (distance2 < best_distance2)
+      {
+        best_distance2 = distance2;
+        best = e;
       }
     }
   }
-  // if arrived here, it means no element has been found in the octtree cell. Give up.
-  element = Entity();
-  CFdebug << "coord";
-  for(Uint i = 0; i != m_dim; ++i)
+
+  element = m_elements[best];
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Uint Octtree::find_elements(const boost::multi_array<Real,2>& coordinates, std::vector<Entity>& elements, const bool closest)
+{
+  if ( !is_created() )
+    create_octtree();
+
+  const Uint nb_coords = coordinates.size();
+  elements.assign(nb_coords, Entity());
+
+  // Process the coordinates in Morton order, so consecutive searches visit the same part of the tree
+  std::vector<boost::uint64_t> keys(nb_coords);
+  std::vector<Uint> order(nb_coords);
+  RealVector coord(m_dim);
+  for (Uint i=0; i<nb_coords; ++i)
   {
-    CFdebug << " " << common::to_str(t_coord[i]);
+    for (Uint d=0; d<m_dim; ++d)
+      coord[d] = coordinates[i][d];
+    keys[i] = detail::morton_key(coord, m_bounding_box, m_dim);
+    order[i] = i;
   }
-  CFdebug << " has not been found in the octtree cell" << CFendl;
-  return false;
+  std::sort(order.begin(), order.end(), detail::MortonLess(keys));
+
+  // The point-in-element tests of some element types use static work variables, so the searches are not run concurrently
+  static const Real tolerance = 100*math::Consts::eps();
+  Uint nb_found = 0;
+  boost_foreach (const Uint i, order)
+  {
+    for (Uint d=0; d<m_dim; ++d)
+      coord[d] = coordinates[i][d];
+
+    if (find_element(coord, elements[i], m_stack))
+    {
+      ++nb_found;
+      continue;
+    }
+
+    if (closest)
+    {
+      bool in_bounding_box = true;
+      for (Uint d=0; d<m_dim; ++d)
+      {
+        if (coord[d] > m_bounding_box.max()[d] + tolerance || coord[d] < m_bounding_box.min()[d] - tolerance)
+          in_bounding_box = false;
+      }
+      if (in_bounding_box && find_nearest_element(coord, elements[i], m_stack))
+        ++nb_found;
+    }
+  }
+
+  return nb_found;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
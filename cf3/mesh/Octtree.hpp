@@ -26,17 +26,20 @@ namespace mesh {
 
 //////////////////////////////////////////////////////////////////////////////
 
-/// This class defines neutral mesh format reader
+/// @brief Spatial index to find the elements of a mesh containing given coordinates
+///
+/// The elements are stored in a bounding volume hierarchy: a binary tree in which each node holds the bounding box of
+/// its elements. Nodes are split at the median centroid along their longest direction, so the tree adapts to the local
+/// element size, and strongly graded meshes do not produce overfull or empty cells. A point is located by descending only
+/// into nodes whose box contains it, and the closest element is found by a branch-and-bound search on the box distances.
+///
+/// For the ring-based neighbourhood queries used by the stencil computers, the bounding box of the mesh is also divided in a
+/// uniform grid of cells, as before. This grid is virtual: the elements in a ring of cells are collected from the hierarchy
+/// by the cell index of their centroid, so no storage is needed for the cells.
 /// @author Willem Deconinck
 class Mesh_API Octtree : public common::Component
 {
 
-private: // typedefs
-
-  typedef std::pair<const Elements*,Uint> Point;
-  typedef boost::multi_array<std::vector<Entity> ,3> ArrayT;
-  typedef std::vector<const Point*> Pointcloud;
-
 public: // functions
   /// constructor
   Octtree( const std::string& name );
@@ -55,6 +58,17 @@ public: // functions
   /// @return if element was found
   virtual bool find_element(const RealVector& target_coord, Entity& element);
 
+  /// @brief Find the element with the centroid closest to the given coordinate
+  /// @return false only if the mesh has no elements
+  bool find_nearest_element(const RealVector& target_coord, Entity& element);
+
+  /// @brief Find the elements containing a set of coordinates, one coordinate per row.
+  /// The coordinates are processed in the order of their Morton key, so consecutive searches visit the same part of the hierarchy.
+  /// @param [out] elements  the element for each coordinate. Its comp is null if the coordinate was not found
+  /// @param [in]  closest   if true, coordinates within the bounding box of the mesh that are not inside an element get the nearest element
+  /// @return the number of coordinates for which an element was found
+  Uint find_elements(const boost::multi_array<Real,2>& coordinates, std::vector<Entity>& elements, const bool closest = false);
+
   /// Given a coordinate, find which box in the octtree it is located in
   /// @param coordinate  [in]  The coordinate to look for
   /// @param octtree_idx [out] location of the box (i,j,k) in which the coordinate sits
@@ -71,23 +85,64 @@ public: // functions
 
   void find_cell_ranks( const boost::multi_array<Real,2>& coordinates, std::vector<Uint>& ranks );
 
-  bool is_created() const { return m_octtree.num_elements()!=0; }
+  bool is_created() const { return !m_nodes.empty(); }
 
   const Uint dimension() { return m_dim; }
 
-private: // data
+private: // functions
+
+  /// Node of the bounding volume hierarchy, covering the elements [begin, end). Leaves have no children.
+  struct Node
+  {
+    Real min[3];
+    Real max[3];
+    Uint begin;
+    Uint end;
+    Uint children[2];
+
+    bool is_leaf() const { return children[0] == 0; }
+  };
+
+  /// Fill in the node for the elements [begin, end) of the permutation, and create its children
+  void build_node(const Uint node_idx, const Uint begin, const Uint end, std::vector<Uint>& permutation, const std::vector<Real>& centroids);
+
+  /// True if the coordinate lies in the box given by its minimum and maximum
+  bool box_contains(const Real* box_min, const Real* box_max, const RealVector& coord) const;
 
-  ArrayT m_octtree;
+  /// Squared distance from the coordinate to a box
+  Real box_distance2(const Real* box_min, const Real* box_max, const RealVector& coord) const;
+
+  /// Index of the uniform grid cell containing the coordinate, clamped to the grid
+  Uint cell_index(const Real coord, const Uint d) const;
+
+  /// Find the element containing the coordinate, using the given traversal stack
+  bool find_element(const RealVector& target_coord, Entity& element, std::vector<Uint>& stack) const;
+
+  bool find_nearest_element(const RealVector& target_coord, Entity& element, std::vector<Uint>& stack) const;
+
+private: // data
 
   Uint m_dim;
+
+  /// Number of cells and cell size of the uniform grid in each direction
   std::vector<Uint> m_N;
   std::vector<Real> m_D;
 
   Handle<Mesh> m_mesh;
 
-  std::vector<Uint> m_octtree_idx;
+  /// Nodes of the hierarchy, the root first
+  std::vector<Node> m_nodes;
+
+  /// The volume elements, ordered so each leaf covers a contiguous range
+  std::vector<Entity> m_elements;
+
+  /// Bounding box of each element, as 3 minimum and 3 maximum coordinates
+  std::vector<Real> m_element_boxes;
+
+  /// Grid cell of the centroid of each element, 3 indices per element
+  std::vector<Uint> m_element_cells;
 
-  std::vector<Entity> m_elements_pool;
+  std::vector<Uint> m_stack;
 
   math::BoundingBox m_bounding_box;
 
@@ -41,6 +41,8 @@ const char * Tags::connectivity_table () { return "connectivity_table"; }
 const char * Tags::event_mesh_loaded() { return "mesh_loaded"; }
 const char * Tags::event_mesh_changed() { return "mesh_changed"; }
 
+const char * Tags::cache() { return "cache"; }
+
 //const char * Tags::geometry_elements () { return "geometry_elements"; }
 
 ////////////////////////////////////////////////////////////////////////////////
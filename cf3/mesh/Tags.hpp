@@ -53,6 +53,9 @@ public:
   static const char * event_mesh_loaded();
   static const char * event_mesh_changed();
 
+  /// Tag for components holding data derived from the mesh, removed when the mesh is loaded or changed
+  static const char * cache();
+
 //  static const char * geometry_elements ();
 
 }; // Tags
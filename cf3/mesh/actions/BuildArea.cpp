@@ -19,6 +19,9 @@
 #include "mesh/Mesh.hpp"
 #include "mesh/Field.hpp"
 #include "mesh/Connectivity.hpp"
+#include "mesh/ElementData.hpp"
+#include "mesh/ElementTypeDispatch.hpp"
+#include "mesh/ElementTypes.hpp"
 
 //////////////////////////////////////////////////////////////////////////////
 
@@ -30,6 +33,56 @@ namespace actions {
 
 ////////////////////////////////////////////////////////////////////////////////
 
+namespace detail
+{
+
+/// Computes the area of each face in a block, using the static API of its element type if available
+struct ComputeAreas
+{
+  ComputeAreas(const Space& space, Field& area) :
+    m_space(space),
+    m_area(area)
+  {
+  }
+
+  template<typename ETYPE>
+  void operator()(const ETYPE&, const Entities& faces)
+  {
+    const Connectivity& geometry_connectivity = faces.geometry_space().connectivity();
+    const common::Table<Real>& coordinates = faces.geometry_fields().coordinates();
+    const Connectivity& field_connectivity = m_space.connectivity();
+    const Uint nb_elems = m_space.size();
+
+    typename ETYPE::NodesT nodes;
+    for(Uint elem_idx = 0; elem_idx != nb_elems; ++elem_idx)
+    {
+      fill(nodes, coordinates, geometry_connectivity[elem_idx]);
+      m_area[field_connectivity[elem_idx][0]][0] = ETYPE::area(nodes);
+    }
+  }
+
+  /// Fallback for element types without a static implementation
+  void operator()(const Entities& faces)
+  {
+    RealMatrix coordinates;
+    faces.geometry_space().allocate_coordinates(coordinates);
+    const Connectivity& field_connectivity = m_space.connectivity();
+    const Uint nb_elems = m_space.size();
+    for(Uint elem_idx = 0; elem_idx != nb_elems; ++elem_idx)
+    {
+      faces.geometry_space().put_coordinates(coordinates, elem_idx);
+      m_area[field_connectivity[elem_idx][0]][0] = faces.element_type().area(coordinates);
+    }
+  }
+
+  const Space& m_space;
+  Field& m_area;
+};
+
+} // detail
+
+////////////////////////////////////////////////////////////////////////////////
+
 common::ComponentBuilder < BuildArea, MeshTransformer, mesh::actions::LibActions> BuildArea_Builder;
 
 //////////////////////////////////////////////////////////////////////////////
@@ -66,13 +119,8 @@ void BuildArea::execute()
 
   boost_foreach(const Handle<Space>& space, area.spaces() )
   {
-    RealMatrix coordinates;  space->support().geometry_space().allocate_coordinates(coordinates);
-    const Connectivity& field_connectivity = space->connectivity();
-    for (Uint face_idx = 0; face_idx<space->size(); ++face_idx)
-    {
-      space->support().geometry_space().put_coordinates( coordinates, face_idx );
-      area[field_connectivity[face_idx][0]][0] = space->support().element_type().area( coordinates );
-    }
+    detail::ComputeAreas kernel(*space, area);
+    dispatch_element_type_with_fallback<FaceTypes>(space->support(), kernel);
   }
 }
 
@@ -0,0 +1,53 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include "common/Builder.hpp"
+#include "common/FindComponents.hpp"
+#include "common/Foreach.hpp"
+#include "common/PropertyList.hpp"
+
+#include "mesh/actions/BuildComputeView.hpp"
+#include "mesh/Elements.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/Region.hpp"
+
+//////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace mesh {
+namespace actions {
+
+  using namespace common;
+
+////////////////////////////////////////////////////////////////////////////////
+
+common::ComponentBuilder < BuildComputeView, MeshTransformer, mesh::actions::LibActions> BuildComputeView_Builder;
+
+//////////////////////////////////////////////////////////////////////////////
+
+BuildComputeView::BuildComputeView( const std::string& name )
+: MeshTransformer(name)
+{
+  properties()["brief"] = std::string("Build a blocked copy of the connectivity and coordinates of all elements");
+  properties()["description"] = std::string("Element loops read the copy sequentially instead of looking up the coordinates of each node.\n"
+                                            "Execute again after moving the mesh.");
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void BuildComputeView::execute()
+{
+  boost_foreach(Elements& elements, find_components_recursively<Elements>(m_mesh->topology()))
+  {
+    elements.update_compute_view();
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+} // actions
+} // mesh
+} // cf3
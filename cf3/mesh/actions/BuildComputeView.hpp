@@ -0,0 +1,50 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_mesh_actions_BuildComputeView_hpp
+#define cf3_mesh_actions_BuildComputeView_hpp
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include "mesh/MeshTransformer.hpp"
+
+#include "mesh/actions/LibActions.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace mesh {
+namespace actions {
+
+//////////////////////////////////////////////////////////////////////////////
+
+/// Build the compute view of all elements in the mesh, see mesh::ElementComputeView.
+/// Element loops that support it then read the connectivity and coordinates from the view. The views are rebuilt
+/// automatically when the mesh changes, but moving the coordinates requires executing this action again.
+class mesh_actions_API BuildComputeView : public MeshTransformer
+{
+public: // functions
+
+  /// constructor
+  BuildComputeView( const std::string& name );
+
+  /// Gets the Class name
+  static std::string type_name() { return "BuildComputeView"; }
+
+  virtual void execute();
+
+}; // end BuildComputeView
+
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // actions
+} // mesh
+} // cf3
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif // cf3_mesh_actions_BuildComputeView_hpp
@@ -19,6 +19,10 @@
 #include "mesh/Mesh.hpp"
 #include "mesh/Field.hpp"
 #include "mesh/Connectivity.hpp"
+#include "mesh/ElementData.hpp"
+#include "mesh/ElementComputeView.hpp"
+#include "mesh/ElementTypeDispatch.hpp"
+#include "mesh/ElementTypes.hpp"
 
 //////////////////////////////////////////////////////////////////////////////
 
@@ -30,6 +34,68 @@ namespace actions {
 
 ////////////////////////////////////////////////////////////////////////////////
 
+namespace detail
+{
+
+/// Computes the volume of each cell in a block, using the static API of its element type if available
+struct ComputeVolumes
+{
+  ComputeVolumes(const Space& space, Field& volume) :
+    m_space(space),
+    m_volume(volume)
+  {
+  }
+
+  template<typename ETYPE>
+  void operator()(const ETYPE&, const Entities& cells)
+  {
+    const Connectivity& geometry_connectivity = cells.geometry_space().connectivity();
+    const common::Table<Real>& coordinates = cells.geometry_fields().coordinates();
+    const Connectivity& field_connectivity = m_space.connectivity();
+    const Uint nb_elems = m_space.size();
+
+    typename ETYPE::NodesT nodes;
+    const Elements* elements = dynamic_cast<const Elements*>(&cells);
+    if(is_not_null(elements) && elements->has_compute_view())
+    {
+      const ElementComputeView& view = elements->compute_view();
+      for(Uint elem_idx = 0; elem_idx != nb_elems; ++elem_idx)
+      {
+        view.put_coordinates(elem_idx, nodes);
+        m_volume[field_connectivity[elem_idx][0]][0] = ETYPE::volume(nodes);
+      }
+      return;
+    }
+
+    for(Uint elem_idx = 0; elem_idx != nb_elems; ++elem_idx)
+    {
+      fill(nodes, coordinates, geometry_connectivity[elem_idx]);
+      m_volume[field_connectivity[elem_idx][0]][0] = ETYPE::volume(nodes);
+    }
+  }
+
+  /// Fallback for element types without a static implementation
+  void operator()(const Entities& cells)
+  {
+    RealMatrix coordinates;
+    cells.geometry_space().allocate_coordinates(coordinates);
+    const Connectivity& field_connectivity = m_space.connectivity();
+    const Uint nb_elems = m_space.size();
+    for(Uint elem_idx = 0; elem_idx != nb_elems; ++elem_idx)
+    {
+      cells.geometry_space().put_coordinates(coordinates, elem_idx);
+      m_volume[field_connectivity[elem_idx][0]][0] = cells.element_type().volume(coordinates);
+    }
+  }
+
+  const Space& m_space;
+  Field& m_volume;
+};
+
+} // detail
+
+////////////////////////////////////////////////////////////////////////////////
+
 common::ComponentBuilder < BuildVolume, MeshTransformer, mesh::actions::LibActions> BuildVolume_Builder;
 
 //////////////////////////////////////////////////////////////////////////////
@@ -66,14 +132,8 @@ void BuildVolume::execute()
 
   boost_foreach( const Handle<Space>& space, volume.spaces() )
   {
-    RealMatrix coordinates;  space->support().geometry_space().allocate_coordinates(coordinates);
-
-    const Connectivity& space_connectivity = space->connectivity();
-    for (Uint cell_idx = 0; cell_idx<space->size(); ++cell_idx)
-    {
-      space->support().geometry_space().put_coordinates( coordinates, cell_idx );
-      volume[space_connectivity[cell_idx][0]][0] = space->support().element_type().volume( coordinates );
-    }
+    detail::ComputeVolumes kernel(*space, volume);
+    dispatch_element_type_with_fallback<CellTypes>(space->support(), kernel);
   }
 
 }
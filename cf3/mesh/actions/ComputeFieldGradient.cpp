@@ -27,6 +27,9 @@
 #include "mesh/Space.hpp"
 #include "mesh/Entities.hpp"
 #include "mesh/Connectivity.hpp"
+#include "mesh/ElementData.hpp"
+#include "mesh/ElementTypeDispatch.hpp"
+#include "mesh/ElementTypes.hpp"
 
 #include "mesh/actions/ComputeFieldGradient.hpp"
 
@@ -41,6 +44,175 @@ namespace actions {
 
 ////////////////////////////////////////////////////////////////////////////////
 
+namespace detail
+{
+
+/// Computes the gradient of a field in the points of the gradient space, for all elements in a block.
+/// The jacobian of the geometric element type and the transformation to physical coordinates are fixed-size,
+/// only the number of field nodes and variables, which depend on the field, are dynamic.
+/// Element types without a static implementation use the virtual ElementType interface.
+struct ElementGradients
+{
+  ElementGradients(const Field& field, const Space& field_space, Field& grad, const Space& grad_space, const RealMatrix& n, std::vector<Uint>& shared_nodes) :
+    m_field(field),
+    m_field_space(field_space),
+    m_grad(grad),
+    m_grad_space(grad_space),
+    m_n(n),
+    m_shared_nodes(shared_nodes)
+  {
+  }
+
+  template<typename ETYPE>
+  void operator()(const ETYPE&, const Entities& entities)
+  {
+    typedef typename ETYPE::MappedCoordsT MappedCoordsT;
+    typedef typename ETYPE::JacobianT JacobianT;
+    typedef Eigen::Matrix<Real, ETYPE::dimension, ETYPE::dimension> TransformT;
+    typedef Eigen::Matrix<Real, ETYPE::dimension, Eigen::Dynamic> GradientT;
+
+    const ShapeFunction& grad_sf = m_grad_space.shape_function();
+    const Uint nb_grad_pts = grad_sf.nb_nodes();
+
+    std::vector<MappedCoordsT, Eigen::aligned_allocator<MappedCoordsT> > grad_pt_coords(nb_grad_pts);
+    std::vector<GradientT> gradient_matrix_per_point(nb_grad_pts);
+    RealMatrix gradient_matrix;
+    for (Uint grad_pt=0; grad_pt<nb_grad_pts; ++grad_pt)
+    {
+      grad_pt_coords[grad_pt] = grad_sf.local_coordinates().row(grad_pt).transpose();
+      compute_gradient_matrix(grad_pt, gradient_matrix);
+      gradient_matrix_per_point[grad_pt] = gradient_matrix;
+    }
+
+    const Connectivity& geometry_connectivity = entities.geometry_space().connectivity();
+    const common::Table<Real>& coordinates = entities.geometry_fields().coordinates();
+    const TransformT n = m_n;
+
+    RealMatrix field_element_values(m_field_space.shape_function().nb_nodes(), m_field.row_size());
+    GradientT mapped_grad_values(ETYPE::dimension, m_field.row_size());
+    GradientT grad_values(ETYPE::dimension, m_field.row_size());
+    typename ETYPE::NodesT cell_coords;
+    JacobianT jacobian;
+    TransformT transform;
+
+    // Compute the actual gradients for each element
+    const Uint nb_elems = m_grad_space.size();
+    for (Uint e=0; e<nb_elems; ++e)
+    {
+      fill(cell_coords, coordinates, geometry_connectivity[e]);
+      gather_field_values(e, field_element_values);
+
+      const Connectivity::ConstRow grad_row = m_grad_space.connectivity()[e];
+      for (Uint grad_pt=0; grad_pt<nb_grad_pts; ++grad_pt)
+      {
+        // Compute jacobian of transformation to local coordinates in grad_pt
+        ETYPE::compute_jacobian(grad_pt_coords[grad_pt], cell_coords, jacobian);
+        transform.noalias() = n * jacobian.inverse();
+        // Compute gradient
+        mapped_grad_values.noalias() = gradient_matrix_per_point[grad_pt] * field_element_values;
+        grad_values.noalias() = transform * mapped_grad_values;
+        store(grad_row[grad_pt], grad_values);
+      }
+    }
+  }
+
+  /// Fallback for element types without a static implementation
+  void operator()(const Entities& entities)
+  {
+    const ShapeFunction& grad_sf = m_grad_space.shape_function();
+    const Uint nb_grad_pts = grad_sf.nb_nodes();
+    const Uint ndim = m_n.rows();
+
+    std::vector<RealMatrix> gradient_matrix_per_point(nb_grad_pts);
+    for (Uint grad_pt=0; grad_pt<nb_grad_pts; ++grad_pt)
+      compute_gradient_matrix(grad_pt, gradient_matrix_per_point[grad_pt]);
+
+    RealMatrix field_element_values(m_field_space.shape_function().nb_nodes(), m_field.row_size());
+    RealMatrix grad_values(ndim, m_field.row_size());
+    RealMatrix jacobian(entities.element_type().dimensionality(), ndim);
+    RealMatrix cell_coords;
+    entities.geometry_space().allocate_coordinates(cell_coords);
+
+    const Uint nb_elems = m_grad_space.size();
+    for (Uint e=0; e<nb_elems; ++e)
+    {
+      entities.geometry_space().put_coordinates(cell_coords, e);
+      gather_field_values(e, field_element_values);
+
+      const Connectivity::ConstRow grad_row = m_grad_space.connectivity()[e];
+      for (Uint grad_pt=0; grad_pt<nb_grad_pts; ++grad_pt)
+      {
+        entities.element_type().compute_jacobian(grad_sf.local_coordinates().row(grad_pt), cell_coords, jacobian);
+        grad_values.noalias() = m_n * jacobian.inverse() * gradient_matrix_per_point[grad_pt] * field_element_values;
+        store(grad_row[grad_pt], grad_values);
+      }
+    }
+  }
+
+  /// Gradient of the field shape functions in mapped coordinates, at a point of the gradient space
+  void compute_gradient_matrix(const Uint grad_pt, RealMatrix& gradient_matrix) const
+  {
+    const ShapeFunction& field_sf = m_field_space.shape_function();
+    gradient_matrix.resize(m_n.rows(), field_sf.nb_nodes());
+    field_sf.compute_gradient(m_grad_space.shape_function().local_coordinates().row(grad_pt), gradient_matrix);
+  }
+
+  /// Assemble the field values of an element in a matrix
+  void gather_field_values(const Uint e, RealMatrix& field_element_values) const
+  {
+    const Connectivity::ConstRow field_row = m_field_space.connectivity()[e];
+    const Uint nb_vars = m_field.row_size();
+    for (Uint node=0; node<field_row.size(); ++node)
+    {
+      const Uint p = field_row[node];
+      for (Uint v=0; v<nb_vars; ++v)
+      {
+        field_element_values(node,v) = m_field[p][v];
+      }
+    }
+  }
+
+  /// Store the gradient in point p of the gradient field
+  template<typename GradientT>
+  void store(const Uint p, const GradientT& grad_values)
+  {
+    const Uint nb_vars = m_field.row_size();
+    const Uint ndim = grad_values.rows();
+    if (m_grad.continuous()) // just sum up, and divide by shared_nodes[p] later to average
+    {
+      m_shared_nodes[p] += 1;
+      for (Uint d=0; d<ndim; ++d)
+      {
+        for (Uint v=0; v<nb_vars; ++v)
+        {
+          m_grad[p][v+d*nb_vars] += grad_values(d,v);
+        }
+      }
+    }
+    else // if discontinuous
+    {
+      for (Uint d=0; d<ndim; ++d)
+      {
+        for (Uint v=0; v<nb_vars; ++v)
+        {
+          m_grad[p][v+d*nb_vars] = grad_values(d,v);
+        }
+      }
+    }
+  }
+
+  const Field& m_field;
+  const Space& m_field_space;
+  Field& m_grad;
+  const Space& m_grad_space;
+  const RealMatrix& m_n;
+  std::vector<Uint>& m_shared_nodes;
+};
+
+} // detail
+
+////////////////////////////////////////////////////////////////////////////////
+
 common::ComponentBuilder < ComputeFieldGradient, MeshTransformer, mesh::actions::LibActions> ComputeFieldGradient_Builder;
 
 //////////////////////////////////////////////////////////////////////////////
@@ -126,75 +298,10 @@ void ComputeFieldGradient::execute()
     {
       if (field.dict().defined_for_entities( grad_space.support().handle<Entities>() ) == false )
         throw SetupError(FromHere(), "Field "+field.uri().string()+" is not defined for elements "+grad_space.support().uri().string());
-      Space& field_space = grad_space.support().space(field.dict());
-
-
-      // Compute interpolation matrices to compute the gradient of
-      // field_space in coordinates of grad_space
-      std::vector<RealMatrix> gradient_matrix_per_point (grad_space.shape_function().nb_nodes());
-      for (Uint grad_pt=0; grad_pt<gradient_matrix_per_point.size(); ++grad_pt)
-      {
-        gradient_matrix_per_point[grad_pt].resize(ndim,field_space.shape_function().nb_nodes());
-        field_space.shape_function().compute_gradient(grad_space.shape_function().local_coordinates().row(grad_pt),
-                                                      gradient_matrix_per_point[grad_pt]);
-      }
-
-      RealMatrix field_element_values( field_space.shape_function().nb_nodes() , field.row_size() );
-      RealMatrix grad_values (ndim,field.row_size());
+      const Space& field_space = grad_space.support().space(field.dict());
 
-      RealMatrix jacobian(field_space.shape_function().dimensionality(),ndim);
-      RealMatrix cell_coords;
-      Entities& entities = field_space.support();
-      entities.geometry_space().allocate_coordinates(cell_coords);
-      // Compute the actual gradients for each element
-      for (Uint e=0; e<grad_space.size(); ++e)
-      {
-        entities.geometry_space().put_coordinates(cell_coords,e);
-
-        // Assemble field values in a matrix
-        for (Uint node=0; node<field_space.shape_function().nb_nodes(); ++node)
-        {
-          Uint p = field_space.connectivity()[e][node];
-          for (Uint v=0; v<field.row_size(); ++v)
-          {
-            field_element_values(node,v) = field[p][v];
-          }
-        }
-
-        for (Uint grad_pt=0; grad_pt<grad_space.shape_function().nb_nodes(); ++grad_pt)
-        {
-          // Compute jacobian of transformation to local coordinates in grad_pt
-          entities.element_type().compute_jacobian(grad_space.shape_function().local_coordinates().row(grad_pt),
-                                                   cell_coords,
-                                                   jacobian);
-          // Compute gradient
-          grad_values.noalias() = n * jacobian.inverse() * gradient_matrix_per_point[grad_pt] * field_element_values;
-
-          Uint p = grad_space.connectivity()[e][grad_pt];
-
-          if (grad.continuous()) // just sum up, and divide by shared_nodes[p] later to average
-          {
-            shared_nodes[p] += 1;
-            for (Uint d=0; d<ndim; ++d)
-            {
-              for (Uint v=0; v<field.row_size(); ++v)
-              {
-                grad[p][v+d*field.row_size()] += grad_values(d,v);
-              }
-            }
-          }
-          else // if discontinuous
-          {
-            for (Uint d=0; d<ndim; ++d)
-            {
-              for (Uint v=0; v<field.row_size(); ++v)
-              {
-                grad[p][v+d*field.row_size()] = grad_values(d,v);
-              }
-            }
-          }
-        }
-      }
+      detail::ElementGradients kernel(field, field_space, grad, grad_space, n, shared_nodes);
+      dispatch_element_type_with_fallback<CellTypes>(grad_space.support(), kernel);
     }
   }
 
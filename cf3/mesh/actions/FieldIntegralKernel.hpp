@@ -0,0 +1,229 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_mesh_actions_FieldIntegralKernel_hpp
+#define cf3_mesh_actions_FieldIntegralKernel_hpp
+
+#include <cmath>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include <Eigen/StdVector>
+
+#include "math/MatrixTypes.hpp"
+
+#include "mesh/Connectivity.hpp"
+#include "mesh/Dictionary.hpp"
+#include "mesh/ElementType.hpp"
+#include "mesh/ElementData.hpp"
+#include "mesh/Entities.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/Quadrature.hpp"
+#include "mesh/ShapeFunction.hpp"
+#include "mesh/Space.hpp"
+#include "mesh/gausslegendre/SumFactorization.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace mesh {
+namespace actions {
+namespace detail {
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Sum factorization that interpolates a field with shape function sf to exactly the points of the quadrature, or null if
+/// there is none. The number of points in each direction is derived from the number of quadrature points, and the points and
+/// weights are compared with those of the quadrature, so only tensor-product Gauss-Legendre quadratures qualify.
+inline boost::shared_ptr<gausslegendre::SumFactorization> create_sum_factorization(const Quadrature& quadrature, const ShapeFunction& sf)
+{
+  boost::shared_ptr<gausslegendre::SumFactorization> result;
+  if(quadrature.shape() != sf.shape())
+    return result;
+
+  const Uint dim = sf.dimensionality();
+  const Uint nb_qdr_pts = quadrature.nb_nodes();
+  const Uint nb_qdr_pts_1d = static_cast<Uint>(std::pow(static_cast<Real>(nb_qdr_pts), 1. / dim) + 0.5);
+  Uint nb_tensor_pts = 1;
+  for(Uint d = 0; d != dim; ++d)
+    nb_tensor_pts *= nb_qdr_pts_1d;
+  if(nb_qdr_pts_1d == 0 || nb_tensor_pts != nb_qdr_pts)
+    return result;
+
+  result = gausslegendre::SumFactorization::create(sf, nb_qdr_pts_1d);
+  if(!result)
+    return result;
+
+  for(Uint qn = 0; qn != nb_qdr_pts; ++qn)
+  {
+    bool same_point = std::abs(result->qdr_weights()[qn] - quadrature.weights()[qn]) < 1e-12;
+    for(Uint d = 0; d != dim; ++d)
+      same_point = same_point && std::abs(result->qdr_local_coordinates()(qn, d) - quadrature.local_coordinates()(qn, d)) < 1e-12;
+    if(!same_point)
+      return boost::shared_ptr<gausslegendre::SumFactorization>();
+  }
+
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Adds the integral of the first variable of a field over the owned elements of a block to the result.
+/// To be used with dispatch_element_type_with_fallback, so the jacobian determinant is computed with the fixed-size
+/// static API of the geometric element type when it is known. If a sum factorization is given (see create_sum_factorization),
+/// the field is interpolated to the Gauss points with it.
+struct FieldIntegralKernel
+{
+  FieldIntegralKernel(const Field& field, const Quadrature& quadrature, const gausslegendre::SumFactorization* sum_factorization, Real& result) :
+    m_field(field),
+    m_quadrature(quadrature),
+    m_sum_factorization(sum_factorization),
+    m_result(result)
+  {
+  }
+
+  template<typename ETYPE>
+  void operator()(const ETYPE&, const Entities& patch)
+  {
+    typedef typename ETYPE::MappedCoordsT MappedCoordsT;
+    typedef typename ETYPE::NodesT NodesT;
+
+    if(m_sum_factorization != 0)
+    {
+      integrate_sum_factorization<ETYPE>(patch, *m_sum_factorization);
+      return;
+    }
+
+    const Space& space = m_field.space(patch);
+    const ShapeFunction& sf = space.shape_function();
+
+    const Connectivity& field_connectivity = space.connectivity();
+    const Connectivity& geometry_connectivity = patch.geometry_space().connectivity();
+    const common::Table<Real>& coordinates = patch.geometry_fields().coordinates();
+    const Uint nb_elems = space.size();
+    const Uint nb_field_nodes = sf.nb_nodes();
+    const Uint nb_qdr_pts = m_quadrature.nb_nodes();
+
+    // Quadrature point locations and weighted interpolation coefficients are the same for all elements
+    std::vector<MappedCoordsT, Eigen::aligned_allocator<MappedCoordsT> > mapped_coords(nb_qdr_pts);
+    RealMatrix weighted_interpolation(nb_qdr_pts, nb_field_nodes);
+    for(Uint qn = 0; qn != nb_qdr_pts; ++qn)
+    {
+      mapped_coords[qn] = m_quadrature.local_coordinates().row(qn).transpose();
+      weighted_interpolation.row(qn) = m_quadrature.weights()[qn] * sf.value(m_quadrature.local_coordinates().row(qn));
+    }
+
+    NodesT nodes;
+    Real local_integral = 0.;
+    for(Uint e = 0; e != nb_elems; ++e)
+    {
+      if(patch.is_ghost(e))
+        continue;
+
+      fill(nodes, coordinates, geometry_connectivity[e]);
+      const Connectivity::ConstRow field_row = field_connectivity[e];
+      for(Uint qn = 0; qn != nb_qdr_pts; ++qn)
+      {
+        Real qdr_pt_value = 0.;
+        for(Uint n = 0; n != nb_field_nodes; ++n)
+          qdr_pt_value += weighted_interpolation(qn, n) * m_field[field_row[n]][0];
+        local_integral += ETYPE::jacobian_determinant(mapped_coords[qn], nodes) * qdr_pt_value;
+      }
+    }
+    m_result += local_integral;
+  }
+
+  /// Fallback for element types without a static implementation, using the virtual ElementType interface
+  void operator()(const Entities& patch)
+  {
+    const Space& space = m_field.space(patch);
+    const ShapeFunction& sf = space.shape_function();
+    const Connectivity& field_connectivity = space.connectivity();
+    const Uint nb_elems = space.size();
+    const Uint nb_field_nodes = sf.nb_nodes();
+    const Uint nb_qdr_pts = m_quadrature.nb_nodes();
+
+    RealMatrix weighted_interpolation(nb_qdr_pts, nb_field_nodes);
+    for(Uint qn = 0; qn != nb_qdr_pts; ++qn)
+      weighted_interpolation.row(qn) = m_quadrature.weights()[qn] * sf.value(m_quadrature.local_coordinates().row(qn));
+
+    RealMatrix nodes;
+    patch.geometry_space().allocate_coordinates(nodes);
+    Real local_integral = 0.;
+    for(Uint e = 0; e != nb_elems; ++e)
+    {
+      if(patch.is_ghost(e))
+        continue;
+
+      patch.geometry_space().put_coordinates(nodes, e);
+      const Connectivity::ConstRow field_row = field_connectivity[e];
+      for(Uint qn = 0; qn != nb_qdr_pts; ++qn)
+      {
+        Real qdr_pt_value = 0.;
+        for(Uint n = 0; n != nb_field_nodes; ++n)
+          qdr_pt_value += weighted_interpolation(qn, n) * m_field[field_row[n]][0];
+        local_integral += patch.element_type().jacobian_determinant(m_quadrature.local_coordinates().row(qn), nodes) * qdr_pt_value;
+      }
+    }
+    m_result += local_integral;
+  }
+
+  /// Same integral, interpolating the field to the tensor-product Gauss points of the sum factorization
+  template<typename ETYPE>
+  void integrate_sum_factorization(const Entities& patch, const gausslegendre::SumFactorization& sum_factorization)
+  {
+    typedef typename ETYPE::MappedCoordsT MappedCoordsT;
+    typedef typename ETYPE::NodesT NodesT;
+
+    const Space& space = m_field.space(patch);
+    const Connectivity& field_connectivity = space.connectivity();
+    const Connectivity& geometry_connectivity = patch.geometry_space().connectivity();
+    const common::Table<Real>& coordinates = patch.geometry_fields().coordinates();
+    const Uint nb_elems = space.size();
+    const Uint nb_field_nodes = sum_factorization.nb_nodes();
+    const Uint nb_qdr_pts = sum_factorization.nb_qdr_pts();
+
+    std::vector<MappedCoordsT, Eigen::aligned_allocator<MappedCoordsT> > mapped_coords(nb_qdr_pts);
+    for(Uint qn = 0; qn != nb_qdr_pts; ++qn)
+      mapped_coords[qn] = sum_factorization.qdr_local_coordinates().row(qn).transpose();
+
+    NodesT nodes;
+    std::vector<Real> nodal_values(nb_field_nodes);
+    std::vector<Real> qdr_values(nb_qdr_pts);
+    Real local_integral = 0.;
+    for(Uint e = 0; e != nb_elems; ++e)
+    {
+      if(patch.is_ghost(e))
+        continue;
+
+      fill(nodes, coordinates, geometry_connectivity[e]);
+      const Connectivity::ConstRow field_row = field_connectivity[e];
+      for(Uint n = 0; n != nb_field_nodes; ++n)
+        nodal_values[n] = m_field[field_row[n]][0];
+      sum_factorization.interpolate(&nodal_values[0], &qdr_values[0]);
+      for(Uint qn = 0; qn != nb_qdr_pts; ++qn)
+        local_integral += sum_factorization.qdr_weights()[qn] * ETYPE::jacobian_determinant(mapped_coords[qn], nodes) * qdr_values[qn];
+    }
+    m_result += local_integral;
+  }
+
+  const Field& m_field;
+  const Quadrature& m_quadrature;
+  const gausslegendre::SumFactorization* m_sum_factorization;
+  Real& m_result;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // detail
+} // actions
+} // mesh
+} // cf3
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif // cf3_mesh_actions_FieldIntegralKernel_hpp
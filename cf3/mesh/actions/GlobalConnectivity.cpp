@@ -4,6 +4,8 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <map>
+
 #include <boost/foreach.hpp>
 #include <boost/static_assert.hpp>
 
@@ -84,7 +86,7 @@ void GlobalConnectivity::execute()
   // 1) make std::map<glb_node_idx,loc_node_idx>
   // 2) Make node2elem connectivity (does not contain elements from other partitions)
   // 3) foreach ghostnode, store connected owned elements
-  // 4) broadcast (3) to all, and store the map node to ghost elements
+  // 4) send (3) to the rank owning the node, and store the map node to ghost elements
   // 5) create the node to glb_elem_connectivity, as the combination of (2) and (4)
 
 
@@ -103,34 +105,25 @@ void GlobalConnectivity::execute()
 
 
   // 3)
-  Uint nb_ghost(0);
-  for (Uint i=0; i<nodes.size(); ++i)
-    if (nodes.is_ghost(i))
-      ++nb_ghost;
-
-  std::vector<Uint> ghostnode_glb_idx(nb_ghost);
-  std::vector<Uint> ghostnode_glb_elem_connectivity;
-  std::vector<Uint> ghostnode_glb_elem_connectivity_start(nb_ghost+1);
-  ghostnode_glb_elem_connectivity_start[0]=0;
+  // For each owning rank: the ghost node global index, the number of connected elements and their global indices
+  std::map< int, std::vector<Uint> > ghostnode_glb_elem_connectivity;
   Handle< Component > elem_comp;
   Uint elem_idx;
 
-  Uint cnt(0);
   for (Uint i=0; i<mesh.geometry_fields().size(); ++i)
   {
     if (mesh.geometry_fields().is_ghost(i))
     {
-      ghostnode_glb_idx[cnt] = nodes_glb_idx[i];
+      std::vector<Uint>& send_buffer = ghostnode_glb_elem_connectivity[nodes.rank()[i]];
+      send_buffer.push_back(nodes_glb_idx[i]);
 
       DynTable<Uint>::ConstRow elems = node2elem.connectivity()[i];
+      send_buffer.push_back(elems.size());
       boost_foreach(const Uint e, elems)
       {
         boost::tie(elem_comp,elem_idx) = node2elem.elements().location(e);
-        ghostnode_glb_elem_connectivity.push_back(dynamic_cast<Elements&>(*elem_comp).glb_idx()[elem_idx]);
+        send_buffer.push_back(dynamic_cast<Elements&>(*elem_comp).glb_idx()[elem_idx]);
       }
-      ghostnode_glb_elem_connectivity_start[cnt+1] = ghostnode_glb_elem_connectivity_start[cnt] + elems.size();
-
-      ++cnt;
     }
   }
 
@@ -138,35 +131,23 @@ void GlobalConnectivity::execute()
   std::vector<std::vector<Uint> > glb_elem_connectivity(nodes.size());
   nodes_glb_idx.resize(mesh.geometry_fields().size());
 
-  for (Uint root=0; root<PE::Comm::instance().size(); ++root)
+  if (PE::Comm::instance().is_active())
   {
-    std::vector<Uint> rcv_glb_node_idx(0);//ghostnode_glb_idx.size());
-    PE::Comm::instance().broadcast(ghostnode_glb_idx,rcv_glb_node_idx,root);
-    std::vector<Uint> rcv_glb_elem_connectivity(0);//ghostnode_glb_elem_connectivity.size());
-    PE::Comm::instance().broadcast(ghostnode_glb_elem_connectivity,rcv_glb_elem_connectivity,root);
-    std::vector<Uint> rcv_glb_elem_connectivity_start(0);//ghostnode_glb_elem_connectivity_start.size());
-    PE::Comm::instance().broadcast(ghostnode_glb_elem_connectivity_start,rcv_glb_elem_connectivity_start,root);
-
-    if (PE::Comm::instance().rank() != root)
+    std::map< int, std::vector<Uint> > rcv_glb_elem_connectivity;
+    PE::Comm::instance().sparse_all_to_all(ghostnode_glb_elem_connectivity, rcv_glb_elem_connectivity);
+
+    for (std::map< int, std::vector<Uint> >::const_iterator it = rcv_glb_elem_connectivity.begin(); it != rcv_glb_elem_connectivity.end(); ++it)
     {
-      for (Uint p=0; p<PE::Comm::instance().size(); ++p)
+      const std::vector<Uint>& rcv_buffer = it->second;
+      Uint rcv_idx(0);
+      while (rcv_idx < rcv_buffer.size())
       {
-        if (p == PE::Comm::instance().rank())
-        {
-          Uint rcv_idx(0);
-          boost_foreach(const std::size_t glb_node, rcv_glb_node_idx)
-          {
-            if (node_glb2loc.find(glb_node) != node_glb2loc.end())
-            {
-              //std::cout << "["<<PE::Comm::instance().rank() << "] owns ghostnode " << glb_node << " of [" << root << "]" << std::endl;
-              Uint loc_node_idx = node_glb2loc[glb_node];
-              for(Uint l=rcv_glb_elem_connectivity_start[rcv_idx]; l<rcv_glb_elem_connectivity_start[rcv_idx+1]; ++l)
-                glb_elem_connectivity[loc_node_idx].push_back(rcv_glb_elem_connectivity[l]);
-            }
-            ++rcv_idx;
-          }
-          break;
-        }
+        const Uint glb_node = rcv_buffer[rcv_idx++];
+        const Uint nb_elems = rcv_buffer[rcv_idx++];
+        std::map<Uint,Uint>::const_iterator found = node_glb2loc.find(glb_node);
+        if (found != node_glb2loc.end())
+          glb_elem_connectivity[found->second].insert(glb_elem_connectivity[found->second].end(), rcv_buffer.begin()+rcv_idx, rcv_buffer.begin()+rcv_idx+nb_elems);
+        rcv_idx += nb_elems;
       }
     }
   }
@@ -183,7 +164,7 @@ void GlobalConnectivity::execute()
     cf3_assert(i<nodes_glb_elem_connectivity.size());
     cf3_assert(i<glb_elem_connectivity.size());
     nodes_glb_elem_connectivity[i].resize(glb_elem_connectivity[i].size() + elems.size());
-    cnt = 0;
+    Uint cnt = 0;
     boost_foreach(const Uint e, elems)
     {
       cf3_assert(e<node2elem.elements().size());
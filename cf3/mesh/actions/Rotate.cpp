@@ -115,6 +115,9 @@ void Rotate::execute()
   {
     throw common::InvalidStructure(FromHere(),"Cannot rotate a mesh of dimension "+common::to_str(m_mesh->dimension()));
   }
+
+  // The compute views hold a copy of the coordinates
+  m_mesh->update_compute_views();
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -69,6 +69,9 @@ void Translate::execute()
         point[d] += vec[d];
     }
   }
+
+  // The compute views hold a copy of the coordinates
+  m_mesh->update_compute_views();
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -21,10 +21,13 @@
 #include "mesh/Field.hpp"
 #include "mesh/ShapeFunction.hpp"
 #include "mesh/ElementType.hpp"
+#include "mesh/ElementTypeDispatch.hpp"
+#include "mesh/ElementTypes.hpp"
 #include "mesh/Entities.hpp"
 #include "mesh/Quadrature.hpp"
 #include "mesh/Connectivity.hpp"
 
+#include "mesh/actions/FieldIntegralKernel.hpp"
 #include "mesh/actions/VolumeIntegral.hpp"
 
 //////////////////////////////////////////////////////////////////////////////
@@ -125,56 +128,9 @@ Real VolumeIntegral::integrate(const Field& field, const std::vector< Handle<Ent
     if( patch->element_type().dimensionality() != patch->element_type().dimension() )
       throw SetupError( FromHere(), "Cannot compute Volume integral of surface element");
 
-    if( is_not_null(m_quadrature) )
-      remove_component("quadrature");
-    m_quadrature = create_component<Quadrature>("quadrature",
-        "cf3.mesh.gausslegendre."+GeoShape::Convert::instance().to_str(patch->element_type().shape())+"P"+common::to_str(m_order));
-
-    /// Common part for every element of this patch
-    const Space& space = field.space(*patch);
-    const Uint nb_elems = space.size();
-    const Uint nb_nodes_per_elem = space.shape_function().nb_nodes();
-    const Uint nb_qdr_pts = m_quadrature->nb_nodes();
-    const Uint nb_vars = field.row_size();
-
-    RealMatrix qdr_pt_values( nb_qdr_pts, nb_vars );
-    RealMatrix interpolate( nb_qdr_pts, nb_nodes_per_elem );
-    RealMatrix field_pt_values( nb_nodes_per_elem, nb_vars );
-    RealMatrix elem_coords;
-
-    patch->geometry_space().allocate_coordinates(elem_coords);
-
-    for( Uint qn=0; qn<nb_qdr_pts; ++qn)
-    {
-      interpolate.row(qn) = space.shape_function().value( m_quadrature->local_coordinates().row(qn) );
-    }
-
-    /// Loop over every element of this patch
-    for (Uint e=0; e<nb_elems; ++e)
-    {
-      if( ! patch->is_ghost(e) )
-      {
-        patch->geometry_space().put_coordinates(elem_coords,e);
-
-        // interpolate
-        for (Uint n=0; n<nb_nodes_per_elem; ++n)
-        {
-          const Uint p = space.connectivity()[e][n];
-          for (Uint v=0; v<nb_vars; ++v)
-          {
-            field_pt_values(n,v) = field[p][v];
-          }
-        }
-        qdr_pt_values = interpolate * field_pt_values;
-
-        // integrate
-        for( Uint qn=0; qn<nb_qdr_pts; ++qn)
-        {
-          const Real Jdet = patch->element_type().jacobian_determinant( m_quadrature->local_coordinates().row(qn), elem_coords );
-          local_integral += Jdet * m_quadrature->weights()[qn] * qdr_pt_values(qn,0);
-        }
-      }
-    }
+    const Quadrature& patch_quadrature = quadrature(patch->element_type());
+    detail::FieldIntegralKernel kernel(field, patch_quadrature, sum_factorization(patch_quadrature, field.space(*patch).shape_function()), local_integral);
+    dispatch_element_type_with_fallback<CellTypes>(*patch, kernel);
   }
   Real global_integral;
   PE::Comm::instance().all_reduce(PE::plus(), &local_integral, 1, &global_integral);
@@ -183,6 +139,30 @@ Real VolumeIntegral::integrate(const Field& field, const std::vector< Handle<Ent
 
 //////////////////////////////////////////////////////////////////////////////
 
+const Quadrature& VolumeIntegral::quadrature(const ElementType& etype)
+{
+  // Quadratures are kept for later calls, one for each shape and order
+  const std::string quadrature_name = GeoShape::Convert::instance().to_str(etype.shape())+"P"+common::to_str(m_order);
+  m_quadrature = Handle<Quadrature>(get_child("quadrature_"+quadrature_name));
+  if(is_null(m_quadrature))
+    m_quadrature = create_component<Quadrature>("quadrature_"+quadrature_name, "cf3.mesh.gausslegendre."+quadrature_name);
+  return *m_quadrature;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+const gausslegendre::SumFactorization* VolumeIntegral::sum_factorization(const Quadrature& quadrature, const ShapeFunction& sf)
+{
+  // Kept for later calls like the quadratures, with a null entry if sum factorization does not apply
+  const std::string key = quadrature.name()+"_"+sf.derived_type_name();
+  SumFactorizationsT::iterator found = m_sum_factorizations.find(key);
+  if(found == m_sum_factorizations.end())
+    found = m_sum_factorizations.insert(std::make_pair(key, detail::create_sum_factorization(quadrature, sf))).first;
+  return found->second.get();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
 void VolumeIntegral::signal_integrate ( common::SignalArgs& node )
 {
   common::XML::SignalOptions options( node );
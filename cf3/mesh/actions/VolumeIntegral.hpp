@@ -9,6 +9,10 @@
 
 ////////////////////////////////////////////////////////////////////////////////
 
+#include <map>
+
+#include <boost/shared_ptr.hpp>
+
 #include "common/Action.hpp"
 #include "mesh/actions/LibActions.hpp"
 
@@ -21,6 +25,10 @@ namespace mesh {
   class Field;
   class Entities;
   class Quadrature;
+  class ElementType;
+  class ShapeFunction;
+
+namespace gausslegendre { class SumFactorization; }
   
 namespace actions {
 
@@ -59,11 +67,20 @@ public: // functions
 
 private:
 
+  /// Quadrature for the given element type, created on first use
+  const Quadrature& quadrature(const ElementType& etype);
+
+  /// Sum factorization of the given shape function for the given quadrature, or null if it does not apply
+  const gausslegendre::SumFactorization* sum_factorization(const Quadrature& quadrature, const ShapeFunction& sf);
+
   Uint m_order;
   Handle<Field> m_field;
   std::vector< Handle<Region> > m_regions;
   Handle<Quadrature> m_quadrature;
 
+  typedef std::map< std::string, boost::shared_ptr<gausslegendre::SumFactorization> > SumFactorizationsT;
+  SumFactorizationsT m_sum_factorizations;
+
 }; // end VolumeIntegral
 
 
@@ -24,7 +24,8 @@
 #include "mesh/Field.hpp"
 #include "mesh/Functions.hpp"
 #include "mesh/Connectivity.hpp"
-#include "mesh/ElementData.hpp"
+#include "mesh/ElementTypeDispatch.hpp"
+#include "mesh/ElementTypes.hpp"
 
 #include "mesh/LagrangeP1/Triag2D.hpp"
 #include "mesh/LagrangeP1/Quad2D.hpp"
@@ -46,56 +47,104 @@ common::ComponentBuilder < WallDistance, MeshTransformer, mesh::actions::LibActi
 namespace detail
 {
 
+/// Computes the unit normal of each element in a block of surface elements, using the static API of its element type.
+/// The normals are stored consecutively, starting at the given element index, and the number of nodes of each element
+/// is stored for WallProjection. Elements it does not support get zero nodes.
+struct SurfaceNormals
+{
+  SurfaceNormals(const Uint first_element, std::vector<Real>& normals, std::vector<Uint>& nb_nodes) :
+    m_first_element(first_element),
+    m_normals(normals),
+    m_nb_nodes(nb_nodes)
+  {
+  }
+
+  template<typename ETYPE>
+  void operator()(const ETYPE&, const Entities& surface)
+  {
+    // Only first order lines, triangles and quads are supported by WallProjection, which raises the error for the others
+    if(ETYPE::order != 1 || ETYPE::nb_nodes < 2 || ETYPE::nb_nodes > 4)
+      return;
+
+    const Connectivity& geometry_connectivity = surface.geometry_space().connectivity();
+    const common::Table<Real>& coordinates = surface.geometry_fields().coordinates();
+    const Uint nb_elems = surface.size();
+
+    typename ETYPE::NodesT nodes;
+    typename ETYPE::CoordsT normal;
+    for(Uint elem_idx = 0; elem_idx != nb_elems; ++elem_idx)
+    {
+      fill(nodes, coordinates, geometry_connectivity[elem_idx]);
+      ETYPE::compute_normal(nodes, normal);
+      normal.normalize();
+      Real* normal_begin = &m_normals[(m_first_element + elem_idx)*ETYPE::dimension];
+      for(Uint d = 0; d != ETYPE::dimension; ++d)
+        normal_begin[d] = normal[d];
+      m_nb_nodes[m_first_element + elem_idx] = ETYPE::nb_nodes;
+    }
+  }
+
+  /// Element types without a static implementation are not supported
+  void operator()(const Entities&)
+  {
+  }
+
+  const Uint m_first_element;
+  std::vector<Real>& m_normals;
+  std::vector<Uint>& m_nb_nodes;
+};
+
 /// Helper struct to handle projection to the wall near a given surface node
 struct WallProjection
 {
-  WallProjection(const Field& coordinates, const CNodeConnectivity& node_connectivity) :
+  WallProjection(const Field& coordinates, const CNodeConnectivity& node_connectivity, const std::vector<Real>& normals, const std::vector<Uint>& nb_nodes) :
     m_coords(coordinates),
-    m_node_connectivity(node_connectivity)
+    m_node_connectivity(node_connectivity),
+    m_normals(normals),
+    m_nb_nodes(nb_nodes)
   {
   }
 
   // Get the wall distance for an inner node, looking at the elements that are adjacent to the given surface node
   Real operator()(const Uint inner_node_idx, const Uint surface_node_idx)
   {
-    RealMatrix elem_coords;
     const Uint dim = m_coords.row_size();
     const RealVector inner_coord = to_vector(m_coords[inner_node_idx]);
     std::vector<Uint> neighbor_nodes; // Collect neighboring nodes, so we can project onto a sharp corner in 3D if needed (i.e. near a step)
     // Loop over all surface elements around the given node
     BOOST_FOREACH(const Uint elem_idx, m_node_connectivity.node_element_range(surface_node_idx))
     {
-      // Get the element coordinates
       const CNodeConnectivity::ElementReferenceT element_ref = m_node_connectivity.element(elem_idx);
-      const ElementType& etype = element_ref.first->element_type();
-      const Uint element_nb_nodes = etype.nb_nodes();
-      elem_coords.resize(element_nb_nodes, dim);
-      const Connectivity::ConstRow conn_row = element_ref.first->geometry_space().connectivity()[element_ref.second];
-      fill(elem_coords, m_coords, conn_row);
+      const Uint element_nb_nodes = m_nb_nodes[elem_idx];
 
-      // We consider lines, triangles and quads as viable surface elements
-      if(element_nb_nodes < 2 || element_nb_nodes > 4 || etype.order() != 1)
+      // We consider first order lines, triangles and quads as viable surface elements
+      if(element_nb_nodes == 0)
       {
-        throw common::SetupError(FromHere(), "Unsupported surface element of type " + etype.name() + " in surface region " + element_ref.first->uri().path());
+        throw common::SetupError(FromHere(), "Unsupported surface element of type " + element_ref.first->element_type().name() + " in surface region " + element_ref.first->uri().path());
       }
+
+      // Get the element coordinates
+      const Connectivity::ConstRow conn_row = element_ref.first->geometry_space().connectivity()[element_ref.second];
       
       bool in_element = false;
 
       if(element_nb_nodes == 2) // line segment
       {
         cf3_assert(dim == 2);
-        cf3_assert(etype.shape() == GeoShape::LINE);
-        RealVector e1 = elem_coords.row(1) - elem_coords.row(0); // line segment vector
+        Eigen::Matrix<Real, 2, 2> line_coords;
+        fill(line_coords, m_coords, conn_row);
+        RealVector2 e1 = line_coords.row(1) - line_coords.row(0); // line segment vector
         Real e1_len = e1.norm();
         e1 /= e1_len;
-        const Real projection = e1.dot(inner_coord - elem_coords.row(0).transpose());
+        const Real projection = e1.dot(inner_coord - line_coords.row(0).transpose());
         // If the projection of the node along the normal fits inside the element, we can take the normal distance
         in_element = projection > 0 && projection < e1_len;
       }
       if(element_nb_nodes == 3)
       {
         cf3_assert(dim == 3);
-        cf3_assert(etype.shape() == GeoShape::TRIAG);
+        Eigen::Matrix<Real, 3, 3> elem_coords;
+        fill(elem_coords, m_coords, conn_row);
         RealVector3 e1 = (elem_coords.row(1) - elem_coords.row(0)).normalized();
         RealVector3 en = elem_coords.row(2) - elem_coords.row(0);
         RealVector3 e2 = (e1.cross(en)).cross(e1).normalized();
@@ -134,7 +183,8 @@ struct WallProjection
       if(element_nb_nodes == 4)
       {
         cf3_assert(dim == 3);
-        cf3_assert(etype.shape() == GeoShape::QUAD);
+        Eigen::Matrix<Real, 4, 3> elem_coords;
+        fill(elem_coords, m_coords, conn_row);
         RealVector3 e1 = (elem_coords.row(1) - elem_coords.row(0)).normalized();
         RealVector3 en = elem_coords.row(3) - elem_coords.row(0);
         RealVector3 e2 = (e1.cross(en)).cross(e1).normalized();
@@ -170,9 +220,12 @@ struct WallProjection
       // If the projection was in an element, we can just proceed to compute the normal distance
       if(in_element)
       {
-        RealVector n(dim); // normal vector
-        etype.compute_normal(elem_coords, n);
-        return fabs((n/n.norm()).dot(inner_coord - elem_coords.row(0).transpose()));
+        const Real* n = &m_normals[elem_idx*dim]; // unit normal vector
+        const common::Table<Real>::ConstRow origin = m_coords[conn_row[0]];
+        Real distance = 0.;
+        for(Uint d = 0; d != dim; ++d)
+          distance += n[d] * (inner_coord[d] - origin[d]);
+        return fabs(distance);
       }
     }
     // If we got here, no projections on the elements gave a result
@@ -195,6 +248,8 @@ struct WallProjection
 
   const Field& m_coords;
   const CNodeConnectivity& m_node_connectivity;
+  const std::vector<Real>& m_normals;
+  const std::vector<Uint>& m_nb_nodes;
 };
 }
 
@@ -232,7 +287,18 @@ void WallDistance::execute()
   const common::List<Uint>& surface_nodes = *surface_nodes_ptr;
   const Uint nb_surface_nodes = surface_nodes.size();
 
-  detail::WallProjection normal_distance(coords, *node_connectivity);
+  // Unit normals of the surface elements, indexed in the same way as the elements in the node connectivity
+  const Uint dim = coords.row_size();
+  const Uint nb_surface_elements = node_connectivity->node_elements().empty() ? 0 : node_connectivity->celements_first_elements().back() + node_connectivity->celements_vector().back()->size();
+  std::vector<Real> normals(nb_surface_elements*dim);
+  std::vector<Uint> element_nb_nodes(nb_surface_elements, 0);
+  for(Uint i = 0; i != node_connectivity->celements_vector().size(); ++i)
+  {
+    detail::SurfaceNormals kernel(node_connectivity->celements_first_elements()[i], normals, element_nb_nodes);
+    dispatch_element_type_with_fallback<FaceTypes>(*node_connectivity->celements_vector()[i], kernel);
+  }
+
+  detail::WallProjection normal_distance(coords, *node_connectivity, normals, element_nb_nodes);
 
   for(Uint inner_node_idx = 0; inner_node_idx != nb_nodes; ++inner_node_idx)
   {
@@ -247,7 +313,12 @@ void WallDistance::execute()
         is_surface_node = true;
         break;
       }
-      const Real d2 = (to_vector(coords[inner_node_idx]) - to_vector(coords[surface_node_idx])).squaredNorm();
+      Real d2 = 0.;
+      for(Uint d = 0; d != dim; ++d)
+      {
+        const Real delta = coords[inner_node_idx][d] - coords[surface_node_idx][d];
+        d2 += delta*delta;
+      }
       if(d2 < shortest_distance)
       {
         shortest_distance = d2;
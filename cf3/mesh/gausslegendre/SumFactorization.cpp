@@ -0,0 +1,296 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <cmath>
+
+#include "common/BasicExceptions.hpp"
+#include "common/StringConversion.hpp"
+
+#include "mesh/ShapeFunction.hpp"
+#include "mesh/gausslegendre/Legendre.hpp"
+#include "mesh/gausslegendre/SumFactorization.hpp"
+
+namespace cf3 {
+namespace mesh {
+namespace gausslegendre {
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace detail
+{
+
+/// Value of the 1D Lagrange polynomial for node k, on p+1 equispaced nodes in [-1,1]
+Real lagrange_value(const Uint p, const Uint k, const Real x)
+{
+  Real result = 1.;
+  const Real xk = -1. + 2.*k/p;
+  for(Uint m = 0; m <= p; ++m)
+  {
+    if(m == k)
+      continue;
+    const Real xm = -1. + 2.*m/p;
+    result *= (x - xm) / (xk - xm);
+  }
+  return result;
+}
+
+/// Derivative of the 1D Lagrange polynomial for node k, on p+1 equispaced nodes in [-1,1]
+Real lagrange_derivative(const Uint p, const Uint k, const Real x)
+{
+  Real result = 0.;
+  const Real xk = -1. + 2.*k/p;
+  for(Uint j = 0; j <= p; ++j)
+  {
+    if(j == k)
+      continue;
+    const Real xj = -1. + 2.*j/p;
+    Real term = 1. / (xk - xj);
+    for(Uint m = 0; m <= p; ++m)
+    {
+      if(m == k || m == j)
+        continue;
+      const Real xm = -1. + 2.*m/p;
+      term *= (x - xm) / (xk - xm);
+    }
+    result += term;
+  }
+  return result;
+}
+
+/// Lexicographic index of each node of the shape function, or an empty vector if the nodes are not on a tensor-product grid
+std::vector<Uint> lexicographic_indices(const ShapeFunction& sf)
+{
+  std::vector<Uint> result;
+  if(sf.shape() != GeoShape::LINE && sf.shape() != GeoShape::QUAD && sf.shape() != GeoShape::HEXA)
+    return result;
+
+  const Uint dim = sf.dimensionality();
+  const Uint p = sf.order();
+  const Uint nb_nodes = sf.nb_nodes();
+  Uint expected_nb_nodes = 1;
+  for(Uint d = 0; d != dim; ++d)
+    expected_nb_nodes *= p+1;
+  if(p == 0 || nb_nodes != expected_nb_nodes)
+    return result;
+
+  const RealMatrix& nodes = sf.local_coordinates();
+  std::vector<bool> found(nb_nodes, false);
+  result.resize(nb_nodes);
+  for(Uint n = 0; n != nb_nodes; ++n)
+  {
+    Uint lex = 0;
+    for(Uint d = 0; d != dim; ++d)
+    {
+      const Real scaled = (nodes(n, d) + 1.) * 0.5 * p;
+      const Uint idx = static_cast<Uint>(std::floor(scaled + 0.5));
+      if(std::abs(scaled - idx) > 1e-10 || idx > p)
+        return std::vector<Uint>();
+      lex = lex*(p+1) + idx;
+    }
+    if(found[lex])
+      return std::vector<Uint>();
+    found[lex] = true;
+    result[n] = lex;
+  }
+
+  // Check that the shape functions are the tensor-product Lagrange polynomials
+  RealVector test_point(dim);
+  const Real test_coords[3] = {0.3137, -0.2718, 0.1234};
+  for(Uint d = 0; d != dim; ++d)
+    test_point[d] = test_coords[d];
+  const RealRowVector values = sf.value(test_point);
+  for(Uint n = 0; n != nb_nodes; ++n)
+  {
+    Real expected = 1.;
+    Uint lex = result[n];
+    for(int d = dim-1; d >= 0; --d)
+    {
+      expected *= lagrange_value(p, lex % (p+1), test_point[d]);
+      lex /= p+1;
+    }
+    if(std::abs(expected - values[n]) > 1e-10)
+      return std::vector<Uint>();
+  }
+
+  return result;
+}
+
+} // detail
+
+////////////////////////////////////////////////////////////////////////////////
+
+SumFactorization::SumFactorization(const ShapeFunction& sf, const Uint nb_qdr_pts_1d) :
+  m_dimensionality(sf.dimensionality()),
+  m_nb_nodes_1d(sf.order()+1),
+  m_nb_qdr_pts_1d(nb_qdr_pts_1d)
+{
+  const std::vector<Uint> lexicographic = detail::lexicographic_indices(sf);
+  if(lexicographic.empty())
+    throw common::NotSupported(FromHere(), "Shape function " + sf.derived_type_name() + " is not a tensor-product Lagrange shape function");
+
+  setup(sf, lexicographic);
+}
+
+SumFactorization::SumFactorization(const ShapeFunction& sf, const std::vector<Uint>& lexicographic, const Uint nb_qdr_pts_1d) :
+  m_dimensionality(sf.dimensionality()),
+  m_nb_nodes_1d(sf.order()+1),
+  m_nb_qdr_pts_1d(nb_qdr_pts_1d)
+{
+  setup(sf, lexicographic);
+}
+
+boost::shared_ptr<SumFactorization> SumFactorization::create(const ShapeFunction& sf, const Uint nb_qdr_pts_1d)
+{
+  const std::vector<Uint> lexicographic = detail::lexicographic_indices(sf);
+  if(lexicographic.empty())
+    return boost::shared_ptr<SumFactorization>();
+
+  return boost::shared_ptr<SumFactorization>(new SumFactorization(sf, lexicographic, nb_qdr_pts_1d));
+}
+
+void SumFactorization::setup(const ShapeFunction& sf, const std::vector<Uint>& lexicographic)
+{
+  const Uint nb_qdr_pts_1d = m_nb_qdr_pts_1d;
+  const Uint nb_nodes = lexicographic.size();
+  m_node_order.resize(nb_nodes);
+  for(Uint n = 0; n != nb_nodes; ++n)
+    m_node_order[lexicographic[n]] = n;
+
+  const std::pair< std::vector<Real>, std::vector<Real> > qdr = GaussLegendre(nb_qdr_pts_1d);
+  const Uint p = sf.order();
+  m_values_1d.resize(nb_qdr_pts_1d, m_nb_nodes_1d);
+  m_derivatives_1d.resize(nb_qdr_pts_1d, m_nb_nodes_1d);
+  for(Uint q = 0; q != nb_qdr_pts_1d; ++q)
+  {
+    for(Uint k = 0; k != m_nb_nodes_1d; ++k)
+    {
+      m_values_1d(q, k) = detail::lagrange_value(p, k, qdr.first[q]);
+      m_derivatives_1d(q, k) = detail::lagrange_derivative(p, k, qdr.first[q]);
+    }
+  }
+
+  Uint nb_qdr_pts = 1;
+  for(Uint d = 0; d != m_dimensionality; ++d)
+    nb_qdr_pts *= nb_qdr_pts_1d;
+  m_qdr_coordinates.resize(nb_qdr_pts, m_dimensionality);
+  m_qdr_weights.resize(nb_qdr_pts);
+  for(Uint q = 0; q != nb_qdr_pts; ++q)
+  {
+    m_qdr_weights[q] = 1.;
+    Uint lex = q;
+    for(int d = m_dimensionality-1; d >= 0; --d)
+    {
+      const Uint q_1d = lex % nb_qdr_pts_1d;
+      lex /= nb_qdr_pts_1d;
+      m_qdr_coordinates(q, d) = qdr.first[q_1d];
+      m_qdr_weights[q] *= qdr.second[q_1d];
+    }
+  }
+
+  const Uint work_size = std::max(nb_nodes, nb_qdr_pts) * std::max(m_nb_nodes_1d, m_nb_qdr_pts_1d);
+  m_work_in.reserve(work_size);
+  m_work_out.reserve(work_size);
+}
+
+bool SumFactorization::is_supported(const ShapeFunction& sf)
+{
+  return !detail::lexicographic_indices(sf).empty();
+}
+
+void SumFactorization::interpolate(const Real* nodal_values, Real* qdr_values) const
+{
+  const RealMatrix* ops[3] = {&m_values_1d, &m_values_1d, &m_values_1d};
+  const Uint nb_nodes = m_node_order.size();
+  m_work_in.resize(nb_nodes);
+  for(Uint i = 0; i != nb_nodes; ++i)
+    m_work_in[i] = nodal_values[m_node_order[i]];
+  apply(ops, false);
+  std::copy(m_work_in.begin(), m_work_in.end(), qdr_values);
+}
+
+void SumFactorization::gradient(const Real* nodal_values, Real* qdr_gradients) const
+{
+  const Uint nb_nodes = m_node_order.size();
+  const Uint nb_qdr = nb_qdr_pts();
+  for(Uint d = 0; d != m_dimensionality; ++d)
+  {
+    const RealMatrix* ops[3] = {&m_values_1d, &m_values_1d, &m_values_1d};
+    ops[d] = &m_derivatives_1d;
+    m_work_in.resize(nb_nodes);
+    for(Uint i = 0; i != nb_nodes; ++i)
+      m_work_in[i] = nodal_values[m_node_order[i]];
+    apply(ops, false);
+    std::copy(m_work_in.begin(), m_work_in.end(), qdr_gradients + d*nb_qdr);
+  }
+}
+
+void SumFactorization::integrate(const Real* qdr_values, Real* nodal_result) const
+{
+  const RealMatrix* ops[3] = {&m_values_1d, &m_values_1d, &m_values_1d};
+  const Uint nb_nodes = m_node_order.size();
+  m_work_in.assign(qdr_values, qdr_values + nb_qdr_pts());
+  apply(ops, true);
+  for(Uint i = 0; i != nb_nodes; ++i)
+    nodal_result[m_node_order[i]] = m_work_in[i];
+}
+
+void SumFactorization::integrate_gradient(const Real* qdr_gradients, Real* nodal_result) const
+{
+  const Uint nb_nodes = m_node_order.size();
+  const Uint nb_qdr = nb_qdr_pts();
+  std::fill(nodal_result, nodal_result + nb_nodes, 0.);
+  for(Uint d = 0; d != m_dimensionality; ++d)
+  {
+    const RealMatrix* ops[3] = {&m_values_1d, &m_values_1d, &m_values_1d};
+    ops[d] = &m_derivatives_1d;
+    m_work_in.assign(qdr_gradients + d*nb_qdr, qdr_gradients + (d+1)*nb_qdr);
+    apply(ops, true);
+    for(Uint i = 0; i != nb_nodes; ++i)
+      nodal_result[m_node_order[i]] += m_work_in[i];
+  }
+}
+
+void SumFactorization::apply(const RealMatrix* const* ops, const bool transpose) const
+{
+  const Uint nb_in_1d = transpose ? m_nb_qdr_pts_1d : m_nb_nodes_1d;
+  const Uint nb_out_1d = transpose ? m_nb_nodes_1d : m_nb_qdr_pts_1d;
+
+  // Axes before the current one are already transformed, the ones after it not yet
+  Uint nb_pre = 1;
+  for(Uint axis = 0; axis != m_dimensionality; ++axis)
+  {
+    Uint nb_post = 1;
+    for(Uint d = axis+1; d < m_dimensionality; ++d)
+      nb_post *= nb_in_1d;
+
+    const RealMatrix& op = *ops[axis];
+    m_work_out.assign(nb_pre*nb_out_1d*nb_post, 0.);
+    for(Uint pre = 0; pre != nb_pre; ++pre)
+    {
+      const Real* in = &m_work_in[pre*nb_in_1d*nb_post];
+      Real* out = &m_work_out[pre*nb_out_1d*nb_post];
+      for(Uint r = 0; r != nb_out_1d; ++r)
+      {
+        Real* out_line = out + r*nb_post;
+        for(Uint c = 0; c != nb_in_1d; ++c)
+        {
+          const Real coeff = transpose ? op(c, r) : op(r, c);
+          const Real* in_line = in + c*nb_post;
+          for(Uint post = 0; post != nb_post; ++post)
+            out_line[post] += coeff * in_line[post];
+        }
+      }
+    }
+    m_work_in.swap(m_work_out);
+    nb_pre *= nb_out_1d;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // gausslegendre
+} // mesh
+} // cf3
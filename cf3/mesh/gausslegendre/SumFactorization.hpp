@@ -0,0 +1,110 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_mesh_gausslegendre_SumFactorization_hpp
+#define cf3_mesh_gausslegendre_SumFactorization_hpp
+
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include "math/MatrixTypes.hpp"
+
+#include "mesh/gausslegendre/API.hpp"
+
+namespace cf3 {
+namespace mesh {
+
+class ShapeFunction;
+
+namespace gausslegendre {
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// @brief Evaluation of tensor-product shape functions in tensor-product Gauss-Legendre points by sum factorization
+///
+/// Lagrange shape functions on Line, Quad and Hexa elements are products of 1D Lagrange polynomials on equispaced nodes.
+/// Interpolating nodal values to the P^d Gauss points is then done as d successive contractions with the
+/// 1D interpolation matrix, costing O(p^(d+1)) per element instead of O(p^(2d)) for the dense interpolation matrix.
+/// The transposed operations, used to apply an operator matrix-free, are provided as well.
+///
+/// Nodal values are in the ordering of the shape function. The Gauss points are ordered as in the
+/// gausslegendre quadratures, i.e. with the last mapped coordinate running fastest.
+class mesh_gausslegendre_API SumFactorization
+{
+public:
+  /// Set up for the given shape function, using nb_qdr_pts_1d Gauss-Legendre points in each direction
+  /// @throws common::NotSupported if the shape function is not a tensor product of 1D Lagrange polynomials
+  SumFactorization(const ShapeFunction& sf, const Uint nb_qdr_pts_1d);
+
+  /// Same as the constructor, but returns null if the shape function is not supported
+  static boost::shared_ptr<SumFactorization> create(const ShapeFunction& sf, const Uint nb_qdr_pts_1d);
+
+  /// True if the shape function is a tensor-product Lagrange shape function on Line, Quad or Hexa
+  static bool is_supported(const ShapeFunction& sf);
+
+  Uint dimensionality() const { return m_dimensionality; }
+  Uint nb_nodes() const { return m_node_order.size(); }
+  Uint nb_qdr_pts() const { return m_qdr_weights.size(); }
+
+  /// Mapped coordinates of the Gauss points, one row per point
+  const RealMatrix& qdr_local_coordinates() const { return m_qdr_coordinates; }
+
+  /// Weights of the Gauss points
+  const RealVector& qdr_weights() const { return m_qdr_weights; }
+
+  /// Values in the Gauss points of the scalar field with the given nodal values
+  /// @param [in]  nodal_values  nb_nodes values
+  /// @param [out] qdr_values    nb_qdr_pts values
+  void interpolate(const Real* nodal_values, Real* qdr_values) const;
+
+  /// Gradient with respect to the mapped coordinates in the Gauss points
+  /// @param [in]  nodal_values   nb_nodes values
+  /// @param [out] qdr_gradients  dimensionality blocks of nb_qdr_pts values, one block for each mapped coordinate
+  void gradient(const Real* nodal_values, Real* qdr_gradients) const;
+
+  /// Transpose of interpolate: result(n) = sum over the Gauss points q of N_n(q) * qdr_values(q)
+  /// Multiplying qdr_values with the weights and jacobian determinants first gives the integral of the values times each shape function.
+  void integrate(const Real* qdr_values, Real* nodal_result) const;
+
+  /// Transpose of gradient: result(n) = sum over the Gauss points q and directions d of dN_n/dxi_d(q) * qdr_gradients(d, q)
+  void integrate_gradient(const Real* qdr_gradients, Real* nodal_result) const;
+
+private:
+  /// Set up the operators, with lexicographic the lexicographic index of each node of the shape function
+  SumFactorization(const ShapeFunction& sf, const std::vector<Uint>& lexicographic, const Uint nb_qdr_pts_1d);
+  void setup(const ShapeFunction& sf, const std::vector<Uint>& lexicographic);
+
+  /// Apply the given 1D operator along each axis (values or derivatives), from the lexicographically ordered nodes to the Gauss points
+  /// or, if transpose is true, back. The input and result are in m_work_in.
+  void apply(const RealMatrix* const* ops, const bool transpose) const;
+
+  Uint m_dimensionality;
+  Uint m_nb_nodes_1d;
+  Uint m_nb_qdr_pts_1d;
+
+  /// Index of each lexicographically numbered node in the ordering of the shape function
+  std::vector<Uint> m_node_order;
+
+  /// 1D shape function values and derivatives, one row for each Gauss point
+  RealMatrix m_values_1d;
+  RealMatrix m_derivatives_1d;
+
+  RealMatrix m_qdr_coordinates;
+  RealVector m_qdr_weights;
+
+  /// Work storage, so an object must not be shared between threads
+  mutable std::vector<Real> m_work_in;
+  mutable std::vector<Real> m_work_out;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // gausslegendre
+} // mesh
+} // cf3
+
+#endif // cf3_mesh_gausslegendre_SumFactorization_hpp
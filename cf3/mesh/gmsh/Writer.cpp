@@ -213,7 +213,7 @@ void Writer::write_coordinates(std::fstream& file)
   file.precision(8);
 
   // Assemble a list of all the coordinates that are used in this mesh
-  const boost::shared_ptr< common::List<Uint> > used_nodes_ptr = build_used_nodes_list(m_filtered_entities,m_mesh->geometry_fields(),m_enable_overlap);
+  const boost::shared_ptr< common::List<Uint> const > used_nodes_ptr = cached_used_nodes_list(m_filtered_entities,m_mesh->geometry_fields(),m_enable_overlap);
   const common::List<Uint>& used_nodes = *used_nodes_ptr;
 
   // Create a mapping between the actual node-numbering in the mesh, and the node-numbering to be written
@@ -641,7 +641,7 @@ void Writer::write_nodal_data(std::fstream& file)
         }
       }
 
-      const boost::shared_ptr< common::List<Uint> > used_nodes_ptr = build_used_nodes_list(filtered_used_entities_by_field,m_mesh->geometry_fields(),m_enable_overlap);
+      const boost::shared_ptr< common::List<Uint> const > used_nodes_ptr = cached_used_nodes_list(filtered_used_entities_by_field,m_mesh->geometry_fields(),m_enable_overlap);
       const common::List<Uint>& used_nodes = *used_nodes_ptr;
       std::vector<bool> is_node_visited(m_mesh->geometry_fields().size(),false);
 
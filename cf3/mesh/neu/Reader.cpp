@@ -4,8 +4,13 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <algorithm>
+#include <cstdlib>
+#include <map>
 #include <set>
 
+#include <boost/cstdint.hpp>
+
 #include "common/Log.hpp"
 #include "common/Builder.hpp"
 #include "common/FindComponents.hpp"
@@ -18,6 +23,7 @@
 #include "common/DynTable.hpp"
 #include "common/List.hpp"
 #include "common/PropertyList.hpp"
+#include "common/PE/Comm.hpp"
 
 #include "mesh/Mesh.hpp"
 #include "mesh/Region.hpp"
@@ -46,6 +52,26 @@ cf3::common::ComponentBuilder < neu::Reader, MeshReader, LibNeu > aneuReader_Bui
 
 //////////////////////////////////////////////////////////////////////////////
 
+namespace detail
+{
+  /// Count the whitespace-separated entries in a line
+  Uint count_entries(const std::string& line)
+  {
+    Uint nb_entries = 0;
+    bool in_entry = false;
+    for(std::string::const_iterator c = line.begin(); c != line.end(); ++c)
+    {
+      const bool is_space = (*c == ' ' || *c == '\t' || *c == '\r');
+      if(!is_space && !in_entry)
+        ++nb_entries;
+      in_entry = !is_space;
+    }
+    return nb_entries;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
 Reader::Reader( const std::string& name )
 : MeshReader(name),
   Shared()
@@ -105,9 +131,6 @@ void Reader::do_read_mesh_into(const URI& file, Mesh& mesh)
   // set the internal mesh pointer
   m_mesh = Handle<Mesh>(mesh.handle<Component>());
 
-  // Read file once and store positions
-  get_file_positions();
-
   // Read mesh information
   read_headerData();
 
@@ -121,6 +144,14 @@ void Reader::do_read_mesh_into(const URI& file, Mesh& mesh)
   num_obj[0] = m_headerData.NUMNP;
   num_obj[1] = m_headerData.NELEM;
   m_hash->options().set("nb_obj",num_obj);
+  m_part = options().value<Uint>("part");
+  m_nb_parts = options().value<Uint>("nb_parts");
+  if (m_part >= m_nb_parts)
+    throw common::BadValue(FromHere(), "Part "+to_str(m_part)+" does not exist in "+to_str(m_nb_parts)+" parts");
+  m_hash->options().set("nb_parts",m_nb_parts);
+
+  // Read file once and store positions, including the start of the node and element ranges of every part
+  get_file_positions();
 
   // Create a region component inside the mesh with the name mesh_name
   //if (option("new_api").value<bool>())
@@ -128,7 +159,7 @@ void Reader::do_read_mesh_into(const URI& file, Mesh& mesh)
   //else
   //  m_region = m_mesh->create_region(m_headerData.mesh_name,!option("Serial Handle<Region>(Merge").value<bool>()).handle<Component>());
 
-  find_ghost_nodes();
+  read_elements();
   read_coordinates();
   read_connectivity();
   if (options().value<bool>("read_boundaries"))
@@ -146,10 +177,9 @@ void Reader::do_read_mesh_into(const URI& file, Mesh& mesh)
   boost_foreach(Elements& elements, find_components_recursively<Elements>(m_mesh->topology()))
   {
     elements.rank().resize(elements.size());
-    Uint my_rank = options().value<Uint>("part");
     for (Uint e=0; e<elements.size(); ++e)
     {
-      elements.rank()[e] = my_rank;
+      elements.rank()[e] = m_part;
     }
   }
 
@@ -178,27 +208,131 @@ void Reader::get_file_positions()
   std::string elements_cells("ELEMENTS/CELLS");
   std::string element_group("ELEMENT GROUP");
   std::string boundary_condition("BOUNDARY CONDITIONS");
+  std::string end_of_section("ENDOFSECTION");
 
   m_element_group_positions.resize(0);
   m_boundary_condition_positions.resize(0);
-
-  int p;
-  std::string line;
-  while (!m_file.eof())
+  m_part_nodes_positions.assign(m_nb_parts,0);
+  m_part_elements_positions.assign(m_nb_parts,0);
+
+  // Contiguous ranges of nodes and elements of every part
+  const ParallelDistribution& node_hash = m_hash->subhash(NODES);
+  const ParallelDistribution& elem_hash = m_hash->subhash(ELEMS);
+  m_nodes_begin = node_hash.start_idx_in_part(m_part);
+  m_nodes_end   = node_hash.end_idx_in_part(m_part);
+  m_elems_begin = elem_hash.start_idx_in_part(m_part);
+  m_elems_end   = elem_hash.end_idx_in_part(m_part);
+
+  // Record boundaries can not be found from an arbitrary offset in the file, because element records may continue
+  // on the next lines. The file is therefore scanned by rank 0 only, instead of by every rank.
+  const bool is_parallel = PE::Comm::instance().is_active() && PE::Comm::instance().size() > 1;
+  if (!is_parallel || PE::Comm::instance().rank() == 0)
   {
-    p = m_file.tellg();
-    getline(m_file,line);
-    if (line.find(nodal_coordinates)!=std::string::npos)
-      m_nodal_coordinates_position=p;
-    else if (line.find(elements_cells)!=std::string::npos)
-      m_elements_cells_position=p;
-    else if (line.find(element_group)!=std::string::npos)
-      m_element_group_positions.push_back(p);
-    else if (line.find(boundary_condition)!=std::string::npos)
-      m_boundary_condition_positions.push_back(p);
+    enum { OTHER_SECTION, NODES_SECTION, ELEMS_SECTION } section = OTHER_SECTION;
+    Uint record_idx = 0;
+    Uint next_part = 0;
+    Uint nb_pending_nodes = 0; // element nodes still to come on continuation lines
+
+    m_file.clear();
+    m_file.seekg(0,std::ios::beg);
+
+    std::streampos p;
+    std::string line;
+    while (!m_file.eof())
+    {
+      p = m_file.tellg();
+      getline(m_file,line);
+      if (section == NODES_SECTION && line.find(end_of_section)==std::string::npos)
+      {
+        // one line per node
+        for ( ; next_part < m_nb_parts && record_idx == node_hash.start_idx_in_part(next_part); ++next_part)
+          m_part_nodes_positions[next_part]=p;
+        ++record_idx;
+      }
+      else if (section == ELEMS_SECTION && line.find(end_of_section)==std::string::npos)
+      {
+        // an element record may continue on the next lines if it has many nodes
+        const Uint nb_entries = detail::count_entries(line);
+        if (nb_pending_nodes == 0)
+        {
+          for ( ; next_part < m_nb_parts && record_idx == elem_hash.start_idx_in_part(next_part); ++next_part)
+            m_part_elements_positions[next_part]=p;
+          ++record_idx;
+          char* entry_end;
+          std::strtoul(line.c_str(), &entry_end, 10);      // element number
+          std::strtoul(entry_end, &entry_end, 10);         // element type
+          const Uint nb_elem_nodes = std::strtoul(entry_end, &entry_end, 10);
+          nb_pending_nodes = nb_elem_nodes + 3 - nb_entries;
+        }
+        else
+        {
+          nb_pending_nodes -= nb_entries;
+        }
+      }
+      else if (line.find(nodal_coordinates)!=std::string::npos)
+      {
+        m_nodal_coordinates_position=p;
+        section = NODES_SECTION;
+        record_idx = 0;
+        next_part = 0;
+      }
+      else if (line.find(elements_cells)!=std::string::npos)
+      {
+        m_elements_cells_position=p;
+        section = ELEMS_SECTION;
+        record_idx = 0;
+        next_part = 0;
+        nb_pending_nodes = 0;
+      }
+      else
+      {
+        section = OTHER_SECTION;
+        if (line.find(element_group)!=std::string::npos)
+          m_element_group_positions.push_back(p);
+        else if (line.find(boundary_condition)!=std::string::npos)
+          m_boundary_condition_positions.push_back(p);
+      }
+    }
+    m_file.clear();
   }
-  m_file.clear();
 
+  if (!is_parallel)
+    return;
+
+  // Positions are broadcast as [nodal coordinates, elements, nb groups, nb boundaries, groups, boundaries, part nodes, part elements]
+  std::vector<boost::uint64_t> send_positions;
+  if (PE::Comm::instance().rank() == 0)
+  {
+    send_positions.push_back(std::streamoff(m_nodal_coordinates_position));
+    send_positions.push_back(std::streamoff(m_elements_cells_position));
+    send_positions.push_back(m_element_group_positions.size());
+    send_positions.push_back(m_boundary_condition_positions.size());
+    boost_foreach(const std::streampos& pos, m_element_group_positions)
+      send_positions.push_back(std::streamoff(pos));
+    boost_foreach(const std::streampos& pos, m_boundary_condition_positions)
+      send_positions.push_back(std::streamoff(pos));
+    boost_foreach(const std::streampos& pos, m_part_nodes_positions)
+      send_positions.push_back(std::streamoff(pos));
+    boost_foreach(const std::streampos& pos, m_part_elements_positions)
+      send_positions.push_back(std::streamoff(pos));
+  }
+  std::vector<boost::uint64_t> positions;
+  PE::Comm::instance().broadcast(send_positions,positions,0);
+
+  std::vector<boost::uint64_t>::const_iterator pos = positions.begin();
+  m_nodal_coordinates_position = std::streamoff(*pos++);
+  m_elements_cells_position = std::streamoff(*pos++);
+  m_element_group_positions.resize(*pos++);
+  m_boundary_condition_positions.resize(*pos++);
+  cf3_assert(positions.size() == 4 + m_element_group_positions.size() + m_boundary_condition_positions.size() + 2*m_nb_parts);
+  for (Uint i=0; i<m_element_group_positions.size(); ++i)
+    m_element_group_positions[i] = std::streamoff(*pos++);
+  for (Uint i=0; i<m_boundary_condition_positions.size(); ++i)
+    m_boundary_condition_positions[i] = std::streamoff(*pos++);
+  for (Uint part=0; part<m_nb_parts; ++part)
+    m_part_nodes_positions[part] = std::streamoff(*pos++);
+  for (Uint part=0; part<m_nb_parts; ++part)
+    m_part_elements_positions[part] = std::streamoff(*pos++);
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -237,127 +371,186 @@ void Reader::read_headerData()
 
 //////////////////////////////////////////////////////////////////////////////
 
-void Reader::find_ghost_nodes()
+void Reader::read_elements()
 {
+  m_owned_elements.clear();
   m_ghost_nodes.clear();
 
-  // Only find ghost nodes if the domain is split up
-  if (options().value<Uint>("nb_parts") > 1)
+  const Uint nb_owned_elems = m_elems_end - m_elems_begin;
+  if (nb_owned_elems == 0)
+    return;
+
+  // Only the element records owned by this rank are read
+  m_file.seekg(m_part_elements_positions[m_part],std::ios::beg);
+
+  Uint elementNumber, elementType, nbElementNodes, neu_node_number;
+  for (Uint i=0; i<nb_owned_elems; ++i)
   {
-    m_file.seekg(m_elements_cells_position,std::ios::beg);
-    // skip next line
-    std::string line;
-    getline(m_file,line);
+    m_file >> elementNumber >> elementType >> nbElementNodes;
+    cf3_assert_desc(to_str(elementNumber)+" == "+to_str(m_elems_begin+i+1),elementNumber == m_elems_begin+i+1);
 
+    if(!m_supported_neu_types.count(elementType))
+      throw common::NotSupported(FromHere(), "Failed to read neutral file: unsupported element type " + common::to_str(elementType));
 
-    // read every line and store the connectivity in the correct region through the buffer
-    Uint elementNumber, elementType, nbElementNodes, dummy_node;
-    for (Uint i=0; i<m_headerData.NELEM; ++i)
+    m_owned_elements.push_back(elementType);
+    m_owned_elements.push_back(nbElementNodes);
+    for (Uint j=0; j<nbElementNodes; ++j)
     {
-      if (m_headerData.NELEM > 100000)
-      {
-        if(i%(m_headerData.NELEM/20)==0)
-          CFinfo << 100*i/m_headerData.NELEM << "% " << CFendl;
-      }
-
-      if (m_hash->subhash(ELEMS).owns(i))
-      {
-        // element description
-        m_file >> elementNumber >> elementType >> nbElementNodes;
-        cf3_assert_desc(to_str(elementNumber)+" == "+to_str(i+1),elementNumber == i+1);
-        // check if element nodes are ghost
-        std::vector<Uint> neu_element_nodes(nbElementNodes);
-        for (Uint j=0; j<nbElementNodes; ++j)
-        {
-          m_file >> neu_element_nodes[j];
-          if (!m_hash->subhash(NODES).owns(neu_element_nodes[j]-1))
-          {
-            m_ghost_nodes.insert(neu_element_nodes[j]);
-          }
-        }
-      }
-      else
-      {
-        // element description
-        m_file >> elementNumber >> elementType >> nbElementNodes;
-        cf3_assert_desc(to_str(elementNumber)+" == "+to_str(i+1),elementNumber == i+1);
-        // check if element nodes are ghost
-        std::vector<Uint> neu_element_nodes(nbElementNodes);
-        for (Uint j=0; j<nbElementNodes; ++j)
-        {
-          m_file >> dummy_node;
-        }
-      }
-      // finish the line
-      getline(m_file,line);
+      m_file >> neu_node_number;
+      m_owned_elements.push_back(neu_node_number);
+      // nodes outside the owned range are ghosts
+      if (neu_node_number-1 < m_nodes_begin || neu_node_number-1 >= m_nodes_end)
+        m_ghost_nodes.push_back(neu_node_number);
     }
-    getline(m_file,line);  // ENDOFSECTION
   }
+
+  std::sort(m_ghost_nodes.begin(), m_ghost_nodes.end());
+  m_ghost_nodes.erase(std::unique(m_ghost_nodes.begin(), m_ghost_nodes.end()), m_ghost_nodes.end());
 }
 
 //////////////////////////////////////////////////////////////////////////////
 
 void Reader::read_coordinates()
 {
-  m_file.seekg(m_nodal_coordinates_position,std::ios::beg);
-
   // Create the nodes
 
   Dictionary& nodes = m_mesh->geometry_fields();
+  const ParallelDistribution& node_hash = m_hash->subhash(NODES);
+  const Uint dim = m_headerData.NDFCD;
+
+  const Uint nb_owned_nodes = m_nodes_end - m_nodes_begin;
+  nodes.resize(nb_owned_nodes + m_ghost_nodes.size());
+  common::Table<Real>& coordinates = nodes.coordinates();
+
+  // Only the node lines owned by this rank are read
+  if (nb_owned_nodes != 0)
+    m_file.seekg(m_part_nodes_positions[m_part],std::ios::beg);
 
-  nodes.resize(m_hash->subhash(NODES).nb_objects_in_part(PE::Comm::instance().rank()) + m_ghost_nodes.size());
   std::string line;
-  // skip one line
-  getline(m_file,line);
+  for (Uint coord_idx=0; coord_idx<nb_owned_nodes; ++coord_idx)
+  {
+    getline(m_file,line);
+    std::stringstream ss(line);
+    Uint nodeNumber;
+    ss >> nodeNumber;
+    cf3_assert(nodeNumber == m_nodes_begin+coord_idx+1);
+    nodes.rank()[coord_idx] = node_hash.part_of_obj(nodeNumber-1);
+    nodes.glb_idx()[coord_idx] = nodeNumber;
+    for (Uint d=0; d<dim; ++d)
+      ss >> coordinates[coord_idx][d];
+  }
 
-  // declare and allocate one coordinate row
-  std::vector<Real> rowVector(m_headerData.NDFCD);
+  // Ghost node coordinates are obtained from the ranks that read them, in one exchange. If this reader does not
+  // read the part matching its rank, they are read from the ranges of the other parts in the file.
+  m_neu_node_to_coord_idx.clear();
+  if (m_ghost_nodes.empty() && !PE::Comm::instance().is_active())
+    return;
+  const Uint my_part_is_rank = PE::Comm::instance().is_active()
+      && m_nb_parts == PE::Comm::instance().size()
+      && m_part == PE::Comm::instance().rank();
+  // the exchange is collective, so all ranks must agree
+  Uint parts_are_ranks = my_part_is_rank;
+  if (PE::Comm::instance().is_active())
+    PE::Comm::instance().all_reduce(PE::min(), &my_part_is_rank, 1, &parts_are_ranks);
+  if (parts_are_ranks)
+    exchange_ghost_coordinates();
+  else
+    read_ghost_coordinates();
+}
 
-  std::set<Uint>::const_iterator not_found = m_ghost_nodes.end();
+//////////////////////////////////////////////////////////////////////////////
 
-  Uint coord_idx=0;
-  for (Uint neu_node_idx=1; neu_node_idx<=m_headerData.NUMNP; ++neu_node_idx)
+void Reader::exchange_ghost_coordinates()
+{
+  Dictionary& nodes = m_mesh->geometry_fields();
+  const ParallelDistribution& node_hash = m_hash->subhash(NODES);
+  const Uint dim = m_headerData.NDFCD;
+  const Uint nb_owned_nodes = m_nodes_end - m_nodes_begin;
+  common::Table<Real>& coordinates = nodes.coordinates();
+
+  // Only the ranks that own ghost nodes are contacted
+  typedef std::map< int, std::vector<Uint> > NodesPerRankT;
+  typedef std::map< int, std::vector<Real> > CoordinatesPerRankT;
+  NodesPerRankT requested_nodes;
+  boost_foreach(const Uint ghost_node, m_ghost_nodes)
+    requested_nodes[node_hash.proc_of_obj(ghost_node-1)].push_back(ghost_node);
+
+  NodesPerRankT nodes_to_send;
+  PE::Comm::instance().sparse_all_to_all(requested_nodes, nodes_to_send);
+
+  CoordinatesPerRankT coordinates_to_send;
+  for (NodesPerRankT::const_iterator it = nodes_to_send.begin(); it != nodes_to_send.end(); ++it)
   {
-    if (m_headerData.NUMNP > 100000)
+    std::vector<Real>& proc_coordinates = coordinates_to_send[it->first];
+    proc_coordinates.reserve(it->second.size()*dim);
+    boost_foreach(const Uint neu_node, it->second)
     {
-      if(neu_node_idx%(m_headerData.NUMNP/20)==0)
-        CFinfo << 100*neu_node_idx/m_headerData.NUMNP << "% " << CFendl;
+      cf3_assert(neu_node-1 >= m_nodes_begin && neu_node-1 < m_nodes_end);
+      const common::Table<Real>::ConstRow row = coordinates[neu_node-1-m_nodes_begin];
+      proc_coordinates.insert(proc_coordinates.end(), row.begin(), row.end());
     }
-    getline(m_file,line);
-    if (m_hash->subhash(NODES).owns(neu_node_idx-1))
+  }
+
+  CoordinatesPerRankT received_coordinates;
+  PE::Comm::instance().sparse_all_to_all(coordinates_to_send, received_coordinates);
+
+  Uint coord_idx = nb_owned_nodes;
+  for (NodesPerRankT::const_iterator it = requested_nodes.begin(); it != requested_nodes.end(); ++it)
+  {
+    const std::vector<Uint>& proc_nodes = it->second;
+    const std::vector<Real>& proc_coordinates = received_coordinates[it->first];
+    cf3_assert(proc_coordinates.size() == proc_nodes.size()*dim);
+    for (Uint i=0; i<proc_nodes.size(); ++i, ++coord_idx)
     {
-      nodes.rank()[coord_idx] = m_hash->subhash(NODES).part_of_obj(neu_node_idx-1);
-      nodes.glb_idx()[coord_idx] = neu_node_idx;
-      m_neu_node_to_coord_idx[neu_node_idx]=coord_idx;
+      const Uint neu_node = proc_nodes[i];
+      nodes.rank()[coord_idx] = node_hash.part_of_obj(neu_node-1);
+      nodes.glb_idx()[coord_idx] = neu_node;
+      m_neu_node_to_coord_idx[neu_node] = coord_idx;
+      for (Uint d=0; d<dim; ++d)
+        coordinates[coord_idx][d] = proc_coordinates[i*dim+d];
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void Reader::read_ghost_coordinates()
+{
+  Dictionary& nodes = m_mesh->geometry_fields();
+  const ParallelDistribution& node_hash = m_hash->subhash(NODES);
+  const Uint dim = m_headerData.NDFCD;
+  common::Table<Real>& coordinates = nodes.coordinates();
+
+  // The ghost nodes are sorted, so the nodes of each part are read in one forward pass from the start of its range
+  Uint coord_idx = m_nodes_end - m_nodes_begin;
+  Uint ghost = 0;
+  std::string line;
+  while (ghost < m_ghost_nodes.size())
+  {
+    const Uint part = node_hash.part_of_obj(m_ghost_nodes[ghost]-1);
+    m_file.clear();
+    m_file.seekg(m_part_nodes_positions[part],std::ios::beg);
+    for (Uint neu_node = node_hash.start_idx_in_part(part)+1; ghost < m_ghost_nodes.size() && neu_node <= node_hash.end_idx_in_part(part); ++neu_node)
+    {
+      getline(m_file,line);
+      if (neu_node != m_ghost_nodes[ghost])
+        continue;
       std::stringstream ss(line);
       Uint nodeNumber;
       ss >> nodeNumber;
-      cf3_assert(nodeNumber == neu_node_idx);
-      for (Uint dim=0; dim<m_headerData.NDFCD; ++dim)
-        ss >> nodes.coordinates()[coord_idx][dim];
-      coord_idx++;
-    }
-    else
-    {
-      if (m_ghost_nodes.find(neu_node_idx) != not_found)
-      {
-        // add global node index
-        nodes.rank()[coord_idx] = m_hash->subhash(NODES).part_of_obj(neu_node_idx-1);
-        nodes.glb_idx()[coord_idx] = neu_node_idx;
-        m_neu_node_to_coord_idx[neu_node_idx]=coord_idx;
-        std::stringstream ss(line);
-        Uint nodeNumber;
-        ss >> nodeNumber;
-        for (Uint dim=0; dim<m_headerData.NDFCD; ++dim)
-          ss >> nodes.coordinates()[coord_idx][dim];
-        coord_idx++;
-      }
+      cf3_assert(nodeNumber == neu_node);
+      nodes.rank()[coord_idx] = part;
+      nodes.glb_idx()[coord_idx] = neu_node;
+      m_neu_node_to_coord_idx[neu_node] = coord_idx;
+      for (Uint d=0; d<dim; ++d)
+        ss >> coordinates[coord_idx][d];
+      ++coord_idx;
+      ++ghost;
     }
   }
-  getline(m_file,line);
+  cf3_assert(coord_idx == nodes.size());
 }
 
-
 //////////////////////////////////////////////////////////////////////////////
 
 void Reader::read_connectivity()
@@ -366,16 +559,11 @@ void Reader::read_connectivity()
   m_tmp = Handle<Region>(m_region->create_region("main").handle<Component>());
 
   m_global_to_tmp.clear();
-  m_file.seekg(m_elements_cells_position,std::ios::beg);
 
   std::map<std::string,Handle< Elements > > elements = create_cells_in_region(*m_tmp,nodes,m_supported_types);
   std::map<std::string,boost::shared_ptr< Connectivity::Buffer > > buffer = create_connectivity_buffermap(elements);
 
-  // skip next line
-  std::string line;
-  getline(m_file,line);
-
-  // read every line and store the connectivity in the correct region through the buffer
+  // store the connectivity of the owned elements, read before, in the correct region through the buffer
   std::string etype_CF;
   std::vector<Uint> cf_element;
   Uint neu_node_number;
@@ -383,52 +571,37 @@ void Reader::read_connectivity()
   Uint cf_idx;
   Uint table_idx;
 
-  for (Uint i=0; i<m_headerData.NELEM; ++i)
+  std::vector<Uint>::const_iterator record = m_owned_elements.begin();
+  for (Uint elementNumber=m_elems_begin+1; record != m_owned_elements.end(); ++elementNumber)
   {
-    if (m_headerData.NELEM > 100000)
-    {
-      if(i%(m_headerData.NELEM/20)==0)
-        CFinfo << 100*i/m_headerData.NELEM << "% " << CFendl;
-    }
+    const Uint elementType = *record++;
+    const Uint nbElementNodes = *record++;
 
-    // element description
-    Uint elementNumber, elementType, nbElementNodes;
-    m_file >> elementNumber >> elementType >> nbElementNodes;
-    
-    if(!m_supported_neu_types.count(elementType))
-      throw common::NotSupported(FromHere(), "Failed to read neutral file: unsupported element type " + common::to_str(elementType));
-
-    // get element nodes
-    if (m_hash->subhash(ELEMS).owns(i))
+    cf_element.resize(nbElementNodes);
+    for (Uint j=0; j<nbElementNodes; ++j)
     {
-      cf_element.resize(nbElementNodes);
-      for (Uint j=0; j<nbElementNodes; ++j)
+      cf_idx = m_nodes_neu_to_cf[elementType][j];
+      neu_node_number = *record++;
+      if (neu_node_number-1 >= m_nodes_begin && neu_node_number-1 < m_nodes_end)
       {
-        cf_idx = m_nodes_neu_to_cf[elementType][j];
-        m_file >> neu_node_number;
-        cf3_assert(m_neu_node_to_coord_idx.count(neu_node_number));
-        cf_node_number = m_neu_node_to_coord_idx[neu_node_number];
-        cf3_assert(cf_node_number < nodes.size());
-        cf_element[cf_idx] = cf_node_number;
+        cf_node_number = neu_node_number-1-m_nodes_begin;
       }
-      etype_CF = element_type(elementType,nbElementNodes);
-      table_idx = buffer[etype_CF]->add_row(cf_element);
-      m_global_to_tmp[elementNumber] = std::make_pair(elements[etype_CF],table_idx);
-    }
-    else
-    {
-      for (Uint j=0; j<nbElementNodes; ++j)
+      else
       {
-        m_file >> neu_node_number;
+        cf3_assert(m_neu_node_to_coord_idx.count(neu_node_number));
+        cf_node_number = m_neu_node_to_coord_idx[neu_node_number];
       }
+      cf3_assert(cf_node_number < nodes.size());
+      cf_element[cf_idx] = cf_node_number;
     }
-
-    // finish the line
-    getline(m_file,line);
+    etype_CF = element_type(elementType,nbElementNodes);
+    table_idx = buffer[etype_CF]->add_row(cf_element);
+    m_global_to_tmp[elementNumber] = std::make_pair(elements[etype_CF],table_idx);
   }
-  getline(m_file,line);  // ENDOFSECTION
 
   m_neu_node_to_coord_idx.clear();
+  std::vector<Uint>().swap(m_owned_elements);
+  std::vector<Uint>().swap(m_ghost_nodes);
 
 }
 
@@ -479,12 +652,12 @@ void Reader::read_groups()
     //    these new regions.
 
     // Read first to see howmany elements to allocate
-    int p = m_file.tellg();
+    std::streampos p = m_file.tellg();
     Uint nb_elems_in_group = 0;
     for (Uint i=0; i<NELGP; ++i)
     {
       m_file >> I;
-      if (m_hash->subhash(ELEMS).owns(I-1))
+      if (I-1 >= m_elems_begin && I-1 < m_elems_end)
         nb_elems_in_group++;
     }
     // now allocate and read again
@@ -493,7 +666,7 @@ void Reader::read_groups()
     for (Uint i=0; i<NELGP; ++i)
     {
       m_file >> I;
-      if (m_hash->subhash(ELEMS).owns(I-1))
+      if (I-1 >= m_elems_begin && I-1 < m_elems_end)
         groups[g].ELEM.push_back(I);     // set element index
     }
 
@@ -28,6 +28,10 @@ namespace neu {
 //////////////////////////////////////////////////////////////////////////////
 
 /// This class defines neutral mesh format reader
+///
+/// In parallel, each rank reads only the node and element records of its own part, and gets the coordinates of its
+/// ghost nodes from the other ranks. To find these records, rank 0 first scans the whole file serially and broadcasts
+/// the file positions (see get_file_positions()), so the time to open a mesh still grows with the file size on a single rank.
 /// @author Willem Deconinck
 class neu_API Reader : public MeshReader, public Shared
 {
@@ -52,7 +56,8 @@ private: // functions
 
   void read_headerData();
 
-  void find_ghost_nodes();
+  /// Read the element records owned by this rank and find the ghost nodes they refer to
+  void read_elements();
 
   void read_coordinates();
 
@@ -62,8 +67,16 @@ private: // functions
 
   void read_boundaries();
 
+  /// Find the sections of the file and the start of the node and element ranges of every part.
+  /// Only rank 0 scans the file, and broadcasts the positions.
   void get_file_positions();
 
+  /// Get the coordinates of the ghost nodes from the ranks that read them
+  void exchange_ghost_coordinates();
+
+  /// Read the coordinates of the ghost nodes from the file, seeking to the range of each part that owns them
+  void read_ghost_coordinates();
+
   std::string element_type(const Uint neu_type, const Uint nb_nodes);
 
 private: // data
@@ -81,13 +94,26 @@ private: // data
   Handle<Region> m_region;
   Handle< Region > m_tmp;
 
-  std::set<Uint> m_ghost_nodes;
+  /// sorted neu indices of the nodes used by owned elements, but owned by another rank
+  std::vector<Uint> m_ghost_nodes;
+  /// coordinate index of the ghost nodes
   std::map<Uint,Uint> m_neu_node_to_coord_idx;
-
-  Uint m_nodal_coordinates_position;
-  Uint m_elements_cells_position;
-  std::vector<Uint> m_element_group_positions;
-  std::vector<Uint> m_boundary_condition_positions;
+  /// owned element records, stored as [type, nb_nodes, neu nodes...]
+  std::vector<Uint> m_owned_elements;
+
+  /// part read by this reader, and total number of parts
+  Uint m_part, m_nb_parts;
+
+  /// range of zero-based node and element indices owned by this part
+  Uint m_nodes_begin, m_nodes_end, m_elems_begin, m_elems_end;
+
+  std::streampos m_nodal_coordinates_position;
+  std::streampos m_elements_cells_position;
+  /// position of the first node and element record of every part
+  std::vector<std::streampos> m_part_nodes_positions;
+  std::vector<std::streampos> m_part_elements_positions;
+  std::vector<std::streampos> m_element_group_positions;
+  std::vector<std::streampos> m_boundary_condition_positions;
 
   struct HeaderData
   {
@@ -339,7 +339,7 @@ void Writer::write()
       throw NotImplemented(FromHere(), "Tecplot can only output P1 elements. A new P1 space should be created, and used as geometry space");
     }
 
-    boost::shared_ptr< common::List<Uint> > used_nodes_ptr = mesh::build_used_nodes_list(elements,m_mesh->geometry_fields(),m_enable_overlap);
+    boost::shared_ptr< common::List<Uint> const > used_nodes_ptr = mesh::cached_used_nodes_list(elements,m_mesh->geometry_fields(),m_enable_overlap);
     common::List<Uint> const& used_nodes = *used_nodes_ptr;
 
     // print zone header,
@@ -175,8 +175,8 @@ void Writer::write_file(std::fstream& file)
       throw NotImplemented(FromHere(), "Tecplot can only output P1 elements. A new P1 space should be created, and used as geometry space");
     }
 
-    boost::shared_ptr< common::List<Uint> > used_nodes_ptr = mesh::build_used_nodes_list(elements,m_mesh->geometry_fields(),m_enable_overlap);
-    common::List<Uint>& used_nodes = *used_nodes_ptr;
+    boost::shared_ptr< common::List<Uint> const > used_nodes_ptr = mesh::cached_used_nodes_list(elements,m_mesh->geometry_fields(),m_enable_overlap);
+    const common::List<Uint>& used_nodes = *used_nodes_ptr;
     std::map<Uint,Uint> zone_node_idx;
     for (Uint n=0; n<used_nodes.size(); ++n)
       zone_node_idx[ used_nodes[n] ] = n+1;
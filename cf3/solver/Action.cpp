@@ -20,6 +20,8 @@
 
 #include "solver/Time.hpp"
 #include "solver/Action.hpp"
+#include "solver/ActionDirector.hpp"
+#include "solver/ElementSweep.hpp"
 #include "solver/Solver.hpp"
 #include "solver/Tags.hpp"
 
@@ -62,6 +64,7 @@ Action::Action ( const std::string& name ) :
       .attach_trigger ( boost::bind ( &Action::config_regions,   this ) )
       .mark_basic();
 
+  ActionDirector::add_field_access_options(*this);
 }
 
 
@@ -105,6 +108,24 @@ const std::vector< Handle<Region> >& Action::regions() const
 }
 
 
+bool Action::is_element_loop() const
+{
+  return false;
+}
+
+
+bool Action::supports_element_sweep(Elements& elements)
+{
+  return false;
+}
+
+
+boost::shared_ptr<ElementSweep> Action::element_sweep(Elements& elements, boost::shared_ptr<ElementGeometry>& geometry)
+{
+  return boost::shared_ptr<ElementSweep>();
+}
+
+
 void Action::config_regions()
 {
 
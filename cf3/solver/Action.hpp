@@ -7,18 +7,22 @@
 #ifndef cf3_solver_Action_hpp
 #define cf3_solver_Action_hpp
 
+#include <boost/shared_ptr.hpp>
+
 #include "common/Action.hpp"
 
 #include "solver/LibSolver.hpp"
 
 namespace cf3 {
 namespace common { template <typename T> struct ComponentIterator; }
-namespace mesh { class Region; class Mesh; }
+namespace mesh { class Region; class Mesh; class Elements; }
 namespace physics { class PhysModel; }
 namespace solver {
 
 class Solver;
 class Time;
+class ElementGeometry;
+class ElementSweep;
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -53,6 +57,18 @@ public: // functions
 
   //@} END ACCESSORS
 
+  /// True if execute() only loops over the elements of the regions, so the loop can be merged with the loops of other actions.
+  /// Actions must opt in explicitly, since anything execute() does besides the loop is skipped when the loop is merged.
+  virtual bool is_element_loop() const;
+
+  /// True if element_sweep() can evaluate the action on the given elements one element at a time
+  virtual bool supports_element_sweep(mesh::Elements& elements);
+
+  /// Sweep evaluating the action on the given elements, one element at a time
+  /// @param geometry Geometry of the current element, shared with the other sweeps over the same elements. If null, the sweep creates it.
+  /// @return null if the action does nothing for these elements
+  virtual boost::shared_ptr<ElementSweep> element_sweep(mesh::Elements& elements, boost::shared_ptr<ElementGeometry>& geometry);
+
 protected: // functions
 
   void config_regions();
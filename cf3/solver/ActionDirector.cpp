@@ -4,7 +4,18 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <algorithm>
+#include <set>
+
+#include <boost/thread/tss.hpp>
+
+#include "common/BasicExceptions.hpp"
 #include "common/Builder.hpp"
+#include "common/FindComponents.hpp"
 #include "common/Foreach.hpp"
 #include "common/URI.hpp"
 #include "common/OptionArray.hpp"
@@ -12,6 +23,9 @@
 #include "common/OptionList.hpp"
 #include "common/Signal.hpp"
 
+#include "common/PE/Comm.hpp"
+
+#include "mesh/Elements.hpp"
 #include "mesh/Mesh.hpp"
 #include "mesh/Region.hpp"
 
@@ -19,7 +33,9 @@
 
 #include "solver/LibSolver.hpp"
 #include "solver/Time.hpp"
+#include "solver/Action.hpp"
 #include "solver/ActionDirector.hpp"
+#include "solver/ElementSweep.hpp"
 #include "solver/Solver.hpp"
 #include "solver/Tags.hpp"
 
@@ -30,11 +46,70 @@ namespace solver {
 
 using namespace cf3::common;
 using namespace cf3::mesh;
+
+namespace
+{
+  typedef std::vector< boost::function<void()> > DeferredFunctionsT;
+
+  /// The deferred functions are owned by execute_concurrent
+  void keep_deferred_functions(DeferredFunctionsT*)
+  {
+  }
+
+  /// Functions deferred by the concurrent action running on this thread, null outside of concurrent execution
+  boost::thread_specific_ptr<DeferredFunctionsT> deferred_functions(&keep_deferred_functions);
+
+  /// Number of threads available for concurrent actions
+  int max_threads()
+  {
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+  }
+
+  /// True if the sorted sets have a common element
+  bool intersects(const std::set<std::string>& a, const std::set<std::string>& b)
+  {
+    std::set<std::string>::const_iterator a_it = a.begin();
+    std::set<std::string>::const_iterator b_it = b.begin();
+    while(a_it != a.end() && b_it != b.end())
+    {
+      if(*a_it < *b_it)
+        ++a_it;
+      else if(*b_it < *a_it)
+        ++b_it;
+      else
+        return true;
+    }
+    return false;
+  }
+
+  /// True if the action can be evaluated one element at a time on all of its elements, so its loop can be fused
+  bool is_fusable(solver::Action& action)
+  {
+    if(!action.is_element_loop())
+      return false;
+
+    boost_foreach(const Handle<Region>& region, action.regions())
+    {
+      boost_foreach(Elements& elements, find_components_recursively<Elements>(*region))
+      {
+        if(!action.supports_element_sweep(elements))
+          return false;
+      }
+    }
+    return true;
+  }
+}
   
 ////////////////////////////////////////////////////////////////////////////////////////////
 
 ActionDirector::ActionDirector ( const std::string& name ) :
-  common::ActionDirector(name)
+  common::ActionDirector(name),
+  m_fuse_element_loops(false),
+  m_concurrent_actions(false)
 {
   mark_basic();
 
@@ -64,6 +139,21 @@ ActionDirector::ActionDirector ( const std::string& name ) :
       .pretty_name("Regions")
       .attach_trigger ( boost::bind ( &ActionDirector::config_regions,   this ) )
       .mark_basic();
+
+  options().add("fuse_element_loops", m_fuse_element_loops)
+      .description("Execute consecutive actions that loop over the elements of the same regions in a single loop. "
+                   "Only valid if these actions do not read values written by the previous actions for other elements.")
+      .pretty_name("Fuse Element Loops")
+      .link_to(&m_fuse_element_loops);
+
+  options().add("concurrent_actions", m_concurrent_actions)
+      .description("Execute actions that access different fields at the same time, on separate threads. "
+                   "Only actions with the option thread_safe take part, and their accessed fields are declared in the options "
+                   "read_fields and written_fields.")
+      .pretty_name("Concurrent Actions")
+      .link_to(&m_concurrent_actions);
+
+  add_field_access_options(*this);
 }
 
 ActionDirector::~ActionDirector() {}
@@ -134,6 +224,295 @@ void ActionDirector::on_regions_set()
 {
 }
 
+void ActionDirector::execute()
+{
+  if(!m_fuse_element_loops && !m_concurrent_actions)
+  {
+    common::ActionDirector::execute();
+    return;
+  }
+
+  std::vector< Handle<common::Action> > actions;
+  BOOST_FOREACH(Component& child, *this)
+  {
+    Handle<common::Action> action(follow_link(child));
+    if(is_not_null(action) && !is_disabled(action->name()))
+      actions.push_back(action);
+  }
+
+  if(m_concurrent_actions)
+  {
+    // Thread safe actions make no MPI calls, so in an MPI run all calls still come from the main thread
+    if(max_threads() > 1 && (!PE::Comm::instance().is_active() || PE::Comm::instance().is_funneled()))
+    {
+      execute_concurrent(actions);
+      return;
+    }
+    CFdebug << name() << ": Executing actions in sequence, since concurrent execution is not possible with a single thread or without MPI thread support" << CFendl;
+  }
+
+  execute_in_sequence(actions);
+}
+
+void ActionDirector::execute_in_sequence(const std::vector< Handle<common::Action> >& actions)
+{
+  const Uint nb_actions = actions.size();
+  Uint begin = 0;
+  while(begin != nb_actions)
+  {
+    // Group the consecutive element loops over the same regions
+    std::vector< Handle<solver::Action> > group;
+    Handle<solver::Action> first(actions[begin]);
+    Uint end = begin + 1;
+    if(m_fuse_element_loops && is_not_null(first) && is_fusable(*first))
+    {
+      group.push_back(first);
+      for(; end != nb_actions; ++end)
+      {
+        // Actions that can't be fused end the group, so they still run after the previous actions and before the next ones
+        Handle<solver::Action> next(actions[end]);
+        if(is_null(next) || next->regions() != first->regions() || !is_fusable(*next))
+          break;
+        group.push_back(next);
+      }
+    }
+
+    if(group.size() > 1)
+    {
+      execute_fused(group);
+    }
+    else
+    {
+      CFdebug << name() << ": Executing action " << actions[begin]->uri().path() << CFendl;
+      actions[begin]->execute();
+    }
+
+    begin = end;
+  }
+}
+
+void ActionDirector::execute_concurrent(const std::vector< Handle<common::Action> >& actions)
+{
+  const Uint nb_actions = actions.size();
+
+  // Fields accessed by each action. Actions that are not thread safe or declare nothing may access anything.
+  std::vector< std::set<std::string> > read(nb_actions), written(nb_actions);
+  std::vector<bool> declared(nb_actions);
+  for(Uint i = 0; i != nb_actions; ++i)
+    declared[i] = declared_field_access(*actions[i], read[i], written[i]);
+
+  // An action runs after all previous actions it conflicts with, so each action gets a stage in which all actions are independent
+  std::vector<Uint> stages(nb_actions, 0);
+  Uint nb_stages = 0;
+  for(Uint j = 0; j != nb_actions; ++j)
+  {
+    for(Uint i = 0; i != j; ++i)
+    {
+      const bool conflict = !declared[i] || !declared[j]
+        || intersects(written[i], read[j]) || intersects(written[i], written[j]) || intersects(read[i], written[j]);
+      if(conflict)
+        stages[j] = std::max(stages[j], stages[i] + 1);
+    }
+    nb_stages = std::max(nb_stages, stages[j] + 1);
+  }
+
+  for(Uint stage = 0; stage != nb_stages; ++stage)
+  {
+    std::vector< Handle<common::Action> > stage_actions;
+    for(Uint i = 0; i != nb_actions; ++i)
+    {
+      if(stages[i] == stage)
+        stage_actions.push_back(actions[i]);
+    }
+
+    // The first execution of an action may create fields or components, so it runs alone
+    std::vector< Handle<common::Action> > concurrent_actions;
+    boost_foreach(const Handle<common::Action>& action, stage_actions)
+    {
+      std::map< std::string, Handle<common::Action> >::const_iterator executed = m_executed_actions.find(action->uri().path());
+      if(stage_actions.size() > 1 && executed != m_executed_actions.end() && executed->second == action)
+      {
+        concurrent_actions.push_back(action);
+      }
+      else
+      {
+        execute_in_sequence(std::vector< Handle<common::Action> >(1, action));
+        m_executed_actions[action->uri().path()] = action;
+      }
+    }
+
+    if(concurrent_actions.empty())
+      continue;
+
+    CFdebug << name() << ": Executing " << concurrent_actions.size() << " independent actions concurrently" << CFendl;
+
+    // Exceptions can't leave the parallel region, so the failures are reported afterwards
+    const int nb_concurrent_actions = concurrent_actions.size();
+    std::vector<std::string> errors(nb_concurrent_actions);
+    std::vector<bool> failed(nb_concurrent_actions, false);
+    std::vector<DeferredFunctionsT> deferred(nb_concurrent_actions);
+    #pragma omp parallel for schedule(dynamic, 1)
+    for(int i = 0; i < nb_concurrent_actions; ++i)
+    {
+      deferred_functions.reset(&deferred[i]);
+      try
+      {
+        concurrent_actions[i]->execute();
+      }
+      catch(std::exception& e)
+      {
+        errors[i] = e.what();
+        failed[i] = true;
+      }
+      catch(...)
+      {
+        errors[i] = "unknown exception";
+        failed[i] = true;
+      }
+      deferred_functions.reset();
+    }
+
+    for(int i = 0; i != nb_concurrent_actions; ++i)
+    {
+      if(failed[i])
+        throw common::ParallelError(FromHere(), "Action " + concurrent_actions[i]->uri().path() + " failed during concurrent execution: " + errors[i]);
+    }
+
+    // MPI calls of the actions, such as the field synchronizations at the end of their loops
+    for(int i = 0; i != nb_concurrent_actions; ++i)
+    {
+      boost_foreach(const boost::function<void()>& f, deferred[i])
+      {
+        f();
+      }
+    }
+  }
+}
+
+bool ActionDirector::in_concurrent_execution()
+{
+  return deferred_functions.get() != 0;
+}
+
+void ActionDirector::defer_to_main_thread(const boost::function<void()>& f)
+{
+  DeferredFunctionsT* deferred = deferred_functions.get();
+  if(deferred == 0)
+    f();
+  else
+    deferred->push_back(f);
+}
+
+bool ActionDirector::declared_field_access(const common::Action& action, std::set<std::string>& read, std::set<std::string>& written)
+{
+  if(!action.options().check("read_fields") || !action.options().check("written_fields") || !action.options().check("thread_safe"))
+    return false;
+
+  if(!action.options().value<bool>("thread_safe"))
+    return false;
+
+  const std::vector<std::string> read_fields = action.options().value< std::vector<std::string> >("read_fields");
+  const std::vector<std::string> written_fields = action.options().value< std::vector<std::string> >("written_fields");
+  read.insert(read_fields.begin(), read_fields.end());
+  written.insert(written_fields.begin(), written_fields.end());
+  return !read.empty() || !written.empty();
+}
+
+void ActionDirector::add_field_access_options(common::Component& action)
+{
+  action.options().add("read_fields", std::vector<std::string>())
+      .description("Tags of the fields read by this action. Together with written_fields, this allows a parent ActionDirector "
+                   "to execute independent actions concurrently. If both are empty, the action may access any field.")
+      .pretty_name("Read Fields");
+
+  action.options().add("written_fields", std::vector<std::string>())
+      .description("Tags of the fields written by this action, see read_fields")
+      .pretty_name("Written Fields");
+
+  action.options().add("thread_safe", false)
+      .description("True if this action may run on a separate thread, at the same time as other actions. After its first execution, "
+                   "the action must not create components or fields or write to the log, and may call MPI only through "
+                   "ActionDirector::defer_to_main_thread. Element and node loops do this for their field synchronization, "
+                   "but solving a linear system is not thread safe.")
+      .pretty_name("Thread Safe");
+}
+
+void ActionDirector::execute_fused(const std::vector< Handle<solver::Action> >& actions)
+{
+  CFdebug << name() << ": Executing " << actions.size() << " actions in a single element loop, starting with " << actions.front()->uri().path() << CFendl;
+
+  const Uint nb_actions = actions.size();
+
+  // Last sweep of each action, used to synchronize the values modified by the action
+  std::vector< boost::shared_ptr<ElementSweep> > last_sweeps(nb_actions);
+  std::vector< boost::shared_ptr<ElementSweep> > sweeps;
+
+  // In a distributed mesh, the halo elements of all Elements go first, so the synchronization can run while the interior elements are processed
+  for(Uint pass = 0; pass != 2; ++pass)
+  {
+    const bool halo_pass = pass == 0;
+    boost_foreach(const Handle<Region>& region, actions.front()->regions())
+    {
+      boost_foreach(Elements& elements, find_components_recursively<Elements>(*region))
+      {
+        // Without halo partition, all elements are evaluated in the interior pass
+        const bool halo_first = elements.has_halo_partition();
+        if(halo_pass && !halo_first)
+          continue;
+
+        // Connectivity and coordinates of the current element, loaded once for all sweeps
+        boost::shared_ptr<ElementGeometry> geometry;
+        sweeps.clear();
+        for(Uint i = 0; i != nb_actions; ++i)
+        {
+          boost::shared_ptr<ElementSweep> sweep = actions[i]->element_sweep(elements, geometry);
+          if(is_not_null(sweep))
+          {
+            sweeps.push_back(sweep);
+            last_sweeps[i] = sweep;
+          }
+        }
+
+        const Uint nb_sweeps = sweeps.size();
+        if(nb_sweeps == 0)
+          continue;
+
+        const Uint nb_halo_elems = halo_first ? elements.nb_halo_elements() : 0;
+        const Uint begin = halo_pass ? 0 : nb_halo_elems;
+        const Uint end = halo_pass ? nb_halo_elems : elements.size();
+        // An out of date partition has an empty order, with all elements in the halo pass
+        const std::vector<Uint>* halo_first_order = halo_first && !elements.halo_first_order().empty() ? &elements.halo_first_order() : 0;
+        for(Uint j = begin; j != end; ++j)
+        {
+          const Uint elem = is_not_null(halo_first_order) ? (*halo_first_order)[j] : j;
+          if(is_not_null(geometry))
+            geometry->set_element(elem);
+          for(Uint i = 0; i != nb_sweeps; ++i)
+            sweeps[i]->evaluate(elem);
+        }
+
+        for(Uint i = 0; i != nb_sweeps; ++i)
+          sweeps[i]->finish();
+      }
+    }
+
+    if(halo_pass)
+    {
+      for(Uint i = 0; i != nb_actions; ++i)
+      {
+        if(is_not_null(last_sweeps[i]))
+          last_sweeps[i]->start_synchronization();
+      }
+    }
+  }
+
+  for(Uint i = 0; i != nb_actions; ++i)
+  {
+    if(is_not_null(last_sweeps[i]))
+      last_sweeps[i]->synchronize();
+  }
+}
+
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
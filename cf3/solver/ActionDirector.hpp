@@ -7,6 +7,11 @@
 #ifndef cf3_solver_ActionDirector_hpp
 #define cf3_solver_ActionDirector_hpp
 
+#include <map>
+#include <set>
+
+#include <boost/function.hpp>
+
 #include "common/ActionDirector.hpp"
 
 #include "mesh/Region.hpp"
@@ -20,11 +25,28 @@ namespace physics { class PhysModel; }
 
 namespace solver {
 
+class Action;
 class Solver;
 class Time;
 
 /////////////////////////////////////////////////////////////////////////////////////
 
+/// Executes its child actions in order.
+///
+/// When the option fuse_element_loops is set, consecutive actions that loop over the elements of the same regions
+/// (see Action::is_element_loop()) are executed in a single loop over the elements: for each element, the actions are
+/// evaluated one after the other, so the connectivity and coordinates of an element are loaded once for all actions.
+/// This is only correct if no action reads values that a previous action in the group writes for other elements,
+/// such as nodal values assembled from several elements.
+///
+/// When the option concurrent_actions is set, actions that access different fields run at the same time on separate threads.
+/// Only actions with the option thread_safe set take part. Each of these declares the tags of the fields it reads and writes
+/// in its options read_fields and written_fields, and runs after all previous actions that write a field it accesses, or access
+/// a field it writes. Other actions run after all previous actions, and before all next actions. The first execution of each
+/// action is never concurrent, since it may set up fields and components.
+/// The actions of a stage run on the OpenMP threads, so the loops inside an action use a single thread unless nested parallelism is enabled.
+/// Thread safe actions leave their MPI calls to the main thread through defer_to_main_thread(), which runs them after the stage
+/// in the order of the actions, so in an MPI run this only requires MPI to support threads (see common::PE::Comm::is_funneled()).
 class solver_API ActionDirector : public common::ActionDirector {
 
 public: // functions
@@ -39,6 +61,9 @@ public: // functions
   /// Get the class name
   static std::string type_name () { return "ActionDirector"; }
 
+  /// Execute the actions, fusing the element loops if requested
+  virtual void execute();
+
   /// @name ACCESSORS
   //@{
 
@@ -58,6 +83,32 @@ protected: // functions
 
   void config_regions();
 
+  /// Execute the actions one after the other, fusing the element loops if requested
+  void execute_in_sequence(const std::vector< Handle<common::Action> >& actions);
+
+  /// Execute the given element loop actions in a single loop over their elements
+  void execute_fused(const std::vector< Handle<solver::Action> >& actions);
+
+  /// Execute the actions in stages of independent actions, running each stage on multiple threads
+  void execute_concurrent(const std::vector< Handle<common::Action> >& actions);
+
+public:
+
+  /// Get the fields declared in the read_fields and written_fields options of an action
+  /// @return false if the action is not thread safe or declares no fields, so it can't run concurrently with other actions
+  static bool declared_field_access(const common::Action& action, std::set<std::string>& read, std::set<std::string>& written);
+
+  /// Add the read_fields, written_fields and thread_safe options
+  static void add_field_access_options(common::Component& action);
+
+  /// True if called from an action that runs concurrently with other actions
+  static bool in_concurrent_execution();
+
+  /// Run the given function on the main thread once the concurrent actions of the current stage are done, or right away
+  /// if not in concurrent execution. The deferred functions run in the order of the actions, and for each action in the
+  /// order they were deferred, so collective MPI calls match between the ranks.
+  static void defer_to_main_thread(const boost::function<void()>& f);
+
 protected: // data
 
   /// link back to the solver
@@ -77,6 +128,15 @@ protected: // data
   /// Called after the regions have been set
   virtual void on_regions_set();
 
+  /// True if consecutive element loops over the same regions are executed in a single loop
+  bool m_fuse_element_loops;
+
+  /// True if independent actions are executed concurrently
+  bool m_concurrent_actions;
+
+  /// Actions that were executed at least once, by path
+  std::map< std::string, Handle<common::Action> > m_executed_actions;
+
 };
 
 /////////////////////////////////////////////////////////////////////////////////////
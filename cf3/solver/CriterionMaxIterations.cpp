@@ -43,6 +43,7 @@ CriterionMaxIterations::CriterionMaxIterations( const std::string& name  ) :
   options().add( "maxiter", 1u )
       .description("Maximum number of iterations (0 will perform none)")
       .pretty_name("Maximum number");
+  m_max_iter = options().value_handle<Uint>("maxiter");
 
 }
 
@@ -57,7 +58,7 @@ bool CriterionMaxIterations::operator()()
   Component& comp_iter = *m_iter_comp;
 
   const Uint cur_iter = comp_iter.properties().value<Uint>("iteration");
-  const Uint max_iter = options().value<Uint>("maxiter");
+  const Uint max_iter = *m_max_iter;
 
   return ( cur_iter > max_iter );
 }
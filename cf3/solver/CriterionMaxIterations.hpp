@@ -39,6 +39,9 @@ private:
   /// component where to access the current iteration
   Handle<Component> m_iter_comp;
 
+  /// maximum number of iterations
+  common::OptionValue<Uint> m_max_iter;
+
 };
 
 ////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,55 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_solver_ElementSweep_hpp
+#define cf3_solver_ElementSweep_hpp
+
+#include "common/CF.hpp"
+
+#include "solver/LibSolver.hpp"
+
+namespace cf3 {
+namespace solver {
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Connectivity and coordinates of the current element, shared by all sweeps over the same mesh::Elements in a fused loop
+class solver_API ElementGeometry
+{
+public:
+  virtual ~ElementGeometry() {}
+
+  /// Load the connectivity and coordinates of the given element
+  virtual void set_element(const Uint element_idx) = 0;
+};
+
+/// Evaluates an action on the elements of a single mesh::Elements, one element at a time.
+/// This allows the sweeps of several actions over the same elements to share one loop, see ActionDirector.
+class solver_API ElementSweep
+{
+public:
+  virtual ~ElementSweep() {}
+
+  /// Evaluate the action for the given element. The geometry that was passed when the sweep was created must be set to the same element first.
+  virtual void evaluate(const Uint element_idx) = 0;
+
+  /// Called once the elements are evaluated, to release the data for the elements. The modified values are synchronized later.
+  virtual void finish() = 0;
+
+  /// Called once the halo elements of all Elements in the loop are evaluated and finished, to start the synchronization
+  /// of the modified values. See mesh::Elements::halo_first_order()
+  virtual void start_synchronization() = 0;
+
+  /// Called at the end of the loop, to complete the synchronization of the modified values
+  virtual void synchronize() = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+} // solver
+} // cf3
+
+#endif // cf3_solver_ElementSweep_hpp
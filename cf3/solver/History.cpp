@@ -4,9 +4,16 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <cstring>
 #include <iomanip>
 
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "common/BasicExceptions.hpp"
 #include "common/BoostFilesystem.hpp"
+#include "common/Foreach.hpp"
 #include "common/PropertyList.hpp"
 #include "common/OptionList.hpp"
 #include "common/OptionT.hpp"
@@ -25,11 +32,137 @@ common::ComponentBuilder < History , Component, LibSolver > History_Builder;
 
 ////////////////////////////////////////////////////////////////////////////////
 
+namespace detail
+{
+
+/// Marks the start of a binary history file
+const char binary_magic[] = "CF3HISTORY\n";
+
+/// Tags for the segment headers and records in binary files
+const char segment_tag = 'S';
+const char record_tag = 'R';
+
+/// Writes the log file. In background mode, data is written by a separate thread.
+class HistoryWriter : boost::noncopyable
+{
+public:
+  HistoryWriter(const URI& file_uri, const bool background) :
+    m_stop(false),
+    m_writing(false)
+  {
+    boost::filesystem::path path (file_uri.path());
+    m_file.open(path,std::ios_base::out | std::ios_base::binary);
+    if (!m_file) // didn't open so throw exception
+    {
+      throw boost::filesystem::filesystem_error( path.string() + " failed to open",
+                                                 boost::system::error_code() );
+    }
+    if (background)
+      m_thread = boost::thread(boost::bind(&HistoryWriter::run, this));
+  }
+
+  ~HistoryWriter()
+  {
+    if (m_thread.joinable())
+    {
+      {
+        boost::lock_guard<boost::mutex> lock(m_mutex);
+        m_stop = true;
+      }
+      m_condition.notify_all();
+      m_thread.join();
+    }
+    m_file.close();
+  }
+
+  /// Write the data, or queue it for the background thread. data is empty afterwards.
+  void write(std::string& data)
+  {
+    if (!m_thread.joinable())
+    {
+      m_file.write(data.data(), data.size());
+      m_file.flush();
+      data.clear();
+      return;
+    }
+
+    {
+      boost::lock_guard<boost::mutex> lock(m_mutex);
+      m_pending.append(data);
+    }
+    data.clear();
+    m_condition.notify_all();
+  }
+
+  /// Wait until all queued data is written
+  void wait()
+  {
+    if (!m_thread.joinable())
+      return;
+    boost::unique_lock<boost::mutex> lock(m_mutex);
+    while (!m_pending.empty() || m_writing)
+      m_condition.wait(lock);
+  }
+
+private:
+  void run()
+  {
+    std::string to_write;
+    while (true)
+    {
+      {
+        boost::unique_lock<boost::mutex> lock(m_mutex);
+        m_writing = false;
+        m_condition.notify_all();
+        while (m_pending.empty() && !m_stop)
+          m_condition.wait(lock);
+        if (m_pending.empty())
+          return;
+        to_write.swap(m_pending);
+        m_writing = true;
+      }
+      m_file.write(to_write.data(), to_write.size());
+      m_file.flush();
+      to_write.clear();
+    }
+  }
+
+  boost::filesystem::fstream m_file;
+  boost::thread m_thread;
+  boost::mutex m_mutex;
+  boost::condition_variable m_condition;
+  std::string m_pending;
+  bool m_stop;
+  bool m_writing;
+};
+
+/// Append the raw bytes of a value to a string
+template<typename T>
+void append_binary(std::string& buffer, const T& value)
+{
+  buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+/// Read a value written with append_binary
+template<typename T>
+bool read_binary(std::istream& stream, T& value)
+{
+  return static_cast<bool>(stream.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+} // detail
+
+////////////////////////////////////////////////////////////////////////////////
+
 History::History ( const std::string& name ) :
   Component(name)
 {
   m_table_needs_resize = false;
+  m_nb_buffered_entries = 0;
+  m_summary_stride = 1;
+  m_nb_entries = 0;
   m_table = create_static_component< Table<Real> >("table");
+  m_summary = create_static_component< Table<Real> >("summary");
   m_variables = create_static_component< math::VariablesDescriptor >("variables");
 
   options().add("dimension",0u).mark_basic();
@@ -43,8 +176,26 @@ History::History ( const std::string& name ) :
   // Extension TSV for "Tab Separated Values"
   options().add("file",URI("history.tsv"))
       .description("Log file for history")
+      .attach_trigger( boost::bind( &History::close_log, this ) )
       .mark_basic();
 
+  std::vector<boost::any> formats;
+  formats.push_back(std::string("tsv"));
+  formats.push_back(std::string("binary"));
+  options().add("format",std::string("tsv"))
+      .description("Format of the log file: tab separated values, or binary records of doubles")
+      .attach_trigger( boost::bind( &History::close_log, this ) )
+      .restricted_list() = formats;
+
+  options().add("flush_interval",1u)
+      .description("Number of entries that are collected before writing them to the log file. "
+                   "If larger than 1, writing happens in a background thread.")
+      .attach_trigger( boost::bind( &History::close_log, this ) );
+
+  options().add("max_rows",0u)
+      .description("If not zero, only the most recent entries are kept in the table (at least max_rows), "
+                   "and the complete history is kept downsampled in the summary table");
+
   regist_signal ( "write" )
       .description( "Write history" )
       .pretty_name("Write" )
@@ -63,10 +214,7 @@ History::History ( const std::string& name ) :
 
 History::~History()
 {
-  if (m_file)
-  {
-    m_file.close();
-  }
+  close_log();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -110,10 +258,17 @@ bool History::resize_if_necessary()
       m_buffer->flush();
       m_buffer.reset();
     }
+    if (is_not_null(m_summary_buffer))
+    {
+      m_summary_buffer->flush();
+      m_summary_buffer.reset();
+    }
 
     m_table->set_row_size(m_variables->size());
+    m_summary->set_row_size(m_variables->size());
 
     m_buffer = m_table->create_buffer_ptr();
+    m_summary_buffer = m_summary->create_buffer_ptr();
 
     m_table_needs_resize = false;
     return true;
@@ -129,37 +284,159 @@ void History::save_entry()
   const HistoryEntry this_entry = entry();
 
   bool resized = resize_if_necessary();
-  m_buffer->add_row(this_entry.data());
+  const Uint nb_rows = m_buffer->add_row(this_entry.data()) + 1;
+  limit_memory(this_entry.data(), nb_rows);
+  ++m_nb_entries;
 
   if (m_logging)
   {
     if (PE::Comm::instance().rank() == 0)
     {
-      if (resized)
-        m_file.close();
+      log_entry(this_entry, resized);
+    }
+  }
+}
 
-      if (!m_file)
-      {
-        flush();
-        open_write_access_file(m_file,options().value<URI>("file"));
-        write_file(m_file);
-        m_file.flush();
-      }
-      else
+////////////////////////////////////////////////////////////////////////////////
+
+void History::limit_memory(const std::vector<Real>& entry, const Uint nb_rows)
+{
+  const Uint max_rows = options().value<Uint>("max_rows");
+  if (max_rows == 0)
+    return;
+
+  // Downsampled summary: when full, keep every other row and double the stride
+  if (m_nb_entries % m_summary_stride == 0)
+  {
+    const Uint nb_summary_rows = m_summary_buffer->add_row(entry) + 1;
+    if (nb_summary_rows >= 2*max_rows)
+    {
+      m_summary_buffer->flush();
+      m_summary_buffer.reset();
+      const Uint nb_kept = m_summary->size() / 2;
+      for (Uint row=0; row<nb_kept; ++row)
+        m_summary->set_row(row, (*m_summary)[2*row]);
+      m_summary->resize(nb_kept);
+      m_summary_buffer = m_summary->create_buffer_ptr();
+      m_summary_stride *= 2;
+    }
+  }
+
+  // Window of recent entries: trimmed once it reaches twice its size, so the cost per entry is constant
+  if (nb_rows < 2*max_rows)
+    return;
+
+  m_buffer->flush();
+  m_buffer.reset();
+  const Uint first_kept = m_table->size() - max_rows;
+  for (Uint row=0; row<max_rows; ++row)
+    m_table->set_row(row, (*m_table)[first_kept+row]);
+  m_table->resize(max_rows);
+  m_buffer = m_table->create_buffer_ptr();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void History::log_entry(const HistoryEntry& entry, const bool new_layout)
+{
+  const bool binary = options().value<std::string>("format") == "binary";
+  const bool new_file = is_null(m_writer);
+  if (new_file)
+  {
+    const Uint flush_interval = options().value<Uint>("flush_interval");
+    m_writer.reset(new detail::HistoryWriter(options().value<URI>("file"), flush_interval > 1));
+    if (binary)
+      m_log_buffer.append(detail::binary_magic, std::strlen(detail::binary_magic));
+  }
+
+  // The variables are written at the start of the file, and again as a new segment when they change
+  if (new_file || new_layout)
+  {
+    if (binary)
+    {
+      const std::vector<std::string> columns = column_names();
+      m_log_buffer.push_back(detail::segment_tag);
+      detail::append_binary(m_log_buffer, static_cast<boost::uint32_t>(columns.size()));
+      boost_foreach(const std::string& column, columns)
       {
-        m_file << this_entry << "\n";
-        m_file.flush();
+        detail::append_binary(m_log_buffer, static_cast<boost::uint32_t>(column.size()));
+        m_log_buffer.append(column);
       }
     }
+    else
+    {
+      m_log_buffer.append(file_header());
+    }
+  }
+
+  // Opening the file truncates it, so a new file starts with the entries that are already in the table,
+  // e.g. after read_file() or a change of the "file" option. The last row is the current entry.
+  if (new_file)
+  {
+    m_buffer->flush();
+    for (Uint row=0; row+1<m_table->size(); ++row)
+      log_row(std::vector<Real>((*m_table)[row].begin(), (*m_table)[row].end()), binary);
+  }
+
+  log_row(entry.data(), binary);
+
+  if (++m_nb_buffered_entries >= options().value<Uint>("flush_interval"))
+  {
+    m_writer->write(m_log_buffer);
+    m_nb_buffered_entries = 0;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void History::log_row(const std::vector<Real>& row, const bool binary)
+{
+  if (binary)
+  {
+    m_log_buffer.push_back(detail::record_tag);
+    boost_foreach(const Real value, row)
+      detail::append_binary(m_log_buffer, static_cast<double>(value));
+  }
+  else
+  {
+    // Same precision as the file streams opened by open_write_access_file
+    std::stringstream ss;
+    ss.precision(10);
+    boost_foreach(const Real value, row)
+      ss << "\t" << std::scientific << std::setw(12) << value;
+    ss << "\n";
+    m_log_buffer.append(ss.str());
   }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void History::close_log()
+{
+  if (is_not_null(m_writer))
+  {
+    m_writer->write(m_log_buffer);
+    m_writer.reset();
+  }
+  m_log_buffer.clear();
+  m_nb_buffered_entries = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void History::flush()
 {
   if(is_not_null(m_buffer))
     m_buffer->flush();
+  if(is_not_null(m_summary_buffer))
+    m_summary_buffer->flush();
+
+  if (is_not_null(m_writer))
+  {
+    m_writer->write(m_log_buffer);
+    m_nb_buffered_entries = 0;
+    m_writer->wait();
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -172,6 +449,14 @@ Handle<Table<Real> const> History::table()
 
 ////////////////////////////////////////////////////////////////////////////////
 
+Handle<Table<Real> const> History::summary()
+{
+  flush();
+  return m_summary;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 Handle<math::VariablesDescriptor const> History::variables() const
 {
   return m_variables;
@@ -230,7 +515,7 @@ void History::signal_read(common::SignalArgs& args)
 void History::open_read_access_file(boost::filesystem::fstream& file, const common::URI& file_uri)
 {
   boost::filesystem::path path (file_uri.path());
-  file.open(path,std::ios_base::in);
+  file.open(path,std::ios_base::in | std::ios_base::binary);
   if (!file) // didn't open so throw exception
   {
     throw boost::filesystem::filesystem_error( path.string() + " failed to open",
@@ -254,24 +539,36 @@ void History::open_write_access_file(boost::filesystem::fstream& file, const com
 
 ////////////////////////////////////////////////////////////////////////////////
 
-std::string History::file_header() const
+std::vector<std::string> History::column_names() const
 {
-  std::stringstream ss;
-
-  ss << "#";
+  std::vector<std::string> columns;
+  columns.reserve(m_variables->size());
   for (Uint var_idx=0; var_idx<m_variables->nb_vars(); ++var_idx)
   {
     const Uint var_length = m_variables->var_length(var_idx);
     if (var_length == 1)
     {
-      ss << "\t" << std::setw(16) << m_variables->user_variable_name(var_idx);
+      columns.push_back(m_variables->user_variable_name(var_idx));
     }
     else
     {
       for (Uint i=0; i<var_length; ++i)
-        ss << "\t" << std::setw(16) << m_variables->user_variable_name(var_idx)<<"["<<i<<"]";
+        columns.push_back(m_variables->user_variable_name(var_idx)+"["+to_str(i)+"]");
     }
+  }
+  return columns;
+}
+
+////////////////////////////////////////////////////////////////////////////////
 
+std::string History::file_header() const
+{
+  std::stringstream ss;
+
+  ss << "#";
+  boost_foreach(const std::string& column, column_names())
+  {
+    ss << "\t" << std::setw(16) << column;
   }
   ss << "\n";
   return ss.str();
@@ -303,16 +600,29 @@ void History::write_file(boost::filesystem::fstream& file)
 
 void History::read_file(boost::filesystem::fstream& file)
 {
+  if (file.peek() == detail::binary_magic[0])
+  {
+    read_binary_file(file);
+    return;
+  }
+
   bool logging = m_logging;
   options().set("logging",false);
   std::string line;
   std::vector<std::string> variables;
   Real var;
-  std::getline(file,line);
-  variables = from_str< std::vector<std::string> >( line );
 
   while( std::getline(file, line) )
   {
+    // Header lines can also appear later in the file, when variables were added
+    if (!line.empty() && line[0] == '#')
+    {
+      variables = from_str< std::vector<std::string> >( line );
+      continue;
+    }
+    if (variables.empty())
+      continue;
+
     std::stringstream line_ss(line);
     for (Uint i=1; i<variables.size(); ++i) // first idx in header == "#"
     {
@@ -326,6 +636,54 @@ void History::read_file(boost::filesystem::fstream& file)
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void History::read_binary_file(boost::filesystem::fstream& file)
+{
+  const Uint magic_size = std::strlen(detail::binary_magic);
+  std::string magic(magic_size, ' ');
+  file.read(&magic[0], magic_size);
+  if (magic != detail::binary_magic)
+    throw common::FileFormatError(FromHere(), "Not a history file");
+
+  bool logging = m_logging;
+  options().set("logging",false);
+  std::vector<std::string> columns;
+  char tag;
+  while (file.get(tag))
+  {
+    if (tag == detail::segment_tag)
+    {
+      boost::uint32_t nb_columns, name_length;
+      detail::read_binary(file, nb_columns);
+      columns.resize(nb_columns);
+      for (Uint i=0; i<nb_columns; ++i)
+      {
+        detail::read_binary(file, name_length);
+        columns[i].resize(name_length);
+        if (name_length != 0)
+          file.read(&columns[i][0], name_length);
+      }
+    }
+    else if (tag == detail::record_tag)
+    {
+      double value;
+      for (Uint i=0; i<columns.size(); ++i)
+      {
+        if (!detail::read_binary(file, value))
+          throw common::FileFormatError(FromHere(), "Truncated record in history file");
+        set(columns[i],value);
+      }
+      save_entry();
+    }
+    else
+    {
+      throw common::FileFormatError(FromHere(), "Corrupt history file");
+    }
+  }
+  options().set("logging",logging);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 HistoryEntry History::entry() const
 {
   return HistoryEntry(*this);
@@ -23,6 +23,8 @@ namespace solver {
 class History;
 class HistoryEntry;
 
+namespace detail { class HistoryWriter; }
+
 ////////////////////////////////////////////////////////////////////////////////
 
 /// @brief Stores History of variables
@@ -33,11 +35,23 @@ class HistoryEntry;
 /// History is stored internally using a common::Table<Real> .
 /// An optional (default=ON) logging facility is provided to log the history to
 /// file at every new entry.
-/// The file format is Tab Separated Values (extension tsv)
+/// The default file format is Tab Separated Values (extension tsv). The "binary" format
+/// appends fixed-size records of doubles instead, which is more compact and faster to write.
+///
+/// Any number of variables can be added after logging started. The log file is not
+/// rewritten then: a new header (tsv) or segment header (binary) listing all variables is
+/// appended, and the following entries have the new layout. When the file is (re)opened, e.g. after
+/// read_file() or a change of the "file" option, the entries in the table are written first. read_file() handles both formats
+/// and puts zero's for the non-existent past entries.
+///
+/// With "flush_interval" larger than 1, entries are collected and handed to a background thread
+/// that writes them, so the caller does not wait for the file system. flush() waits until
+/// everything is written.
 ///
-/// Any number of variables can be added after logging started. This will cause
-/// The history file to be rewritten, including the new variables, putting zero's
-/// for the non-existent past entries.
+/// With "max_rows" set, the table only keeps a window of the most recent entries (between max_rows
+/// and 2*max_rows). The "summary" table then keeps a downsampled view of the complete history of at most
+/// 2*max_rows entries, by dropping every other entry and doubling the sampling stride whenever it is full.
+/// A log file that is reopened then only gets the entries of this window.
 ///
 /// Example:\n
 /// @code
@@ -88,8 +102,8 @@ public:
   /// - The entry is assembled from the properties that are set using the function set().
   /// - In case new variables were created, resize the table, and create new buffer.
   /// - The entry is then saved in the buffer
-  /// - The entry is optionally (default=ON) saved to file. In case of new variables, the file
-  ///   gets recreated.
+  /// - The entry is optionally (default=ON) saved to file. In case of new variables, a new
+  ///   header is appended to the file.
   void save_entry();
 
   //@}
@@ -119,10 +133,14 @@ public:
   /// @note This flushes the buffer first, so that most recent information is available
   Handle<common::Table<Real> const> table();
 
+  /// @brief Downsampled history, only filled if the option "max_rows" is set
+  /// @note This flushes the buffer first, so that most recent information is available
+  Handle<common::Table<Real> const> summary();
+
   /// @brief Information of every variable stored in history
   Handle<math::VariablesDescriptor const> variables() const;
 
-  /// @brief Flush the buffer in the table
+  /// @brief Flush the buffer in the table, and write pending entries to the log file
   void flush();
 
   /// @brief make a Entry object that can be written to any output stream
@@ -137,6 +155,24 @@ private: // functions
   /// @brief resize table and rebuild buffer if needed
   bool resize_if_necessary();
 
+  /// @brief Keep only the most recent entries in the table, and add the entry to the summary if needed
+  void limit_memory(const std::vector<Real>& entry, const Uint nb_rows);
+
+  /// @brief Add the entry to the log buffer, and pass that to the writer if it is full
+  void log_entry(const HistoryEntry& entry, const bool new_layout);
+
+  /// @brief Append one row of values to the log buffer, in the configured format
+  void log_row(const std::vector<Real>& row, const bool binary);
+
+  /// @brief Close the log file after writing pending entries, so it is reopened on the next entry
+  void close_log();
+
+  /// @brief Read a log file in binary format
+  void read_binary_file(boost::filesystem::fstream& file);
+
+  /// @brief Names of all scalar columns, vector variables are expanded as name[i]
+  std::vector<std::string> column_names() const;
+
   /// @brief return the log-file header in string format
   std::string file_header() const;
 
@@ -145,12 +181,30 @@ private: // data
   /// Flag to check if the history has to be logged
   bool m_logging;
 
-  /// Log file handle
-  boost::filesystem::fstream m_file;
+  /// Writes the log file, possibly in a background thread. Only exists on rank 0 when logging.
+  boost::shared_ptr<detail::HistoryWriter> m_writer;
+
+  /// Log data that is not yet passed to the writer
+  std::string m_log_buffer;
+
+  /// Number of entries in m_log_buffer
+  Uint m_nb_buffered_entries;
 
   /// Handle to the table
   Handle< common::Table<Real> > m_table;
 
+  /// Downsampled history, used when the number of rows is limited
+  Handle< common::Table<Real> > m_summary;
+
+  /// The buffer to manipulate m_summary
+  boost::shared_ptr< common::Table<Real>::Buffer > m_summary_buffer;
+
+  /// Number of entries between two rows of the summary
+  Uint m_summary_stride;
+
+  /// Total number of entries saved
+  Uint m_nb_entries;
+
   /// The buffer to manipulate m_table
   boost::shared_ptr< common::Table<Real>::Buffer > m_buffer;
 
@@ -15,6 +15,12 @@
 namespace cf3 {
 namespace solver {
 
+/// @brief Compute the time step from the wave speed, for an imposed CFL number
+///
+/// The CFL number can be a function of the iteration i, the time t and the previous cfl, e.g. to ramp it up.
+/// With time_accurate = true, all points advance with the smallest time step. Otherwise each point gets its own
+/// time step cfl/wave_speed (local time stepping), which is the fastest way to converge steady solutions on
+/// stretched meshes, and can be combined with ResidualSmoothing to allow larger CFL numbers.
 class solver_API ImposeCFL : public solver::TimeStepComputer
 {
 public: // functions
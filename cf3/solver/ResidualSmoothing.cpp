@@ -0,0 +1,196 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <algorithm>
+
+#include "common/Builder.hpp"
+#include "common/Core.hpp"
+#include "common/EventHandler.hpp"
+#include "common/OptionList.hpp"
+#include "common/PropertyList.hpp"
+
+#include "mesh/Connectivity.hpp"
+#include "mesh/Dictionary.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/Space.hpp"
+#include "mesh/Tags.hpp"
+
+#include "solver/ResidualSmoothing.hpp"
+
+using namespace cf3::common;
+using namespace cf3::mesh;
+
+namespace cf3 {
+namespace solver {
+
+///////////////////////////////////////////////////////////////////////////////////////
+
+common::ComponentBuilder < ResidualSmoothing, common::Action, solver::LibSolver > ResidualSmoothing_Builder;
+
+////////////////////////////////////////////////////////////////////////////////
+
+ResidualSmoothing::ResidualSmoothing ( const std::string& name ) : common::Action(name)
+{
+  properties()["brief"] = std::string("Implicit residual smoothing");
+
+  options().add("rhs", m_rhs)
+    .description("Right-Hand-Side of equations, smoothed in place")
+    .pretty_name("RHS")
+    .mark_basic()
+    .link_to(&m_rhs);
+
+  options().add("coefficient", 0.5)
+    .description("Smoothing coefficient epsilon. Zero disables the smoothing.")
+    .pretty_name("Coefficient")
+    .mark_basic();
+
+  options().add("nb_iterations", 2u)
+    .description("Number of Jacobi iterations")
+    .pretty_name("Number of Iterations");
+
+  Core::instance().event_handler().connect_to_event(mesh::Tags::event_mesh_changed(), this, &ResidualSmoothing::on_mesh_changed_event);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ResidualSmoothing::on_mesh_changed_event(SignalArgs& args)
+{
+  m_dict.reset();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ResidualSmoothing::compute_neighbours()
+{
+  Dictionary& dict = m_rhs->dict();
+  const Uint nb_pts = dict.size();
+
+  // Count the neighbours, including duplicates, and collect them
+  m_neighbour_offsets.assign(nb_pts+1, 0);
+  boost_foreach(const Handle<Space>& space, dict.spaces())
+  {
+    const Connectivity& connectivity = space->connectivity();
+    const Uint nb_elems = connectivity.size();
+    const Uint nb_elem_pts = connectivity.row_size();
+    for (Uint elem_idx=0; elem_idx<nb_elems; ++elem_idx)
+    {
+      Connectivity::ConstRow pts = connectivity[elem_idx];
+      for (Uint a=0; a<nb_elem_pts; ++a)
+        m_neighbour_offsets[pts[a]+1] += nb_elem_pts-1;
+    }
+  }
+  for (Uint i=0; i<nb_pts; ++i)
+    m_neighbour_offsets[i+1] += m_neighbour_offsets[i];
+
+  m_neighbours.resize(m_neighbour_offsets.back());
+  std::vector<Uint> fill(m_neighbour_offsets.begin(), m_neighbour_offsets.end()-1);
+  boost_foreach(const Handle<Space>& space, dict.spaces())
+  {
+    const Connectivity& connectivity = space->connectivity();
+    const Uint nb_elems = connectivity.size();
+    const Uint nb_elem_pts = connectivity.row_size();
+    for (Uint elem_idx=0; elem_idx<nb_elems; ++elem_idx)
+    {
+      Connectivity::ConstRow pts = connectivity[elem_idx];
+      for (Uint a=0; a<nb_elem_pts; ++a)
+      {
+        for (Uint b=0; b<nb_elem_pts; ++b)
+        {
+          if (a != b)
+            m_neighbours[fill[pts[a]]++] = pts[b];
+        }
+      }
+    }
+  }
+
+  // Remove the duplicates from points shared by several elements, compacting the rows
+  Uint nb_unique = 0;
+  Uint row_begin = 0;
+  for (Uint i=0; i<nb_pts; ++i)
+  {
+    const Uint row_end = m_neighbour_offsets[i+1];
+    std::sort(m_neighbours.begin()+row_begin, m_neighbours.begin()+row_end);
+    const Uint nb_row_unique = std::unique(m_neighbours.begin()+row_begin, m_neighbours.begin()+row_end) - (m_neighbours.begin()+row_begin);
+    std::copy(m_neighbours.begin()+row_begin, m_neighbours.begin()+row_begin+nb_row_unique, m_neighbours.begin()+nb_unique);
+    nb_unique += nb_row_unique;
+    m_neighbour_offsets[i+1] = nb_unique;
+    row_begin = row_end;
+  }
+  m_neighbours.resize(nb_unique);
+
+  m_dict = dict.handle<Dictionary>();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ResidualSmoothing::execute()
+{
+  if ( is_null(m_rhs) ) throw SetupError(FromHere(), "rhs not configured in "+uri().string());
+
+  const Real eps = options().value<Real>("coefficient");
+  const Uint nb_iterations = options().value<Uint>("nb_iterations");
+  if (eps == 0. || nb_iterations == 0)
+    return;
+
+  if (m_dict != m_rhs->dict().handle<Dictionary>() || m_neighbour_offsets.size() != m_rhs->size()+1)
+    compute_neighbours();
+
+  Field& rhs = *m_rhs;
+  const Uint nb_pts = rhs.size();
+  const Uint nb_vars = rhs.row_size();
+
+  // The rhs is only computed in owned points
+  rhs.synchronize();
+
+  m_residual.resize(nb_pts*nb_vars);
+  m_previous.resize(nb_pts*nb_vars);
+  for (Uint i=0; i<nb_pts; ++i)
+  {
+    for (Uint v=0; v<nb_vars; ++v)
+      m_residual[i*nb_vars+v] = rhs[i][v];
+  }
+
+  for (Uint iter=0; iter<nb_iterations; ++iter)
+  {
+    if (iter != 0)
+    {
+      for (Uint i=0; i<nb_pts; ++i)
+      {
+        for (Uint v=0; v<nb_vars; ++v)
+          m_previous[i*nb_vars+v] = rhs[i][v];
+      }
+    }
+    else
+    {
+      m_previous = m_residual;
+    }
+
+    #pragma omp parallel for
+    for (int i=0; i<static_cast<int>(nb_pts); ++i)
+    {
+      if (rhs.is_ghost(i))
+        continue;
+      const Uint row_begin = m_neighbour_offsets[i];
+      const Uint row_end = m_neighbour_offsets[i+1];
+      const Real denominator = 1. + eps*static_cast<Real>(row_end-row_begin);
+      Field::Row smoothed = rhs[i];
+      for (Uint v=0; v<nb_vars; ++v)
+      {
+        Real neighbour_sum = 0.;
+        for (Uint n=row_begin; n<row_end; ++n)
+          neighbour_sum += m_previous[m_neighbours[n]*nb_vars+v];
+        smoothed[v] = (m_residual[i*nb_vars+v] + eps*neighbour_sum) / denominator;
+      }
+    }
+
+    rhs.synchronize();
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+} // solver
+} // cf3
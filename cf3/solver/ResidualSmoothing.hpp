@@ -0,0 +1,85 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_solver_ResidualSmoothing_hpp
+#define cf3_solver_ResidualSmoothing_hpp
+
+#include "common/Action.hpp"
+#include "solver/LibSolver.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Forward declares
+namespace cf3 {
+  namespace mesh {
+    class Field;
+    class Dictionary;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace solver {
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// @brief Implicit residual smoothing, to accelerate the convergence of explicit steady solvers
+///
+/// The right-hand-side R is replaced by the solution S of (1 - eps L) S = R, with L the undivided Laplacian
+/// over the points that share an element, using a few Jacobi iterations:
+/// @f[ S_i^{k+1} = \frac{R_i + \epsilon \sum_{j} S_j^k}{1 + \epsilon n_i} @f]
+/// This damps the high-frequency content of the residual, so the explicit scheme remains stable at
+/// a CFL number that is about a factor sqrt(1+4 eps) larger. It is typically combined with local time stepping
+/// (ImposeCFL with time_accurate = false), and executed after ComputeRHS.
+///
+/// The neighbours of each point are computed once, and again after the mesh_changed event.
+class solver_API ResidualSmoothing : public common::Action
+{
+public:
+
+  /// @brief Contructor
+  /// @param name of the component
+  ResidualSmoothing ( const std::string& name );
+
+  /// Virtual destructor
+  virtual ~ResidualSmoothing() {}
+
+  /// @brief Get the class name
+  static std::string type_name () { return "ResidualSmoothing"; }
+
+  /// @brief Smooth the configured rhs field in place
+  virtual void execute();
+
+private:
+
+  /// Compute the neighbours of each point of the dictionary of the rhs
+  void compute_neighbours();
+
+  void on_mesh_changed_event(common::SignalArgs& args);
+
+private:
+
+  Handle< mesh::Field > m_rhs;        ///! Field that is smoothed
+
+  /// Dictionary for which the neighbours were computed
+  Handle< mesh::Dictionary > m_dict;
+
+  /// Neighbours of each point, in compressed row format
+  std::vector<Uint> m_neighbour_offsets;
+  std::vector<Uint> m_neighbours;
+
+  /// Unsmoothed values and previous iterate
+  std::vector<Real> m_residual;
+  std::vector<Real> m_previous;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // solver
+} // cf3
+
+#endif // cf3_solver_ResidualSmoothing_hpp
@@ -0,0 +1,334 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <algorithm>
+
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+
+#include "common/Core.hpp"
+#include "common/Builder.hpp"
+#include "common/EventHandler.hpp"
+#include "common/FindComponents.hpp"
+#include "common/Foreach.hpp"
+#include "common/Log.hpp"
+#include "common/OptionList.hpp"
+#include "common/OptionT.hpp"
+#include "common/PropertyList.hpp"
+#include "common/Signal.hpp"
+
+#include "common/PE/Comm.hpp"
+
+#include "mesh/Dictionary.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/PointInterpolator.hpp"
+#include "mesh/Space.hpp"
+#include "mesh/Tags.hpp"
+
+#include "solver/actions/MeshSequencing.hpp"
+
+namespace cf3 {
+namespace solver {
+namespace actions {
+
+using namespace common;
+using namespace mesh;
+
+common::ComponentBuilder < MeshSequencing, common::Action, solver::actions::LibActions > MeshSequencing_Builder;
+
+namespace
+{
+  /// Add the values interpolated with the given stencil to result, which has the row size of the array
+  void interpolate(const Field::ArrayT& coarse_array, const Uint* points, const Real* weights, const Uint stencil_size, Real* result)
+  {
+    const Uint row_size = coarse_array.shape()[1];
+    for(Uint s = 0; s != stencil_size; ++s)
+    {
+      const Field::ConstRow coarse_row = coarse_array[points[s]];
+      const Real weight = weights[s];
+      for(Uint v = 0; v != row_size; ++v)
+        result[v] += coarse_row[v] * weight;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+MeshSequencing::MeshSequencing( const std::string& name  ) :
+  solver::Action(name)
+{
+  mark_basic();
+
+  properties()["brief"] = std::string("Initialize fields from a solution on a coarser mesh");
+  properties()["description"] = std::string("Executes the child actions, which solve on the coarse mesh, and interpolates the fields with the same name to the mesh of this action");
+
+  options().add("coarse_mesh", m_coarse_mesh)
+    .pretty_name("Coarse Mesh")
+    .description("Mesh on which the child actions compute the initial solution")
+    .link_to(&m_coarse_mesh)
+    .attach_trigger( boost::bind( &MeshSequencing::invalidate, this ) )
+    .mark_basic();
+
+  options().add("field_names", std::vector<std::string>())
+    .pretty_name("Field Names")
+    .description("Names of the fields to prolongate. If empty, all fields that exist in both meshes are prolongated")
+    .mark_basic();
+
+  m_point_interpolator = create_static_component<PointInterpolator>("point_interpolator");
+  m_point_interpolator->options().set("function", std::string("cf3.mesh.ShapeFunctionInterpolation"));
+
+  Core::instance().event_handler().connect_to_event(mesh::Tags::event_mesh_changed(), this, &MeshSequencing::on_mesh_changed_event);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+MeshSequencing::~MeshSequencing() {}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MeshSequencing::invalidate()
+{
+  m_prolongations.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MeshSequencing::on_mesh_changed_event(SignalArgs& args)
+{
+  invalidate();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MeshSequencing::execute()
+{
+  boost_foreach (common::Action& action, find_components<common::Action>(*this))
+  {
+    action.execute();
+  }
+
+  prolongate();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const MeshSequencing::Prolongation& MeshSequencing::prolongation(Dictionary& fine_dict, Dictionary& coarse_dict)
+{
+  boost_foreach(const Prolongation& cached, m_prolongations)
+  {
+    if(cached.fine_dict == fine_dict.handle<Dictionary>() && cached.coarse_dict == coarse_dict.handle<Dictionary>() && cached.fine_size == fine_dict.size())
+      return cached;
+  }
+
+  m_prolongations.push_back(Prolongation());
+  Prolongation& result = m_prolongations.back();
+  result.fine_dict = fine_dict.handle<Dictionary>();
+  result.coarse_dict = coarse_dict.handle<Dictionary>();
+  result.fine_size = fine_dict.size();
+  result.offsets.assign(1, 0);
+  result.nb_remote = 0;
+  result.remote_begin = 0;
+  result.owned_remote_offsets.assign(1, 0);
+
+  m_point_interpolator->options().set("dict", coarse_dict.handle<Dictionary>());
+
+  const Field& coordinates = fine_dict.coordinates();
+  const Uint nb_points = coordinates.size();
+  const Uint dim = coordinates.row_size();
+  RealVector coord(dim);
+  SpaceElem element;
+  std::vector<SpaceElem> stencil;
+  std::vector<Uint> points;
+  std::vector<Real> weights;
+  std::vector<Real> not_found_coords;
+  for(Uint i = 0; i != nb_points; ++i)
+  {
+    for(Uint d = 0; d != dim; ++d)
+      coord[d] = coordinates[i][d];
+    if(m_point_interpolator->compute_storage(coord, element, stencil, points, weights))
+    {
+      result.points.insert(result.points.end(), points.begin(), points.end());
+      result.weights.insert(result.weights.end(), weights.begin(), weights.end());
+    }
+    else
+    {
+      result.remote_fine_points.push_back(i);
+      not_found_coords.insert(not_found_coords.end(), coordinates[i].begin(), coordinates[i].end());
+    }
+    result.offsets.push_back(result.points.size());
+  }
+
+  if(!PE::Comm::instance().is_active())
+  {
+    if(!result.remote_fine_points.empty())
+    {
+      const std::string nb_not_found = to_str(result.remote_fine_points.size());
+      m_prolongations.pop_back();
+      throw SetupError(FromHere(), nb_not_found + " points of " + fine_dict.uri().path() + " are outside of " + m_coarse_mesh->uri().path());
+    }
+    return result;
+  }
+
+  const Uint my_nb_remote = result.remote_fine_points.size();
+  Uint nb_remote = 0;
+  PE::Comm::instance().all_reduce(PE::plus(), &my_nb_remote, 1, &nb_remote);
+  if(nb_remote == 0)
+    return result;
+
+  // Search the points that were not found on their own rank in the local part of the coarse mesh.
+  // If found on several ranks, the highest rank owns the stencil.
+  const int rank = PE::Comm::instance().rank();
+  std::vector< std::vector<Real> > all_not_found_coords;
+  PE::Comm::instance().all_gather(not_found_coords, all_not_found_coords);
+  std::vector<int> owners;
+  std::vector<Uint> found_offsets(1, 0);
+  std::vector<Uint> found_points;
+  std::vector<Real> found_weights;
+  for(int r = 0; r != static_cast<int>(all_not_found_coords.size()); ++r)
+  {
+    if(r == rank)
+      result.remote_begin = owners.size();
+    const std::vector<Real>& rank_coords = all_not_found_coords[r];
+    const Uint nb_rank_points = rank_coords.size() / dim;
+    for(Uint i = 0; i != nb_rank_points; ++i)
+    {
+      for(Uint d = 0; d != dim; ++d)
+        coord[d] = rank_coords[i*dim + d];
+      if(r != rank && m_point_interpolator->compute_storage(coord, element, stencil, points, weights))
+      {
+        owners.push_back(rank);
+        found_points.insert(found_points.end(), points.begin(), points.end());
+        found_weights.insert(found_weights.end(), weights.begin(), weights.end());
+      }
+      else
+      {
+        owners.push_back(-1);
+      }
+      found_offsets.push_back(found_points.size());
+    }
+  }
+
+  cf3_assert(owners.size() == nb_remote);
+  PE::Comm::instance().all_reduce(PE::max(), owners, owners);
+
+  result.nb_remote = nb_remote;
+  Uint nb_not_found = 0;
+  for(Uint i = 0; i != result.nb_remote; ++i)
+  {
+    if(owners[i] < 0)
+      ++nb_not_found;
+    if(owners[i] != rank)
+      continue;
+
+    result.owned_remote_indices.push_back(i);
+    result.owned_remote_points.insert(result.owned_remote_points.end(), found_points.begin() + found_offsets[i], found_points.begin() + found_offsets[i+1]);
+    result.owned_remote_weights.insert(result.owned_remote_weights.end(), found_weights.begin() + found_offsets[i], found_weights.begin() + found_offsets[i+1]);
+    result.owned_remote_offsets.push_back(result.owned_remote_points.size());
+  }
+
+  // All ranks know the owners of all points, so they throw together
+  if(nb_not_found != 0)
+  {
+    m_prolongations.pop_back();
+    throw SetupError(FromHere(), to_str(nb_not_found) + " points of " + fine_dict.uri().path() + " are outside of " + m_coarse_mesh->uri().path() + " on all ranks");
+  }
+
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MeshSequencing::prolongate()
+{
+  if(is_null(m_mesh))
+    throw SetupError(FromHere(), "Option \"mesh\" was not configured in " + uri().path());
+  if(is_null(m_coarse_mesh))
+    throw SetupError(FromHere(), "Option \"coarse_mesh\" was not configured in " + uri().path());
+
+  const std::vector<std::string> field_names = options().value< std::vector<std::string> >("field_names");
+
+  boost_foreach(const Handle<Dictionary>& fine_dict, m_mesh->dictionaries())
+  {
+    boost_foreach(const Handle<Field>& fine_field, fine_dict->fields())
+    {
+      if(fine_field->has_tag(mesh::Tags::coordinates()))
+        continue;
+      if(!field_names.empty() && std::find(field_names.begin(), field_names.end(), fine_field->name()) == field_names.end())
+        continue;
+
+      Handle<Field> coarse_field;
+      boost_foreach(const Handle<Dictionary>& coarse_dict, m_coarse_mesh->dictionaries())
+      {
+        coarse_field = Handle<Field>(coarse_dict->get_child(fine_field->name()));
+        if(is_not_null(coarse_field))
+          break;
+      }
+
+      if(is_null(coarse_field))
+      {
+        if(!field_names.empty())
+          throw SetupError(FromHere(), "Field " + fine_field->name() + " was not found in coarse mesh " + m_coarse_mesh->uri().path());
+        continue;
+      }
+
+      if(coarse_field->row_size() != fine_field->row_size())
+        throw SetupError(FromHere(), "Field " + fine_field->name() + " has " + to_str(coarse_field->row_size()) + " variables in the coarse mesh and " + to_str(fine_field->row_size()) + " in the fine mesh");
+
+      const Prolongation& stencils = prolongation(*fine_dict, coarse_field->dict());
+
+      const Field::ArrayT& coarse_array = coarse_field->array();
+      Field::ArrayT& fine_array = fine_field->array();
+      const Uint row_size = fine_field->row_size();
+      const Uint nb_points = fine_field->size();
+      std::vector<Real> values(row_size);
+      for(Uint i = 0; i != nb_points; ++i)
+      {
+        const Uint stencil_begin = stencils.offsets[i];
+        const Uint stencil_end = stencils.offsets[i+1];
+        if(stencil_begin == stencil_end)
+          continue;
+
+        std::fill(values.begin(), values.end(), 0.);
+        interpolate(coarse_array, &stencils.points[stencil_begin], &stencils.weights[stencil_begin], stencil_end - stencil_begin, &values[0]);
+        std::copy(values.begin(), values.end(), fine_array[i].begin());
+      }
+
+      // Points interpolated on another rank. The number of these points is the same on all ranks.
+      if(stencils.nb_remote != 0)
+      {
+        std::vector<Real> remote_values(stencils.nb_remote*row_size, 0.);
+        const Uint nb_owned_remote = stencils.owned_remote_indices.size();
+        for(Uint i = 0; i != nb_owned_remote; ++i)
+        {
+          const Uint stencil_begin = stencils.owned_remote_offsets[i];
+          const Uint stencil_end = stencils.owned_remote_offsets[i+1];
+          interpolate(coarse_array, &stencils.owned_remote_points[stencil_begin], &stencils.owned_remote_weights[stencil_begin], stencil_end - stencil_begin, &remote_values[stencils.owned_remote_indices[i]*row_size]);
+        }
+
+        PE::Comm::instance().all_reduce(PE::plus(), remote_values, remote_values);
+
+        const Uint nb_remote_fine = stencils.remote_fine_points.size();
+        for(Uint i = 0; i != nb_remote_fine; ++i)
+        {
+          const Real* remote_row = &remote_values[(stencils.remote_begin + i)*row_size];
+          std::copy(remote_row, remote_row + row_size, fine_array[stencils.remote_fine_points[i]].begin());
+        }
+      }
+
+      if(PE::Comm::instance().is_active())
+        fine_field->synchronize();
+
+      CFinfo << "Prolongated field " << fine_field->name() << " from " << m_coarse_mesh->uri().path() << " to " << m_mesh->uri().path() << CFendl;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // actions
+} // solver
+} // cf3
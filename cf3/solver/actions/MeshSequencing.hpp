@@ -0,0 +1,107 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_solver_actions_MeshSequencing_hpp
+#define cf3_solver_actions_MeshSequencing_hpp
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include "solver/Action.hpp"
+
+#include "solver/actions/LibActions.hpp"
+
+namespace cf3 {
+namespace mesh { class Dictionary; class PointInterpolator; }
+namespace solver {
+namespace actions {
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// @brief Initialize the fields of a mesh from a solution computed on a coarser mesh
+///
+/// The child actions are executed first, and must compute the solution on the coarse mesh, e.g. a time loop or
+/// a copy of the solver actions configured to work on the coarse mesh. The fields of the coarse mesh are then
+/// prolongated to the fields with the same name on the mesh of this action, by interpolation in the coarse elements.
+/// The interpolation stencils are computed once for each dictionary, and are kept until the coarse mesh option
+/// changes or a mesh raises the mesh_changed event.
+///
+/// In parallel, the points of the fine mesh that are not inside the coarse mesh on the same rank are searched on the
+/// other ranks, and interpolated by the highest rank that contains them, as done by ProbeSet. The coordinates of these
+/// points are gathered on all ranks, so this is cheapest when both meshes are partitioned alike.
+/// Points that are not inside the coarse mesh on any rank are an error.
+class solver_actions_API MeshSequencing : public solver::Action
+{
+public: // functions
+
+  /// Contructor
+  /// @param name of the component
+  MeshSequencing ( const std::string& name );
+
+  /// Virtual destructor
+  virtual ~MeshSequencing();
+
+  /// Get the class name
+  static std::string type_name () { return "MeshSequencing"; }
+
+  /// Run the child actions, then prolongate the fields
+  virtual void execute();
+
+  /// Interpolate the fields of the coarse mesh to the mesh of this action
+  void prolongate();
+
+  /// Discard the cached interpolation stencils
+  void invalidate();
+
+private:
+
+  /// Interpolation from the coarse mesh to the points of a fine dictionary, in compressed row format
+  struct Prolongation
+  {
+    Handle<mesh::Dictionary> fine_dict;
+    Handle<mesh::Dictionary> coarse_dict;
+    Uint fine_size;
+    std::vector<Uint> offsets;
+    std::vector<Uint> points;
+    std::vector<Real> weights;
+
+    /// Number of points that were not found on their own rank, over all ranks
+    Uint nb_remote;
+    /// Index of the first local point that was not found in the list of all points not found on their own rank
+    Uint remote_begin;
+    /// Local points that were not found on this rank, interpolated by another rank
+    std::vector<Uint> remote_fine_points;
+    /// Points of other ranks interpolated on this rank, as index in the list of all points not found on their own rank
+    std::vector<Uint> owned_remote_indices;
+    /// Stencils of the points of other ranks, in compressed row format
+    std::vector<Uint> owned_remote_offsets;
+    std::vector<Uint> owned_remote_points;
+    std::vector<Real> owned_remote_weights;
+  };
+
+private: // functions
+
+  /// Find the cached prolongation, or compute it
+  const Prolongation& prolongation(mesh::Dictionary& fine_dict, mesh::Dictionary& coarse_dict);
+
+  void on_mesh_changed_event(common::SignalArgs& args);
+
+private: // data
+
+  Handle<mesh::Mesh> m_coarse_mesh;
+  Handle<mesh::PointInterpolator> m_point_interpolator;
+
+  std::vector<Prolongation> m_prolongations;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // actions
+} // solver
+} // cf3
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif // cf3_solver_actions_MeshSequencing_hpp
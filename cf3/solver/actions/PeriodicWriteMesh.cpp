@@ -44,6 +44,7 @@ PeriodicWriteMesh::PeriodicWriteMesh ( const std::string& name ) : solver::Actio
   options().add( "saverate", 0u )
       .pretty_name("Save Rate")
       .description("Interval of iterations between saves");
+  m_saverate = options().value_handle<Uint>("saverate");
 
   options().add( "filepath", URI() )
       .pretty_name("File Path")
@@ -58,7 +59,7 @@ void PeriodicWriteMesh::execute()
 
   const Uint iteration = boost::any_cast<Uint> ( m_iterator->properties().property("iteration") );
 
-  const Uint saverate = options().value<Uint>("saverate");
+  const Uint saverate = *m_saverate;
 
   if (saverate == 0) return;
 
@@ -37,6 +37,8 @@ private: // data
 
   Handle<Component> m_iterator;  ///< component that holds the iteration
 
+  common::OptionValue<Uint> m_saverate; ///< interval of iterations between saves
+
   mesh::WriteMesh& m_writer; ///< mesh writer
 
 };
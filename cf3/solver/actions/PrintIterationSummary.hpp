@@ -45,6 +45,9 @@ private: // data
   Handle<Component> my_norm;
   Handle<Component> my_iter;
 
+  common::OptionValue<Uint> m_print_rate;
+  common::OptionValue<bool> m_check_convergence;
+
 };
 
 ////////////////////////////////////////////////////////////////////////////////
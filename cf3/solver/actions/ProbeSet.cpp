@@ -0,0 +1,279 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+
+#include "common/Core.hpp"
+#include "common/Builder.hpp"
+#include "common/EventHandler.hpp"
+#include "common/PropertyList.hpp"
+#include "common/OptionList.hpp"
+#include "common/OptionT.hpp"
+#include "common/OptionComponent.hpp"
+#include "common/FindComponents.hpp"
+#include "common/Signal.hpp"
+
+#include "common/PE/Comm.hpp"
+
+#include "math/VariablesDescriptor.hpp"
+
+#include "mesh/Dictionary.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/PointInterpolator.hpp"
+#include "mesh/Space.hpp"
+#include "mesh/Tags.hpp"
+
+#include "solver/History.hpp"
+#include "solver/actions/ProbeSet.hpp"
+
+namespace cf3 {
+namespace solver {
+namespace actions {
+
+using namespace common;
+using namespace mesh;
+
+common::ComponentBuilder < ProbeSet, common::Action, solver::actions::LibActions > ProbeSet_Builder;
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+ProbeSet::ProbeSet( const std::string& name  ) :
+  common::Action(name),
+  m_located(false),
+  m_located_dict_size(0)
+{
+  mark_basic();
+
+  properties()["brief"] = std::string("Set of probes to interpolate field values to many coordinates");
+  std::string description =
+      "Configure the coordinates and dictionary. The probes are located once, and all values are interpolated in a single pass";
+  properties()["description"] = description;
+
+  options().add("coordinates", std::vector<Real>())
+    .pretty_name("Coordinates")
+    .description("Coordinates of all probes, one after the other")
+    .attach_trigger( boost::bind( &ProbeSet::invalidate, this ) )
+    .mark_basic();
+
+  options().add("dict", m_dict)
+    .pretty_name("Dictionary")
+    .description("Dictionary that will be probed")
+    .link_to(&m_dict)
+    .attach_trigger( boost::bind( &ProbeSet::invalidate, this ) )
+    .mark_basic();
+
+  options().add("history", m_history)
+    .pretty_name("History")
+    .description("Optional history to log all probed variables to, as <probe set name>_<probe index>_<variable>")
+    .link_to(&m_history);
+
+  regist_signal ( "invalidate" )
+      .description( "Discard the cached probe locations, e.g. after moving the mesh" )
+      .pretty_name("Invalidate" )
+      .connect   ( boost::bind ( &ProbeSet::signal_invalidate, this, _1 ) );
+
+  m_point_interpolator = create_static_component<PointInterpolator>("point_interpolator");
+  m_values = create_static_component< Table<Real> >("values");
+
+  Core::instance().event_handler().connect_to_event(mesh::Tags::event_mesh_changed(), this, &ProbeSet::on_mesh_changed_event);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ProbeSet::~ProbeSet() {}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Uint ProbeSet::nb_probes() const
+{
+  if(is_null(m_dict))
+    return 0;
+  return options().value< std::vector<Real> >("coordinates").size() / m_dict->coordinates().row_size();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ProbeSet::invalidate()
+{
+  m_located = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ProbeSet::signal_invalidate(SignalArgs& args)
+{
+  invalidate();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ProbeSet::on_mesh_changed_event(SignalArgs& args)
+{
+  invalidate();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ProbeSet::locate()
+{
+  const std::vector<Real> coordinates = options().value< std::vector<Real> >("coordinates");
+  const Uint dim = m_dict->coordinates().row_size();
+  if(coordinates.size() % dim != 0)
+    throw SetupError(FromHere(), "Number of coordinates for " + uri().path() + " is not a multiple of the mesh dimension " + to_str(dim));
+
+  const Uint nb_probes = coordinates.size() / dim;
+  const int rank = PE::Comm::instance().rank();
+
+  m_point_interpolator->options().set("dict", m_dict);
+
+  // Search all probes in the local part of the mesh. If found on several processes, the highest rank owns the probe.
+  std::vector< std::vector<Uint> > points(nb_probes);
+  std::vector< std::vector<Real> > weights(nb_probes);
+  std::vector<int> owners(nb_probes, -1);
+  RealVector coord(dim);
+  SpaceElem element;
+  std::vector<SpaceElem> stencil;
+  for(Uint probe = 0; probe != nb_probes; ++probe)
+  {
+    for(Uint i = 0; i != dim; ++i)
+      coord[i] = coordinates[probe*dim + i];
+    if(m_point_interpolator->compute_storage(coord, element, stencil, points[probe], weights[probe]))
+      owners[probe] = rank;
+  }
+
+  if(PE::Comm::instance().is_active())
+    PE::Comm::instance().all_reduce(PE::max(), owners, owners);
+
+  m_owned_probes.clear();
+  m_stencil_offsets.assign(1, 0);
+  m_stencil_points.clear();
+  m_stencil_weights.clear();
+  for(Uint probe = 0; probe != nb_probes; ++probe)
+  {
+    if(owners[probe] < 0)
+    {
+      const std::vector<Real> probe_coord(coordinates.begin() + probe*dim, coordinates.begin() + (probe+1)*dim);
+      throw SetupError(FromHere(), "Cannot probe: coordinate (" + to_str(probe_coord) + ") of probe " + to_str(probe) + " in " + uri().path() + " lies outside the domain");
+    }
+
+    if(owners[probe] != rank)
+      continue;
+
+    m_owned_probes.push_back(probe);
+    m_stencil_points.insert(m_stencil_points.end(), points[probe].begin(), points[probe].end());
+    m_stencil_weights.insert(m_stencil_weights.end(), weights[probe].begin(), weights[probe].end());
+    m_stencil_offsets.push_back(m_stencil_points.size());
+  }
+
+  m_located_dict_size = m_dict->size();
+  m_located = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ProbeSet::update_columns()
+{
+  m_column_names.clear();
+  boost_foreach (const Handle<Field>& field, m_dict->fields())
+  {
+    const math::VariablesDescriptor& descriptor = field->descriptor();
+    for (Uint var_idx=0; var_idx<field->nb_vars(); ++var_idx)
+    {
+      const Uint var_length = descriptor.var_length(var_idx);
+      if (var_length==1)
+      {
+        m_column_names.push_back(descriptor.user_variable_name(var_idx));
+      }
+      else
+      {
+        for (Uint i=0; i<var_length; ++i)
+          m_column_names.push_back(descriptor.user_variable_name(var_idx)+"["+to_str(i)+"]");
+      }
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ProbeSet::execute()
+{
+  if ( is_null(m_dict) )
+    throw SetupError(FromHere(), "Option \"dict\" was not configured in "+uri().string());
+
+  if(!m_located || m_dict->size() != m_located_dict_size)
+    locate();
+
+  update_columns();
+
+  const Uint nb_probes = this->nb_probes();
+  const Uint nb_columns = m_column_names.size();
+
+  // Interpolate the owned probes, leaving zeros for the others
+  std::vector<Real> local_values(nb_probes*nb_columns, 0.);
+  const Uint nb_owned = m_owned_probes.size();
+  Uint column_begin = 0;
+  boost_foreach (const Handle<Field>& field, m_dict->fields())
+  {
+    const Field::ArrayT& array = field->array();
+    const Uint row_size = field->row_size();
+    for(Uint i = 0; i != nb_owned; ++i)
+    {
+      Real* result = &local_values[m_owned_probes[i]*nb_columns + column_begin];
+      const Uint stencil_end = m_stencil_offsets[i+1];
+      for(Uint s = m_stencil_offsets[i]; s != stencil_end; ++s)
+      {
+        const Field::ConstRow row = array[m_stencil_points[s]];
+        const Real weight = m_stencil_weights[s];
+        for(Uint v = 0; v != row_size; ++v)
+          result[v] += row[v] * weight;
+      }
+    }
+    column_begin += row_size;
+  }
+  cf3_assert(column_begin == nb_columns);
+
+  std::vector<Real> global_values;
+  if(PE::Comm::instance().is_active())
+    PE::Comm::instance().reduce(PE::plus(), local_values, global_values, 0);
+  else
+    global_values.swap(local_values);
+
+  if(PE::Comm::instance().rank() == 0)
+  {
+    m_values->set_row_size(nb_columns);
+    m_values->resize(nb_probes);
+    for(Uint probe = 0; probe != nb_probes; ++probe)
+    {
+      for(Uint j = 0; j != nb_columns; ++j)
+        (*m_values)[probe][j] = global_values[probe*nb_columns + j];
+    }
+
+    // The values are only available on rank 0, which is also the only rank that writes the history file
+    if(is_not_null(m_history))
+    {
+      for(Uint probe = 0; probe != nb_probes; ++probe)
+      {
+        const std::string prefix = name() + "_" + to_str(probe) + "_";
+        for(Uint j = 0; j != nb_columns; ++j)
+          m_history->set(prefix + m_column_names[j], (*m_values)[probe][j]);
+      }
+      m_history->save_entry();
+    }
+  }
+
+  // Do all post-processing actions
+  boost_foreach (common::Action& action, find_components<common::Action>(*this))
+  {
+    action.execute();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // actions
+} // solver
+} // cf3
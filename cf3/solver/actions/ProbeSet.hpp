@@ -0,0 +1,113 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_solver_actions_ProbeSet_hpp
+#define cf3_solver_actions_ProbeSet_hpp
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include "common/Action.hpp"
+#include "common/Table.hpp"
+
+#include "solver/actions/LibActions.hpp"
+
+namespace cf3 {
+namespace mesh { class Dictionary; class PointInterpolator; }
+namespace solver {
+class History;
+namespace actions {
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// @brief Interpolate all fields of a dictionary to a set of coordinates at once
+///
+/// Unlike a Probe, which searches the element containing its coordinate on each execution,
+/// the probes of a set are located only once: each process searches all probes in its part of the mesh,
+/// and a single reduction decides which process owns each probe. The owners keep the interpolation
+/// stencil (points and weights) of their probes, so an execution is a plain weighted sum over the stencils,
+/// followed by one reduction of all values to rank 0. The locations are recomputed only when the coordinates
+/// or the dictionary change, when the mesh raises the mesh_changed event, or after a call to invalidate(),
+/// which must be done after moving the mesh.
+///
+/// The interpolated values are available on rank 0 in values(), and can be logged to a History.
+/// Actions added as child are executed after the probes are evaluated.
+class solver_actions_API ProbeSet : public common::Action
+{
+public: // functions
+
+  /// Contructor
+  /// @param name of the component
+  ProbeSet ( const std::string& name );
+
+  /// Virtual destructor
+  virtual ~ProbeSet();
+
+  /// Get the class name
+  static std::string type_name () { return "ProbeSet"; }
+
+  virtual void execute();
+
+  /// Number of configured probes
+  Uint nb_probes() const;
+
+  /// Interpolated values, one row for each probe, containing the variables of all fields of the dictionary.
+  /// Only filled on rank 0.
+  const common::Table<Real>& values() const { return *m_values; }
+
+  /// Names of the columns of values(), with an index appended for the components of vector variables
+  const std::vector<std::string>& column_names() const { return m_column_names; }
+
+  /// Discard the cached probe locations, so they are searched again on the next execution
+  void invalidate();
+
+  /// @name SIGNALS
+  //@{
+  void signal_invalidate(common::SignalArgs& args);
+  //@}
+
+private: // functions
+
+  /// Find the owner and interpolation stencil of each probe
+  void locate();
+
+  /// Update the column names and the total number of variables from the fields of the dictionary
+  void update_columns();
+
+  void on_mesh_changed_event(common::SignalArgs& args);
+
+private: // data
+
+  Handle<mesh::Dictionary> m_dict;
+  Handle<mesh::PointInterpolator> m_point_interpolator;
+  Handle<History> m_history;
+  Handle< common::Table<Real> > m_values;
+
+  std::vector<std::string> m_column_names;
+
+  /// True if the stencils below are up-to-date
+  bool m_located;
+
+  /// Size of the dictionary when the probes were located
+  Uint m_located_dict_size;
+
+  /// Probes owned by this process
+  std::vector<Uint> m_owned_probes;
+
+  /// Interpolation stencils of the owned probes, in compressed row format
+  std::vector<Uint> m_stencil_offsets;
+  std::vector<Uint> m_stencil_points;
+  std::vector<Real> m_stencil_weights;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // actions
+} // solver
+} // cf3
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif // cf3_solver_actions_ProbeSet_hpp
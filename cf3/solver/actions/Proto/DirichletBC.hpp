@@ -13,6 +13,7 @@
 
 #include "math/LSS/System.hpp"
 
+#include "DirichletBCApplier.hpp"
 #include "LSSWrapper.hpp"
 #include "Terminals.hpp"
 #include "Transforms.hpp"
@@ -35,7 +36,7 @@ inline void assign_dirichlet(math::LSS::System& lss, const Real new_value, const
 {
   if(node_idx < 0)
     return;
-  lss.dirichlet(node_idx, offset, new_value - old_value, true);
+  DirichletBCApplier::instance().insert(lss, node_idx, offset, new_value - old_value);
 }
 
 /// Overload for vector types
@@ -45,7 +46,7 @@ inline void assign_dirichlet(math::LSS::System& lss, const NewT& new_value, cons
   if(node_idx < 0)
     return;
   for(Uint i = 0; i != OldT::RowsAtCompileTime; ++i)
-    lss.dirichlet(node_idx, offset+i, new_value[i] - old_value[i], true);
+    DirichletBCApplier::instance().insert(lss, node_idx, offset+i, new_value[i] - old_value[i]);
 }
 
 /// Sets whole-variable dirichlet BC, allowing the use of a complete vector as value
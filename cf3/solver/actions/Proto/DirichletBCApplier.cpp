@@ -0,0 +1,74 @@
+// Copyright (C) 2010-2011 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <boost/thread/tss.hpp>
+
+#include "DirichletBCApplier.hpp"
+
+namespace cf3 {
+namespace solver {
+namespace actions {
+namespace Proto {
+
+DirichletBCApplier::DirichletBCApplier() :
+  m_last(0)
+{
+}
+
+DirichletBCApplier& DirichletBCApplier::instance()
+{
+  // One instance per thread, since loops may run concurrently (see solver::ActionDirector)
+  static boost::thread_specific_ptr<DirichletBCApplier> instance;
+  if(instance.get() == 0)
+    instance.reset(new DirichletBCApplier());
+  return *instance;
+}
+
+DirichletBCApplier::Conditions& DirichletBCApplier::find_conditions(math::LSS::System& lss)
+{
+  for(std::list<Conditions>::iterator it = m_conditions.begin(); it != m_conditions.end(); ++it)
+  {
+    if(it->lss.get() == &lss)
+    {
+      m_last = &(*it);
+      return *m_last;
+    }
+  }
+
+  m_conditions.push_back(Conditions());
+  m_last = &m_conditions.back();
+  m_last->lss = lss.handle<math::LSS::System>();
+  return *m_last;
+}
+
+void DirichletBCApplier::apply()
+{
+  for(std::list<Conditions>::iterator it = m_conditions.begin(); it != m_conditions.end(); )
+  {
+    // Forget systems that were deleted
+    if(is_null(it->lss))
+    {
+      it = m_conditions.erase(it);
+      continue;
+    }
+
+    if(!it->blockrows.empty())
+    {
+      it->lss->dirichlet(it->blockrows, it->ieqs, it->values, true);
+      it->blockrows.clear();
+      it->ieqs.clear();
+      it->values.clear();
+    }
+    ++it;
+  }
+
+  m_last = 0;
+}
+
+} // namespace Proto
+} // namespace actions
+} // namespace solver
+} // namespace cf3
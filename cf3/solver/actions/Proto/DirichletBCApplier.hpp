@@ -0,0 +1,67 @@
+// Copyright (C) 2010-2011 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_solver_actions_Proto_DirichletBCApplier_hpp
+#define cf3_solver_actions_Proto_DirichletBCApplier_hpp
+
+#include <list>
+
+#include <boost/noncopyable.hpp>
+
+#include "math/LSS/System.hpp"
+
+/// @file
+/// Helper class to apply the Dirichlet conditions at the end of a loop
+
+namespace cf3 {
+namespace solver {
+namespace actions {
+namespace Proto {
+
+/// Collects the Dirichlet conditions set in a loop, to apply them to each system in a single batch at the end of the loop
+class DirichletBCApplier : public boost::noncopyable
+{
+public:
+
+  /// Singleton implementation
+  static DirichletBCApplier& instance();
+
+  /// Queue a condition for the given system
+  void insert(math::LSS::System& lss, const Uint blockrow, const Uint ieq, const Real value)
+  {
+    Conditions& conditions = m_last != 0 && m_last->lss.get() == &lss ? *m_last : find_conditions(lss);
+    conditions.blockrows.push_back(blockrow);
+    conditions.ieqs.push_back(ieq);
+    conditions.values.push_back(value);
+  }
+
+  /// Apply the queued conditions and clear the queue
+  void apply();
+
+private:
+  DirichletBCApplier();
+
+  /// Conditions for one system. The vectors are kept between loops, to reuse their storage
+  struct Conditions
+  {
+    Handle<math::LSS::System> lss;
+    std::vector<Uint> blockrows;
+    std::vector<Uint> ieqs;
+    std::vector<Real> values;
+  };
+
+  Conditions& find_conditions(math::LSS::System& lss);
+
+  std::list<Conditions> m_conditions;
+  Conditions* m_last;
+};
+
+} // namespace Proto
+} // namespace actions
+} // namespace solver
+} // namespace cf3
+
+#endif // cf3_solver_actions_Proto_DirichletBCApplier_hpp
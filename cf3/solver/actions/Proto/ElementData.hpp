@@ -21,6 +21,7 @@
 #include <boost/mpl/range_c.hpp>
 #include <boost/mpl/transform.hpp>
 #include <boost/mpl/vector_c.hpp>
+#include <boost/scoped_ptr.hpp>
 
 #include "common/Component.hpp"
 #include "common/FindComponents.hpp"
@@ -35,6 +36,7 @@
 #include "mesh/Space.hpp"
 #include "mesh/Dictionary.hpp"
 #include "mesh/ElementData.hpp"
+#include "mesh/ElementComputeView.hpp"
 #include "mesh/Connectivity.hpp"
 
 #include "ElementMatrix.hpp"
@@ -183,7 +185,8 @@ public:
 
   GeometricSupport(const mesh::Elements& elements) :
     m_coordinates(elements.geometry_fields().coordinates()),
-    m_connectivity_array(elements.geometry_space().connectivity().array())
+    m_connectivity_array(elements.geometry_space().connectivity().array()),
+    m_compute_view(elements.has_compute_view() ? &elements.compute_view() : 0)
   {
   }
 
@@ -191,6 +194,12 @@ public:
   void set_element(const Uint element_idx)
   {
     m_element_idx = element_idx;
+    if(m_compute_view != 0)
+    {
+      m_compute_view->put_connectivity(element_idx, m_connectivity);
+      m_compute_view->put_coordinates(element_idx, m_nodes);
+      return;
+    }
     const mesh::Connectivity::ConstRow row = m_connectivity_array[element_idx];
     std::copy(row.begin(), row.end(), m_connectivity.begin());
     mesh::fill(m_nodes, m_coordinates, m_connectivity);
@@ -321,6 +330,9 @@ private:
 
   /// Connectivity for all elements
   const mesh::Connectivity::ArrayT& m_connectivity_array;
+
+  /// Blocked copy of the connectivity and coordinates, used instead of the tables above if the elements have one
+  const mesh::ElementComputeView* m_compute_view;
   
   /// Connectivity table for the current element
   boost::array<Uint, EtypeT::nb_nodes> m_connectivity;
@@ -448,14 +460,7 @@ public:
   
   ~EtypeTVariableData()
   {
-    if(common::PE::Comm::instance().is_active())
-    {
-      const Uint my_sync = m_need_sync ? 1 : 0;
-      Uint global_sync = 0;
-      common::PE::Comm::instance().all_reduce(common::PE::plus(), &my_sync, 1, &global_sync);
-      if(global_sync != 0)
-        FieldSynchronizer::instance().insert(m_field, true);
-    }
+    FieldSynchronizer::insert_if_modified(m_field, m_need_sync, true);
   }
 
   /// Update nodes for the current element
@@ -916,11 +921,30 @@ public:
   
   static const Uint nb_lss_nodes = detail::GetNbNodes<EquationDataT>::value;
 
+  typedef GeometricSupport<SupportEtypeT> SupportT;
+
   ElementData(VariablesT& variables, mesh::Elements& elements) :
     m_variables(variables),
     m_elements(elements),
-    m_support(elements),
+    m_owned_support(new SupportT(elements)),
+    m_support(*m_owned_support),
+    m_equation_data(m_variables_data)
+  {
+    init();
+  }
+
+  /// Use a geometric support that is shared with other data for the same elements. The owner of the support is responsible for calling
+  /// set_element on it, before set_element is called here.
+  ElementData(VariablesT& variables, mesh::Elements& elements, SupportT& shared_support) :
+    m_variables(variables),
+    m_elements(elements),
+    m_support(shared_support),
     m_equation_data(m_variables_data)
+  {
+    init();
+  }
+
+  void init()
   {
     boost::mpl::for_each< boost::mpl::range_c<int, 0, NbVarsT::value> >(InitVariablesData(m_variables, m_elements, m_variables_data, m_support));
     for(Uint i = 0; i != CF3_PROTO_MAX_ELEMENT_MATRICES; ++i)
@@ -958,7 +982,8 @@ public:
   void set_element(const Uint element_idx)
   {
     m_element_idx = element_idx;
-    m_support.set_element(element_idx);
+    if(is_not_null(m_owned_support.get()))
+      m_support.set_element(element_idx);
     boost::mpl::for_each< boost::mpl::range_c<int, 0, NbVarsT::value> >(SetElement(m_variables_data, element_idx));
     boost::fusion::for_each(m_equation_data, FillRhs(m_element_rhs));
     update_blocks(typename boost::fusion::result_of::empty<EquationDataT>::type());
@@ -1019,8 +1044,6 @@ public:
     >::type type;
   };
 
-  typedef GeometricSupport<SupportEtypeT> SupportT;
-
   /// Return the data stored at index I
   template<typename I>
   typename DataType<I>::type& var_data(const I&)
@@ -1075,8 +1098,9 @@ private:
   /// Referred Elements
   mesh::Elements& m_elements;
 
-  /// Data for the geometric support
-  SupportT m_support;
+  /// Data for the geometric support, either owned or shared with other data
+  boost::scoped_ptr<SupportT> m_owned_support;
+  SupportT& m_support;
 
   /// Data associated with each numbered variable
   VariablesDataT m_variables_data;
@@ -16,6 +16,12 @@
 #include <boost/mpl/for_each.hpp>
 #include <boost/mpl/filter_view.hpp>
 
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/type_traits/remove_const.hpp>
+#include <boost/type_traits/remove_reference.hpp>
+#include <boost/utility/result_of.hpp>
+
 #include "ElementData.hpp"
 #include "ElementExpressionWrapper.hpp"
 #include "ElementGrammar.hpp"
@@ -24,11 +30,18 @@
 #include "mesh/Space.hpp"
 #include "mesh/ElementTypePredicates.hpp"
 
+#include "solver/ElementSweep.hpp"
+
 namespace cf3 {
 namespace solver {
 namespace actions {
 namespace Proto {
 
+/// Pass of an element loop. In a distributed mesh, the halo elements of all Elements are visited first, so the synchronization
+/// of the modified fields can run while the interior elements are processed (see mesh::Elements::halo_first_order()).
+/// Without a halo partition, all elements are visited in the interior pass.
+enum ElementSubset { HALO_ELEMENTS, INTERIOR_ELEMENTS };
+
 /// Check if all variables are on fields with element type ETYPE
 template<typename ETYPE>
 struct CheckSameEtype
@@ -60,7 +73,7 @@ struct CheckSameEtype
 template<typename ElementTypesT, typename ExprT, typename SupportETYPE, typename VariablesT, typename VariablesEtypesT, typename NbVarsT, typename VarIdxT>
 struct ExpressionRunner
 {
-  ExpressionRunner(VariablesT& vars, const ExprT& expr, mesh::Elements& elems) : variables(vars), expression(expr), elements(elems), m_nb_tests(0), m_found(false) {}
+  ExpressionRunner(VariablesT& vars, const ExprT& expr, mesh::Elements& elems, const ElementSubset elem_subset) : variables(vars), expression(expr), elements(elems), subset(elem_subset), m_nb_tests(0), m_found(false) {}
 
   typedef typename boost::remove_reference<typename boost::fusion::result_of::at<VariablesT, VarIdxT>::type>::type VarT;
 
@@ -89,7 +102,7 @@ struct ExpressionRunner
       NewVariablesEtypesT,
       NbVarsT,
       NextIdxT
-    >(variables, expression, elements).run();
+    >(variables, expression, elements, subset).run();
   }
 
   // Chosen otherwise
@@ -141,12 +154,13 @@ struct ExpressionRunner
       NewVariablesEtypesT,
       NbVarsT,
       NextIdxT
-    >(variables, expression, elements).run();
+    >(variables, expression, elements, subset).run();
   }
 
   VariablesT& variables;
   const ExprT& expression;
   mesh::Elements& elements;
+  const ElementSubset subset;
   // Number of times we tried a shape function
   mutable Uint m_nb_tests;
   mutable bool m_found;
@@ -159,22 +173,43 @@ template<typename DataT>
 struct ElementLooperImpl
 {
   template<typename ExprT>
-  void operator()(const ExprT& expr, DataT& data, const Uint nb_elems) const
+  void operator()(const ExprT& expr, DataT& data, const mesh::Elements& elements, const ElementSubset subset) const
   {
     const typename DataT::SupportShapeFunction::MappedCoordsT mapped_coords; // needed to deduce proper return type when wrapping
-    run(WrapExpression()(expr, mapped_coords, data), data, nb_elems);
+    run(WrapExpression()(expr, mapped_coords, data), data, elements, subset);
   }
 
 private:
   template<typename FilteredExprT>
-  void run(const FilteredExprT& expr, DataT& data, const Uint nb_elems) const
+  void run(const FilteredExprT& expr, DataT& data, const mesh::Elements& elements, const ElementSubset subset) const
   {
     ElementGrammar grammar;
-    for(Uint elem = 0; elem != nb_elems; ++elem)
+    const Uint nb_elems = elements.size();
+    if(!elements.has_halo_partition())
     {
-      // Update the data for the element
+      if(subset == HALO_ELEMENTS)
+        return;
+
+      for(Uint elem = 0; elem != nb_elems; ++elem)
+      {
+        // Update the data for the element
+        data.set_element(elem);
+        // Run the expression using a proto transform, passing as arguments in the standard proto sense: the expression, a state and the data
+        grammar(expr, elem, data);
+      }
+      return;
+    }
+
+    // An out of date partition has an empty order, and all elements are then visited in the halo pass
+    const std::vector<Uint>& halo_first_order = elements.halo_first_order();
+    const bool plain_order = halo_first_order.empty();
+    const Uint nb_halo_elems = elements.nb_halo_elements();
+    const Uint begin = subset == HALO_ELEMENTS ? 0 : nb_halo_elems;
+    const Uint end = subset == HALO_ELEMENTS ? nb_halo_elems : nb_elems;
+    for(Uint i = begin; i != end; ++i)
+    {
+      const Uint elem = plain_order ? i : halo_first_order[i];
       data.set_element(elem);
-      // Run the expression using a proto transform, passing as arguments in the standard proto sense: the expression, a state and the data
       grammar(expr, elem, data);
     }
   }
@@ -184,7 +219,7 @@ private:
 template<typename ElementTypesT, typename ExprT, typename SupportETYPE, typename VariablesT, typename VariablesEtypesT, typename NbVarsT>
 struct ExpressionRunner<ElementTypesT, ExprT, SupportETYPE, VariablesT, VariablesEtypesT, NbVarsT, NbVarsT>
 {
-  ExpressionRunner(VariablesT& vars, const ExprT& expr, mesh::Elements& elems) : variables(vars), expression(expr), elements(elems) {}
+  ExpressionRunner(VariablesT& vars, const ExprT& expr, mesh::Elements& elems, const ElementSubset elem_subset) : variables(vars), expression(expr), elements(elems), subset(elem_subset) {}
 
   typedef ElementData<VariablesT, VariablesEtypesT, SupportETYPE, typename EquationVariables<ExprT, NbVarsT>::type> DataT;
 
@@ -198,13 +233,14 @@ struct ExpressionRunner<ElementTypesT, ExprT, SupportETYPE, VariablesT, Variable
 
     DataT data(variables, elements);
 
-    ElementLooperImpl<DataT>()(expression, data, elements.size());
+    ElementLooperImpl<DataT>()(expression, data, elements, subset);
   }
 
 private:
   VariablesT& variables;
   const ExprT& expression;
   mesh::Elements& elements;
+  const ElementSubset subset;
 };
 
 /// mpl::for_each compatible functor to loop over elements, using the correct shape function for the geometry
@@ -215,10 +251,11 @@ struct ElementLooper
   // Type of a fusion vector that can contain a copy of each variable that is used in the expression
   typedef typename ExpressionProperties<ExprT>::VariablesT VariablesT;
 
-  ElementLooper(mesh::Elements& elements, const ExprT& expr, VariablesT& variables) :
+  ElementLooper(mesh::Elements& elements, const ExprT& expr, VariablesT& variables, const ElementSubset subset) :
     m_elements(elements),
     m_expr(expr),
-    m_variables(variables)
+    m_variables(variables),
+    m_subset(subset)
   {
   }
 
@@ -237,9 +274,11 @@ struct ElementLooper
     if(!mesh::IsElementType<ETYPE>()(m_elements.element_type()))
       return;
 
+    // Without halo partition there are no halo elements, so the element data is not even created
+    if(m_subset == HALO_ELEMENTS && !m_elements.has_halo_partition())
+      return;
+
     dispatch(boost::mpl::int_<boost::mpl::size< boost::mpl::filter_view< ElementTypesT, mesh::IsCompatibleWith<ETYPE> > >::value>(), sf);
-    
-    FieldSynchronizer::instance().synchronize();
   }
 
   /// Static dispatch in case everything has the same ETYPE
@@ -254,7 +293,7 @@ struct ElementLooper
 
     DataT data(m_variables, m_elements);
 
-    ElementLooperImpl<DataT>()(m_expr, data, m_elements.size());
+    ElementLooperImpl<DataT>()(m_expr, data, m_elements, m_subset);
   }
 
   /// Static dispatch in case different ETYPE are possible
@@ -275,13 +314,205 @@ struct ElementLooper
       boost::mpl::vector0<>, // Start with an empty vector for the per-variable element types
       NbVarsT, // number of variables
       boost::mpl::int_<0> // Start index, as MPL integral constant
-    >(m_variables, m_expr, m_elements).run();
+    >(m_variables, m_expr, m_elements, m_subset).run();
+  }
+
+private:
+  mesh::Elements& m_elements;
+  const ExprT& m_expr;
+  VariablesT& m_variables;
+  const ElementSubset m_subset;
+};
+
+/// Loop over all elements under the given region, first the halo elements and then the interior elements.
+/// The fields modified in the halo pass start synchronizing before the interior pass, and all fields are synchronized at the end.
+template<typename ElementTypesT, typename ExprT>
+void loop_elements(mesh::Region& region, const ExprT& expr, typename ExpressionProperties<ExprT>::VariablesT& variables)
+{
+  // We skip order 0 functions in the top-call, because first the support shape function is determined, and order 0 is not allowed there
+  typedef boost::mpl::filter_view< ElementTypesT, mesh::IsMinimalOrder<1> > SupportTypesT;
+
+  BOOST_FOREACH(mesh::Elements& elements, common::find_components_recursively<mesh::Elements>(region))
+  {
+    boost::mpl::for_each<SupportTypesT>( ElementLooper<ElementTypesT, ExprT>(elements, expr, variables, HALO_ELEMENTS) );
+  }
+
+  FieldSynchronizer::instance().start_synchronization();
+
+  BOOST_FOREACH(mesh::Elements& elements, common::find_components_recursively<mesh::Elements>(region))
+  {
+    boost::mpl::for_each<SupportTypesT>( ElementLooper<ElementTypesT, ExprT>(elements, expr, variables, INTERIOR_ELEMENTS) );
+  }
+
+  FieldSynchronizer::instance().synchronize();
+}
+
+/// Geometric support for the elements of a fused loop, shared by all sweeps over these elements
+template<typename ETYPE>
+class ElementGeometryImpl : public ElementGeometry
+{
+public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  ElementGeometryImpl(const mesh::Elements& elements) : support(elements)
+  {
+  }
+
+  virtual void set_element(const Uint element_idx)
+  {
+    support.set_element(element_idx);
+  }
+
+  GeometricSupport<ETYPE> support;
+};
+
+/// Evaluates an expression one element at a time, for expressions where all variables use the element type of the support.
+/// The connectivity and coordinates come from the shared geometry, and the expression is wrapped once for all elements.
+template<typename VariablesT, typename DataT, typename ExprT>
+class ElementSweepImpl : public ElementSweep
+{
+  typedef typename DataT::SupportShapeFunction SupportEtypeT;
+  typedef ElementGeometryImpl<SupportEtypeT> GeometryT;
+  typedef typename SupportEtypeT::MappedCoordsT MappedCoordsT;
+  typedef typename boost::remove_const
+  <
+    typename boost::remove_reference
+    <
+      typename boost::result_of<WrapExpression(const ExprT&, const MappedCoordsT&, DataT&)>::type
+    >::type
+  >::type WrappedExprT;
+
+public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  ElementSweepImpl(const ExprT& expr, VariablesT& variables, mesh::Elements& elements, boost::shared_ptr<ElementGeometry>& geometry) :
+    m_geometry(get_geometry(elements, geometry)),
+    m_data(new DataT(variables, elements, m_geometry->support)),
+    m_wrapped_expr(WrapExpression()(expr, m_mapped_coords, *m_data))
+  {
+  }
+
+  virtual void evaluate(const Uint element_idx)
+  {
+    m_data->set_element(element_idx);
+    ElementGrammar()(m_wrapped_expr, element_idx, *m_data);
+  }
+
+  virtual void finish()
+  {
+    m_data.reset();
+  }
+
+  virtual void start_synchronization()
+  {
+    FieldSynchronizer::instance().start_synchronization();
+  }
+
+  virtual void synchronize()
+  {
+    FieldSynchronizer::instance().synchronize();
+  }
+
+private:
+  /// Use the given geometry, or create it if this is the first sweep over the elements
+  static boost::shared_ptr<GeometryT> get_geometry(mesh::Elements& elements, boost::shared_ptr<ElementGeometry>& geometry)
+  {
+    if(is_null(geometry))
+    {
+      boost::shared_ptr<GeometryT> result(new GeometryT(elements));
+      geometry = result;
+      return result;
+    }
+
+    boost::shared_ptr<GeometryT> result = boost::dynamic_pointer_cast<GeometryT>(geometry);
+    if(is_null(result))
+      throw common::SetupError(FromHere(), "Geometry shared by the sweeps over " + elements.uri().path() + " has the wrong element type");
+    return result;
+  }
+
+  boost::shared_ptr<GeometryT> m_geometry;
+  boost::scoped_ptr<DataT> m_data;
+  /// Only used to deduce the type of the wrapped expression
+  const MappedCoordsT m_mapped_coords;
+  WrappedExprT m_wrapped_expr;
+};
+
+/// mpl::for_each compatible functor to check if an expression can be evaluated one element at a time on the given elements.
+/// This is not possible if several element types are compatible with the element type of the elements, since the variables
+/// may then use a different element type.
+template<typename ElementTypesT>
+struct ElementSweepSupport
+{
+  ElementSweepSupport(mesh::Elements& elements, bool& supported) :
+    m_elements(elements),
+    m_supported(supported)
+  {
+  }
+
+  template < typename ETYPE >
+  void operator() (const ETYPE&) const
+  {
+    if(!mesh::IsElementType<ETYPE>()(m_elements.element_type()))
+      return;
+
+    if(boost::mpl::size< boost::mpl::filter_view< ElementTypesT, mesh::IsCompatibleWith<ETYPE> > >::value != 1)
+      m_supported = false;
+  }
+
+private:
+  mesh::Elements& m_elements;
+  bool& m_supported;
+};
+
+/// mpl::for_each compatible functor to create the ElementSweep for the element type of the given elements
+template<typename ElementTypesT, typename ExprT>
+struct ElementSweepCreator
+{
+  typedef typename ExpressionProperties<ExprT>::VariablesT VariablesT;
+
+  ElementSweepCreator(mesh::Elements& elements, const ExprT& expr, VariablesT& variables, boost::shared_ptr<ElementGeometry>& geometry, boost::shared_ptr<ElementSweep>& sweep) :
+    m_elements(elements),
+    m_expr(expr),
+    m_variables(variables),
+    m_geometry(geometry),
+    m_sweep(sweep)
+  {
+  }
+
+  template < typename ETYPE >
+  void operator() (const ETYPE& sf) const
+  {
+    if(!mesh::IsElementType<ETYPE>()(m_elements.element_type()))
+      return;
+
+    create(boost::mpl::int_<boost::mpl::size< boost::mpl::filter_view< ElementTypesT, mesh::IsCompatibleWith<ETYPE> > >::value>(), sf);
+  }
+
+  /// Everything has the same ETYPE, so the expression can be evaluated per element
+  template<typename ETYPE>
+  void create(const boost::mpl::int_<1>&, const ETYPE&) const
+  {
+    typedef typename ExpressionProperties<ExprT>::NbVarsT NbVarsT;
+    typedef ElementData<VariablesT, ETYPE, ETYPE, typename EquationVariables<ExprT, NbVarsT>::type> DataT;
+
+    boost::fusion::for_each(m_variables, CheckSameEtype<ETYPE>(m_elements));
+
+    m_sweep.reset(new ElementSweepImpl<VariablesT, DataT, ExprT>(m_expr, m_variables, m_elements, m_geometry));
+  }
+
+  /// Different ETYPE are possible, so no sweep can be made. ElementSweepSupport excludes this case.
+  template<typename T, typename ETYPE>
+  void create(const T&, const ETYPE&) const
+  {
+    throw common::SetupError(FromHere(), "Expression can't be evaluated one element at a time on " + m_elements.uri().path() + ", since its variables may use different element types");
   }
 
 private:
   mesh::Elements& m_elements;
   const ExprT& m_expr;
   VariablesT& m_variables;
+  boost::shared_ptr<ElementGeometry>& m_geometry;
+  boost::shared_ptr<ElementSweep>& m_sweep;
 };
 
 template<typename ElementTypesT, typename ExprT>
@@ -294,11 +525,7 @@ void for_each_element(mesh::Region& root_region, const ExprT& expr)
   boost::proto::eval(expr, ctx); // calling eval using the above context stores all variables in vars
 
   // Traverse all Elements under the root and evaluate the expression
-  BOOST_FOREACH(mesh::Elements& elements, common::find_components_recursively<mesh::Elements>(root_region))
-  {
-    // We skip order 0 functions in the top-call, because first the support shape function is determined, and order 0 is not allowed there
-    boost::mpl::for_each< boost::mpl::filter_view< ElementTypesT, mesh::IsMinimalOrder<1> > >( ElementLooper<ElementTypesT, ExprT>(elements, expr, vars) );
-  }
+  loop_elements<ElementTypesT>(root_region, expr, vars);
 };
 
 } // namespace Proto
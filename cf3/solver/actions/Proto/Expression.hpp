@@ -65,6 +65,26 @@ public:
   /// value: space library name, to indicate what kind of field is expected
   virtual void insert_field_info(std::map<std::string, std::string>& tags) const = 0;
 
+  /// True if the expression loops over elements
+  virtual bool is_element_expression() const
+  {
+    return false;
+  }
+
+  /// True if the expression can be evaluated one element at a time on the given elements, i.e. all variables use the element type of the elements
+  virtual bool supports_element_sweep(mesh::Elements& elements)
+  {
+    return false;
+  }
+
+  /// Sweep evaluating the expression on the given elements, one element at a time
+  /// @param geometry Geometry shared with other sweeps over the same elements, created by the sweep if null
+  /// @return null if the expression is not compiled for the element type
+  virtual boost::shared_ptr<ElementSweep> element_sweep(mesh::Elements& elements, boost::shared_ptr<ElementGeometry>& geometry)
+  {
+    return boost::shared_ptr<ElementSweep>();
+  }
+
   virtual ~Expression() {}
 };
 
@@ -253,10 +273,26 @@ public:
   void loop(mesh::Region& region)
   {
     // Traverse all Elements under the region and evaluate the expression
-    BOOST_FOREACH(mesh::Elements& elements, common::find_components_recursively<mesh::Elements>(region) )
-    {
-      boost::mpl::for_each<boost::mpl::filter_view< ElementTypes, mesh::IsMinimalOrder<1> > >( ElementLooper<ElementTypes, typename BaseT::CopiedExprT>(elements, BaseT::m_expr, BaseT::m_variables) );
-    }
+    loop_elements<ElementTypes>(region, BaseT::m_expr, BaseT::m_variables);
+  }
+
+  bool is_element_expression() const
+  {
+    return true;
+  }
+
+  bool supports_element_sweep(mesh::Elements& elements)
+  {
+    bool result = true;
+    boost::mpl::for_each<boost::mpl::filter_view< ElementTypes, mesh::IsMinimalOrder<1> > >( ElementSweepSupport<ElementTypes>(elements, result) );
+    return result;
+  }
+
+  boost::shared_ptr<ElementSweep> element_sweep(mesh::Elements& elements, boost::shared_ptr<ElementGeometry>& geometry)
+  {
+    boost::shared_ptr<ElementSweep> result;
+    boost::mpl::for_each<boost::mpl::filter_view< ElementTypes, mesh::IsMinimalOrder<1> > >( ElementSweepCreator<ElementTypes, typename BaseT::CopiedExprT>(elements, BaseT::m_expr, BaseT::m_variables, geometry, result) );
+    return result;
   }
 };
 
@@ -4,9 +4,14 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <boost/bind.hpp>
+#include <boost/thread/tss.hpp>
+
 #include "common/PE/Comm.hpp"
 #include "common/List.hpp"
 
+#include "solver/ActionDirector.hpp"
+
 #include "FieldSync.hpp"
 
 namespace cf3 {
@@ -14,14 +19,36 @@ namespace solver {
 namespace actions {
 namespace Proto {
 
+namespace detail
+{
+  /// Collective part of FieldSynchronizer::insert_if_modified, run on the main thread
+  void insert_if_modified(const Handle<mesh::Field>& field, const bool modified, const bool do_periodic_element_update)
+  {
+    const Uint my_sync = modified ? 1 : 0;
+    Uint global_sync = 0;
+    common::PE::Comm::instance().all_reduce(common::PE::plus(), &my_sync, 1, &global_sync);
+    if(global_sync != 0)
+      FieldSynchronizer::instance().insert(*field, do_periodic_element_update);
+  }
+
+  /// Synchronize the fields inserted on the main thread
+  void synchronize_main_thread()
+  {
+    FieldSynchronizer::instance().synchronize();
+  }
+}
+
 FieldSynchronizer::FieldSynchronizer()
 {
 }
 
 FieldSynchronizer& FieldSynchronizer::instance()
 {
-  static FieldSynchronizer instance;
-  return instance;
+  // One instance per thread, since loops may run concurrently (see solver::ActionDirector)
+  static boost::thread_specific_ptr<FieldSynchronizer> instance;
+  if(instance.get() == 0)
+    instance.reset(new FieldSynchronizer());
+  return *instance;
 }
 
 
@@ -30,8 +57,39 @@ void FieldSynchronizer::insert(mesh::Field& f, bool do_periodic_element_update)
   m_fields[f.uri().path()] = std::make_pair(f.handle<mesh::Field>(), do_periodic_element_update);
 }
 
+void FieldSynchronizer::insert_if_modified(mesh::Field& f, const bool modified, const bool do_periodic_element_update)
+{
+  if(!common::PE::Comm::instance().is_active())
+    return;
+
+  solver::ActionDirector::defer_to_main_thread(boost::bind(&detail::insert_if_modified, f.handle<mesh::Field>(), modified, do_periodic_element_update));
+}
+
+void FieldSynchronizer::start_synchronization()
+{
+  // The fields are inserted on the main thread in concurrent execution
+  if(!common::PE::Comm::instance().is_active() || solver::ActionDirector::in_concurrent_execution())
+    return;
+
+  for(FieldsT::iterator field_it = m_fields.begin(); field_it != m_fields.end(); ++field_it)
+  {
+    mesh::Field& field = *field_it->second.first;
+    if(field_it->second.second && is_not_null(field.dict().get_child("periodic_links_nodes")))
+      continue;
+
+    if(m_started_fields.insert(field_it->first).second)
+      field.synchronize_begin();
+  }
+}
+
 void FieldSynchronizer::synchronize()
 {
+  if(solver::ActionDirector::in_concurrent_execution())
+  {
+    solver::ActionDirector::defer_to_main_thread(&detail::synchronize_main_thread);
+    return;
+  }
+
   // Periodic update needed even in a sequential run
   for(FieldsT::iterator field_it = m_fields.begin(); field_it != m_fields.end(); ++field_it)
   {
@@ -88,11 +146,15 @@ void FieldSynchronizer::synchronize()
   {
     for(FieldsT::iterator field_it = m_fields.begin(); field_it != m_fields.end(); ++field_it)
     {
-      field_it->second.first->synchronize();
+      if(m_started_fields.count(field_it->first) != 0)
+        field_it->second.first->synchronize_end();
+      else
+        field_it->second.first->synchronize();
     }
   }
 
   m_fields.clear();
+  m_started_fields.clear();
 }
 
 } // namespace Proto
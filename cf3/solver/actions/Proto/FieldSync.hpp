@@ -7,6 +7,9 @@
 #ifndef cf3_solver_actions_Proto_FieldSync_hpp
 #define cf3_solver_actions_Proto_FieldSync_hpp
 
+#include <map>
+#include <set>
+
 #include "mesh/Field.hpp"
 
 /// @file
@@ -29,7 +32,18 @@ public:
   /// @param do_periodic_element_update Sum together periodic entries, i.e. after an element loop that updates nodal values
   void insert(mesh::Field& f, bool do_periodic_element_update);
 
-  /// Sync fields and clear the list
+  /// Insert the field on all ranks if it was modified on any rank. This is a collective call in an MPI run, so in concurrent
+  /// execution it is deferred to the main thread (see solver::ActionDirector::defer_to_main_thread()), like synchronize().
+  /// @param modified True if the field was modified on this rank
+  static void insert_if_modified(mesh::Field& f, const bool modified, const bool do_periodic_element_update);
+
+  /// Start a non-blocking synchronization of the inserted fields, so the communication can overlap with the rest of a loop.
+  /// Called by the element loops once the halo elements are done, see mesh::Elements::halo_first_order().
+  /// Fields that need the periodic update are left to synchronize(), since it needs the complete loop result.
+  void start_synchronization();
+
+  /// Sync fields and clear the list. Completes the synchronizations started with start_synchronization()
+  /// In concurrent execution, this is deferred to the main thread, and start_synchronization() does nothing.
   void synchronize();
 
 private:
@@ -39,6 +53,9 @@ private:
   // on each cpu.
   typedef std::map< std::string, std::pair<Handle<mesh::Field>, bool> > FieldsT;
   FieldsT m_fields;
+
+  // URIs of the fields for which start_synchronization() started a synchronization
+  std::set<std::string> m_started_fields;
 };
 
 
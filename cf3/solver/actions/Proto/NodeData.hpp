@@ -74,6 +74,8 @@ struct NodeVarData
 
   void set_node(const Uint) {}
 
+  void transfer_synchronization(NodeVarData&) {}
+
   /// By default, value just returns the supplied value
   ValueResultT value()
   {
@@ -101,7 +103,8 @@ struct NodeVarData< ScalarField >
 
   NodeVarData(const ScalarField& placeholder, mesh::Region& region) :
     m_field(find_field(region, placeholder.field_tag())),
-    m_need_synchronization(false)
+    m_need_synchronization(false),
+    m_is_thread_copy(false)
   {
     const math::VariablesDescriptor& descriptor = m_field.descriptor();
     m_var_begin = descriptor.offset(placeholder.name());
@@ -115,14 +118,8 @@ struct NodeVarData< ScalarField >
 
   ~NodeVarData()
   {
-    if(common::PE::Comm::instance().is_active())
-    {
-      const Uint my_sync = m_need_synchronization ? 1 : 0;
-      Uint global_sync = 0;
-      common::PE::Comm::instance().all_reduce(common::PE::plus(), &my_sync, 1, &global_sync);
-      if(global_sync != 0)
-        FieldSynchronizer::instance().insert(m_field, false);
-    }
+    if(!m_is_thread_copy)
+      FieldSynchronizer::insert_if_modified(m_field, m_need_synchronization, false);
   }
 
   void set_node(const Uint idx)
@@ -131,6 +128,14 @@ struct NodeVarData< ScalarField >
     m_value = m_field[idx][m_var_begin];
   }
 
+  /// Pass the need for synchronization to the data used by the master thread, which synchronizes on destruction
+  void transfer_synchronization(NodeVarData& master)
+  {
+    master.m_need_synchronization = master.m_need_synchronization || m_need_synchronization;
+    m_need_synchronization = false;
+    m_is_thread_copy = true;
+  }
+
   typedef Real ValueT;
   typedef Real ValueResultT;
 
@@ -174,6 +179,7 @@ private:
   Uint m_idx;
   Real m_value;
   bool m_need_synchronization;
+  bool m_is_thread_copy;
 };
 
 template<Uint Dim>
@@ -188,7 +194,8 @@ struct NodeVarData<VectorField, Dim>
 
   NodeVarData(const VectorField& placeholder, mesh::Region& region) :
     m_field( find_field(region, placeholder.field_tag()) ),
-    m_need_synchronization(false)
+    m_need_synchronization(false),
+    m_is_thread_copy(false)
   {
     const math::VariablesDescriptor& descriptor = m_field.descriptor();
     m_var_begin = descriptor.offset(placeholder.name());
@@ -202,14 +209,8 @@ struct NodeVarData<VectorField, Dim>
 
   ~NodeVarData()
   {
-    if(common::PE::Comm::instance().is_active())
-    {
-      const Uint my_sync = m_need_synchronization ? 1 : 0;
-      Uint global_sync = 0;
-      common::PE::Comm::instance().all_reduce(common::PE::plus(), &my_sync, 1, &global_sync);
-      if(global_sync != 0)
-        FieldSynchronizer::instance().insert(m_field, false);
-    }
+    if(!m_is_thread_copy)
+      FieldSynchronizer::insert_if_modified(m_field, m_need_synchronization, false);
   }
 
   void set_node(const Uint idx)
@@ -219,6 +220,14 @@ struct NodeVarData<VectorField, Dim>
       m_value[i] = m_field[idx][m_var_begin + i];
   }
 
+  /// Pass the need for synchronization to the data used by the master thread, which synchronizes on destruction
+  void transfer_synchronization(NodeVarData& master)
+  {
+    master.m_need_synchronization = master.m_need_synchronization || m_need_synchronization;
+    m_need_synchronization = false;
+    m_is_thread_copy = true;
+  }
+
   /// Return a reference to the stored value
   ValueResultT value() const
   {
@@ -286,6 +295,7 @@ private:
   ValueT m_value;
   Uint m_idx;
   bool m_need_synchronization;
+  bool m_is_thread_copy;
 };
 
 /// MPL transform operator to wrap a variable in its data type
@@ -365,6 +375,12 @@ public:
     boost::mpl::for_each< boost::mpl::range_c<int, 0, NbVarsT::value> >(SetNode(m_variables_data, m_node_idx));
   }
   
+  /// Called on the data of a worker thread, to leave the synchronization of the modified fields to the data of the master thread
+  void transfer_synchronization(NodeData& master)
+  {
+    boost::mpl::for_each< boost::mpl::range_c<int, 0, NbVarsT::value> >(TransferSynchronization(m_variables_data, master.m_variables_data));
+  }
+
   inline Uint node_idx() const
   {
     return m_node_idx;
@@ -452,6 +468,32 @@ private:
     VariablesDataT& variables_data;
   };
 
+  /// Transfer the synchronization flags of each stored data item
+  struct TransferSynchronization
+  {
+    TransferSynchronization(VariablesDataT& vars_data, VariablesDataT& master_vars_data) :
+      variables_data(vars_data),
+      master_variables_data(master_vars_data)
+    {
+    }
+
+    template<typename I>
+    void operator()(const I&)
+    {
+      apply(boost::fusion::at<I>(variables_data), boost::fusion::at<I>(master_variables_data));
+    }
+
+    template<typename VarDataT>
+    void apply(VarDataT* data, VarDataT* master_data)
+    {
+      if(data != 0)
+        data->transfer_synchronization(*master_data);
+    }
+
+    VariablesDataT& variables_data;
+    VariablesDataT& master_variables_data;
+  };
+
   /// Set the element on each stored data item
   struct SetNode
   {
@@ -31,6 +31,48 @@ struct WrappableNodeExpressions :
 {
 };
 
+/// Right-hand sides of node expressions that only read the current node, and no values that may be modified by other threads
+struct ThreadSafeNodeMath :
+  boost::proto::or_
+  <
+    boost::proto::terminal< Var< boost::proto::_, ScalarField > >,
+    boost::proto::terminal< Var< boost::proto::_, VectorField > >,
+    CoordsTerminals,
+    boost::proto::terminal<NodeIdxOp>,
+    Scalar,
+    MatVec,
+    boost::proto::terminal< IndexTag<boost::proto::_> >,
+    boost::proto::negate<ThreadSafeNodeMath>,
+    boost::proto::plus<ThreadSafeNodeMath, ThreadSafeNodeMath>,
+    boost::proto::minus<ThreadSafeNodeMath, ThreadSafeNodeMath>,
+    boost::proto::multiplies<ThreadSafeNodeMath, ThreadSafeNodeMath>,
+    boost::proto::divides<ThreadSafeNodeMath, ThreadSafeNodeMath>,
+    boost::proto::subscript<ThreadSafeNodeMath, boost::proto::_>
+  >
+{
+};
+
+/// Field assignments that have no dependencies between nodes, so the nodes can be processed by several threads.
+/// Expressions that modify a linear system, print output or call user-defined functions do not match.
+struct ThreadSafeNodeAssignment :
+  boost::proto::or_
+  <
+    boost::proto::assign< boost::proto::or_< FieldTypes, boost::proto::subscript<FieldTypes, boost::proto::_> >, ThreadSafeNodeMath >,
+    boost::proto::plus_assign< boost::proto::or_< FieldTypes, boost::proto::subscript<FieldTypes, boost::proto::_> >, ThreadSafeNodeMath >,
+    boost::proto::minus_assign< boost::proto::or_< FieldTypes, boost::proto::subscript<FieldTypes, boost::proto::_> >, ThreadSafeNodeMath >
+  >
+{
+};
+
+struct ThreadSafeNodeExpression :
+  boost::proto::or_
+  <
+    ThreadSafeNodeAssignment,
+    boost::proto::function< boost::proto::terminal<ExpressionGroupTag>, boost::proto::vararg<ThreadSafeNodeAssignment> >
+  >
+{
+};
+
 /// Loop over nodes, when the dimension is known
 template<typename ExprT, typename NbDimsT>
 struct NodeLooperDim
@@ -139,31 +181,56 @@ struct NodeLooperDim
     const mesh::Field& coordinates = dict->coordinates();
     DataT node_data(m_variables, m_region, coordinates, m_expr);
 
+    // Build a list of used nodes, or reuse the list from a previous execution
+    boost::shared_ptr< common::List<Uint> const > used_nodes_ptr = mesh::cached_used_nodes_list(m_region, *dict, true);
+    const common::List<Uint>& nodes = *used_nodes_ptr;
+
+    if(boost::proto::matches<ExprT, ThreadSafeNodeExpression>::value && nodes.size() >= min_nodes_per_thread)
+    {
+      #pragma omp parallel
+      {
+        // Each thread has its own data and its own copy of the wrapped expression, which holds the intermediate results
+        DataT thread_data(m_variables, m_region, coordinates, m_expr);
+        do_run_threaded(WrapExpression()(m_expr, 0, thread_data), thread_data, nodes);
+        #pragma omp critical
+        thread_data.transfer_synchronization(node_data);
+      }
+      return;
+    }
+
     // Wrap things up so that we can store the intermediate product results
-    do_run(WrapExpression()(m_expr, 0, node_data), node_data, *dict);
+    do_run(WrapExpression()(m_expr, 0, node_data), node_data, nodes);
   }
 
+  /// Lists with fewer nodes are always processed serially
+  static const Uint min_nodes_per_thread = 1024;
+
 private:
   template<typename FilteredExprT>
-  void do_run(const FilteredExprT& expr, DataT& data, const mesh::Dictionary& dict) const
+  void do_run(const FilteredExprT& expr, DataT& data, const common::List<Uint>& nodes) const
   {
     NodeGrammar grammar;
 
-    // Build a list of used entities
-    std::vector< Handle<mesh::Entities const> > used_entities;
-    BOOST_FOREACH(const mesh::Entities& entities, common::find_components_recursively<mesh::Entities>(m_region))
+    const Uint nb_nodes = nodes.size();
+    for(Uint i = 0; i != nb_nodes; ++i)
     {
-      used_entities.push_back(entities.handle<mesh::Entities>());
+      data.set_node(nodes[i]);
+      grammar(expr, 0, data); // The "0" is the proto state, which is unused at the top-level expression
     }
+  }
 
-    boost::shared_ptr< common::List<Uint> > used_nodes_ptr = mesh::build_used_nodes_list(used_entities, dict, true);
+  /// Process a contiguous chunk of the nodes in each thread. Must be called from inside a parallel region.
+  template<typename FilteredExprT>
+  void do_run_threaded(const FilteredExprT& expr, DataT& data, const common::List<Uint>& nodes) const
+  {
+    NodeGrammar grammar;
 
-    const common::List<Uint>& nodes = *used_nodes_ptr;
-    const Uint nb_nodes = nodes.size();
-    for(Uint i = 0; i != nb_nodes; ++i)
+    const int nb_nodes = nodes.size();
+    #pragma omp for schedule(static)
+    for(int i = 0; i < nb_nodes; ++i)
     {
       data.set_node(nodes[i]);
-      grammar(expr, 0, data); // The "0" is the proto state, which is unused at the top-level expression
+      grammar(expr, 0, data);
     }
   }
 
@@ -224,7 +291,8 @@ struct NodeLooper
 
     // Execute with known dimension
     NodeLooperDim<ExprT, NbDimsT>(m_expr, m_region, m_variables)();
-    
+
+    DirichletBCApplier::instance().apply();
     FieldSynchronizer::instance().synchronize();
   }
 
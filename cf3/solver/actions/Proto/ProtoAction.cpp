@@ -4,6 +4,8 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <typeinfo>
+
 #include <boost/bind.hpp>
 #include <boost/function.hpp>
 #include <boost/ptr_container/ptr_vector.hpp>
@@ -17,6 +19,7 @@
 
 #include "physics/PhysModel.hpp"
 
+#include "solver/ActionDirector.hpp"
 #include "solver/Tags.hpp"
 
 #include "ProtoAction.hpp"
@@ -115,14 +118,18 @@ ProtoAction::~ProtoAction()
 
 void ProtoAction::execute()
 {
-  if(m_loop_regions.empty())
+  // The log is not thread safe
+  const bool log = !solver::ActionDirector::in_concurrent_execution();
+
+  if(m_loop_regions.empty() && log)
     CFwarn << "No regions to loop over for action " << uri().string() << CFendl;
 
   boost_foreach(const Handle< Region >& region, m_loop_regions)
   {
     if(is_null(m_implementation->m_expression))
       throw SetupError(FromHere(), "Expression for ProtoAction " + uri().path() + " is not set.");
-    CFdebug << "  Action " << name() << ": running over region " << region->uri().path() << CFendl;
+    if(log)
+      CFdebug << "  Action " << name() << ": running over region " << region->uri().path() << CFendl;
     m_implementation->m_expression->loop(*region);
   }
 }
@@ -151,6 +158,28 @@ void ProtoAction::insert_field_info(std::map<std::string, std::string>& tags) co
   m_implementation->m_expression->insert_field_info(tags);
 }
 
+bool ProtoAction::is_element_loop() const
+{
+  return typeid(*this) == typeid(ProtoAction) && has_element_expression();
+}
+
+bool ProtoAction::has_element_expression() const
+{
+  return is_not_null(m_implementation->m_expression) && m_implementation->m_expression->is_element_expression();
+}
+
+bool ProtoAction::supports_element_sweep(Elements& elements)
+{
+  return is_not_null(m_implementation->m_expression) && m_implementation->m_expression->supports_element_sweep(elements);
+}
+
+boost::shared_ptr<ElementSweep> ProtoAction::element_sweep(Elements& elements, boost::shared_ptr<ElementGeometry>& geometry)
+{
+  if(is_null(m_implementation->m_expression))
+    throw SetupError(FromHere(), "Expression for ProtoAction " + uri().path() + " is not set.");
+  return m_implementation->m_expression->element_sweep(elements, geometry);
+}
+
 
 boost::shared_ptr< ProtoAction > create_proto_action(const std::string& name, const boost::shared_ptr< Expression >& expression)
 {
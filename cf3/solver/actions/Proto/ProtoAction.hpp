@@ -14,7 +14,7 @@
 
 namespace cf3 {
   namespace common { template<typename T> class OptionComponent; }
-  namespace mesh { class Region; }
+  namespace mesh { class Region; class Elements; }
   namespace physics { class PhysModel; }
 namespace solver {
 namespace actions {
@@ -47,6 +47,18 @@ public:
   /// Append the tags used in the expression
   void insert_field_info(std::map<std::string, std::string>& tags) const;
 
+  /// True if the expression loops over elements. Only plain ProtoActions are element loops, since subclasses may do
+  /// more in execute(). Subclasses that only run the expression can opt in by returning has_element_expression().
+  virtual bool is_element_loop() const;
+
+  virtual bool supports_element_sweep(mesh::Elements& elements);
+
+  virtual boost::shared_ptr<ElementSweep> element_sweep(mesh::Elements& elements, boost::shared_ptr<ElementGeometry>& geometry);
+
+protected:
+  /// True if the expression is set and loops over elements
+  bool has_element_expression() const;
+
 private:
   class Implementation;
   boost::scoped_ptr<Implementation> m_implementation;
@@ -4,6 +4,9 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <algorithm>
+#include <map>
+
 #include <boost/bind.hpp>
 #include <boost/function.hpp>
 
@@ -11,6 +14,8 @@
 #include "common/OptionList.hpp"
 #include "common/List.hpp"
 #include "common/BinaryDataReader.hpp"
+#include "common/Table.hpp"
+#include "common/PE/Comm.hpp"
 
 #include "common/XML/FileOperations.hpp"
 
@@ -25,6 +30,7 @@
 #include "solver/Time.hpp"
 
 #include "solver/actions/ReadRestartFile.hpp"
+#include "solver/actions/WriteRestartFile.hpp"
 
 /////////////////////////////////////////////////////////////////////////////////////
 
@@ -60,6 +66,11 @@ ReadRestartFile::ReadRestartFile ( const std::string& name ) :
     .pretty_name("Read  Time Step")
     .description("Use the time step from the restart file")
     .mark_basic();
+
+  options().add("redistribute", false)
+    .pretty_name("Redistribute")
+    .description("Match the rows by their key, even if the number of CPUs did not change. Needed when the mesh was partitioned differently. "
+                 "Files that were written on a different number of CPUs are always redistributed.");
 }
 
 /////////////////////////////////////////////////////////////////////////////////////
@@ -88,16 +99,19 @@ void ReadRestartFile::execute()
     time->options().set("iteration", common::from_str<Uint>(restart_node.attribute_value("iteration")));
   }
 
-  if(common::from_str<Uint>(restart_node.attribute_value("version")) != 1)
+  const Uint version = common::from_str<Uint>(restart_node.attribute_value("version"));
+  if(version != 1 && version != 2)
     throw common::FileFormatError(FromHere(), "File  " + filepath.path() + " has unsupported version");
 
   common::PE::Comm& comm = common::PE::Comm::instance();
-  if(common::from_str<Uint>(restart_node.attribute_value("nb_procs")) != comm.size())
-    throw common::SetupError(FromHere(), "File  " + filepath.path() + " was made for " + restart_node.attribute_value("nb_procs") + " CPUs, but we are loading on " + common::to_str(comm.size()) + " CPUs");
-
-  boost::shared_ptr<common::BinaryDataReader> data_reader = common::allocate_component<common::BinaryDataReader>("DataReader");
-  data_reader->options().set("file", common::URI(restart_node.attribute_value("binary_file")));
+  const Uint nb_writers = common::from_str<Uint>(restart_node.attribute_value("nb_procs"));
+  const bool redistribute = options().value<bool>("redistribute") || nb_writers != comm.size();
+  if(redistribute && version < 2)
+    throw common::SetupError(FromHere(), "File  " + filepath.path() + " was made for " + restart_node.attribute_value("nb_procs") + " CPUs and has no row keys, so it can't be loaded on " + common::to_str(comm.size()) + " CPUs");
 
+  std::vector< Handle<mesh::Field> > fields;
+  std::vector<Uint> field_indices;
+  std::vector<Uint> keys_indices;
   common::XML::XmlNode field_node = restart_node.content->first_node("field");
   for(; field_node.is_valid(); field_node.content = field_node.content->next_sibling("field"))
   {
@@ -105,8 +119,258 @@ void ReadRestartFile::execute()
     if(is_null(field))
       throw common::SetupError(FromHere(), "Field " + field_node.attribute_value("path") + " was not found in mesh " + mesh->uri().path());
 
-    data_reader->read_table(*field, common::from_str<Uint>(field_node.attribute_value("index")));
+    fields.push_back(field);
+    field_indices.push_back(common::from_str<Uint>(field_node.attribute_value("index")));
+    keys_indices.push_back(version < 2 ? 0 : common::from_str<Uint>(field_node.attribute_value("keys_index")));
+  }
+
+  const common::URI binary_file(restart_node.attribute_value("binary_file"));
+  if(redistribute)
+  {
+    read_redistributed(binary_file, nb_writers, fields, field_indices, keys_indices);
+    return;
+  }
+
+  boost::shared_ptr<common::BinaryDataReader> data_reader = common::allocate_component<common::BinaryDataReader>("DataReader");
+  data_reader->options().set("file", binary_file);
+  for(Uint i = 0; i != fields.size(); ++i)
+    data_reader->read_table(*fields[i], field_indices[i]);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+void ReadRestartFile::read_redistributed(const common::URI& binary_file,
+                                         const Uint nb_writers,
+                                         const std::vector< Handle<mesh::Field> >& fields,
+                                         const std::vector<Uint>& field_indices,
+                                         const std::vector<Uint>& keys_indices)
+{
+  typedef std::pair<Uint, Uint> KeyT;
+  typedef std::pair<KeyT, Uint> KeyEntryT;
+  typedef std::map< int, std::vector<Uint> > UintMessagesT;
+  typedef std::map< int, std::vector<Real> > RealMessagesT;
+
+  common::PE::Comm& comm = common::PE::Comm::instance();
+  const Uint nb_procs = comm.size();
+  const Uint rank = comm.rank();
+
+  // Each rank reads the data of a contiguous range of the ranks that wrote the file
+  const Uint first_writer = (rank * nb_writers) / nb_procs;
+  const Uint end_writer = ((rank+1) * nb_writers) / nb_procs;
+
+  // The XML describing the binary file is parsed once, selecting a writer afterwards only opens its data
+  boost::shared_ptr<common::BinaryDataReader> data_reader = common::allocate_component<common::BinaryDataReader>("DataReader");
+  if(first_writer != end_writer)
+  {
+    data_reader->options().set("rank", first_writer);
+    data_reader->options().set("file", binary_file);
   }
+  boost::shared_ptr< common::Table<Uint> > file_keys = common::allocate_component< common::Table<Uint> >("FileKeys");
+  boost::shared_ptr< common::Table<Real> > file_data = common::allocate_component< common::Table<Real> >("FileData");
+  boost::shared_ptr< common::Table<Uint> > local_keys = common::allocate_component< common::Table<Uint> >("LocalKeys");
+
+  // Fields sharing a dictionary are redistributed together. The map is ordered on the key block index, which is the same on all ranks.
+  std::map< Uint, std::vector<Uint> > dict_fields;
+  for(Uint i = 0; i != fields.size(); ++i)
+    dict_fields[keys_indices[i]].push_back(i);
+
+  for(std::map< Uint, std::vector<Uint> >::const_iterator dict_it = dict_fields.begin(); dict_it != dict_fields.end(); ++dict_it)
+  {
+    const std::vector<Uint>& dict_field_indices = dict_it->second;
+    const mesh::Dictionary& dict = fields[dict_field_indices.front()]->dict();
+    const Uint nb_fields = dict_field_indices.size();
+    Uint total_row_size = 0;
+    BOOST_FOREACH(const Uint field_idx, dict_field_indices)
+    {
+      if(&fields[field_idx]->dict() != &dict)
+        throw common::SetupError(FromHere(), "Field " + fields[field_idx]->uri().path() + " shares its row keys with a field from another dictionary");
+      total_row_size += fields[field_idx]->row_size();
+    }
+    if(total_row_size == 0)
+      continue;
+
+    // Owned rows of the file slice of this rank: their keys, and the values of all fields interleaved per row
+    std::vector<Uint> read_keys;
+    std::vector<Real> read_values;
+    for(Uint writer = first_writer; writer != end_writer; ++writer)
+    {
+      data_reader->options().set("rank", writer);
+      data_reader->read_table(*file_keys, dict_it->first);
+      const Uint nb_rows = file_keys->size();
+
+      std::vector<Uint> owned_rows;
+      for(Uint row = 0; row != nb_rows; ++row)
+      {
+        const common::Table<Uint>::ConstRow key = (*file_keys)[row];
+        if(key[2] == 0)
+          continue;
+        owned_rows.push_back(row);
+        read_keys.push_back(key[0]);
+        read_keys.push_back(key[1]);
+      }
+
+      const Uint first_read_row = read_values.size() / total_row_size;
+      read_values.resize((read_keys.size()/2) * total_row_size);
+      Uint field_offset = 0;
+      for(Uint f = 0; f != nb_fields; ++f)
+      {
+        const Uint field_idx = dict_field_indices[f];
+        data_reader->read_table(*file_data, field_indices[field_idx]);
+        const Uint row_size = fields[field_idx]->row_size();
+        if(file_data->size() != nb_rows || file_data->row_size() != row_size)
+          throw common::FileFormatError(FromHere(), "Data for field " + fields[field_idx]->uri().path() + " from rank " + common::to_str(writer) + " has the wrong size");
+
+        const Uint nb_owned = owned_rows.size();
+        for(Uint i = 0; i != nb_owned; ++i)
+        {
+          const common::Table<Real>::ConstRow values = (*file_data)[owned_rows[i]];
+          std::copy(values.begin(), values.end(), read_values.begin() + (first_read_row + i)*total_row_size + field_offset);
+        }
+        field_offset += row_size;
+      }
+    }
+    const Uint nb_read_rows = read_keys.size() / 2;
+
+    // Rows of the local dictionary, sorted by key
+    WriteRestartFile::row_keys(dict, *local_keys);
+    const Uint nb_local_rows = local_keys->size();
+    std::vector<KeyEntryT> local_rows(nb_local_rows);
+    for(Uint row = 0; row != nb_local_rows; ++row)
+      local_rows[row] = KeyEntryT(KeyT((*local_keys)[row][0], (*local_keys)[row][1]), row);
+    std::sort(local_rows.begin(), local_rows.end());
+
+    // The range of the first key is split evenly over the ranks, each keeping the directory of the ranks that need the keys in its range
+    Uint my_nb_keys = 0;
+    for(Uint i = 0; i != nb_read_rows; ++i)
+      my_nb_keys = std::max(my_nb_keys, read_keys[2*i] + 1);
+    if(nb_local_rows != 0)
+      my_nb_keys = std::max(my_nb_keys, local_rows.back().first.first + 1);
+    Uint nb_keys = 0;
+    comm.all_reduce(common::PE::max(), &my_nb_keys, 1, &nb_keys);
+    const Uint keys_per_rank = std::max(1u, (nb_keys + nb_procs - 1) / nb_procs);
+
+    // Register the keys of the local rows with their directory rank
+    UintMessagesT registrations;
+    BOOST_FOREACH(const KeyEntryT& entry, local_rows)
+    {
+      std::vector<Uint>& registration = registrations[directory_rank(entry.first.first, keys_per_rank)];
+      registration.push_back(entry.first.first);
+      registration.push_back(entry.first.second);
+    }
+
+    UintMessagesT received_registrations;
+    comm.sparse_all_to_all(registrations, received_registrations);
+
+    std::vector<KeyEntryT> directory;
+    for(UintMessagesT::const_iterator it = received_registrations.begin(); it != received_registrations.end(); ++it)
+    {
+      const Uint nb_received = it->second.size() / 2;
+      for(Uint i = 0; i != nb_received; ++i)
+        directory.push_back(KeyEntryT(KeyT(it->second[2*i], it->second[2*i+1]), it->first));
+    }
+    std::sort(directory.begin(), directory.end());
+
+    // Ask the directory which ranks need the rows that were read
+    UintMessagesT lookups;
+    std::map< int, std::vector<Uint> > lookup_rows;
+    for(Uint i = 0; i != nb_read_rows; ++i)
+    {
+      const int directory_idx = directory_rank(read_keys[2*i], keys_per_rank);
+      lookups[directory_idx].push_back(read_keys[2*i]);
+      lookups[directory_idx].push_back(read_keys[2*i+1]);
+      lookup_rows[directory_idx].push_back(i);
+    }
+
+    UintMessagesT received_lookups;
+    comm.sparse_all_to_all(lookups, received_lookups);
+
+    // For each key, answer the number of ranks that need it, followed by these ranks
+    UintMessagesT answers;
+    for(UintMessagesT::const_iterator it = received_lookups.begin(); it != received_lookups.end(); ++it)
+    {
+      std::vector<Uint>& answer = answers[it->first];
+      const Uint nb_lookups = it->second.size() / 2;
+      for(Uint i = 0; i != nb_lookups; ++i)
+      {
+        const KeyT key(it->second[2*i], it->second[2*i+1]);
+        std::vector<KeyEntryT>::const_iterator entry = std::lower_bound(directory.begin(), directory.end(), KeyEntryT(key, 0));
+        const Uint count_idx = answer.size();
+        answer.push_back(0);
+        for(; entry != directory.end() && entry->first == key; ++entry)
+        {
+          answer.push_back(entry->second);
+          ++answer[count_idx];
+        }
+      }
+    }
+
+    UintMessagesT received_answers;
+    comm.sparse_all_to_all(answers, received_answers);
+
+    // Send the rows straight to the ranks that need them
+    UintMessagesT send_keys;
+    RealMessagesT send_values;
+    for(std::map< int, std::vector<Uint> >::const_iterator it = lookup_rows.begin(); it != lookup_rows.end(); ++it)
+    {
+      const std::vector<Uint>& answer = received_answers[it->first];
+      std::vector<Uint>::const_iterator answer_it = answer.begin();
+      BOOST_FOREACH(const Uint read_row, it->second)
+      {
+        cf3_assert(answer_it != answer.end());
+        const Uint nb_destinations = *answer_it++;
+        for(Uint d = 0; d != nb_destinations; ++d)
+        {
+          const int destination = *answer_it++;
+          send_keys[destination].push_back(read_keys[2*read_row]);
+          send_keys[destination].push_back(read_keys[2*read_row+1]);
+          send_values[destination].insert(send_values[destination].end(), read_values.begin() + read_row*total_row_size, read_values.begin() + (read_row+1)*total_row_size);
+        }
+      }
+    }
+
+    UintMessagesT received_keys;
+    RealMessagesT received_values;
+    comm.sparse_all_to_all(send_keys, received_keys);
+    comm.sparse_all_to_all(send_values, received_values);
+
+    std::vector<bool> received_rows(nb_local_rows, false);
+    for(UintMessagesT::const_iterator it = received_keys.begin(); it != received_keys.end(); ++it)
+    {
+      const std::vector<Real>& values = received_values[it->first];
+      const Uint nb_received = it->second.size() / 2;
+      cf3_assert(values.size() == nb_received * total_row_size);
+      for(Uint i = 0; i != nb_received; ++i)
+      {
+        const KeyT key(it->second[2*i], it->second[2*i+1]);
+        std::vector<KeyEntryT>::const_iterator entry = std::lower_bound(local_rows.begin(), local_rows.end(), KeyEntryT(key, 0));
+        for(; entry != local_rows.end() && entry->first == key; ++entry)
+        {
+          const Real* row_values = &values[i*total_row_size];
+          BOOST_FOREACH(const Uint field_idx, dict_field_indices)
+          {
+            mesh::Field& field = *fields[field_idx];
+            const Uint row_size = field.row_size();
+            std::copy(row_values, row_values + row_size, field[entry->second].begin());
+            row_values += row_size;
+          }
+          received_rows[entry->second] = true;
+        }
+      }
+    }
+
+    for(Uint row = 0; row != nb_local_rows; ++row)
+    {
+      if(!received_rows[row])
+        throw common::FileFormatError(FromHere(), "No restart data for row with key (" + common::to_str((*local_keys)[row][0]) + ", " + common::to_str((*local_keys)[row][1]) + ") in " + binary_file.path());
+    }
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+Uint ReadRestartFile::directory_rank(const Uint key0, const Uint keys_per_rank)
+{
+  return key0 / keys_per_rank;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -13,6 +13,7 @@
 /////////////////////////////////////////////////////////////////////////////////////
 
 namespace cf3 {
+namespace mesh { class Field; }
 namespace solver {
 namespace actions {
 
@@ -34,6 +35,20 @@ public: // functions
 
   /// execute the action
   virtual void execute ();
+
+private:
+  /// Read the file in slices of the ranks that wrote it, and send the rows to the ranks that need them, using the keys
+  /// stored for each row. The ranks holding a row in the current partitioning register its key with a directory rank,
+  /// chosen by splitting the range of the keys evenly. The readers ask the directory where each row goes, and send it there
+  /// directly. All exchanges are sparse, so their cost depends on the number of ranks that actually communicate.
+  void read_redistributed(const common::URI& binary_file,
+                          const Uint nb_writers,
+                          const std::vector< Handle<mesh::Field> >& fields,
+                          const std::vector<Uint>& field_indices,
+                          const std::vector<Uint>& keys_indices);
+
+  /// Rank that keeps the directory entries for the given first row key
+  static Uint directory_rank(const Uint key0, const Uint keys_per_rank);
 };
 
 /////////////////////////////////////////////////////////////////////////////////////
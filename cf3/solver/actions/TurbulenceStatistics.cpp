@@ -4,6 +4,7 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <boost/algorithm/string/join.hpp>
 #include <boost/bind.hpp>
 #include <boost/function.hpp>
 #include <boost/make_shared.hpp>
@@ -37,13 +38,54 @@ common::ComponentBuilder < TurbulenceStatistics, common::Action, LibActions > Tu
 ///////////////////////////////////////////////////////////////////////////////////////
 
 namespace detail
-{  
-  inline void update_mean(Real& mean, const Real new_value, const Uint count)
+{
+  /// Incremental mean update, with inv_count = 1/(n+1) for the (n+1)th value
+  inline void update_mean(Real& mean, const Real new_value, const Real inv_count)
+  {
+    mean += (new_value - mean) * inv_count;
+  }
+
+  /// Number of velocity products of order 2 (uu, vv, uv, ...) for the given dimension
+  inline Uint nb_second_order(const Uint dim)
+  {
+    return dim*(dim+1)/2;
+  }
+
+  /// Number of velocity products of order 3 (uuu, uuv, ...) for the given dimension
+  inline Uint nb_third_order(const Uint dim)
+  {
+    return dim*(dim+1)*(dim+2)/6;
+  }
+
+  /// Variable description of the triple correlations field: the velocity products i <= j <= k, followed by p times each component
+  std::string triple_correlations_description(const Uint dim)
   {
-    if(count != 0)
-      mean = (mean * static_cast<Real>(count) + new_value) / static_cast<Real>(count+1);
-    else
-      mean = new_value;
+    const char names[] = "uvw";
+    std::vector<std::string> variables;
+    for(Uint i = 0; i != dim; ++i)
+      for(Uint j = i; j != dim; ++j)
+        for(Uint k = j; k != dim; ++k)
+          variables.push_back(std::string(1, names[i]) + names[j] + names[k]);
+    for(Uint i = 0; i != dim; ++i)
+      variables.push_back(std::string("p") + names[i]);
+    return boost::algorithm::join(variables, ",");
+  }
+
+  /// Maximum number of nodes in a range, so a region with contiguous nodes still gives enough ranges to share among the threads
+  const Uint max_range_size = 1024;
+
+  /// Split the sorted node list into contiguous ranges of at most max_range_size nodes
+  void build_node_ranges(const common::List<Uint>::ListT& nodes, std::vector< std::pair<Uint, Uint> >& ranges)
+  {
+    ranges.clear();
+    const Uint nb_nodes = nodes.size();
+    for(Uint i = 0; i != nb_nodes; ++i)
+    {
+      if(ranges.empty() || ranges.back().second != nodes[i] || ranges.back().second - ranges.back().first == max_range_size)
+        ranges.push_back(std::make_pair(nodes[i], nodes[i]+1));
+      else
+        ++ranges.back().second;
+    }
   }
 }
 
@@ -54,7 +96,11 @@ TurbulenceStatistics::TurbulenceStatistics ( const std::string& name ) :
   m_dim(0),
   m_velocity_field_offset(0),
   m_pressure_field_offset(0),
-  m_count(0)
+  m_nb_executions(0),
+  m_count(0),
+  m_triple_count(0),
+  m_probe_stride(0),
+  m_probe_count(0)
 {
   options().add("velocity_variable_name", "Velocity")
     .pretty_name("Velocity Variable Name")
@@ -80,6 +126,16 @@ TurbulenceStatistics::TurbulenceStatistics ( const std::string& name ) :
     .attach_trigger(boost::bind(&TurbulenceStatistics::reset_statistics, this))
     .mark_basic();
     
+  options().add("sample_interval", 1u)
+    .pretty_name("Sample Interval")
+    .description("Statistics are only updated every sample_interval executions")
+    .mark_basic();
+
+  options().add("triple_correlations", false)
+    .pretty_name("Triple Correlations")
+    .description("Also compute the means of the third order velocity products and of the velocity-pressure products")
+    .attach_trigger(boost::bind(&TurbulenceStatistics::trigger_option, this));
+
   options().add("file", common::URI())
     .pretty_name("File")
     .description("Base file name for the probe output files")
@@ -90,6 +146,11 @@ TurbulenceStatistics::TurbulenceStatistics ( const std::string& name ) :
     .description("Number of averages made")
     .link_to(&m_count);
 
+  options().add("triple_correlations_count", m_triple_count)
+    .pretty_name("Triple Correlations Count")
+    .description("Number of averages made for the triple correlations, which may have been enabled later than the other statistics")
+    .link_to(&m_triple_count);
+
   regist_signal( "add_probe" )
     .connect( boost::bind( &TurbulenceStatistics::signal_add_probe, this, _1 ) )
     .description("Add a probe at the given location, logging to its own file")
@@ -107,133 +168,166 @@ TurbulenceStatistics::TurbulenceStatistics ( const std::string& name ) :
 void TurbulenceStatistics::execute()
 {
   setup();
-  common::PE::Comm& comm = common::PE::Comm::instance();
 
-  const Uint nb_nodes = m_used_nodes->size();
-  const common::List<Uint>::ListT& used_nodes_list = m_used_nodes->array();
-  const mesh::Field::ArrayT& velocity_array = m_velocity_field->array();
-  const mesh::Field::ArrayT& pressure_array = m_pressure_field->array();
-  mesh::Field::ArrayT& means_array = m_statistics_field->array();
-  const Uint stride = 2.*m_dim + m_dim-1 + m_dim-2;
-  const Uint nb_my_probes = m_probe_nodes.size();
+  const Uint sample_interval = options().value<Uint>("sample_interval");
+  if(m_nb_executions++ % (sample_interval == 0 ? 1 : sample_interval) != 0)
+    return;
 
+  const Real inv_count = 1. / static_cast<Real>(m_count+1);
+  const Real inv_triple_count = 1. / static_cast<Real>(m_triple_count+1);
   if(m_dim == 2)
   {
-    for(Uint i = 0; i != nb_nodes; ++i)
-    {
-      const mesh::Field::ConstRow velocity = velocity_array[used_nodes_list[i]];
-      mesh::Field::Row means = means_array[used_nodes_list[i]];
-      const Real u = velocity[XX+m_velocity_field_offset]; const Real v = velocity[YY+m_velocity_field_offset];
-      const Real p = pressure_array[used_nodes_list[i]][m_pressure_field_offset];
-    
-      detail::update_mean(means[0], u, m_count);
-      detail::update_mean(means[1], v, m_count);
-      detail::update_mean(means[2], u*u, m_count);
-      detail::update_mean(means[3], v*v, m_count);
-      detail::update_mean(means[4], u*v, m_count);
-      detail::update_mean(means[5], p, m_count);
-      detail::update_mean(means[6], p*p, m_count);
-    }
+    update_statistics<2>(inv_count, inv_triple_count);
+    update_probes<2>();
+  }
+  else if(m_dim == 3)
+  {
+    update_statistics<3>(inv_count, inv_triple_count);
+    update_probes<3>();
+  }
+
+  write_probes();
+
+  options().set("count", m_count+1u);
+  if(is_not_null(m_triple_correlations_field))
+    options().set("triple_correlations_count", m_triple_count+1u);
+}
 
-    for(Uint my_probe_idx = 0; my_probe_idx != nb_my_probes; ++my_probe_idx)
+template<Uint Dim>
+void TurbulenceStatistics::update_statistics(const Real inv_count, const Real inv_triple_count)
+{
+  const mesh::Field::ArrayT& velocity_array = m_velocity_field->array();
+  const mesh::Field::ArrayT& pressure_array = m_pressure_field->array();
+  mesh::Field::ArrayT& means_array = m_statistics_field->array();
+  const bool triple_correlations = is_not_null(m_triple_correlations_field);
+  const Uint velocity_offset = m_velocity_field_offset;
+  const Uint pressure_offset = m_pressure_field_offset;
+  const int nb_ranges = m_node_ranges.size();
+
+  // Ranges are independent, so they can be processed in parallel
+  #pragma omp parallel for schedule(dynamic, 1)
+  for(int range_idx = 0; range_idx < nb_ranges; ++range_idx)
+  {
+    const Uint range_end = m_node_ranges[range_idx].second;
+    for(Uint node = m_node_ranges[range_idx].first; node != range_end; ++node)
     {
-      const Uint probe_begin = my_probe_idx*stride;
-      const mesh::Field::ConstRow velocity = velocity_array[m_probe_nodes[my_probe_idx]];
-      const Real u = velocity[XX+m_velocity_field_offset]; const Real v = velocity[YY+m_velocity_field_offset];
-
-      m_means[probe_begin  ](u);
-      m_means[probe_begin+1](v);
-      m_means[probe_begin+2](u*u);
-      m_means[probe_begin+3](v*v);
-      m_means[probe_begin+4](u*v);
-
-      m_rolling_means[probe_begin  ](u);
-      m_rolling_means[probe_begin+1](v);
-      m_rolling_means[probe_begin+2](u*u);
-      m_rolling_means[probe_begin+3](v*v);
-      m_rolling_means[probe_begin+4](u*v);
+      const mesh::Field::ConstRow velocity_row = velocity_array[node];
+      Real u[Dim];
+      for(Uint i = 0; i != Dim; ++i)
+        u[i] = velocity_row[velocity_offset+i];
+      const Real p = pressure_array[node][pressure_offset];
+
+      // Layout: U, V, (W), uu, vv, (ww), uv, (uw, vw), p, pp
+      Real* means = &means_array[node][0];
+      for(Uint i = 0; i != Dim; ++i)
+      {
+        detail::update_mean(means[i], u[i], inv_count);
+        detail::update_mean(means[Dim+i], u[i]*u[i], inv_count);
+      }
+      Uint mean_idx = 2*Dim;
+      for(Uint i = 0; i != Dim; ++i)
+        for(Uint j = i+1; j != Dim; ++j)
+          detail::update_mean(means[mean_idx++], u[i]*u[j], inv_count);
+      detail::update_mean(means[mean_idx++], p, inv_count);
+      detail::update_mean(means[mean_idx], p*p, inv_count);
+
+      if(triple_correlations)
+      {
+        Real* triples = &m_triple_correlations_field->array()[node][0];
+        Uint triple_idx = 0;
+        for(Uint i = 0; i != Dim; ++i)
+          for(Uint j = i; j != Dim; ++j)
+            for(Uint k = j; k != Dim; ++k)
+              detail::update_mean(triples[triple_idx++], u[i]*u[j]*u[k], inv_triple_count);
+        for(Uint i = 0; i != Dim; ++i)
+          detail::update_mean(triples[triple_idx++], p*u[i], inv_triple_count);
+      }
     }
   }
-  else if(m_dim == 3)
+}
+
+template<Uint Dim>
+void TurbulenceStatistics::update_probes()
+{
+  const mesh::Field::ArrayT& velocity_array = m_velocity_field->array();
+  const Uint nb_my_probes = m_probe_nodes.size();
+  if(nb_my_probes == 0)
+    return;
+
+  const Uint window_size = std::max(options().value<Uint>("rolling_window"), 1u);
+  const Uint nb_values = nb_my_probes*m_probe_stride;
+  const Real inv_count = 1. / static_cast<Real>(m_probe_count+1);
+  const bool window_full = m_probe_count >= window_size;
+  Real* window_row = &m_probe_window[(m_probe_count % window_size)*nb_values];
+
+  for(Uint my_probe_idx = 0; my_probe_idx != nb_my_probes; ++my_probe_idx)
   {
-    for(Uint i = 0; i != nb_nodes; ++i)
+    const mesh::Field::ConstRow velocity_row = velocity_array[m_probe_nodes[my_probe_idx]];
+    Real u[Dim];
+    for(Uint i = 0; i != Dim; ++i)
+      u[i] = velocity_row[m_velocity_field_offset+i];
+
+    // Layout: U, V, (W), uu, vv, (ww), uv, (uw, vw)
+    Real values[Dim + Dim*(Dim+1)/2];
+    for(Uint i = 0; i != Dim; ++i)
     {
-      const mesh::Field::ConstRow velocity = velocity_array[used_nodes_list[i]];
-      mesh::Field::Row means = means_array[used_nodes_list[i]];
-      const Real u = velocity[XX+m_velocity_field_offset]; const Real v = velocity[YY+m_velocity_field_offset]; const Real w = velocity[ZZ+m_velocity_field_offset];
-      const Real p = pressure_array[used_nodes_list[i]][m_pressure_field_offset];
-      
-      detail::update_mean(means[0], u, m_count);
-      detail::update_mean(means[1], v, m_count);
-      detail::update_mean(means[2], w, m_count);
-      detail::update_mean(means[3], u*u, m_count);
-      detail::update_mean(means[4], v*v, m_count);
-      detail::update_mean(means[5], w*w, m_count);
-      detail::update_mean(means[6], u*v, m_count);
-      detail::update_mean(means[7], u*w, m_count);
-      detail::update_mean(means[8], v*w, m_count);
-      detail::update_mean(means[9], p, m_count);
-      detail::update_mean(means[10], p*p, m_count);
+      values[i] = u[i];
+      values[Dim+i] = u[i]*u[i];
     }
+    Uint value_idx = 2*Dim;
+    for(Uint i = 0; i != Dim; ++i)
+      for(Uint j = i+1; j != Dim; ++j)
+        values[value_idx++] = u[i]*u[j];
 
-    for(Uint my_probe_idx = 0; my_probe_idx != nb_my_probes; ++my_probe_idx)
+    const Uint probe_begin = my_probe_idx*m_probe_stride;
+    for(Uint j = 0; j != m_probe_stride; ++j)
     {
-      const Uint probe_begin = my_probe_idx*stride;
-      const mesh::Field::ConstRow velocity = velocity_array[m_probe_nodes[my_probe_idx]];
-      const Real u = velocity[XX+m_velocity_field_offset]; const Real v = velocity[YY+m_velocity_field_offset]; const Real w = velocity[ZZ+m_velocity_field_offset];
-
-      m_means[probe_begin  ](u);
-      m_means[probe_begin+1](v);
-      m_means[probe_begin+2](w);
-      m_means[probe_begin+3](u*u);
-      m_means[probe_begin+4](v*v);
-      m_means[probe_begin+5](w*w);
-      m_means[probe_begin+6](u*v);
-      m_means[probe_begin+7](u*w);
-      m_means[probe_begin+8](v*w);
-
-      m_rolling_means[probe_begin  ](u);
-      m_rolling_means[probe_begin+1](v);
-      m_rolling_means[probe_begin+2](w);
-      m_rolling_means[probe_begin+3](u*u);
-      m_rolling_means[probe_begin+4](v*v);
-      m_rolling_means[probe_begin+5](w*w);
-      m_rolling_means[probe_begin+6](u*v);
-      m_rolling_means[probe_begin+7](u*w);
-      m_rolling_means[probe_begin+8](v*w);
+      detail::update_mean(m_probe_means[probe_begin+j], values[j], inv_count);
+      Real& window_value = window_row[probe_begin+j];
+      m_probe_window_sums[probe_begin+j] += values[j] - (window_full ? window_value : 0.);
+      window_value = values[j];
     }
   }
 
-  // Write the probe data
+  ++m_probe_count;
+}
+
+void TurbulenceStatistics::write_probes()
+{
+  const Uint nb_my_probes = m_probe_nodes.size();
+  const Uint window_size = std::max(options().value<Uint>("rolling_window"), 1u);
+  const Real inv_window_count = 1. / static_cast<Real>(std::min(m_probe_count, window_size));
   for(Uint my_probe_idx = 0; my_probe_idx != nb_my_probes; ++my_probe_idx)
   {
-    const Uint probe_begin = my_probe_idx*stride;
-    const Uint probe_end = probe_begin + stride;
+    const Uint probe_begin = my_probe_idx*m_probe_stride;
+    const Uint probe_end = probe_begin + m_probe_stride;
     boost::filesystem::fstream& file = *m_probe_files[my_probe_idx];
     for(Uint j = probe_begin; j != probe_end; ++j)
     {
       if(j != 0)
         file << " ";
-      file << boost::accumulators::mean(m_means[j]);
+      file << m_probe_means[j];
     }
-    
-    for(Uint j = 0; j != stride; ++j)
+
+    for(Uint j = probe_begin; j != probe_end; ++j)
     {
-      file << " " << boost::accumulators::rolling_mean(m_rolling_means[j]);
+      file << " " << m_probe_window_sums[j] * inv_window_count;
     }
-    
+
     file << "\n";
   }
-
-  options().set("count", m_count+1u);
 }
 
 void TurbulenceStatistics::reset_statistics()
 {
-  const Uint nb_accs = (2.*m_dim + m_dim-1 + m_dim-2)*m_probe_nodes.size();
-  m_means.assign(nb_accs, MeanAccT());
-  m_rolling_means.assign(nb_accs, RollingAccT(boost::accumulators::tag::rolling_window::window_size = options().value<Uint>("rolling_window")));
+  m_probe_stride = m_dim + detail::nb_second_order(m_dim);
+  const Uint nb_values = m_probe_stride*m_probe_nodes.size();
+  m_probe_count = 0;
+  m_probe_means.assign(nb_values, 0.);
+  m_probe_window.assign(nb_values*std::max(options().value<Uint>("rolling_window"), 1u), 0.);
+  m_probe_window_sums.assign(nb_values, 0.);
   options().set("count", 0u);
+  options().set("triple_correlations_count", 0u);
 }
 
 void TurbulenceStatistics::add_probe(const RealVector& probe_location)
@@ -271,6 +365,7 @@ void TurbulenceStatistics::setup()
   m_options_changed = false;
 
   m_used_nodes.reset();
+  m_node_ranges.clear();
 
   Handle<mesh::Region> region = options().value< Handle<mesh::Region> >("region");
   if(is_null(region))
@@ -329,6 +424,7 @@ void TurbulenceStatistics::setup()
   common::PE::Comm& comm = common::PE::Comm::instance();
 
   m_used_nodes = mesh::build_used_nodes_list(*region, *dictionary, true, false);
+  detail::build_node_ranges(m_used_nodes->array(), m_node_ranges);
   const int nb_probes = m_probe_locations.size();
   std::vector<int> my_probes_found(nb_probes, 0);
   m_probe_nodes.clear();
@@ -411,10 +507,26 @@ void TurbulenceStatistics::setup()
     m_statistics_field->add_tag("turbulence_statistics");
   }
 
-  // Reset statistics without changing m_count
-  const Uint nb_accs = (2.*m_dim + m_dim-1 + m_dim-2)*m_probe_nodes.size();
-  m_means.assign(nb_accs, MeanAccT());
-  m_rolling_means.assign(nb_accs, RollingAccT(boost::accumulators::tag::rolling_window::window_size = options().value<Uint>("rolling_window")));
+  m_triple_correlations_field.reset();
+  if(options().value<bool>("triple_correlations"))
+  {
+    m_triple_correlations_field = Handle<mesh::Field>(dictionary->get_child("turbulence_triple_correlations"));
+    if(is_null(m_triple_correlations_field))
+    {
+      m_triple_correlations_field = dictionary->create_field("turbulence_triple_correlations", detail::triple_correlations_description(m_dim)).handle<mesh::Field>();
+      m_triple_correlations_field->add_tag("turbulence_statistics");
+      // A new field starts its own average, also when the other statistics are already running
+      options().set("triple_correlations_count", 0u);
+    }
+  }
+
+  // Reset the probe statistics without changing m_count
+  m_probe_stride = m_dim + detail::nb_second_order(m_dim);
+  const Uint nb_values = m_probe_stride*m_probe_nodes.size();
+  m_probe_count = 0;
+  m_probe_means.assign(nb_values, 0.);
+  m_probe_window.assign(nb_values*std::max(options().value<Uint>("rolling_window"), 1u), 0.);
+  m_probe_window_sums.assign(nb_values, 0.);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -7,11 +7,7 @@
 #ifndef cf3_solver_actions_TurbulenceStatistics_hpp
 #define cf3_solver_actions_TurbulenceStatistics_hpp
 
-#include <boost/accumulators/accumulators.hpp>
-#include <boost/accumulators/statistics/stats.hpp>
-#include <boost/accumulators/statistics/count.hpp>
-#include <boost/accumulators/statistics/mean.hpp>
-#include <boost/accumulators/statistics/rolling_mean.hpp>
+#include "common/BoostFilesystem.hpp"
 
 #include "common/Action.hpp"
 #include "common/List.hpp"
@@ -28,6 +24,14 @@ namespace actions {
 
 ///////////////////////////////////////////////////////////////////////////////////////
 
+/// Running averages of the velocity and pressure moments, stored in the field "turbulence_statistics":
+/// the mean velocity, the mean of the velocity component products (uu, vv, uv, ...), the mean pressure and
+/// the mean of p^2. With the option "triple_correlations", the field "turbulence_triple_correlations" also holds
+/// the means of all third order velocity products and of p times each velocity component.
+/// Both fields are tagged "turbulence_statistics", which is listed in the restart_field_tags property.
+/// These are means of the raw products, so the fluctuations follow as e.g. <u'v'> = <uv> - <u><v>.
+/// Each mean is updated as mean += (x - mean)/(n+1), over contiguous ranges of nodes. The triple correlations
+/// have their own count, since they may be enabled later in the run.
 class solver_actions_API TurbulenceStatistics : public common::Action
 {
 public: // functions
@@ -56,6 +60,17 @@ private:
   /// Triggered when an option is changed
   void trigger_option();
 
+  /// Update the means on the used nodes, for the given dimension
+  template<Uint Dim>
+  void update_statistics(const Real inv_count, const Real inv_triple_count);
+
+  /// Update the probe accumulators, for the given dimension
+  template<Uint Dim>
+  void update_probes();
+
+  /// Write the current probe means to the probe files
+  void write_probes();
+
   void signal_add_probe(common::SignalArgs& args);
   void signature_add_probe(common::SignalArgs& args);
   void signal_setup(common::SignalArgs& args);
@@ -66,20 +81,33 @@ private:
   bool m_options_changed;
   /// Nodes used by the region
   boost::shared_ptr< common::List<Uint> > m_used_nodes;
+  /// The used nodes, as contiguous ranges [first, second) of node indices, split so the threads can share the work
+  std::vector< std::pair<Uint, Uint> > m_node_ranges;
   /// Field having the velocity
   Handle<mesh::Field> m_velocity_field;
   Handle<mesh::Field> m_pressure_field;
   Handle<mesh::Field> m_statistics_field;
+  Handle<mesh::Field> m_triple_correlations_field;
   Uint m_dim;
   Uint m_velocity_field_offset;
   Uint m_pressure_field_offset;
   
-  typedef boost::accumulators::accumulator_set< Real, boost::accumulators::stats<boost::accumulators::tag::mean> > MeanAccT;
-  typedef boost::accumulators::accumulator_set< Real, boost::accumulators::stats<boost::accumulators::tag::rolling_mean> > RollingAccT;
-
-  std::vector<MeanAccT> m_means;
-  std::vector<RollingAccT> m_rolling_means;
+  /// Number of calls to execute, for the sampling interval
+  Uint m_nb_executions;
   Uint m_count;
+  /// Number of samples in the triple correlations
+  Uint m_triple_count;
+
+  /// Number of values accumulated per probe
+  Uint m_probe_stride;
+  /// Number of samples in the probe means
+  Uint m_probe_count;
+  /// Means since the last reset, m_probe_stride values per probe
+  std::vector<Real> m_probe_means;
+  /// Last rolling_window values for each probe value, stored as a ring buffer of rows of size nb_probes*m_probe_stride
+  std::vector<Real> m_probe_window;
+  /// Sum of the values in the window, for each probe value
+  std::vector<Real> m_probe_window_sums;
   std::vector<RealVector> m_probe_locations;
   std::vector<Uint> m_probe_nodes;
   std::vector<Uint> m_probe_indices;
@@ -6,6 +6,7 @@
 
 #include <set>
 
+#include <boost/algorithm/string/replace.hpp>
 #include <boost/bind.hpp>
 #include <boost/function.hpp>
 #include <boost/make_shared.hpp>
@@ -15,10 +16,11 @@
 #include "common/List.hpp"
 #include "common/PropertyList.hpp"
 #include "common/PE/Comm.hpp"
-#include <common/PE/CommPattern.hpp>
 #include "common/Signal.hpp"
 #include "common/XML/SignalOptions.hpp"
+#include "common/BoostFilesystem.hpp"
 
+#include "math/Consts.hpp"
 #include "math/VariablesDescriptor.hpp"
 
 #include "mesh/Dictionary.hpp"
@@ -58,10 +60,87 @@ struct threshold_compare
   const Real m_threshold;
 };
 
+/// First line owned by the given rank, when nb_lines are distributed in blocks over nb_procs
+inline Uint first_line(const Uint rank, const Uint nb_lines, const Uint nb_procs)
+{
+  return (rank*nb_lines + nb_procs - 1) / nb_procs;
+}
+
+/// Rank that owns the given line
+inline Uint line_owner(const Uint line, const Uint nb_lines, const Uint nb_procs)
+{
+  return (line*nb_procs) / nb_lines;
+}
+
+/// Add the power spectra of all variables on nb_lines consecutive lines, handling two lines with each complex transform
+void add_line_spectra(const math::FFT& fft, const Real* lines, const Uint nb_lines, const Uint nb_vars, std::vector<Real>& spectra)
+{
+  const Uint n = fft.size();
+  const Uint line_size = n*nb_vars;
+  for(Uint var = 0; var != nb_vars; ++var)
+  {
+    Real* result = &spectra[var*n];
+    Uint line = 0;
+    for(; line+1 < nb_lines; line += 2)
+      fft.add_power_spectra(lines + line*line_size + var, lines + (line+1)*line_size + var, nb_vars, result);
+    if(line < nb_lines)
+      fft.add_power_spectrum(lines + line*line_size + var, nb_vars, result);
+  }
+}
+
+/// Mean correlation R(r) = <u(x)u(x+r)> for each variable, from the sum over nb_samples lines of the power spectra
+RealMatrix correlations(const math::FFT& fft, const std::vector<Real>& spectra, const Uint nb_vars, const Real nb_samples)
+{
+  const Uint n = fft.size();
+  RealMatrix result(n, nb_vars);
+  std::vector<math::FFT::ComplexT> transformed(n);
+  for(Uint var = 0; var != nb_vars; ++var)
+  {
+    for(Uint k = 0; k != n; ++k)
+      transformed[k] = spectra[var*n + k];
+    fft.inverse(&transformed[0]);
+    for(Uint r = 0; r != n; ++r)
+      result(r, var) = transformed[r].real() / (nb_samples*static_cast<Real>(n)*static_cast<Real>(n));
+  }
+  return result;
+}
+
+/// Write the correlations in one direction
+void write_correlations(std::ostream& file, const std::vector<Real>& positions, const RealMatrix& corr)
+{
+  const Uint nb_positions = positions.size();
+  for(Uint i = 0; i != nb_positions; ++i)
+  {
+    file << positions[i];
+    for(Uint j = 0; j != corr.cols(); ++j)
+      file << "," << common::to_str(corr(i,j));
+    file << "\n";
+  }
+}
+
+/// Write the mean power spectrum in one direction, for the modes up to n/2
+void write_spectrum(std::ostream& file, const std::vector<Real>& positions, const std::vector<Real>& spectra, const Uint nb_vars, const Real nb_samples)
+{
+  const Uint n = positions.size();
+  const Real length = n > 1 ? static_cast<Real>(n)*(positions[1] - positions[0]) : 1.;
+  const Real scale = 1. / (nb_samples*static_cast<Real>(n)*static_cast<Real>(n));
+  for(Uint k = 0; k <= n/2; ++k)
+  {
+    file << k << "," << common::to_str(2.*math::Consts::pi()*static_cast<Real>(k)/length);
+    for(Uint var = 0; var != nb_vars; ++var)
+      file << "," << common::to_str(spectra[var*n + k]*scale);
+    file << "\n";
+  }
+}
+
 }
 
 TwoPointCorrelation::TwoPointCorrelation ( const std::string& name ) :
   common::Action(name),
+  m_x_lines_begin(0),
+  m_x_lines_end(0),
+  m_y_lines_begin(0),
+  m_y_lines_end(0),
   m_count(0),
   m_interval(1)
 {
@@ -88,6 +167,11 @@ TwoPointCorrelation::TwoPointCorrelation ( const std::string& name ) :
     .description("File name to write the averaged data to")
     .mark_basic();
 
+  options().add("spectrum_file", common::URI())
+    .pretty_name("Spectrum File")
+    .description("File name to write the averaged power spectra to. Not written if empty.")
+    .mark_basic();
+
   options().add("coordinate", 0.)
     .pretty_name("Coordinate")
     .description("Coordinate in the normal direction")
@@ -105,93 +189,100 @@ void TwoPointCorrelation::execute()
 {
   setup();
   
-  const Uint nb_used_nodes = m_used_node_lids.size();
+  const Uint nb_vars = m_field->row_size();
+  const mesh::Field::ArrayT& field_values = m_field->array();
   
-  common::PE::Comm& comm = common::PE::Comm::instance();
-  if(comm.is_active() && comm.rank() == m_root)
+  // Distribute the sampled values to the line owners
+  std::map< int, std::vector<Real> > send_values, recv_values;
+  for(std::map< int, std::vector<Uint> >::const_iterator it = m_send_lids.begin(); it != m_send_lids.end(); ++it)
   {
-    const Uint nb_x_gids = m_x_positions.size();
-    const Uint nb_y_gids = m_y_positions.size();
-    for(Uint i = 0; i != nb_used_nodes; ++i)
+    std::vector<Real>& values = send_values[it->first];
+    values.reserve(it->second.size()*nb_vars);
+    BOOST_FOREACH(const Uint lid, it->second)
     {
-      const Uint gid = m_used_node_y_gids[i]*nb_x_gids+m_used_node_x_gids[i];
-      m_sampled_values[gid] = m_field->array()[m_used_node_lids[i]];
+      const mesh::Field::ConstRow row = field_values[lid];
+      values.insert(values.end(), row.begin(), row.end());
     }
   }
+  
+  common::PE::Comm& comm = common::PE::Comm::instance();
+  if(comm.is_active())
+    comm.sparse_all_to_all(send_values, recv_values);
   else
+    recv_values.swap(send_values);
+  
+  for(std::map< int, std::vector<Real> >::const_iterator it = recv_values.begin(); it != recv_values.end(); ++it)
   {
-    for(Uint i = 0; i != nb_used_nodes; ++i)
-    {
-      m_sampled_values[i] = m_field->array()[m_used_node_lids[i]];
-    }
+    const std::vector<Uint>& offsets = m_recv_offsets[it->first];
+    cf3_assert(it->second.size() == offsets.size()*nb_vars);
+    const Uint nb_received = offsets.size();
+    for(Uint i = 0; i != nb_received; ++i)
+      std::copy(it->second.begin() + i*nb_vars, it->second.begin() + (i+1)*nb_vars, m_line_values.begin() + offsets[i]);
   }
   
-  if(comm.is_active())
-    m_comm_pattern->synchronize("samples");
+  const Uint nb_local_x_lines = m_x_lines_end - m_x_lines_begin;
+  const Uint nb_local_y_lines = m_y_lines_end - m_y_lines_begin;
+  if(nb_local_x_lines != 0)
+    detail_twopoint::add_line_spectra(*m_x_fft, &m_line_values[0], nb_local_x_lines, nb_vars, m_x_spectra);
+  if(nb_local_y_lines != 0)
+    detail_twopoint::add_line_spectra(*m_y_fft, &m_line_values[nb_local_x_lines*m_x_positions.size()*nb_vars], nb_local_y_lines, nb_vars, m_y_spectra);
   
-  if(!comm.is_active() || comm.rank() == m_root)
+  ++m_count;
+  
+  if(m_count % m_interval == 0)
   {
-    const Uint nb_x_gids = m_x_positions.size();
-    const Uint nb_y_gids = m_y_positions.size();
-    
-    const RealMatrix old_x_sum = m_x_corr*static_cast<Real>(m_count);
-    const RealMatrix old_y_sum = m_y_corr*static_cast<Real>(m_count);
-    m_x_corr.setZero();
-    m_y_corr.setZero();
-    
-    const Uint dim = m_field->row_size();
-    
-    for(Uint i = 0; i != nb_x_gids; ++i)
+    if(comm.is_active())
     {
-      const RealRowVector y_ref = Eigen::Map<RealRowVector const>(&m_sampled_values[i][0], dim);
-      for(Uint j = 0; j != nb_y_gids; ++j)
-      {
-        const Uint x_ref_gid = nb_x_gids*j;
-        Eigen::Map<RealRowVector const> mapped_x_ref(&m_sampled_values[x_ref_gid][0], dim);
-        Eigen::Map<RealRowVector const> mapped_val(&m_sampled_values[x_ref_gid + i][0], dim);
-        m_x_corr.row(i).array() += mapped_x_ref.array() * mapped_val.array();
-        m_y_corr.row(j).array() += y_ref.array() * mapped_val.array();
-      }
+      std::vector<Real> global_x_spectra, global_y_spectra;
+      comm.reduce(common::PE::plus(), m_x_spectra, global_x_spectra, 0);
+      comm.reduce(common::PE::plus(), m_y_spectra, global_y_spectra, 0);
+      if(comm.rank() == 0)
+        write(global_x_spectra, global_y_spectra);
     }
-    
-    ++m_count;
-    
-    m_x_corr = (m_x_corr/static_cast<Real>(nb_y_gids) + old_x_sum) / static_cast<Real>(m_count);
-    m_y_corr = (m_y_corr/static_cast<Real>(nb_x_gids) + old_y_sum) / static_cast<Real>(m_count);
-    
-    if(m_count % m_interval == 0)
+    else
     {
-      const Uint normal = options().value<Uint>("normal");
-      const Uint x_direction = (normal+1) % 3;
-      const Uint y_direction = (normal+2) % 3;
-      const Real coord = options().value<Real>("coordinate");
-      
-      const common::URI original_uri = options().value<common::URI>("file");
-      std::string rewritten_path = original_uri.path();
-      boost::algorithm::replace_all(rewritten_path, "{iteration}", common::to_str(m_count));
-      
-      boost::filesystem::fstream file(rewritten_path, std::ios::out);
-      file << "# Autocorrelation at level " << coord << " in direction " << x_direction << " for field " << m_field->descriptor().description() << "\n";
-      for(Uint i = 0; i != nb_x_gids; ++i)
-      {
-        file << m_x_positions[i];
-        for(Uint j = 0; j != dim; ++j)
-          file << "," << common::to_str(m_x_corr(i,j));
-        file << "\n";
-      }
-      file << "# Autocorrelation at level " << coord << " in direction " << y_direction << " for field " << m_field->descriptor().description() << "\n";
-      for(Uint i = 0; i != nb_y_gids; ++i)
-      {
-        file << m_y_positions[i];
-        for(Uint j = 0; j != dim; ++j)
-          file << "," << common::to_str(m_y_corr(i,j));
-        file << "\n";
-      }
-      file.close();
+      write(m_x_spectra, m_y_spectra);
     }
   }
 }
 
+void TwoPointCorrelation::write(const std::vector<Real>& x_spectra, const std::vector<Real>& y_spectra)
+{
+  const Uint nb_vars = m_field->row_size();
+  const Real nb_x_samples = static_cast<Real>(m_count*m_y_positions.size());
+  const Real nb_y_samples = static_cast<Real>(m_count*m_x_positions.size());
+
+  const Uint normal = options().value<Uint>("normal");
+  const Uint x_direction = (normal+1) % 3;
+  const Uint y_direction = (normal+2) % 3;
+  const Real coord = options().value<Real>("coordinate");
+  const std::string description = m_field->descriptor().description();
+  
+  const common::URI original_uri = options().value<common::URI>("file");
+  std::string rewritten_path = original_uri.path();
+  boost::algorithm::replace_all(rewritten_path, "{iteration}", common::to_str(m_count));
+  
+  boost::filesystem::fstream file(rewritten_path, std::ios::out);
+  file << "# Autocorrelation at level " << coord << " in direction " << x_direction << " for field " << description << "\n";
+  detail_twopoint::write_correlations(file, m_x_positions, detail_twopoint::correlations(*m_x_fft, x_spectra, nb_vars, nb_x_samples));
+  file << "# Autocorrelation at level " << coord << " in direction " << y_direction << " for field " << description << "\n";
+  detail_twopoint::write_correlations(file, m_y_positions, detail_twopoint::correlations(*m_y_fft, y_spectra, nb_vars, nb_y_samples));
+  file.close();
+
+  const common::URI spectrum_uri = options().value<common::URI>("spectrum_file");
+  if(spectrum_uri.path().empty())
+    return;
+
+  std::string spectrum_path = spectrum_uri.path();
+  boost::algorithm::replace_all(spectrum_path, "{iteration}", common::to_str(m_count));
+  boost::filesystem::fstream spectrum_file(spectrum_path, std::ios::out);
+  spectrum_file << "# Power spectrum at level " << coord << " in direction " << x_direction << " for field " << description << " (mode, wavenumber, values)\n";
+  detail_twopoint::write_spectrum(spectrum_file, m_x_positions, x_spectra, nb_vars, nb_x_samples);
+  spectrum_file << "# Power spectrum at level " << coord << " in direction " << y_direction << " for field " << description << " (mode, wavenumber, values)\n";
+  detail_twopoint::write_spectrum(spectrum_file, m_y_positions, y_spectra, nb_vars, nb_y_samples);
+  spectrum_file.close();
+}
+
 void TwoPointCorrelation::trigger()
 {
   m_field.reset();
@@ -203,9 +294,6 @@ void TwoPointCorrelation::setup()
   if(is_not_null(m_field))
     return;
 
-  if(is_not_null(m_comm_pattern))
-    remove_component(*m_comm_pattern);
-
   m_field = options().value< Handle<mesh::Field> >("field");
   if(is_null(m_field))
     throw common::SetupError(FromHere(), "No field configured for " + uri().path());
@@ -213,6 +301,7 @@ void TwoPointCorrelation::setup()
   const mesh::Dictionary& dict = m_field->dict();
   const Uint nb_nodes = dict.size();
   const mesh::Field& coords = dict.coordinates();
+  const common::List<bool>* periodic_links_active = Handle<common::List<bool> const>(dict.get_child("periodic_links_active")).get();
 
   if(coords.row_size() != 3)
   {
@@ -232,20 +321,21 @@ void TwoPointCorrelation::setup()
 
   std::set<Real, detail_twopoint::threshold_compare> unique_x_coords((detail_twopoint::threshold_compare(threshold)));
   std::set<Real, detail_twopoint::threshold_compare> unique_y_coords((detail_twopoint::threshold_compare(threshold)));
-  Uint node_counter = 0;
+  std::vector<Uint> used_node_lids;
   for(Uint node_idx = 0; node_idx != nb_nodes; ++node_idx )
   {
-    if(!dict.is_ghost( node_idx ) && ::fabs(coords[node_idx][normal] - coordinate) < threshold)
+    if(!dict.is_ghost( node_idx ) && !(is_not_null(periodic_links_active) && (*periodic_links_active)[node_idx]) && ::fabs(coords[node_idx][normal] - coordinate) < threshold)
     {
       unique_x_coords.insert(coords[node_idx][x_direction]);
       unique_y_coords.insert(coords[node_idx][y_direction]);
-      ++node_counter;
+      used_node_lids.push_back(node_idx);
     }
   }
-  const Uint nb_used_nodes = node_counter;
+  const Uint nb_used_nodes = used_node_lids.size();
 
   common::PE::Comm& comm = common::PE::Comm::instance();
   
+  Uint nb_global_used_nodes = nb_used_nodes;
   if(comm.is_active())
   {
     std::vector<Real> my_unique_x_coords(unique_x_coords.begin(), unique_x_coords.end());
@@ -261,6 +351,7 @@ void TwoPointCorrelation::setup()
     {
       unique_y_coords.insert(vec.begin(), vec.end());
     }
+    comm.all_reduce(common::PE::plus(), &nb_used_nodes, 1, &nb_global_used_nodes);
   }
   
   std::map<Real, Uint, detail_twopoint::threshold_compare> x_coords_map((detail_twopoint::threshold_compare(threshold)));
@@ -278,78 +369,79 @@ void TwoPointCorrelation::setup()
   
   m_x_positions.assign(unique_x_coords.begin(), unique_x_coords.end());
   m_y_positions.assign(unique_y_coords.begin(), unique_y_coords.end());
-
-  CFinfo << "Found " << m_x_positions.size() << "x" << m_y_positions.size() << " unique coordinates in direction normal to " << normal << CFendl;
-  
-  m_used_node_lids.clear();
-  m_used_node_lids.reserve(nb_used_nodes);
-  m_used_node_x_gids.resize(nb_used_nodes); m_used_node_y_gids.resize(nb_used_nodes);
-  for(Uint node_idx = 0; node_idx != nb_nodes; ++node_idx )
-  {
-    if(!dict.is_ghost( node_idx ) && ::fabs(coords[node_idx][normal] - coordinate) < threshold)
-    {
-      cf3_assert(x_coords_map.find(coords[node_idx][x_direction]) != x_coords_map.end());
-      cf3_assert(y_coords_map.find(coords[node_idx][y_direction]) != y_coords_map.end());
-      
-      m_used_node_x_gids[m_used_node_lids.size()] = x_coords_map[coords[node_idx][x_direction]];
-      m_used_node_y_gids[m_used_node_lids.size()] = y_coords_map[coords[node_idx][y_direction]];
-      m_used_node_lids.push_back(node_idx);
-    }
-  }
   
   const Uint nb_x_gids = m_x_positions.size();
   const Uint nb_y_gids = m_y_positions.size();
-  
 
+  CFinfo << "Found " << nb_x_gids << "x" << nb_y_gids << " unique coordinates in direction normal to " << normal << CFendl;
+  
+  if(nb_global_used_nodes == 0 || nb_global_used_nodes != nb_x_gids*nb_y_gids)
+    throw common::SetupError(FromHere(), "The " + common::to_str(nb_global_used_nodes) + " nodes at coordinate " + common::to_str(coordinate) + " do not form a structured "
+                                          + common::to_str(nb_x_gids) + "x" + common::to_str(nb_y_gids) + " plane for " + uri().path());
+  
+  // Lines are distributed in contiguous blocks
+  const Uint nb_procs = comm.is_active() ? comm.size() : 1;
+  const Uint rank = comm.is_active() ? comm.rank() : 0;
+  m_x_lines_begin = detail_twopoint::first_line(rank, nb_y_gids, nb_procs);
+  m_x_lines_end = detail_twopoint::first_line(rank+1, nb_y_gids, nb_procs);
+  m_y_lines_begin = detail_twopoint::first_line(rank, nb_x_gids, nb_procs);
+  m_y_lines_end = detail_twopoint::first_line(rank+1, nb_x_gids, nb_procs);
+  
+  // Each node goes to the owner of its x line, with an even code, and to the owner of its y line, with an odd code
+  m_send_lids.clear();
+  std::map< int, std::vector<Uint> > send_codes, recv_codes;
+  BOOST_FOREACH(const Uint node_idx, used_node_lids)
+  {
+    const Uint x_gid = x_coords_map[coords[node_idx][x_direction]];
+    const Uint y_gid = y_coords_map[coords[node_idx][y_direction]];
+    const Uint gid = y_gid*nb_x_gids + x_gid;
+    
+    const int x_line_owner = detail_twopoint::line_owner(y_gid, nb_y_gids, nb_procs);
+    send_codes[x_line_owner].push_back(2*gid);
+    m_send_lids[x_line_owner].push_back(node_idx);
+    
+    const int y_line_owner = detail_twopoint::line_owner(x_gid, nb_x_gids, nb_procs);
+    send_codes[y_line_owner].push_back(2*gid+1);
+    m_send_lids[y_line_owner].push_back(node_idx);
+  }
   
   if(comm.is_active())
+    comm.sparse_all_to_all(send_codes, recv_codes);
+  else
+    recv_codes.swap(send_codes);
+  
+  const Uint nb_vars = m_field->row_size();
+  const Uint nb_local_x_lines = m_x_lines_end - m_x_lines_begin;
+  const Uint nb_local_y_lines = m_y_lines_end - m_y_lines_begin;
+  const Uint y_lines_offset = nb_local_x_lines*nb_x_gids*nb_vars;
+  m_recv_offsets.clear();
+  for(std::map< int, std::vector<Uint> >::const_iterator it = recv_codes.begin(); it != recv_codes.end(); ++it)
   {
-    m_root = 0;
-    std::vector< std::vector<Uint> > send_gids, recv_gids;
-    send_gids.resize(comm.size());
-    send_gids[m_root].reserve(nb_used_nodes);
-    for(Uint i = 0; i != nb_used_nodes; ++i)
-    {
-      send_gids[m_root].push_back(m_used_node_y_gids[i]*nb_x_gids+m_used_node_x_gids[i]);
-    }
-
-    comm.all_to_all(send_gids, recv_gids);
-
-    if(comm.rank() == m_root)
+    std::vector<Uint>& offsets = m_recv_offsets[it->first];
+    offsets.reserve(it->second.size());
+    BOOST_FOREACH(const Uint code, it->second)
     {
-      m_ranks.resize(nb_x_gids*nb_y_gids);
-      m_gids.resize(nb_x_gids*nb_y_gids);
-      for(Uint rank = 0; rank != comm.size(); ++rank)
+      const Uint gid = code / 2;
+      const Uint x_gid = gid % nb_x_gids;
+      const Uint y_gid = gid / nb_x_gids;
+      if(code % 2 == 0)
       {
-        BOOST_FOREACH(const Uint gid, recv_gids[rank])
-        {
-          m_gids[gid] = gid;
-          m_ranks[gid] = rank;
-        }
+        cf3_assert(y_gid >= m_x_lines_begin && y_gid < m_x_lines_end);
+        offsets.push_back(((y_gid - m_x_lines_begin)*nb_x_gids + x_gid)*nb_vars);
+      }
+      else
+      {
+        cf3_assert(x_gid >= m_y_lines_begin && x_gid < m_y_lines_end);
+        offsets.push_back(y_lines_offset + ((x_gid - m_y_lines_begin)*nb_y_gids + y_gid)*nb_vars);
       }
-
-      m_sampled_values.resize(boost::extents[nb_x_gids*nb_y_gids][m_field->row_size()]);
-      m_x_corr.resize(nb_x_gids, m_field->row_size()); m_x_corr.setZero();
-      m_y_corr.resize(nb_y_gids, m_field->row_size()); m_y_corr.setZero();
-    }
-    else
-    {
-      m_gids = send_gids[m_root];
-      m_ranks.assign(nb_used_nodes, comm.rank());
-      m_sampled_values.resize(boost::extents[nb_used_nodes][m_field->row_size()]);
     }
-    
-    m_comm_pattern = create_component<common::PE::CommPattern>("CommPattern");
-    m_comm_pattern->insert("gid", m_gids, 1, false);
-    m_comm_pattern->setup(Handle<common::PE::CommWrapper>(m_comm_pattern->get_child("gid")), m_ranks);
-    m_comm_pattern->insert("samples", m_sampled_values);
-  }
-  else
-  {
-    m_x_corr.resize(nb_x_gids, m_field->row_size()); m_x_corr.setZero();
-    m_y_corr.resize(nb_y_gids, m_field->row_size()); m_y_corr.setZero();
-    m_sampled_values.resize(boost::extents[nb_x_gids*nb_y_gids][m_field->row_size()]);
   }
+  
+  m_line_values.assign(y_lines_offset + nb_local_y_lines*nb_y_gids*nb_vars, 0.);
+  m_x_spectra.assign(nb_x_gids*nb_vars, 0.);
+  m_y_spectra.assign(nb_y_gids*nb_vars, 0.);
+  m_x_fft.reset(new math::FFT(nb_x_gids));
+  m_y_fft.reset(new math::FFT(nb_y_gids));
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -359,4 +451,3 @@ void TwoPointCorrelation::setup()
 } // cf3
 
 ////////////////////////////////////////////////////////////////////////////////////
-
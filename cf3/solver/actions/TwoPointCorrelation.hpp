@@ -7,15 +7,15 @@
 #ifndef cf3_solver_actions_TwoPointCorrelation_hpp
 #define cf3_solver_actions_TwoPointCorrelation_hpp
 
-#include <boost/accumulators/accumulators.hpp>
-#include <boost/accumulators/statistics/stats.hpp>
-#include <boost/accumulators/statistics/count.hpp>
-#include <boost/accumulators/statistics/mean.hpp>
-#include <boost/accumulators/statistics/rolling_mean.hpp>
+#include <map>
+
+#include <boost/scoped_ptr.hpp>
 
 #include "common/Action.hpp"
 #include "common/List.hpp"
 
+#include "math/FFT.hpp"
+
 #include "mesh/Field.hpp"
 
 #include "solver/actions/LibActions.hpp"
@@ -29,6 +29,12 @@ namespace actions {
 ///////////////////////////////////////////////////////////////////////////////////////
 
 /// Compute two-point correlations in two perpendipular directions on a structured mesh
+///
+/// The sampled plane consists of lines in the two directions. Each line is assigned to a process, and the sampled
+/// values are sent to the line owners, so each process holds complete lines. The power spectrum of each line is computed using
+/// an FFT and summed over all lines and time steps. On output the sums are reduced to the root process, and the correlations
+/// are obtained by the inverse transform of the mean spectrum. This assumes the directions are homogeneous and periodic,
+/// with equally spaced points. Nodes that are periodic copies of another node are skipped.
 class solver_actions_API TwoPointCorrelation : public common::Action
 {
 public: // functions
@@ -49,24 +55,38 @@ public: // functions
 private:
   void trigger();
   void setup();
+  /// Write the mean correlations and spectra, on the root process
+  void write(const std::vector<Real>& x_spectra, const std::vector<Real>& y_spectra);
+
   Handle<mesh::Field> m_field;
   
-  std::vector<Uint> m_used_node_lids;
-  std::vector<Uint> m_used_node_x_gids;
-  std::vector<Uint> m_used_node_y_gids;
   std::vector<Real> m_x_positions;
   std::vector<Real> m_y_positions;
-  
-  RealMatrix m_x_corr;
-  RealMatrix m_y_corr;
 
-  Uint m_root;
-  std::vector<Uint> m_gids;
-  std::vector<Uint> m_ranks;
-  
-  common::Table<Real>::ArrayT m_sampled_values;
+  /// Local indices of the nodes whose values are sent to each process, in the order expected by the receiver.
+  /// A node is listed once for each of the two lines it is on.
+  std::map< int, std::vector<Uint> > m_send_lids;
+
+  /// Offset in m_line_values of each value received from each process
+  std::map< int, std::vector<Uint> > m_recv_offsets;
+
+  /// Values on the lines owned by this process, lines in the x direction first. The variables of each point are stored together.
+  std::vector<Real> m_line_values;
+
+  /// Owned lines in x direction, indexed by their y position
+  Uint m_x_lines_begin;
+  Uint m_x_lines_end;
+
+  /// Owned lines in y direction, indexed by their x position
+  Uint m_y_lines_begin;
+  Uint m_y_lines_end;
+
+  /// Sums of the power spectra of the owned lines, for each variable. All modes of a variable are stored together.
+  std::vector<Real> m_x_spectra;
+  std::vector<Real> m_y_spectra;
 
-  Handle<common::PE::CommPattern> m_comm_pattern;
+  boost::scoped_ptr<math::FFT> m_x_fft;
+  boost::scoped_ptr<math::FFT> m_y_fft;
   
   Uint m_count;
   Uint m_interval;
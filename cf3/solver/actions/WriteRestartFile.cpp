@@ -4,6 +4,8 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <map>
+
 #include <boost/bind.hpp>
 #include <boost/function.hpp>
 
@@ -11,6 +13,7 @@
 #include "common/FindComponents.hpp"
 #include "common/OptionList.hpp"
 #include "common/List.hpp"
+#include "common/Table.hpp"
 #include "common/BinaryDataWriter.hpp"
 #include "common/XML/FileOperations.hpp"
 
@@ -20,6 +23,7 @@
 #include "mesh/Space.hpp"
 #include "mesh/ElementType.hpp"
 #include "mesh/Connectivity.hpp"
+#include "mesh/Entities.hpp"
 
 #include "solver/Tags.hpp"
 #include "solver/Time.hpp"
@@ -89,7 +93,7 @@ void WriteRestartFile::execute()
   
   common::XML::XmlDoc xml_doc("1.0", "ISO-8859-1");
   common::XML::XmlNode restart_node = xml_doc.add_node("restart");
-  restart_node.set_attribute("version", "1");
+  restart_node.set_attribute("version", "2");
   restart_node.set_attribute("binary_file", binfile.path());
   restart_node.set_attribute("nb_procs", common::to_str(comm.size()));
   restart_node.set_attribute("current_time", common::to_str(time->current_time()));
@@ -97,21 +101,73 @@ void WriteRestartFile::execute()
   restart_node.set_attribute("iteration", common::to_str(time->iter()));
   
   const std::string base_path = mesh->uri().path() + "/";
+
+  // Block index of the row keys, stored once for each dictionary
+  std::map<const mesh::Dictionary*, Uint> keys_indices;
+  boost::shared_ptr< common::Table<Uint> > keys = common::allocate_component< common::Table<Uint> >("RowKeys");
   
   BOOST_FOREACH(const Handle<mesh::Field>& field, fields)
   {
+    const mesh::Dictionary& dict = field->dict();
+    if(keys_indices.count(&dict) == 0)
+    {
+      row_keys(dict, *keys);
+      keys_indices[&dict] = data_writer->append_data(*keys);
+    }
+
     common::XML::XmlNode field_node = restart_node.add_node("field");
     std::string relative_path = field->uri().path();
     boost::replace_first(relative_path, base_path, "");
     cf3_assert(relative_path.size() == field->uri().path().size() - base_path.size());
     field_node.set_attribute("path", relative_path);
     field_node.set_attribute("index", common::to_str(data_writer->append_data(*field)));
+    field_node.set_attribute("keys_index", common::to_str(keys_indices[&dict]));
   }
 
   if(comm.rank() == 0)
     common::XML::to_file(xml_doc, out_file_path);
 }
 
+/////////////////////////////////////////////////////////////////////////////////////
+
+void WriteRestartFile::row_keys(const mesh::Dictionary& dict, common::Table<Uint>& keys)
+{
+  const Uint nb_rows = dict.size();
+  keys.set_row_size(3);
+  keys.resize(nb_rows);
+
+  if(dict.continuous())
+  {
+    for(Uint i = 0; i != nb_rows; ++i)
+    {
+      keys[i][0] = dict.glb_idx()[i];
+      keys[i][1] = 0;
+      keys[i][2] = !dict.is_ghost(i);
+    }
+    return;
+  }
+
+  // The numbering of discontinuous dictionaries depends on the partitioning, so the element numbering is used instead
+  BOOST_FOREACH(const Handle<mesh::Space>& space, dict.spaces())
+  {
+    const mesh::Entities& entities = space->support();
+    const mesh::Connectivity& connectivity = space->connectivity();
+    const Uint nb_elems = space->size();
+    for(Uint elem = 0; elem != nb_elems; ++elem)
+    {
+      const mesh::Connectivity::ConstRow row = connectivity[elem];
+      const Uint nb_nodes = row.size();
+      for(Uint node = 0; node != nb_nodes; ++node)
+      {
+        common::Table<Uint>::Row key = keys[row[node]];
+        key[0] = entities.glb_idx()[elem];
+        key[1] = node;
+        key[2] = !entities.is_ghost(elem);
+      }
+    }
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 } // actions
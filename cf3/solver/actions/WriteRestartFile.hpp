@@ -8,17 +8,21 @@
 #define cf3_solver_actions_WriteRestartFile_hpp
 
 #include "common/Action.hpp"
+#include "common/Table_fwd.hpp"
 #include "solver/actions/LibActions.hpp"
 
 /////////////////////////////////////////////////////////////////////////////////////
 
 namespace cf3 {
+namespace mesh { class Dictionary; }
 namespace solver {
 namespace actions {
 
 ///////////////////////////////////////////////////////////////////////////////////////
 
-/// Write out a restartfile, designed to be loaded into an already-created mesh
+/// Write out a restartfile, designed to be loaded into an already-created mesh.
+/// Next to the field data, a key is stored for each row of each dictionary, so the file can
+/// be read back on a different number of processes.
 class solver_actions_API WriteRestartFile : public common::Action
 {
 public: // functions
@@ -34,6 +38,11 @@ public: // functions
 
   /// execute the action
   virtual void execute ();
+
+  /// Fill the table with a key for each row of the dictionary, that does not depend on the partitioning.
+  /// The first two columns are the key: the global index for continuous dictionaries, or the global element index and the
+  /// node index within the element for discontinuous dictionaries. The third column is 1 if the row is owned by this rank.
+  static void row_keys(const mesh::Dictionary& dict, common::Table<Uint>& keys);
 };
 
 /////////////////////////////////////////////////////////////////////////////////////
@@ -293,6 +293,11 @@ include(CheckNullPtr)
 
   check_function_exists(gettimeofday  CF3_HAVE_GETTIMEOFDAY)
 
+  # check for hardware performance counters
+  coolfluid_log_file( "+++++  Checking for perf_event_open" )
+
+  check_include_file(linux/perf_event.h CF3_HAVE_PERF_EVENT_H)
+
 #######################################################################################
 # Win32 specific
 #######################################################################################
@@ -137,9 +137,9 @@ void InitialConditionConstant::execute()
     {
       used_entities.push_back(entities.handle<mesh::Entities>());
     }
-    boost::shared_ptr< common::List<Uint> > used_nodes_ptr = mesh::build_used_nodes_list(used_entities, mesh.geometry_fields(), true);
+    boost::shared_ptr< common::List<Uint> const > used_nodes_ptr = mesh::cached_used_nodes_list(used_entities, mesh.geometry_fields(), true);
 
-    common::List<Uint>& nodes = *used_nodes_ptr;
+    const common::List<Uint>& nodes = *used_nodes_ptr;
     
     Field& field = find_field(*region, field_tag);
     BOOST_FOREACH(const Uint node, nodes.array())
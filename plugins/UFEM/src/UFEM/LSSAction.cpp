@@ -213,8 +213,8 @@ void LSSAction::on_regions_set()
     Handle< List<Uint> > ranks = m_implementation->m_lss->create_component< List<Uint> >("Ranks");
     Handle< List<int> > used_node_map = m_implementation->m_lss->create_component< List<int> >("used_node_map");
 
-    std::vector<Uint> node_connectivity, starting_indices;
-    boost::shared_ptr< List<Uint> > used_nodes = build_sparsity(m_loop_regions, *m_dictionary, node_connectivity, starting_indices, *gids, *ranks, *used_node_map);
+    boost::shared_ptr< const std::vector<Uint> > node_connectivity, starting_indices;
+    boost::shared_ptr< List<Uint> > used_nodes = build_sparsity_cached(m_loop_regions, *m_dictionary, node_connectivity, starting_indices, *gids, *ranks, *used_node_map);
     if(is_not_null(get_child(used_nodes->name())))
       remove_component(used_nodes->name());
     add_component(used_nodes);
@@ -266,7 +266,7 @@ void LSSAction::on_regions_set()
       }
     }
 
-    do_create_lss(comm_pattern, descriptor, node_connectivity, starting_indices, periodic_links_nodes_vec, periodic_links_active_vec);
+    do_create_lss(comm_pattern, descriptor, *node_connectivity, *starting_indices, periodic_links_nodes_vec, periodic_links_active_vec);
     cf3_always_assert(m_implementation->m_lss->is_created());
     Handle<math::LSS::SolutionStrategy> solution_strategy = m_implementation->m_lss->solution_strategy();
     cf3_assert(is_not_null(solution_strategy));
@@ -360,7 +360,7 @@ void LSSAction::on_initial_conditions_set(InitialConditions& initial_conditions)
 {
 }
 
-void LSSAction::do_create_lss(PE::CommPattern &cp, const VariablesDescriptor &vars, std::vector<Uint> &node_connectivity, std::vector<Uint> &starting_indices, const std::vector<Uint> &periodic_links_nodes, const std::vector<bool> &periodic_links_active)
+void LSSAction::do_create_lss(PE::CommPattern &cp, const VariablesDescriptor &vars, const std::vector<Uint> &node_connectivity, const std::vector<Uint> &starting_indices, const std::vector<Uint> &periodic_links_nodes, const std::vector<bool> &periodic_links_active)
 {
   const bool blocked_system = options().option("blocked_system").value<bool>();
   if(blocked_system)
@@ -4,7 +4,8 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
-#include <set>
+#include <algorithm>
+#include <map>
 
 #include "common/FindComponents.hpp"
 #include "common/List.hpp"
@@ -17,6 +18,7 @@
 #include "mesh/Functions.hpp"
 #include "mesh/Connectivity.hpp"
 #include "mesh/Space.hpp"
+#include "mesh/Tags.hpp"
 
 #include "UFEM/SparsityBuilder.hpp"
 
@@ -89,9 +91,9 @@ boost::shared_ptr< List<Uint> > build_sparsity(const std::vector< Handle<Region>
   std::vector<Uint> replaced_gids(dict_gid.array().begin(), dict_gid.array().end());
 
   // For each rank, the indices that need to be received from the GID list
-  std::vector< std::vector<Uint> > gids_to_receive(nb_procs);
-  std::vector< std::vector<Uint> > lids_to_receive(nb_procs);
-  std::vector< std::vector<Uint> > gids_to_send(nb_procs);
+  typedef std::map< int, std::vector<Uint> > IndicesPerRankT;
+  IndicesPerRankT gids_to_receive;
+  IndicesPerRankT lids_to_receive;
 
   // Fill gid list
   for(Uint i = 0; i != nb_used_nodes; ++i)
@@ -110,40 +112,41 @@ boost::shared_ptr< List<Uint> > build_sparsity(const std::vector< Handle<Region>
 
   if(PE::Comm::instance().is_active())
   {
-    // Let all ranks know which items of the GID vector need to be updated
-    PE::Comm::instance().all_to_all(gids_to_receive, gids_to_send);
-    cf3_assert(gids_to_send.size() == nb_procs);
-    std::vector<int> send_num(nb_procs, 0);
-    std::vector<int> recv_num(nb_procs, 0);
-    int send_size = 0;
-    int recv_size = 0;
-
-    for(Uint i = 0; i != nb_procs; ++i)
-    {
-      send_num[i] = gids_to_send[i].size();
-      recv_num[i] = gids_to_receive[i].size();
-      send_size += send_num[i];
-      recv_size += recv_num[i];
-    }
+    // Let the owning ranks know which items of the GID vector need to be updated. Only actual neighbours communicate.
+    IndicesPerRankT gids_to_send;
+    PE::Comm::instance().sparse_all_to_all(gids_to_receive, gids_to_send);
 
-    std::vector<int> recv_map; recv_map.reserve(recv_size);
-    std::vector<int> send_map; send_map.reserve(send_size);
-    
-    std::map<Uint, Uint> gids_reverse_map;
+    // Sorted (gid, local index) pairs, to look up the local index of the requested gids
+    std::vector< std::pair<Uint, Uint> > gids_reverse_map(nb_global_nodes);
     for(Uint i = 0; i != nb_global_nodes; ++i)
-      gids_reverse_map[dict_gid[i]] = i;
+      gids_reverse_map[i] = std::make_pair(dict_gid[i], i);
+    std::sort(gids_reverse_map.begin(), gids_reverse_map.end());
 
-    for(Uint i = 0; i != nb_procs; ++i)
+    IndicesPerRankT new_gids_to_send;
+    for(IndicesPerRankT::const_iterator it = gids_to_send.begin(); it != gids_to_send.end(); ++it)
     {
-      recv_map.insert(recv_map.end(), lids_to_receive[i].begin(), lids_to_receive[i].end());
-      const std::vector<Uint> send_gids_i = gids_to_send[i];
+      const std::vector<Uint>& send_gids_i = it->second;
       const Uint len_send_gids_i = send_gids_i.size();
+      std::vector<Uint>& new_gids_i = new_gids_to_send[it->first];
+      new_gids_i.reserve(len_send_gids_i);
       for(Uint j = 0; j != len_send_gids_i; ++j)
-        send_map.push_back(gids_reverse_map[send_gids_i[j]]);
+      {
+        const std::vector< std::pair<Uint, Uint> >::const_iterator found = std::lower_bound(gids_reverse_map.begin(), gids_reverse_map.end(), std::make_pair(send_gids_i[j], 0u));
+        cf3_assert(found != gids_reverse_map.end() && found->first == send_gids_i[j]);
+        new_gids_i.push_back(replaced_gids[found->second]);
+      }
     }
-    
+
     // Update the GIDs for the ghosts
-    PE::Comm::instance().all_to_all(replaced_gids, send_num, send_map, replaced_gids, recv_num, recv_map);
+    IndicesPerRankT received_gids;
+    PE::Comm::instance().sparse_all_to_all(new_gids_to_send, received_gids);
+    for(IndicesPerRankT::const_iterator it = lids_to_receive.begin(); it != lids_to_receive.end(); ++it)
+    {
+      const std::vector<Uint>& new_gids_i = received_gids[it->first];
+      cf3_assert(new_gids_i.size() == it->second.size());
+      for(Uint j = 0; j != it->second.size(); ++j)
+        replaced_gids[it->second[j]] = new_gids_i[j];
+    }
 
     for(Uint i = 0; i != nb_used_nodes; ++i)
     {
@@ -154,43 +157,177 @@ boost::shared_ptr< List<Uint> > build_sparsity(const std::vector< Handle<Region>
     }
   }
 
-  std::vector< std::set<Uint> > connectivity_sets(nb_used_nodes);
-  start_indices.assign(nb_used_nodes+1, 0);
-
-  // Determine the number of connected nodes for each element
+  // Connectivity tables of the used elements, and the offset of each table in a global element numbering
+  std::vector<const Connectivity*> connectivities;
+  std::vector<Uint> elements_offsets(1, 0);
   BOOST_FOREACH(const Handle<Entities const>& elements, used_entities)
   {
-    const Connectivity& connectivity = elements->space(dictionary).connectivity();
+    connectivities.push_back(&elements->space(dictionary).connectivity());
+    elements_offsets.push_back(elements_offsets.back() + connectivities.back()->size());
+  }
+  const Uint nb_connectivities = connectivities.size();
+
+  // Node to element incidence in CSR format, built in two passes: first count, then fill
+  std::vector<Uint> node_elements_start(nb_used_nodes+1, 0);
+  for(Uint i = 0; i != nb_connectivities; ++i)
+  {
+    const Connectivity& connectivity = *connectivities[i];
     const Uint nb_elems = connectivity.size();
-    const Uint nb_elem_nodes = connectivity.row_size();
     for(Uint elem = 0; elem != nb_elems; ++elem)
     {
-      BOOST_FOREACH(const Uint node_a, connectivity[elem])
+      BOOST_FOREACH(const Uint node, connectivity[elem])
+      {
+        ++node_elements_start[used_node_map[node]+1];
+      }
+    }
+  }
+  for(Uint i = 1; i != nb_used_nodes+1; ++i)
+    node_elements_start[i] += node_elements_start[i-1];
+
+  std::vector<Uint> node_elements(node_elements_start.back());
+  std::vector<Uint> node_elements_fill(node_elements_start.begin(), node_elements_start.end()-1);
+  for(Uint i = 0; i != nb_connectivities; ++i)
+  {
+    const Connectivity& connectivity = *connectivities[i];
+    const Uint nb_elems = connectivity.size();
+    for(Uint elem = 0; elem != nb_elems; ++elem)
+    {
+      BOOST_FOREACH(const Uint node, connectivity[elem])
+      {
+        node_elements[node_elements_fill[used_node_map[node]]++] = elements_offsets[i] + elem;
+      }
+    }
+  }
+  std::vector<Uint>().swap(node_elements_fill);
+
+  // Pass 1: count the unique connected nodes for each node. Pass 2: fill them in, sorted. Nodes are independent, so both passes run threaded.
+  start_indices.assign(nb_used_nodes+1, 0);
+  const int nb_used_nodes_int = static_cast<int>(nb_used_nodes);
+  for(Uint pass = 0; pass != 2; ++pass)
+  {
+    if(pass == 1)
+    {
+      // Sum the number of connected nodes to get the real start indices
+      for(Uint i = 1; i != nb_used_nodes+1; ++i)
+        start_indices[i] += start_indices[i-1];
+      node_connectivity.resize(start_indices.back());
+    }
+
+    #pragma omp parallel
+    {
+      std::vector<Uint> connected_nodes;
+      #pragma omp for schedule(dynamic, 256)
+      for(int node = 0; node < nb_used_nodes_int; ++node)
       {
-        BOOST_FOREACH(const Uint node_b, connectivity[elem])
+        connected_nodes.clear();
+        for(Uint i = node_elements_start[node]; i != node_elements_start[node+1]; ++i)
         {
-          connectivity_sets[used_node_map[node_a]].insert(used_node_map[node_b]);
+          const Uint glb_elem = node_elements[i];
+          const Uint conn_idx = std::upper_bound(elements_offsets.begin(), elements_offsets.end(), glb_elem) - elements_offsets.begin() - 1;
+          BOOST_FOREACH(const Uint connected_node, (*connectivities[conn_idx])[glb_elem - elements_offsets[conn_idx]])
+          {
+            connected_nodes.push_back(used_node_map[connected_node]);
+          }
         }
+        std::sort(connected_nodes.begin(), connected_nodes.end());
+        const std::vector<Uint>::iterator unique_end = std::unique(connected_nodes.begin(), connected_nodes.end());
+        if(pass == 0)
+          start_indices[node+1] = unique_end - connected_nodes.begin();
+        else
+          std::copy(connected_nodes.begin(), unique_end, node_connectivity.begin() + start_indices[node]);
       }
     }
   }
 
-  // Sum the number of connected nodes to get the real start indices
-  const Uint start_indices_end = start_indices.size();
-  for(Uint i = 1; i != start_indices_end; ++i)
+  return used_nodes_ptr;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+
+boost::shared_ptr< List<Uint> > build_sparsity_cached(const std::vector< Handle<Region> >& regions, Dictionary& dictionary, boost::shared_ptr< const std::vector<Uint> >& node_connectivity, boost::shared_ptr< const std::vector<Uint> >& start_indices, List<Uint>& gids, List<Uint>& ranks, List<int>& used_node_map)
+{
+  Handle<SparsityCache> cache(dictionary.get_child("SparsityCache"));
+  if(is_null(cache))
+    cache = dictionary.create_component<SparsityCache>("SparsityCache");
+
+  const SparsityCache::Entry* cached = cache->find(regions);
+  if(cached == nullptr)
   {
-    start_indices[i] = connectivity_sets[i-1].size() + start_indices[i-1];
+    boost::shared_ptr< std::vector<Uint> > new_node_connectivity(new std::vector<Uint>());
+    boost::shared_ptr< std::vector<Uint> > new_start_indices(new std::vector<Uint>());
+    boost::shared_ptr< List<Uint> > used_nodes = build_sparsity(regions, dictionary, *new_node_connectivity, *new_start_indices, gids, ranks, used_node_map);
+    SparsityCache::Entry& entry = cache->insert(regions);
+    entry.node_connectivity = new_node_connectivity;
+    entry.start_indices = new_start_indices;
+    entry.gids.reset(new std::vector<Uint>(gids.array().begin(), gids.array().end()));
+    entry.ranks.reset(new std::vector<Uint>(ranks.array().begin(), ranks.array().end()));
+    entry.used_node_map.reset(new std::vector<int>(used_node_map.array().begin(), used_node_map.array().end()));
+    entry.used_nodes.reset(new std::vector<Uint>(used_nodes->array().begin(), used_nodes->array().end()));
+    node_connectivity = entry.node_connectivity;
+    start_indices = entry.start_indices;
+    return used_nodes;
   }
 
-  node_connectivity.reserve(start_indices.back());
-  for(Uint node = 0; node != nb_used_nodes; ++node)
+  node_connectivity = cached->node_connectivity;
+  start_indices = cached->start_indices;
+  gids.resize(cached->gids->size());
+  std::copy(cached->gids->begin(), cached->gids->end(), gids.array().begin());
+  ranks.resize(cached->ranks->size());
+  std::copy(cached->ranks->begin(), cached->ranks->end(), ranks.array().begin());
+  used_node_map.resize(cached->used_node_map->size());
+  std::copy(cached->used_node_map->begin(), cached->used_node_map->end(), used_node_map.array().begin());
+
+  boost::shared_ptr< List<Uint> > used_nodes = common::allocate_component< List<Uint> >(mesh::Tags::nodes_used());
+  used_nodes->resize(cached->used_nodes->size());
+  std::copy(cached->used_nodes->begin(), cached->used_nodes->end(), used_nodes->array().begin());
+  return used_nodes;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+SparsityCache::SparsityCache(const std::string& name) : Component(name)
+{
+  // Removed by the mesh when it is loaded or changed
+  add_tag(mesh::Tags::cache());
+}
+
+SparsityCache::~SparsityCache()
+{
+}
+
+namespace detail
+{
+  /// Cache key for a set of regions, independent of the order
+  std::vector<std::string> sparsity_cache_key(const std::vector< Handle<Region> >& regions)
   {
-    node_connectivity.insert(node_connectivity.begin() + start_indices[node], connectivity_sets[node].begin(), connectivity_sets[node].end());
+    std::vector<std::string> key;
+    key.reserve(regions.size());
+    BOOST_FOREACH(const Handle<Region>& region, regions)
+    {
+      key.push_back(region->uri().path());
+    }
+    std::sort(key.begin(), key.end());
+    key.erase(std::unique(key.begin(), key.end()), key.end());
+    return key;
   }
+}
 
-  return used_nodes_ptr;
+const SparsityCache::Entry* SparsityCache::find(const std::vector< Handle<Region> >& regions) const
+{
+  EntriesT::const_iterator found = m_entries.find(detail::sparsity_cache_key(regions));
+  return found == m_entries.end() ? nullptr : &found->second;
 }
 
+SparsityCache::Entry& SparsityCache::insert(const std::vector< Handle<Region> >& regions)
+{
+  return m_entries[detail::sparsity_cache_key(regions)];
+}
+
+void SparsityCache::clear()
+{
+  m_entries.clear();
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 
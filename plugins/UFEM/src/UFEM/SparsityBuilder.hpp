@@ -7,6 +7,10 @@
 #ifndef cf3_UFEM_SparsityBuilder_hpp
 #define cf3_UFEM_SparsityBuilder_hpp
 
+#include <map>
+
+#include "common/Component.hpp"
+
 #include "UFEM/LibUFEM.hpp"
 
 namespace cf3 {
@@ -30,6 +34,46 @@ namespace UFEM {
 /// Size is number of nodes + 1, so the last item is the size of node_connectivity
 UFEM_API boost::shared_ptr< common::List< Uint > > build_sparsity(const std::vector< Handle<mesh::Region> >& regions, const mesh::Dictionary& dictionary, std::vector<Uint>& node_connectivity, std::vector<Uint>& start_indices, common::List<Uint>& gids, common::List<Uint>& ranks, common::List<int>& used_node_map);
 
+/// Same as build_sparsity, but the result is cached on the dictionary for the given set of regions, so it is computed only once
+/// for all LSS systems built over the same regions. The cache is removed by the mesh when it is changed or loaded.
+/// node_connectivity and start_indices point to the cached arrays, which are shared by all systems. gids, ranks and used_node_map
+/// are filled with a copy, since each system owns and modifies these lists.
+UFEM_API boost::shared_ptr< common::List< Uint > > build_sparsity_cached(const std::vector< Handle<mesh::Region> >& regions, mesh::Dictionary& dictionary, boost::shared_ptr< const std::vector<Uint> >& node_connectivity, boost::shared_ptr< const std::vector<Uint> >& start_indices, common::List<Uint>& gids, common::List<Uint>& ranks, common::List<int>& used_node_map);
+
+/// Stores the results of build_sparsity for sets of regions. Created as child of the dictionary by build_sparsity_cached.
+class UFEM_API SparsityCache : public common::Component
+{
+public:
+  SparsityCache(const std::string& name);
+  virtual ~SparsityCache();
+
+  static std::string type_name () { return "SparsityCache"; }
+
+  /// Sparsity data for a set of regions
+  struct Entry
+  {
+    boost::shared_ptr< const std::vector<Uint> > node_connectivity;
+    boost::shared_ptr< const std::vector<Uint> > start_indices;
+    boost::shared_ptr< const std::vector<Uint> > gids;
+    boost::shared_ptr< const std::vector<Uint> > ranks;
+    boost::shared_ptr< const std::vector<int> > used_node_map;
+    boost::shared_ptr< const std::vector<Uint> > used_nodes;
+  };
+
+  /// Get the entry for the given regions, or null if it was not computed yet
+  const Entry* find(const std::vector< Handle<mesh::Region> >& regions) const;
+
+  /// Create the entry for the given regions
+  Entry& insert(const std::vector< Handle<mesh::Region> >& regions);
+
+  /// Remove all cached entries
+  void clear();
+
+private:
+  typedef std::map< std::vector<std::string>, Entry > EntriesT;
+  EntriesT m_entries;
+};
+
 ////////////////////////////////////////////////////////////////////////////////////////////
 
 } // UFEM
@@ -296,6 +296,57 @@ BOOST_AUTO_TEST_CASE( Sparsity3DHexaChannel )
   lss.matrix()->print("utest-ufem-buildsparsity_heat_matrix_3DHexaChannel.plt");
 }
 
+BOOST_AUTO_TEST_CASE( SparsityCached )
+{
+  // Setup a model
+  Model& model = *root.create_component<Model>("Model");
+  Domain& domain = model.create_domain("Domain");
+
+  Mesh& mesh = *domain.create_component<Mesh>("Mesh");
+  Tools::MeshGeneration::create_rectangle_tris(mesh, 5., 5., 5, 5);
+  const std::vector< Handle<Region> > regions(1, mesh.topology().handle<Region>());
+
+  // Reference result
+  std::vector<Uint> node_connectivity, starting_indices;
+  Handle< List<Uint> > gids = domain.create_component< List<Uint> >("GIDs");
+  Handle< List<Uint> > ranks = domain.create_component< List<Uint> >("Ranks");
+  Handle< List<int> > used_node_map = domain.create_component< List<int> >("used_node_map");
+  UFEM::build_sparsity(regions, mesh.geometry_fields(), node_connectivity, starting_indices, *gids, *ranks, *used_node_map);
+
+  // First call fills the cache, second call reads from it
+  boost::shared_ptr< const std::vector<Uint> > first_connectivity;
+  for(Uint i = 0; i != 2; ++i)
+  {
+    boost::shared_ptr< const std::vector<Uint> > cached_connectivity, cached_indices;
+    Handle< List<Uint> > cached_gids = domain.create_component< List<Uint> >("CachedGIDs");
+    Handle< List<Uint> > cached_ranks = domain.create_component< List<Uint> >("CachedRanks");
+    Handle< List<int> > cached_used_node_map = domain.create_component< List<int> >("CachedUsedNodeMap");
+    UFEM::build_sparsity_cached(regions, mesh.geometry_fields(), cached_connectivity, cached_indices, *cached_gids, *cached_ranks, *cached_used_node_map);
+
+    BOOST_CHECK(*cached_connectivity == node_connectivity);
+    BOOST_CHECK(*cached_indices == starting_indices);
+    BOOST_CHECK(cached_gids->array() == gids->array());
+    BOOST_CHECK(cached_ranks->array() == ranks->array());
+    BOOST_CHECK(cached_used_node_map->array() == used_node_map->array());
+
+    domain.remove_component(*cached_gids);
+    domain.remove_component(*cached_ranks);
+    domain.remove_component(*cached_used_node_map);
+
+    // All systems share the same cached arrays
+    if(i == 0)
+      first_connectivity = cached_connectivity;
+    else
+      BOOST_CHECK(cached_connectivity == first_connectivity);
+  }
+
+  BOOST_CHECK(is_not_null(mesh.geometry_fields().get_child("SparsityCache")));
+
+  // Changing the mesh drops the cache
+  mesh.raise_mesh_changed();
+  BOOST_CHECK(is_null(mesh.geometry_fields().get_child("SparsityCache")));
+}
+
 BOOST_AUTO_TEST_CASE( Heat1DComponent )
 {
   Core::instance().environment().options().set("log_level", 4u);
@@ -157,6 +157,48 @@ BOOST_AUTO_TEST_CASE ( test_Map_copy_std_map )
 
 //////////////////////////////////////////////////////////////////////////////
 
+struct IsOdd
+{
+  bool operator()(const std::pair<Uint,Uint>& v) const { return v.second % 2 == 1; }
+};
+
+BOOST_AUTO_TEST_CASE ( test_Map_merge_erase_if )
+{
+  boost::shared_ptr< Map<Uint,Uint> > map_ptr ( allocate_component< Map<Uint,Uint> > ("map"));
+  Map<Uint,Uint>& map = *map_ptr;
+
+  map.push_back(10u, 0u);
+  map.push_back(30u, 1u);
+  map.push_back(20u, 2u);
+  map.sort_keys();
+
+  std::vector< std::pair<Uint,Uint> > batch;
+  batch.push_back(std::make_pair(25u, 3u));
+  batch.push_back(std::make_pair(5u, 4u));
+  map.merge(batch);
+
+  BOOST_CHECK_EQUAL(map.size(), 5u);
+  Uint prev_key = 0;
+  for(Map<Uint,Uint>::const_iterator it = map.begin(); it != map.end(); ++it)
+  {
+    BOOST_CHECK(it->first > prev_key);
+    prev_key = it->first;
+  }
+  BOOST_CHECK_EQUAL(map[25u], 3u);
+  BOOST_CHECK_EQUAL(map[5u], 4u);
+  BOOST_CHECK_EQUAL(map[30u], 1u);
+
+  map.erase_if(IsOdd());
+  BOOST_CHECK_EQUAL(map.size(), 3u);
+  BOOST_CHECK(map.exists(10u));
+  BOOST_CHECK(map.exists(20u));
+  BOOST_CHECK(map.exists(5u));
+  BOOST_CHECK(!map.exists(25u));
+  BOOST_CHECK(!map.exists(30u));
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
 
 BOOST_AUTO_TEST_SUITE_END()
 
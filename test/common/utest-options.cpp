@@ -113,6 +113,38 @@ BOOST_AUTO_TEST_CASE( ResetOptions )
   BOOST_CHECK_EQUAL(root.options().option("test_reset").value_str(), "test01");
 }
 
+BOOST_AUTO_TEST_CASE( ValueHandle )
+{
+  ExceptionManager::instance().ExceptionDumps = false;
+  ExceptionManager::instance().ExceptionAborts = false;
+  ExceptionManager::instance().ExceptionOutputs = false;
+
+  Component& root = Core::instance().root();
+
+  root.options().add("test_handle", 1u);
+  OptionValue<Uint> handle = root.options().value_handle<Uint>("test_handle");
+  const OptionValue<Uint> handle_copy = root.options().value_handle<Uint>("test_handle");
+  BOOST_CHECK(handle.is_valid());
+  BOOST_CHECK_EQUAL(*handle, 1u);
+
+  root.options().set("test_handle", 5u);
+  BOOST_CHECK_EQUAL(*handle, 5u);
+  BOOST_CHECK_EQUAL(handle_copy.get(), 5u);
+
+  root.reset_options();
+  BOOST_CHECK_EQUAL(*handle, 1u);
+
+  std::vector<Real> def(3, 1.);
+  root.options().add("test_array_handle", def);
+  OptionValue< std::vector<Real> > array_handle = root.options().value_handle< std::vector<Real> >("test_array_handle");
+  BOOST_CHECK_EQUAL(array_handle->size(), 3u);
+  root.options().set("test_array_handle", std::vector<Real>(5, 2.));
+  BOOST_CHECK_EQUAL(array_handle->size(), 5u);
+  BOOST_CHECK_EQUAL((*array_handle)[4], 2.);
+
+  BOOST_CHECK_THROW(root.options().value_handle<Real>("test_handle"), CastingFailed);
+  BOOST_CHECK(!OptionValue<Real>().is_valid());
+}
 
 //////////////////////////////////////////////////////////////////////////////
 
@@ -0,0 +1,102 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+// this file is en-block included into utest-parallel-collective.cpp
+// do not include anything here, rather in utest-parallel-collective.cpp
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct PESparseAllToAllFixture
+{
+  /// common setup for each test case
+  PESparseAllToAllFixture()
+  {
+    nproc=PE::Comm::instance().size();
+    irank=PE::Comm::instance().rank();
+  }
+
+  /// data sent from rank src to rank dst
+  static std::vector<double> message(const int src, const int dst)
+  {
+    std::vector<double> result(src+1);
+    for (int i=0; i<=src; i++) result[i]=src*1000.+dst+0.5*i;
+    return result;
+  }
+
+  /// true if rank src sends to rank dst: only to the next and the third next rank
+  bool sends_to(const int src, const int dst) const
+  {
+    return dst==(src+1)%nproc || dst==(src+3)%nproc;
+  }
+
+  /// number of processes
+  int nproc;
+  /// rank of process
+  int irank;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_FIXTURE_TEST_SUITE( PESparseAllToAllSuite, PESparseAllToAllFixture )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( sparse_all_to_all )
+{
+  PEProcessSortedExecute(-1,CFinfo << "Testing sparse_all_to_all " << irank << "/" << nproc << CFendl; );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( sparse_all_to_all_neighbours )
+{
+  std::map< int, std::vector<double> > snd, rcv;
+  for (int dst=0; dst<nproc; dst++)
+    if (sends_to(irank,dst)) snd[dst]=message(irank,dst);
+
+  // repeated exchanges must not mix up messages
+  for (int repeat=0; repeat<3; repeat++)
+  {
+    PE::Comm::instance().sparse_all_to_all(snd,rcv);
+
+    int nb_expected=0;
+    for (int src=0; src<nproc; src++)
+    {
+      if (!sends_to(src,irank)) continue;
+      ++nb_expected;
+      BOOST_REQUIRE( rcv.find(src)!=rcv.end() );
+      const std::vector<double> expected=message(src,irank);
+      BOOST_CHECK_EQUAL_COLLECTIONS( rcv[src].begin(), rcv[src].end(), expected.begin(), expected.end() );
+    }
+    BOOST_CHECK_EQUAL( (int)rcv.size() , nb_expected );
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( sparse_all_to_all_empty )
+{
+  // only rank 0 sends, and empty vectors are not delivered
+  std::map< int, std::vector<int> > snd, rcv;
+  for (int dst=0; dst<nproc; dst++)
+  {
+    if (irank==0) snd[dst].assign(dst+1,dst);
+    else snd[dst].clear();
+  }
+
+  PE::Comm::instance().sparse_all_to_all(snd,rcv);
+
+  BOOST_CHECK_EQUAL( rcv.size() , 1u );
+  BOOST_REQUIRE( rcv.find(0)!=rcv.end() );
+  BOOST_CHECK_EQUAL( (int)rcv[0].size() , irank+1 );
+  for (int i=0; i<(int)rcv[0].size(); i++) BOOST_CHECK_EQUAL( rcv[0][i] , irank );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
@@ -13,6 +13,7 @@
 
 ////////////////////////////////////////////////////////////////////////////////
 
+#include <map>
 #include <vector>
 
 #include <boost/test/unit_test.hpp>
@@ -26,6 +27,7 @@
 #include "common/PE/datatype.hpp"
 #include "common/PE/operations.hpp"
 #include "common/PE/all_to_all.hpp"
+#include "common/PE/sparse_all_to_all.hpp"
 #include "common/PE/all_reduce.hpp"
 #include "common/PE/reduce.hpp"
 #include "common/PE/scatter.hpp"
@@ -75,6 +77,7 @@ BOOST_FIXTURE_TEST_CASE( init, PECollectiveFixture )
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "test/common/utest-parallel-collective-all_to_all.hpp"
+#include "test/common/utest-parallel-collective-sparse_all_to_all.hpp"
 #include "test/common/utest-parallel-collective-all_reduce.hpp"
 #include "test/common/utest-parallel-collective-reduce.hpp"
 #include "test/common/utest-parallel-collective-scatter.hpp"
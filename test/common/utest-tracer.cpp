@@ -0,0 +1,149 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for the Tracer"
+
+#include <fstream>
+#include <sstream>
+
+#include <boost/test/unit_test.hpp>
+
+#include "common/Core.hpp"
+#include "common/Environment.hpp"
+#include "common/OptionList.hpp"
+#include "common/Tracer.hpp"
+#include "common/URI.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+
+////////////////////////////////////////////////////////////////////////////////
+
+void traced_leaf()
+{
+  CF3_TRACE_SCOPE("leaf");
+}
+
+void traced_parent(const Uint nb_leaves)
+{
+  CF3_TRACE_SCOPE("parent");
+  for(Uint i = 0; i != nb_leaves; ++i)
+    traced_leaf();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE( TracerSuite )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( Disabled )
+{
+  Tracer& tracer = Tracer::instance();
+  BOOST_CHECK(!tracer.is_enabled());
+
+  traced_parent(3);
+
+  const std::vector<TraceStatistics> stats = tracer.statistics();
+  BOOST_CHECK_EQUAL(stats.size(), 2u);
+  BOOST_CHECK_EQUAL(stats[0].count, 0u);
+  BOOST_CHECK_EQUAL(stats[1].count, 0u);
+}
+
+BOOST_AUTO_TEST_CASE( Nesting )
+{
+  Tracer& tracer = Tracer::instance();
+  Core::instance().environment().options().set("tracing", true);
+  Core::instance().environment().options().set("tracing_events", 100u);
+  BOOST_CHECK(tracer.is_enabled());
+
+  traced_parent(3);
+  traced_parent(2);
+
+  const std::vector<TraceStatistics> stats = tracer.statistics();
+  BOOST_CHECK_EQUAL(tracer.region_name(0), "parent");
+  BOOST_CHECK_EQUAL(tracer.region_name(1), "leaf");
+  BOOST_CHECK_EQUAL(stats[0].count, 2u);
+  BOOST_CHECK_EQUAL(stats[1].count, 5u);
+  BOOST_CHECK(stats[0].total >= stats[1].total);
+  BOOST_CHECK(stats[1].minimum <= stats[1].maximum);
+}
+
+BOOST_AUTO_TEST_CASE( UnbalancedEnd )
+{
+  Tracer& tracer = Tracer::instance();
+  const Uint outer = tracer.region("outer");
+  const Uint inner = tracer.region("inner");
+
+  // Simulates an exception skipping the end of the inner region
+  tracer.begin(outer);
+  tracer.begin(inner);
+  tracer.end(outer);
+
+  const std::vector<TraceStatistics> stats = tracer.statistics();
+  BOOST_CHECK_EQUAL(stats[outer].count, 1u);
+  BOOST_CHECK_EQUAL(stats[inner].count, 0u);
+}
+
+BOOST_AUTO_TEST_CASE( Output )
+{
+  Tracer& tracer = Tracer::instance();
+
+  std::stringstream stats_stream;
+  tracer.print_statistics(stats_stream);
+  BOOST_CHECK(stats_stream.str().find("parent") != std::string::npos);
+  BOOST_CHECK(stats_stream.str().find("leaf") != std::string::npos);
+
+  tracer.write_chrome_trace(URI("utest-tracer.json"));
+  std::ifstream trace_file("utest-tracer.json");
+  const std::string trace((std::istreambuf_iterator<char>(trace_file)), std::istreambuf_iterator<char>());
+  BOOST_CHECK_EQUAL(trace[0], '[');
+  BOOST_CHECK(trace.find("\"name\":\"leaf\"") != std::string::npos);
+  BOOST_CHECK(trace.find("\"ph\":\"X\"") != std::string::npos);
+
+  tracer.clear();
+  BOOST_CHECK_EQUAL(tracer.statistics()[0].count, 0u);
+}
+
+BOOST_AUTO_TEST_CASE( BoundedEvents )
+{
+  Tracer& tracer = Tracer::instance();
+
+  // Only the most recent events are kept, while the statistics count all executions
+  Core::instance().environment().options().set("tracing_events", 4u);
+  traced_parent(10);
+  BOOST_CHECK_EQUAL(tracer.statistics()[1].count, 10u);
+
+  tracer.write_chrome_trace(URI("utest-tracer-bounded.json"));
+  std::ifstream trace_file("utest-tracer-bounded.json");
+  const std::string trace((std::istreambuf_iterator<char>(trace_file)), std::istreambuf_iterator<char>());
+  Uint nb_events = 0;
+  for(std::size_t pos = trace.find("\"ph\":\"X\""); pos != std::string::npos; pos = trace.find("\"ph\":\"X\"", pos+1))
+    ++nb_events;
+  BOOST_CHECK_EQUAL(nb_events, 4u);
+  // The parent ends last, so it is the last event
+  BOOST_CHECK(trace.rfind("\"name\":\"parent\"") > trace.rfind("\"name\":\"leaf\""));
+
+  // Statistics only, which is the default
+  Core::instance().environment().options().set("tracing_events", 0u);
+  traced_parent(10);
+  BOOST_CHECK_EQUAL(tracer.statistics()[1].count, 20u);
+  tracer.write_chrome_trace(URI("utest-tracer-bounded.json"));
+  std::ifstream empty_file("utest-tracer-bounded.json");
+  const std::string empty_trace((std::istreambuf_iterator<char>(empty_file)), std::istreambuf_iterator<char>());
+  BOOST_CHECK(empty_trace.find("\"ph\":\"X\"") == std::string::npos);
+
+  tracer.clear();
+  Core::instance().environment().options().set("tracing", false);
+  BOOST_CHECK(!tracer.is_enabled());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,87 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for the mixed precision LSS solution strategy"
+
+#include <boost/test/unit_test.hpp>
+
+#include "common/Core.hpp"
+#include "common/OptionList.hpp"
+
+#include "common/PE/Comm.hpp"
+
+#include "math/LSS/System.hpp"
+#include "math/LSS/SolutionStrategy.hpp"
+#include "math/LSS/Trilinos/MixedPrecisionStrategy.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+using namespace cf3::common::PE;
+using namespace cf3::math;
+
+BOOST_AUTO_TEST_SUITE( MixedPrecisionSuite )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( Init )
+{
+  Comm::instance().init(boost::unit_test::framework::master_test_suite().argc, boost::unit_test::framework::master_test_suite().argv);
+}
+
+// Single precision inner solves, with the outer iterations reaching double precision accuracy
+BOOST_AUTO_TEST_CASE( SolveMixed )
+{
+  Component& root = Core::instance().root();
+  Handle<LSS::System> lss = root.create_component<LSS::System>("LSSMixed");
+  lss->options().set("matrix_builder", std::string("cf3.math.LSS.TrilinosCrsMatrix"));
+  lss->options().set("solution_strategy", std::string("cf3.math.LSS.MixedPrecisionStrategy"));
+  lss->read_native(URI(boost::unit_test::framework::master_test_suite().argv[1]));
+
+  Handle<LSS::SolutionStrategy> strategy = lss->solution_strategy();
+  strategy->options().set("tolerance", 1e-8);
+  strategy->options().set("max_inner_iterations", 2000u);
+  lss->solve();
+  BOOST_CHECK_LT(strategy->compute_residual(), 1e-8);
+
+  // Most of the work must have been done in single precision
+  Handle<LSS::MixedPrecisionStrategy> mixed(strategy);
+  BOOST_REQUIRE(is_not_null(mixed));
+  BOOST_CHECK_GT(mixed->single_precision_iterations(), 0u);
+  BOOST_CHECK_GT(mixed->single_precision_iterations(), mixed->double_precision_iterations());
+}
+
+// All corrections in double precision
+BOOST_AUTO_TEST_CASE( SolveDouble )
+{
+  Component& root = Core::instance().root();
+  Handle<LSS::System> lss = root.create_component<LSS::System>("LSSDouble");
+  lss->options().set("matrix_builder", std::string("cf3.math.LSS.TrilinosCrsMatrix"));
+  lss->options().set("solution_strategy", std::string("cf3.math.LSS.MixedPrecisionStrategy"));
+  lss->read_native(URI(boost::unit_test::framework::master_test_suite().argv[1]));
+
+  Handle<LSS::SolutionStrategy> strategy = lss->solution_strategy();
+  strategy->options().set("single_precision", false);
+  strategy->options().set("max_inner_iterations", 2000u);
+  lss->solve();
+  BOOST_CHECK_LT(strategy->compute_residual(), 1e-8);
+
+  Handle<LSS::MixedPrecisionStrategy> mixed(strategy);
+  BOOST_REQUIRE(is_not_null(mixed));
+  BOOST_CHECK_EQUAL(mixed->single_precision_iterations(), 0u);
+  BOOST_CHECK_GT(mixed->double_precision_iterations(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE( Finalize )
+{
+  Comm::instance().finalize();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
@@ -209,6 +209,124 @@ BOOST_AUTO_TEST_CASE( test_complete_system )
 
 ////////////////////////////////////////////////////////////////////////////////
 
+BOOST_AUTO_TEST_CASE( test_batched_dirichlet )
+{
+  boost::shared_ptr<common::PE::CommPattern> cp_ptr = common::allocate_component<common::PE::CommPattern>("commpattern");
+  common::PE::CommPattern& cp = *cp_ptr;
+  build_commpattern(cp);
+  boost::shared_ptr<LSS::System> sys(common::allocate_component<LSS::System>("sys"));
+  sys->options().option("matrix_builder").change_value(matrix_builder);
+  build_system(*sys,cp);
+
+  const std::vector<Uint> blockrows(1, irank == 0 ? 1 : 0);
+  const std::vector<Uint> ieqs(1, 0);
+
+  // The second application reuses the positions of the eliminated entries on the reset matrix
+  for(Uint iter = 0; iter != 2; ++iter)
+  {
+    const Real value = iter == 0 ? 10. : 5.;
+    sys->reset();
+    sys->matrix()->set_row(0, 0, 2, 1);
+    sys->matrix()->set_row(1, 0, 2, 1);
+    sys->matrix()->set_row(2, 0, 2, 1);
+
+    sys->dirichlet(blockrows, ieqs, std::vector<Real>(1, value), true);
+
+    Real val;
+    if(irank == 0)
+    {
+      sys->matrix()->get_value(0, 0, val);
+      BOOST_CHECK_EQUAL(val, 2.);
+      sys->matrix()->get_value(1, 0, val);
+      BOOST_CHECK_EQUAL(val, 0.);
+      sys->matrix()->get_value(0, 1, val);
+      BOOST_CHECK_EQUAL(val, 0.);
+      sys->matrix()->get_value(1, 1, val);
+      BOOST_CHECK_EQUAL(val, 1.);
+      sys->matrix()->get_value(2, 1, val);
+      BOOST_CHECK_EQUAL(val, 0.);
+
+      sys->rhs()->get_value(0, val);
+      BOOST_CHECK_EQUAL(val, -value);
+      sys->rhs()->get_value(1, val);
+      BOOST_CHECK_EQUAL(val, value);
+      sys->solution()->get_value(1, val);
+      BOOST_CHECK_EQUAL(val, value);
+    }
+    else
+    {
+      sys->matrix()->get_value(0, 1, val);
+      BOOST_CHECK_EQUAL(val, 0.);
+      sys->matrix()->get_value(1, 1, val);
+      BOOST_CHECK_EQUAL(val, 2.);
+      sys->matrix()->get_value(2, 2, val);
+      BOOST_CHECK_EQUAL(val, 2.);
+
+      sys->rhs()->get_value(0, val);
+      BOOST_CHECK_EQUAL(val, value);
+      sys->rhs()->get_value(1, val);
+      BOOST_CHECK_EQUAL(val, -value);
+      sys->rhs()->get_value(2, val);
+      BOOST_CHECK_EQUAL(val, 0.);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( test_batched_dirichlet_patches )
+{
+  boost::shared_ptr<common::PE::CommPattern> cp_ptr = common::allocate_component<common::PE::CommPattern>("commpattern");
+  common::PE::CommPattern& cp = *cp_ptr;
+  build_commpattern(cp);
+  boost::shared_ptr<LSS::System> batched(common::allocate_component<LSS::System>("batched"));
+  batched->options().option("matrix_builder").change_value(matrix_builder);
+  build_system(*batched,cp);
+  boost::shared_ptr<LSS::System> single(common::allocate_component<LSS::System>("single"));
+  single->options().option("matrix_builder").change_value(matrix_builder);
+  build_system(*single,cp);
+
+  // Two patches of owned nodes, applied one after the other as with one node loop per patch
+  const Uint first_owned = irank == 0 ? 0 : 1;
+  const std::vector<Uint> ieqs(1, 0);
+
+  // Each assembly alternates between the patches, so each set of conditions must keep its own eliminated entries
+  for(Uint iter = 0; iter != 3; ++iter)
+  {
+    batched->reset();
+    single->reset();
+    for(Uint i = 0; i != 3; ++i)
+    {
+      batched->matrix()->set_row(i, 0, 2, 1);
+      single->matrix()->set_row(i, 0, 2, 1);
+    }
+
+    for(Uint patch = 0; patch != 2; ++patch)
+    {
+      const Uint blockrow = first_owned + patch;
+      const Real value = 10.*(patch+1) + iter;
+      batched->dirichlet(std::vector<Uint>(1, blockrow), ieqs, std::vector<Real>(1, value), true);
+      single->matrix()->symmetric_dirichlet(blockrow, 0, value, *single->rhs());
+    }
+
+    Real batched_val, single_val;
+    for(Uint row = 0; row != 3; ++row)
+    {
+      for(Uint c = starting_indices[row]; c != starting_indices[row+1]; ++c)
+      {
+        batched->matrix()->get_value(row, node_connectivity[c], batched_val);
+        single->matrix()->get_value(row, node_connectivity[c], single_val);
+        BOOST_CHECK_EQUAL(batched_val, single_val);
+      }
+      batched->rhs()->get_value(row, batched_val);
+      single->rhs()->get_value(row, single_val);
+      BOOST_CHECK_EQUAL(batched_val, single_val);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 BOOST_AUTO_TEST_CASE( finalize_mpi )
 {
   CFinfo.setFilterRankZero(true);
@@ -0,0 +1,139 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for cf3::math::FFT"
+
+#include <cmath>
+
+#include <boost/foreach.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "common/BasicExceptions.hpp"
+
+#include "math/Consts.hpp"
+#include "math/FFT.hpp"
+
+using namespace cf3;
+using namespace cf3::math;
+
+typedef FFT::ComplexT ComplexT;
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+/// Reference O(n^2) transform
+std::vector<ComplexT> direct_dft(const std::vector<ComplexT>& x)
+{
+  const Uint n = x.size();
+  std::vector<ComplexT> result(n, ComplexT(0., 0.));
+  for(Uint k = 0; k != n; ++k)
+  {
+    for(Uint j = 0; j != n; ++j)
+    {
+      const Real angle = -2.*Consts::pi()*static_cast<Real>((j*k) % n)/static_cast<Real>(n);
+      result[k] += x[j]*ComplexT(::cos(angle), ::sin(angle));
+    }
+  }
+  return result;
+}
+
+std::vector<ComplexT> test_sequence(const Uint n)
+{
+  std::vector<ComplexT> x(n);
+  for(Uint j = 0; j != n; ++j)
+    x[j] = ComplexT(::sin(0.3*j) + 0.1*j, ::cos(1.7*j*j));
+  return x;
+}
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE( FFTSuite )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( ForwardAndInverse )
+{
+  // Powers of two, mixed radix and prime sizes
+  const Uint sizes[] = {1, 2, 3, 4, 7, 8, 12, 15, 16, 30, 49, 60, 64, 97, 128};
+  BOOST_FOREACH(const Uint n, sizes)
+  {
+    const FFT fft(n);
+    const std::vector<ComplexT> x = test_sequence(n);
+    const std::vector<ComplexT> reference = direct_dft(x);
+
+    std::vector<ComplexT> transformed = x;
+    fft.forward(&transformed[0]);
+    for(Uint k = 0; k != n; ++k)
+      BOOST_CHECK_SMALL(std::abs(transformed[k] - reference[k]), 1e-10*n);
+
+    fft.inverse(&transformed[0]);
+    for(Uint j = 0; j != n; ++j)
+      BOOST_CHECK_SMALL(std::abs(transformed[j]/static_cast<Real>(n) - x[j]), 1e-12*n);
+  }
+}
+
+BOOST_AUTO_TEST_CASE( PowerSpectra )
+{
+  const Uint n = 24;
+  const FFT fft(n);
+
+  // Two interleaved real sequences
+  std::vector<Real> values(2*n);
+  for(Uint j = 0; j != n; ++j)
+  {
+    values[2*j] = ::sin(2.*Consts::pi()*3.*j/n) + 0.5;
+    values[2*j+1] = ::cos(0.4*j*j);
+  }
+
+  std::vector<Real> reference(n, 0.);
+  std::vector<ComplexT> a(n), b(n);
+  for(Uint j = 0; j != n; ++j)
+  {
+    a[j] = values[2*j];
+    b[j] = values[2*j+1];
+  }
+  const std::vector<ComplexT> a_hat = direct_dft(a);
+  const std::vector<ComplexT> b_hat = direct_dft(b);
+  for(Uint k = 0; k != n; ++k)
+    reference[k] = std::norm(a_hat[k]) + std::norm(b_hat[k]);
+
+  std::vector<Real> paired(n, 0.);
+  fft.add_power_spectra(&values[0], &values[1], 2, &paired[0]);
+
+  std::vector<Real> single(n, 0.);
+  fft.add_power_spectrum(&values[0], 2, &single[0]);
+  fft.add_power_spectrum(&values[1], 2, &single[0]);
+
+  for(Uint k = 0; k != n; ++k)
+  {
+    BOOST_CHECK_SMALL(paired[k] - reference[k], 1e-10);
+    BOOST_CHECK_SMALL(single[k] - reference[k], 1e-10);
+  }
+
+  // The sine with 3 periods and the constant show up in modes 3, n-3 and 0
+  std::vector<Real> sine_spectrum(n, 0.);
+  fft.add_power_spectrum(&values[0], 2, &sine_spectrum[0]);
+  BOOST_CHECK_CLOSE(sine_spectrum[0], 0.25*n*n, 1e-8);
+  BOOST_CHECK_CLOSE(sine_spectrum[3], 0.25*n*n, 1e-8);
+  BOOST_CHECK_CLOSE(sine_spectrum[n-3], 0.25*n*n, 1e-8);
+  BOOST_CHECK_SMALL(sine_spectrum[1], 1e-10);
+}
+
+BOOST_AUTO_TEST_CASE( ZeroSize )
+{
+  BOOST_CHECK_THROW(FFT(0), common::BadValue);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,219 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for direct generation in cf3::mesh::BlockMesh::ChannelGenerator"
+
+#include <algorithm>
+#include <set>
+
+#include <boost/test/unit_test.hpp>
+
+#include "common/Core.hpp"
+#include "common/Foreach.hpp"
+#include "common/List.hpp"
+#include "common/OptionList.hpp"
+#include "common/PropertyList.hpp"
+
+#include "common/PE/Comm.hpp"
+
+#include "mesh/BlockMesh/ChannelGenerator.hpp"
+#include "mesh/Dictionary.hpp"
+#include "mesh/Elements.hpp"
+#include "mesh/ElementType.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/Region.hpp"
+#include "mesh/Space.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+using namespace cf3::mesh;
+
+//////////////////////////////////////////////////////////////////////////////
+
+struct ChannelGeneratorDirectFixture
+{
+  ChannelGeneratorDirectFixture() :
+    x_segs(12),
+    y_segs_half(4),
+    z_segs(6),
+    length(12.),
+    half_height(0.5),
+    width(6.)
+  {
+    if(!PE::Comm::instance().is_active())
+      PE::Comm::instance().init(boost::unit_test::framework::master_test_suite().argc, boost::unit_test::framework::master_test_suite().argv);
+  }
+
+  /// Generate a channel in a new mesh
+  Mesh& generate(const std::string& name, const bool direct)
+  {
+    Component& root = Core::instance().root();
+    Mesh& mesh = *root.create_component<Mesh>(name);
+    BlockMesh::ChannelGenerator& generator = *root.create_component<BlockMesh::ChannelGenerator>(name + "_generator");
+    generator.options().set("mesh", mesh.uri());
+    generator.options().set("x_segments", x_segs);
+    generator.options().set("y_segments_half", y_segs_half);
+    generator.options().set("z_segments", z_segs);
+    generator.options().set("length", length);
+    generator.options().set("half_height", half_height);
+    generator.options().set("width", width);
+    generator.options().set("cell_overlap", 1u);
+    generator.options().set("z_parts", PE::Comm::instance().size() % 2 == 0 ? 2u : 1u);
+    generator.options().set("direct", direct);
+    generator.execute();
+    return mesh;
+  }
+
+  /// Sum of a value over all ranks
+  Real global_sum(const Real local) const
+  {
+    Real result = local;
+    PE::Comm::instance().all_reduce(PE::plus(), &local, 1, &result);
+    return result;
+  }
+
+  /// Sorted unique Y coordinates of the local nodes
+  std::vector<Real> y_coordinates(const Mesh& mesh) const
+  {
+    const Field& coords = mesh.geometry_fields().coordinates();
+    std::vector<Real> result;
+    for(Uint i = 0; i != coords.size(); ++i)
+      result.push_back(coords[i][YY]);
+    std::sort(result.begin(), result.end());
+    std::vector<Real>::iterator last = result.begin();
+    for(std::vector<Real>::iterator it = result.begin(); it != result.end(); ++it)
+    {
+      if(last == result.begin() || fabs(*it - *(last-1)) > 1e-12)
+        *last++ = *it;
+    }
+    result.erase(last, result.end());
+    return result;
+  }
+
+  const Uint x_segs;
+  const Uint y_segs_half;
+  const Uint z_segs;
+  const Real length;
+  const Real half_height;
+  const Real width;
+};
+
+BOOST_FIXTURE_TEST_SUITE( ChannelGeneratorDirectSuite, ChannelGeneratorDirectFixture )
+
+//////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( Numbering )
+{
+  Mesh& mesh = generate("direct", true);
+  const Dictionary& geometry = mesh.geometry_fields();
+  const Uint rank = PE::Comm::instance().rank();
+
+  // Owned node global indices form a single range, and all ranks together own every node exactly once
+  Uint nb_owned = 0;
+  Uint min_gid = std::numeric_limits<Uint>::max();
+  Uint max_gid = 0;
+  std::set<Uint> gids;
+  for(Uint i = 0; i != geometry.size(); ++i)
+  {
+    BOOST_CHECK(gids.insert(geometry.glb_idx()[i]).second);
+    if(geometry.is_ghost(i))
+    {
+      BOOST_CHECK(geometry.rank()[i] < PE::Comm::instance().size());
+      continue;
+    }
+    ++nb_owned;
+    min_gid = std::min(min_gid, geometry.glb_idx()[i]);
+    max_gid = std::max(max_gid, geometry.glb_idx()[i]);
+  }
+  BOOST_CHECK_EQUAL(max_gid - min_gid + 1, nb_owned);
+  const Real nb_nodes = static_cast<Real>((x_segs+1)*(2*y_segs_half+1)*(z_segs+1));
+  BOOST_CHECK_EQUAL(global_sum(nb_owned), nb_nodes);
+
+  // Owned elements per region
+  Real volume = 0.;
+  Real bottom_area = 0.;
+  Real left_area = 0.;
+  boost_foreach(const Elements& elements, find_components_recursively<Elements>(mesh.topology()))
+  {
+    const Space& space = elements.geometry_space();
+    for(Uint e = 0; e != elements.size(); ++e)
+    {
+      if(elements.rank()[e] != rank)
+        continue;
+      const RealMatrix nodes = space.get_coordinates(e);
+      if(elements.parent()->name() == "interior")
+        volume += elements.element_type().volume(nodes);
+      else if(elements.parent()->name() == "bottom")
+        bottom_area += elements.element_type().area(nodes);
+      else if(elements.parent()->name() == "left")
+        left_area += elements.element_type().area(nodes);
+    }
+  }
+  BOOST_CHECK_CLOSE(global_sum(volume), length*2.*half_height*width, 1e-8);
+  BOOST_CHECK_CLOSE(global_sum(bottom_area), length*width, 1e-8);
+  BOOST_CHECK_CLOSE(global_sum(left_area), 2.*half_height*width, 1e-8);
+}
+
+BOOST_AUTO_TEST_CASE( Synchronize )
+{
+  Mesh& mesh = *Handle<Mesh>(Core::instance().root().get_child("direct"));
+  Dictionary& geometry = mesh.geometry_fields();
+  const Field& coords = geometry.coordinates();
+
+  // Ghost nodes must receive the coordinates computed by their owner
+  Field& synced = geometry.create_field("synced_coordinates", "x,y,z");
+  for(Uint i = 0; i != geometry.size(); ++i)
+  {
+    for(Uint d = 0; d != 3; ++d)
+      synced[i][d] = geometry.is_ghost(i) ? -1. : coords[i][d];
+  }
+  synced.synchronize();
+  for(Uint i = 0; i != geometry.size(); ++i)
+  {
+    for(Uint d = 0; d != 3; ++d)
+      BOOST_CHECK_EQUAL(synced[i][d], coords[i][d]);
+  }
+}
+
+BOOST_AUTO_TEST_CASE( CompareBlocks )
+{
+  Mesh& direct = *Handle<Mesh>(Core::instance().root().get_child("direct"));
+  Mesh& blocks = generate("blocks", false);
+
+  Real direct_cells = 0.;
+  Real block_cells = 0.;
+  boost_foreach(const Elements& elements, find_components_recursively_with_filter<Elements>(direct.topology(), IsElementsVolume()))
+  {
+    for(Uint e = 0; e != elements.size(); ++e)
+      direct_cells += !elements.is_ghost(e);
+  }
+  boost_foreach(const Elements& elements, find_components_recursively_with_filter<Elements>(blocks.topology(), IsElementsVolume()))
+  {
+    for(Uint e = 0; e != elements.size(); ++e)
+      block_cells += !elements.is_ghost(e);
+  }
+  BOOST_CHECK_EQUAL(global_sum(direct_cells), global_sum(block_cells));
+
+  // The wall normal grading must be the same as for the blocks
+  const std::vector<Real> direct_y = y_coordinates(direct);
+  const std::vector<Real> block_y = y_coordinates(blocks);
+  BOOST_REQUIRE_EQUAL(direct_y.size(), block_y.size());
+  for(Uint i = 0; i != direct_y.size(); ++i)
+    BOOST_CHECK_SMALL(direct_y[i] - block_y[i], 1e-12);
+}
+
+BOOST_AUTO_TEST_CASE( Finalize )
+{
+  PE::Comm::instance().finalize();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+//////////////////////////////////////////////////////////////////////////////
@@ -7,20 +7,27 @@
 #define BOOST_TEST_DYN_LINK
 #define BOOST_TEST_MODULE "Tests mesh::actions::SurfaceIntegral"
 
+#include <boost/mpl/vector.hpp>
 #include <boost/test/unit_test.hpp>
 
+#include "common/FindComponents.hpp"
+#include "common/Foreach.hpp"
 #include "common/OptionList.hpp"
 #include "common/Core.hpp"
 #include "common/PE/Comm.hpp"
 
 #include "mesh/actions/CreateField.hpp"
+#include "mesh/actions/FieldIntegralKernel.hpp"
 #include "mesh/actions/SurfaceIntegral.hpp"
 #include "mesh/actions/VolumeIntegral.hpp"
 
 #include "mesh/Mesh.hpp"
 #include "mesh/Region.hpp"
 #include "mesh/Dictionary.hpp"
+#include "mesh/ElementTypeDispatch.hpp"
+#include "mesh/ElementTypes.hpp"
 #include "mesh/Field.hpp"
+#include "mesh/Quadrature.hpp"
 #include "mesh/SimpleMeshGenerator.hpp"
 
 using namespace cf3;
@@ -129,6 +136,59 @@ BOOST_AUTO_TEST_CASE( IntegrateOnCube )
   BOOST_CHECK_EQUAL(volume_integral,1000.);
 }
 
+BOOST_AUTO_TEST_CASE( RepeatedIntegration )
+{
+  Handle<MeshGenerator> mesh_generator = Core::instance().root().create_component<SimpleMeshGenerator>("generate_linear");
+  mesh_generator->options().set("mesh",Core::instance().root().uri()/"linear");
+  mesh_generator->options().set("lengths",std::vector<Real>(2,10.));
+  mesh_generator->options().set("nb_cells",std::vector<Uint>(2,5));
+  Mesh& mesh = mesh_generator->generate();
+
+  // Linear field, integrated exactly by the second order quadrature
+  boost::shared_ptr<CreateField> create_field = allocate_component<CreateField>("create_field");
+  std::vector<std::string> functions;
+  functions.push_back("f=x");
+  create_field->options().set("functions",functions);
+  create_field->options().set("name",std::string("field"));
+  create_field->options().set("dict",mesh.geometry_fields().uri());
+  create_field->transform(mesh);
+  Field& field = *mesh.geometry_fields().get_child("field")->handle<Field>();
+
+  boost::shared_ptr<VolumeIntegral> volume_integration = allocate_component<VolumeIntegral>("volume_integration");
+  volume_integration->options().set("order",2u);
+  const std::vector< Handle<Region> > regions(1, mesh.topology().handle<Region>());
+  BOOST_CHECK_CLOSE(volume_integration->integrate(field, regions), 500., 1e-8);
+  BOOST_CHECK_CLOSE(volume_integration->integrate(field, regions), 500., 1e-8);
+
+  // The quadrature is reused between calls
+  BOOST_CHECK_EQUAL(count(find_components<Quadrature>(*volume_integration)), 1u);
+
+  // Element types without a static kernel use the virtual ElementType interface, with the same result
+  const Quadrature& quadrature = *find_component_ptr<Quadrature>(*volume_integration);
+  Real fallback_integral = 0.;
+  boost_foreach(const Entities& cells, find_components_recursively_with_filter<Entities>(mesh.topology(), IsElementsVolume()))
+  {
+    mesh::actions::detail::FieldIntegralKernel kernel(field, quadrature, 0, fallback_integral);
+    dispatch_element_type_with_fallback< boost::mpl::vector0<> >(cells, kernel);
+  }
+  Real global_fallback_integral;
+  PE::Comm::instance().all_reduce(PE::plus(), &fallback_integral, 1, &global_fallback_integral);
+  BOOST_CHECK_CLOSE(global_fallback_integral, 500., 1e-8);
+
+  // The Gauss-Legendre quadrature of the quads allows sum factorization, with the same result
+  Real sum_factorization_integral = 0.;
+  boost_foreach(const Entities& cells, find_components_recursively_with_filter<Entities>(mesh.topology(), IsElementsVolume()))
+  {
+    const boost::shared_ptr<gausslegendre::SumFactorization> sum_factorization = mesh::actions::detail::create_sum_factorization(quadrature, field.space(cells).shape_function());
+    BOOST_REQUIRE(sum_factorization);
+    mesh::actions::detail::FieldIntegralKernel kernel(field, quadrature, sum_factorization.get(), sum_factorization_integral);
+    dispatch_element_type_with_fallback<CellTypes>(cells, kernel);
+  }
+  Real global_sum_factorization_integral;
+  PE::Comm::instance().all_reduce(PE::plus(), &sum_factorization_integral, 1, &global_sum_factorization_integral);
+  BOOST_CHECK_CLOSE(global_sum_factorization_integral, 500., 1e-8);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 BOOST_AUTO_TEST_CASE( Terminate )
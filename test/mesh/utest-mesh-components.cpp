@@ -15,6 +15,7 @@
 #include "common/Core.hpp"
 #include "common/Group.hpp"
 #include "common/FindComponents.hpp"
+#include "common/PE/Comm.hpp"
 
 #include "mesh/Mesh.hpp"
 #include "mesh/Region.hpp"
@@ -26,6 +27,8 @@
 #include "mesh/ElementType.hpp"
 #include "mesh/Dictionary.hpp"
 #include "mesh/Field.hpp"
+#include "mesh/Connectivity.hpp"
+#include "mesh/Space.hpp"
 
 using namespace boost;
 using namespace boost::assign;
@@ -711,6 +714,37 @@ BOOST_AUTO_TEST_CASE ( Mesh_test )
   BOOST_CHECK_EQUAL(mesh.geometry_fields().coordinates().row_size() , (Uint) DIM_3D);
 }
 
+BOOST_AUTO_TEST_CASE ( HaloPartition_test )
+{
+  boost::shared_ptr<Component> root = boost::static_pointer_cast<Component>(allocate_component<Group>("root"));
+  Mesh& mesh = *root->create_component<Mesh>("mesh");
+  Region& region = mesh.topology().create_region("region");
+  mesh.initialize_nodes(4,DIM_2D);
+  Elements& elements = region.create_elements("cf3.mesh.LagrangeP1.Line2D",mesh.geometry_fields());
+  elements.resize(3);
+  Connectivity& connectivity = elements.geometry_space().connectivity();
+  for (Uint e=0; e<3; ++e)
+  {
+    connectivity[e][0] = e;
+    connectivity[e][1] = e+1;
+    elements.rank()[e] = PE::Comm::instance().rank();
+  }
+
+  // Only the last node is shared, so the last element comes first
+  std::vector<bool> shared_nodes(4,false);
+  shared_nodes[3] = true;
+  elements.update_halo_partition(shared_nodes);
+  BOOST_CHECK(elements.has_halo_partition());
+  BOOST_CHECK_EQUAL(elements.nb_halo_elements(), 1u);
+  BOOST_CHECK_EQUAL(elements.halo_first_order().size(), 3u);
+  BOOST_CHECK_EQUAL(elements.halo_first_order()[0], 2u);
+
+  // Out of date partition: empty order, and all elements are halo elements
+  elements.resize(4);
+  BOOST_CHECK(elements.halo_first_order().empty());
+  BOOST_CHECK_EQUAL(elements.nb_halo_elements(), 4u);
+}
+
 BOOST_AUTO_TEST_CASE( List_Uint_Test )
 {
   // CFinfo << "testing Table<Uint> \n" << CFflush;
@@ -0,0 +1,157 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for cf3::mesh::ElementComputeView"
+
+#include <boost/test/unit_test.hpp>
+
+#include "common/Core.hpp"
+#include "common/FindComponents.hpp"
+#include "common/Foreach.hpp"
+#include "common/OptionList.hpp"
+
+#include "math/MatrixTypes.hpp"
+
+#include "mesh/Connectivity.hpp"
+#include "mesh/Dictionary.hpp"
+#include "mesh/Domain.hpp"
+#include "mesh/ElementComputeView.hpp"
+#include "mesh/Elements.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/Region.hpp"
+#include "mesh/Space.hpp"
+#include "mesh/actions/BuildComputeView.hpp"
+#include "mesh/actions/Rotate.hpp"
+#include "mesh/actions/Translate.hpp"
+
+#include "Tools/MeshGeneration/MeshGeneration.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+using namespace cf3::mesh;
+
+//////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+/// Compare the view with the connectivity and coordinates tables
+void check_view(const Elements& elements)
+{
+  BOOST_REQUIRE(elements.has_compute_view());
+  const ElementComputeView& view = elements.compute_view();
+  const Connectivity& connectivity = elements.geometry_space().connectivity();
+  const Field& coords = elements.geometry_fields().coordinates();
+
+  BOOST_CHECK_EQUAL(view.nb_elements(), elements.size());
+  BOOST_CHECK_EQUAL(view.nb_nodes(), connectivity.row_size());
+  BOOST_CHECK_EQUAL(view.dimension(), coords.row_size());
+  BOOST_CHECK_EQUAL(view.nb_blocks()*ElementComputeView::block_size >= elements.size(), true);
+
+  RealMatrix nodes(view.nb_nodes(), view.dimension());
+  std::vector<Uint> row(view.nb_nodes());
+  for(Uint elem = 0; elem != elements.size(); ++elem)
+  {
+    view.put_connectivity(elem, row);
+    view.put_coordinates(elem, nodes);
+    for(Uint n = 0; n != view.nb_nodes(); ++n)
+    {
+      BOOST_CHECK_EQUAL(row[n], connectivity[elem][n]);
+      BOOST_CHECK_EQUAL(view.node(elem, n), connectivity[elem][n]);
+      for(Uint d = 0; d != view.dimension(); ++d)
+        BOOST_CHECK_EQUAL(nodes(n, d), coords[connectivity[elem][n]][d]);
+    }
+  }
+
+  // Coordinate rows are aligned for vector loads
+  for(Uint block = 0; block != view.nb_blocks(); ++block)
+    BOOST_CHECK_EQUAL(reinterpret_cast<std::size_t>(view.coordinates(block, 0, 0)) % 16, 0u);
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE( ElementComputeViewSuite )
+
+//////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( BuildAndCompare )
+{
+  Domain& domain = *Core::instance().root().create_component<Domain>("domain");
+  Mesh& mesh = *domain.create_component<Mesh>("mesh");
+
+  // 15 elements, so the last block is padded
+  Tools::MeshGeneration::create_rectangle(mesh, 1., 1., 5, 3);
+
+  boost_foreach(const Elements& elements, find_components_recursively<Elements>(mesh.topology()))
+    BOOST_CHECK(!elements.has_compute_view());
+
+  Handle<actions::BuildComputeView> build = domain.create_component<actions::BuildComputeView>("build_view");
+  build->transform(mesh);
+
+  boost_foreach(const Elements& elements, find_components_recursively<Elements>(mesh.topology()))
+    check_view(elements);
+
+  // Padding repeats the last element
+  const Elements& cells = *find_component_ptr_recursively_with_filter<Elements>(mesh.topology(), IsElementsVolume());
+  const ElementComputeView& view = cells.compute_view();
+  BOOST_CHECK_EQUAL(view.nb_blocks(), 4u);
+  BOOST_CHECK_EQUAL(view.connectivity(3, 0)[3], view.node(14, 0));
+}
+
+BOOST_AUTO_TEST_CASE( MoveAndChange )
+{
+  Mesh& mesh = *Handle<Mesh>(Core::instance().root().access_component("domain/mesh"));
+  Field& coords = mesh.geometry_fields().coordinates();
+  for(Uint i = 0; i != coords.size(); ++i)
+    coords[i][1] *= 2.;
+
+  // The view is a copy, until built again
+  const Elements& cells = *find_component_ptr_recursively_with_filter<Elements>(mesh.topology(), IsElementsVolume());
+  const Uint elem = 7;
+  const Uint node = cells.compute_view().node(elem, 2);
+  BOOST_CHECK_EQUAL(cells.compute_view().coordinates(elem / ElementComputeView::block_size, 2, 1)[elem % ElementComputeView::block_size], coords[node][1] / 2.);
+
+  Handle<actions::BuildComputeView>(Core::instance().root().access_component("domain/build_view"))->transform(mesh);
+  boost_foreach(const Elements& elements, find_components_recursively<Elements>(mesh.topology()))
+    check_view(elements);
+
+  // Existing views are rebuilt when the mesh changes
+  mesh.raise_mesh_changed();
+  boost_foreach(const Elements& elements, find_components_recursively<Elements>(mesh.topology()))
+    check_view(elements);
+
+  boost_foreach(Elements& elements, find_components_recursively<Elements>(mesh.topology()))
+    elements.clear_compute_view();
+  BOOST_CHECK(!cells.has_compute_view());
+}
+
+BOOST_AUTO_TEST_CASE( TranslateAndRotate )
+{
+  Handle<Component> domain = Core::instance().root().access_component("domain");
+  Mesh& mesh = *Handle<Mesh>(domain->access_component("mesh"));
+  Handle<actions::BuildComputeView>(domain->access_component("build_view"))->transform(mesh);
+
+  // Actions that move the nodes update the views
+  Handle<actions::Translate> translate = domain->create_component<actions::Translate>("translate");
+  translate->options().set("vector", std::vector<Real>(2, 0.5));
+  translate->transform(mesh);
+  boost_foreach(const Elements& elements, find_components_recursively<Elements>(mesh.topology()))
+    check_view(elements);
+
+  Handle<actions::Rotate> rotate = domain->create_component<actions::Rotate>("rotate");
+  rotate->options().set("angle", 30.);
+  rotate->transform(mesh);
+  boost_foreach(const Elements& elements, find_components_recursively<Elements>(mesh.topology()))
+    check_view(elements);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+//////////////////////////////////////////////////////////////////////////////
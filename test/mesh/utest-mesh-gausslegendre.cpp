@@ -21,6 +21,7 @@
 #include "mesh/LagrangeP1/Line2D.hpp"
 #include "mesh/ElementType.hpp"
 #include "mesh/ShapeFunction.hpp"
+#include "mesh/gausslegendre/SumFactorization.hpp"
 
 using namespace boost;
 using namespace boost::assign;
@@ -186,6 +187,90 @@ BOOST_AUTO_TEST_CASE( LagrangeP2_Line_integral_dynamic )
   BOOST_CHECK_CLOSE(integral, std::pow(b,3.)/3.,1e-10);  // integral(x^2) = x^3/3
 }
 
+/// Compare the sum factorization with the dense evaluation of the shape function
+void check_sum_factorization(const std::string& sf_builder, const Uint nb_qdr_pts_1d)
+{
+  Handle<mesh::ShapeFunction> sf = Core::instance().root().create_component<mesh::ShapeFunction>("sf", sf_builder);
+  BOOST_CHECK(gausslegendre::SumFactorization::is_supported(*sf));
+  const gausslegendre::SumFactorization sum_factorization(*sf, nb_qdr_pts_1d);
+
+  const Uint dim = sf->dimensionality();
+  const Uint nb_nodes = sf->nb_nodes();
+  const Uint nb_qdr = sum_factorization.nb_qdr_pts();
+  BOOST_CHECK_EQUAL(nb_qdr, static_cast<Uint>(std::pow(static_cast<Real>(nb_qdr_pts_1d), static_cast<int>(dim)) + 0.5));
+  BOOST_CHECK_CLOSE(sum_factorization.qdr_weights().sum(), std::pow(2., static_cast<int>(dim)), 1e-10);
+
+  std::vector<Real> nodal(nb_nodes), qdr_values(nb_qdr), qdr_gradients(dim*nb_qdr);
+  for(Uint n = 0; n != nb_nodes; ++n)
+    nodal[n] = 1. + 0.37*n - 0.05*n*n;
+  sum_factorization.interpolate(&nodal[0], &qdr_values[0]);
+  sum_factorization.gradient(&nodal[0], &qdr_gradients[0]);
+
+  std::vector<Real> qdr_input(nb_qdr), qdr_gradient_input(dim*nb_qdr);
+  for(Uint i = 0; i != nb_qdr; ++i)
+    qdr_input[i] = 0.5 - 0.11*i;
+  for(Uint i = 0; i != dim*nb_qdr; ++i)
+    qdr_gradient_input[i] = 0.2 + 0.07*i;
+  std::vector<Real> integrated(nb_nodes), integrated_gradient(nb_nodes);
+  sum_factorization.integrate(&qdr_input[0], &integrated[0]);
+  sum_factorization.integrate_gradient(&qdr_gradient_input[0], &integrated_gradient[0]);
+
+  std::vector<Real> expected_integrated(nb_nodes, 0.), expected_integrated_gradient(nb_nodes, 0.);
+  RealMatrix gradient(dim, nb_nodes);
+  for(Uint q = 0; q != nb_qdr; ++q)
+  {
+    const RealVector coords = sum_factorization.qdr_local_coordinates().row(q).transpose();
+    const RealRowVector values = sf->value(coords);
+    sf->compute_gradient(coords, gradient);
+
+    Real expected_value = 0.;
+    for(Uint n = 0; n != nb_nodes; ++n)
+    {
+      expected_value += values[n] * nodal[n];
+      expected_integrated[n] += values[n] * qdr_input[q];
+      for(Uint d = 0; d != dim; ++d)
+        expected_integrated_gradient[n] += gradient(d, n) * qdr_gradient_input[d*nb_qdr + q];
+    }
+    BOOST_CHECK_SMALL(qdr_values[q] - expected_value, 1e-12);
+
+    for(Uint d = 0; d != dim; ++d)
+    {
+      Real expected_gradient = 0.;
+      for(Uint n = 0; n != nb_nodes; ++n)
+        expected_gradient += gradient(d, n) * nodal[n];
+      BOOST_CHECK_SMALL(qdr_gradients[d*nb_qdr + q] - expected_gradient, 1e-12);
+    }
+  }
+
+  for(Uint n = 0; n != nb_nodes; ++n)
+  {
+    BOOST_CHECK_SMALL(integrated[n] - expected_integrated[n], 1e-12);
+    BOOST_CHECK_SMALL(integrated_gradient[n] - expected_integrated_gradient[n], 1e-12);
+  }
+
+  Core::instance().root().remove_component("sf");
+}
+
+BOOST_AUTO_TEST_CASE( SumFactorization )
+{
+  check_sum_factorization("cf3.mesh.LagrangeP1.Line", 2);
+  check_sum_factorization("cf3.mesh.LagrangeP1.Quad", 2);
+  check_sum_factorization("cf3.mesh.LagrangeP1.Hexa", 3);
+  check_sum_factorization("cf3.mesh.LagrangeP2.Quad", 3);
+  check_sum_factorization("cf3.mesh.LagrangeP3.Quad", 4);
+
+  Handle<mesh::ShapeFunction> triag = Core::instance().root().create_component<mesh::ShapeFunction>("triag", "cf3.mesh.LagrangeP1.Triag");
+  BOOST_CHECK(!gausslegendre::SumFactorization::is_supported(*triag));
+  BOOST_CHECK_THROW(gausslegendre::SumFactorization(*triag, 2), NotSupported);
+  BOOST_CHECK(!gausslegendre::SumFactorization::create(*triag, 2));
+
+  Handle<mesh::ShapeFunction> quad = Core::instance().root().create_component<mesh::ShapeFunction>("quad", "cf3.mesh.LagrangeP2.Quad");
+  const boost::shared_ptr<gausslegendre::SumFactorization> created = gausslegendre::SumFactorization::create(*quad, 3);
+  BOOST_REQUIRE(created);
+  BOOST_CHECK_EQUAL(created->nb_nodes(), 9u);
+  BOOST_CHECK_EQUAL(created->nb_qdr_pts(), 9u);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 BOOST_AUTO_TEST_SUITE_END()
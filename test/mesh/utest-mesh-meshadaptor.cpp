@@ -7,17 +7,25 @@
 #define BOOST_TEST_DYN_LINK
 #define BOOST_TEST_MODULE "Test module for Mesh Manipulations"
 
+#include <algorithm>
+#include <set>
+
 #include <boost/test/unit_test.hpp>
 
 #include "common/Log.hpp"
 #include "common/OptionList.hpp"
 #include "common/PropertyList.hpp"
 #include "common/Core.hpp"
+#include "common/Foreach.hpp"
 
 #include "common/PE/Comm.hpp"
 #include "common/PE/debug.hpp"
 
+#include "math/Defs.hpp"
+
 #include "mesh/Mesh.hpp"
+#include "mesh/Entities.hpp"
+#include "mesh/Field.hpp"
 #include "mesh/Space.hpp"
 #include "mesh/Connectivity.hpp"
 #include "mesh/Region.hpp"
@@ -39,6 +47,65 @@ using namespace cf3::common;
 
 ////////////////////////////////////////////////////////////////////////////////
 
+/// Create a rectangle of unit square cells, partitioned over all ranks
+Mesh& create_rectangle(const std::string& name, const Uint nx, const Uint ny)
+{
+  boost::shared_ptr< MeshGenerator > meshgenerator = build_component_abstract_type<MeshGenerator>("cf3.mesh.SimpleMeshGenerator","2Dgenerator");
+  meshgenerator->options().set("mesh",URI("//"+name));
+  std::vector<Uint> nb_cells(2); nb_cells[0] = nx; nb_cells[1] = ny;
+  std::vector<Real> lengths(2); lengths[0] = nx; lengths[1] = ny;
+  meshgenerator->options().set("nb_cells",nb_cells);
+  meshgenerator->options().set("lengths",lengths);
+  return meshgenerator->generate();
+}
+
+/// Index i+j*nx of the interior cells on this rank, found from their centroid.
+/// Also checks that every cell is a unit square, so that the connectivity is valid.
+std::set<Uint> cells_on_rank(Mesh& mesh, const Uint nx, const bool only_owned)
+{
+  const Entities& quads = *mesh.access_component_checked("topology/interior/Quad")->handle<Entities>();
+  const Connectivity& connectivity = quads.geometry_space().connectivity();
+  const Field& coords = mesh.geometry_fields().coordinates();
+  std::set<Uint> cells;
+  for (Uint elem=0; elem<quads.size(); ++elem)
+  {
+    if (only_owned && quads.is_ghost(elem))
+      continue;
+    Real x_min = 1e10, x_max = -1e10, y_min = 1e10, y_max = -1e10;
+    boost_foreach (const Uint node, connectivity[elem])
+    {
+      x_min = std::min(x_min, coords[node][XX]); x_max = std::max(x_max, coords[node][XX]);
+      y_min = std::min(y_min, coords[node][YY]); y_max = std::max(y_max, coords[node][YY]);
+    }
+    BOOST_CHECK_CLOSE(x_max-x_min, 1., 1e-8);
+    BOOST_CHECK_CLOSE(y_max-y_min, 1., 1e-8);
+    cells.insert(static_cast<Uint>(x_min+0.5) + static_cast<Uint>(y_min+0.5)*nx);
+  }
+  return cells;
+}
+
+/// Cells that share a node with the given cells
+std::set<Uint> grow_cells(const std::set<Uint>& cells, const Uint nx, const Uint ny)
+{
+  std::set<Uint> grown;
+  boost_foreach (const Uint cell, cells)
+  {
+    const int i = cell % nx;
+    const int j = cell / nx;
+    for (int dj=-1; dj<=1; ++dj)
+    {
+      for (int di=-1; di<=1; ++di)
+      {
+        if (i+di >= 0 && i+di < (int)nx && j+dj >= 0 && j+dj < (int)ny)
+          grown.insert((i+di) + (j+dj)*nx);
+      }
+    }
+  }
+  return grown;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 struct MeshManipulationsTests_Fixture
 {
   /// common setup for each test case
@@ -288,6 +355,88 @@ BOOST_AUTO_TEST_CASE( test_element_node_connectivity_rebuilding )
 
 ////////////////////////////////////////////////////////////////////////////////
 
+BOOST_AUTO_TEST_CASE( test_move_elements_rectangle )
+{
+  const Uint nx = 8;
+  const Uint ny = 6;
+  Mesh& mesh = create_rectangle("move_rectangle", nx, ny);
+  const Uint nb_procs = PE::Comm::instance().size();
+  const Uint rank = PE::Comm::instance().rank();
+
+  // Every rank sends the first half of its cells to the next rank
+  Entities& quads = *mesh.access_component_checked("topology/interior/Quad")->handle<Entities>();
+  std::vector< std::vector<std::vector<Uint> > > change_set(nb_procs, std::vector<std::vector<Uint> >(mesh.elements().size()));
+  if (nb_procs > 1)
+  {
+    for (Uint elem=0; elem<quads.size()/2; ++elem)
+      change_set[(rank+1)%nb_procs][quads.entities_idx()].push_back(elem);
+  }
+
+  MeshAdaptor mesh_adaptor(mesh);
+  mesh_adaptor.prepare();
+  mesh_adaptor.move_elements(change_set);
+  BOOST_CHECK_NO_THROW( mesh_adaptor.finish() );
+
+  // All cells are still there, exactly once
+  const std::set<Uint> owned = cells_on_rank(mesh, nx, true);
+  BOOST_CHECK_EQUAL(owned.size(), quads.size());
+  std::vector<Uint> owned_vector(owned.begin(), owned.end());
+  std::vector< std::vector<Uint> > all_owned;
+  PE::Comm::instance().all_gather(owned_vector, all_owned);
+  std::set<Uint> all_cells;
+  Uint nb_cells = 0;
+  boost_foreach (const std::vector<Uint>& cells, all_owned)
+  {
+    all_cells.insert(cells.begin(), cells.end());
+    nb_cells += cells.size();
+  }
+  BOOST_CHECK_EQUAL(nb_cells, nx*ny);
+  BOOST_CHECK_EQUAL(all_cells.size(), nx*ny);
+
+  // Nodes that are not used anymore are removed
+  const Dictionary& geometry = mesh.geometry_fields();
+  std::vector<bool> used(geometry.size(), false);
+  boost_foreach (const Handle<Entities>& entities, mesh.elements())
+  {
+    boost_foreach (Connectivity::ConstRow nodes, entities->geometry_space().connectivity().array())
+    {
+      boost_foreach (const Uint node, nodes)
+        used[node] = true;
+    }
+  }
+  BOOST_CHECK(std::find(used.begin(), used.end(), false) == used.end());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( test_grow_overlap )
+{
+  const Uint nx = 8;
+  const Uint ny = 6;
+  Mesh& mesh = create_rectangle("overlap_rectangle", nx, ny);
+  mesh.geometry_fields().rebuild_map_glb_to_loc();
+  mesh.geometry_fields().rebuild_node_to_element_connectivity();
+
+  const std::set<Uint> owned = cells_on_rank(mesh, nx, true);
+  BOOST_CHECK(cells_on_rank(mesh, nx, false) == owned);
+
+  // Every layer adds the cells that share a node with the cells that were there before
+  std::set<Uint> expected = owned;
+  for (Uint layer=0; layer<2; ++layer)
+  {
+    MeshAdaptor mesh_adaptor(mesh);
+    mesh_adaptor.prepare();
+    mesh_adaptor.grow_overlap();
+    BOOST_CHECK_NO_THROW( mesh_adaptor.finish() );
+
+    expected = grow_cells(expected, nx, ny);
+    BOOST_CHECK(cells_on_rank(mesh, nx, false) == expected);
+    BOOST_CHECK(cells_on_rank(mesh, nx, true) == owned);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 BOOST_AUTO_TEST_CASE( finalize_mpi )
 {
   PE::Comm::instance().finalize();
@@ -15,9 +15,12 @@
 #include "common/EventHandler.hpp"
 #include "common/Environment.hpp"
 #include "common/XML/SignalFrame.hpp"
+#include "common/PE/Comm.hpp"
 
 #include "mesh/Mesh.hpp"
 #include "mesh/Region.hpp"
+#include "mesh/Elements.hpp"
+#include "mesh/ElementType.hpp"
 #include "mesh/MeshReader.hpp"
 #include "mesh/MeshWriter.hpp"
 #include "mesh/MeshTransformer.hpp"
@@ -105,6 +108,48 @@ BOOST_AUTO_TEST_CASE( read_2d_mesh )
     }
   }
   CFinfo << "ghost node count = " << nb_ghosts << CFendl;
+
+  // Every cell of the file is read by exactly one rank
+  Uint nb_cells = 0;
+  boost_foreach(const Elements& elements, find_components_recursively<Elements>(mesh.topology()))
+  {
+    if (elements.element_type().dimensionality() == 2)
+      nb_cells += elements.size();
+  }
+  Uint total_nb_cells = nb_cells;
+  if (PE::Comm::instance().is_active())
+    PE::Comm::instance().all_reduce(PE::plus(), &nb_cells, 1, &total_nb_cells);
+  BOOST_CHECK_EQUAL(total_nb_cells, 16u);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( read_parts_2d_mesh )
+{
+  // A single process reads all parts in turn, the ghost coordinates then come from the file.
+  // In a parallel run the parts must match the ranks, for the global numbering.
+  if (PE::Comm::instance().size() != 1)
+    return;
+
+  const Uint nb_parts = 3;
+  Uint nb_cells = 0;
+  for (Uint part=0; part<nb_parts; ++part)
+  {
+    boost::shared_ptr< MeshReader > meshreader = build_component_abstract_type<MeshReader>("cf3.mesh.neu.Reader","meshreader");
+    meshreader->options().set("read_groups",true);
+    meshreader->options().set("part",part);
+    meshreader->options().set("nb_parts",nb_parts);
+
+    Mesh& mesh = *Core::instance().root().create_component<Mesh>("quadtriag_part"+to_str(part));
+    meshreader->read_mesh_into("../../resources/quadtriag.neu",mesh);
+
+    boost_foreach(const Elements& elements, find_components_recursively<Elements>(mesh.topology()))
+    {
+      if (elements.element_type().dimensionality() == 2)
+        nb_cells += elements.size();
+    }
+  }
+  BOOST_CHECK_EQUAL(nb_cells, 16u);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -27,6 +27,8 @@
 #include "mesh/Space.hpp"
 #include "common/Table.hpp"
 #include "mesh/Dictionary.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/ElementType.hpp"
 #include "mesh/MeshGenerator.hpp"
 #include "mesh/Octtree.hpp"
 #include "mesh/StencilComputerOcttree.hpp"
@@ -147,6 +149,75 @@ BOOST_AUTO_TEST_CASE( Octtree_creation )
 
 ////////////////////////////////////////////////////////////////////////////////
 
+BOOST_AUTO_TEST_CASE( Octtree_graded )
+{
+  Handle< MeshGenerator > mesh_generator(Core::instance().root().get_child("mesh_generator"));
+  mesh_generator->options().set("mesh",Core::instance().root().uri()/"graded_mesh");
+  mesh_generator->options().set("lengths",std::vector<Real>(2,1.));
+  mesh_generator->options().set("nb_cells",std::vector<Uint>(2,40));
+  mesh_generator->options().set("part",0u);
+  mesh_generator->options().set("nb_parts",1u);
+  Mesh& mesh = mesh_generator->generate();
+
+  // Cluster the elements towards y=0, as in a boundary layer
+  Field& coords = mesh.geometry_fields().coordinates();
+  for (Uint i=0; i<coords.size(); ++i)
+    coords[i][YY] = std::pow(coords[i][YY],4.);
+
+  Octtree& octtree = *mesh.create_component<Octtree>("octtree");
+  octtree.options().set("mesh", mesh.handle<Mesh>() );
+  octtree.create_octtree();
+
+  const Uint nb_coords = 200;
+  boost::multi_array<Real,2> coordinates(boost::extents[nb_coords][2]);
+  for (Uint i=0; i<nb_coords; ++i)
+  {
+    coordinates[i][XX] = std::fmod(0.618034*i, 1.);
+    coordinates[i][YY] = std::pow(std::fmod(0.414214*i + 0.1, 1.), 6.);
+  }
+
+  std::vector<Entity> elements;
+  BOOST_CHECK_EQUAL(octtree.find_elements(coordinates,elements), nb_coords);
+  BOOST_CHECK_EQUAL(elements.size(), nb_coords);
+
+  RealVector2 coord;
+  Uint nb_correct = 0;
+  for (Uint i=0; i<nb_coords; ++i)
+  {
+    coord << coordinates[i][XX], coordinates[i][YY];
+    if (is_not_null(elements[i].comp) && elements[i].element_type().is_coord_in_element(coord,elements[i].get_coordinates()))
+      ++nb_correct;
+    Entity single;
+    BOOST_CHECK(octtree.find_element(coord,single));
+    BOOST_CHECK_EQUAL(single.idx, elements[i].idx);
+  }
+  BOOST_CHECK_EQUAL(nb_correct, nb_coords);
+
+  // The centroid of an element is nearest to the element itself
+  Entity nearest;
+  const Entity thin_element(find_component_recursively_with_filter<Elements>(mesh.topology(),IsElementsVolume()),3);
+  RealVector centroid(2);
+  thin_element.element_type().compute_centroid(thin_element.get_coordinates(),centroid);
+  BOOST_CHECK(octtree.find_nearest_element(centroid,nearest));
+  BOOST_CHECK_EQUAL(nearest.idx, 3u);
+
+  // Coordinates outside the bounding box of the mesh are not found, even when the closest element is allowed
+  coordinates.resize(boost::extents[1][2]);
+  coordinates[0][XX] = 2.; coordinates[0][YY] = 0.5;
+  BOOST_CHECK_EQUAL(octtree.find_elements(coordinates,elements,true), 0u);
+  BOOST_CHECK(is_null(elements[0].comp));
+
+  // Zero elements per leaf is treated as one
+  octtree.options().set("nb_elems_per_leaf", 0u);
+  octtree.create_octtree();
+  coord << 0.5, 0.01;
+  Entity found;
+  BOOST_CHECK(octtree.find_element(coord,found));
+  BOOST_CHECK(found.element_type().is_coord_in_element(coord,found.get_coordinates()));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 BOOST_AUTO_TEST_CASE( Octtree_parallel )
 {
   Handle< MeshGenerator > mesh_generator(Core::instance().root().get_child("mesh_generator"));
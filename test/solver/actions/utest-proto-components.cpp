@@ -27,6 +27,7 @@
 
 #include "physics/PhysModel.hpp"
 
+#include "solver/ActionDirector.hpp"
 #include "solver/Model.hpp"
 #include "solver/SimpleSolver.hpp"
 
@@ -217,6 +218,115 @@ BOOST_AUTO_TEST_CASE( ProtoActionTest )
   BOOST_CHECK_EQUAL(temp_sum / static_cast<Real>(1+nb_segments), 288.);
 }
 
+/// ProtoAction that does more than its loop in execute(), so it must not be fused
+class ScaledVolumeSum : public ProtoAction
+{
+public:
+  ScaledVolumeSum(const std::string& name) : ProtoAction(name), sum(0.)
+  {
+    set_expression(elements_expression(lit(sum) += volume));
+  }
+
+  static std::string type_name() { return "ScaledVolumeSum"; }
+
+  virtual void execute()
+  {
+    sum = 0.;
+    ProtoAction::execute();
+    sum *= 10.;
+  }
+
+  Real sum;
+};
+
+/// Test fusing the element loops of consecutive actions
+BOOST_AUTO_TEST_CASE( FusedElementLoops )
+{
+  Handle<Model> model(Core::instance().root().get_child("Model"));
+  Handle<Mesh> mesh(model->domain().get_child("mesh"));
+
+  Real volume_sum = 0.;
+  Real double_volume_sum = 0.;
+  Real nb_nodes = 0.;
+
+  Handle<solver::ActionDirector> director = Core::instance().root().create_component<solver::ActionDirector>("FusedDirector");
+  director->options().set("fuse_element_loops", true);
+  *director << create_proto_action("SumVolume", elements_expression(lit(volume_sum) += volume));
+  Handle<ScaledVolumeSum> scaled_sum = director->create_component<ScaledVolumeSum>("ScaledVolumeSum");
+  *director << create_proto_action("SumDoubleVolume", elements_expression(lit(double_volume_sum) += 2.*volume))
+            << create_proto_action("CountNodes", nodes_expression(lit(nb_nodes) += 1.));
+  director->configure_option_recursively(solver::Tags::regions(), std::vector<URI>(1, mesh->topology().uri()));
+
+  BOOST_CHECK(director->get_child("SumVolume")->handle<solver::Action>()->is_element_loop());
+  BOOST_CHECK(!scaled_sum->is_element_loop());
+
+  director->execute();
+  BOOST_CHECK_CLOSE(volume_sum, 1., 1e-8);
+  BOOST_CHECK_CLOSE(double_volume_sum, 2., 1e-8);
+  BOOST_CHECK_EQUAL(nb_nodes, 6.);
+  // The subclass is executed normally, including the work after its loop
+  BOOST_CHECK_CLOSE(scaled_sum->sum, 10., 1e-8);
+
+  // The unfused loops give the same result
+  director->options().set("fuse_element_loops", false);
+  director->execute();
+  BOOST_CHECK_CLOSE(volume_sum, 2., 1e-8);
+  BOOST_CHECK_CLOSE(double_volume_sum, 4., 1e-8);
+  BOOST_CHECK_EQUAL(nb_nodes, 12.);
+
+  Core::instance().root().remove_component("FusedDirector");
+}
+
+/// Test running independent proto actions concurrently
+BOOST_AUTO_TEST_CASE( ConcurrentProtoActions )
+{
+  const Uint nb_segments = 5;
+  Handle<Model> model(Core::instance().root().get_child("Model"));
+  Handle<Mesh> mesh(model->domain().get_child("mesh"));
+  Handle<FieldManager> field_manager(model->get_child("FieldManager"));
+
+  FieldVariable<0, ScalarField> A("ConcurrentA", "CA");
+  FieldVariable<1, ScalarField> B("ConcurrentB", "CB");
+
+  Real volume_sum = 0.;
+
+  Handle<solver::ActionDirector> director = Core::instance().root().create_component<solver::ActionDirector>("ConcurrentDirector");
+  director->options().set("concurrent_actions", true);
+  *director << create_proto_action("SetA", nodes_expression(A = 1.))
+            << create_proto_action("SetB", nodes_expression(B = 2.*coordinates[0]))
+            << create_proto_action("SumVolume", elements_expression(lit(volume_sum) += volume));
+  director->configure_option_recursively(solver::Tags::regions(), std::vector<URI>(1, mesh->topology().uri()));
+  director->configure_option_recursively("physical_model", model->physics().handle<physics::PhysModel>());
+
+  // Each action declares what it writes and that it is safe to run on a thread
+  const char* written[] = {"CA", "CB", "volume_sum"};
+  const char* names[] = {"SetA", "SetB", "SumVolume"};
+  for(Uint i = 0; i != 3; ++i)
+  {
+    Component& action = *director->get_child(names[i]);
+    action.options().set("written_fields", std::vector<std::string>(1, written[i]));
+    action.options().set("thread_safe", true);
+  }
+
+  field_manager->create_field("CA", mesh->geometry_fields());
+  field_manager->create_field("CB", mesh->geometry_fields());
+
+  // The first execution is sequential, the second runs the three actions together
+  for(Uint run = 1; run != 3; ++run)
+  {
+    director->execute();
+
+    Real a_sum = 0.;
+    Real b_sum = 0.;
+    nodes_expression(group(lit(a_sum) += A, lit(b_sum) += B))->loop(mesh->topology());
+    BOOST_CHECK_EQUAL(a_sum, static_cast<Real>(1+nb_segments));
+    BOOST_CHECK_CLOSE(b_sum, 6., 1e-8);
+    BOOST_CHECK_CLOSE(volume_sum, static_cast<Real>(run), 1e-8);
+  }
+
+  Core::instance().root().remove_component("ConcurrentDirector");
+}
+
 /// Test SimpleSolver
 BOOST_AUTO_TEST_CASE( SimpleSolverTest )
 {
@@ -174,6 +174,31 @@ BOOST_AUTO_TEST_CASE( NodeFunctor )
   BOOST_CHECK_CLOSE(vec_norm.m_sum, 501.*501.*sqrt(2),1e-8);
 }
 
+template<typename ExprT>
+bool is_thread_safe(const ExprT&)
+{
+  return boost::proto::matches<ExprT, ThreadSafeNodeExpression>::value;
+}
+
+BOOST_AUTO_TEST_CASE( ThreadSafety )
+{
+  FieldVariable<0, VectorField> u("u","velocity");
+  FieldVariable<1, ScalarField> p("p","pressure");
+  RealVector result(2);
+  SumVectorNorm vec_norm;
+
+  // Field assignments can be executed by several threads
+  BOOST_CHECK(is_thread_safe(u[_i] = 1.));
+  BOOST_CHECK(is_thread_safe(group(u[_i] = 0., p = 1.)));
+  BOOST_CHECK(is_thread_safe(u = 2.1875*u - p*coordinates));
+  BOOST_CHECK(is_thread_safe(p += u[0] / 2.));
+
+  // Reductions and functors must be executed serially
+  BOOST_CHECK(!is_thread_safe(lit(result) += u));
+  BOOST_CHECK(!is_thread_safe(lit(vec_norm)(u)));
+  BOOST_CHECK(!is_thread_safe(group(p = 1., lit(result) += u)));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 ////////////////////////////////////////////////////////////////////////////////
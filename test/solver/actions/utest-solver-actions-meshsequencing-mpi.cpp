@@ -0,0 +1,147 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for cf3::solver::actions::MeshSequencing in parallel"
+
+#include <boost/test/unit_test.hpp>
+
+#include "common/Action.hpp"
+#include "common/Core.hpp"
+#include "common/Environment.hpp"
+#include "common/OptionList.hpp"
+#include "common/Table.hpp"
+
+#include "common/PE/Comm.hpp"
+
+#include "mesh/BlockMesh/BlockData.hpp"
+#include "mesh/Dictionary.hpp"
+#include "mesh/Domain.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/Mesh.hpp"
+
+#include "solver/actions/MeshSequencing.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+using namespace cf3::mesh;
+using namespace cf3::solver::actions;
+
+//////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+/// Linear function, which the interpolation reproduces exactly
+Real u(const Real x, const Real y) { return 1. + 2.*x - y; }
+
+/// Stands in for the solve on the coarse mesh
+class CoarseSolve : public common::Action
+{
+public:
+  CoarseSolve(const std::string& name) : common::Action(name) {}
+  static std::string type_name() { return "CoarseSolve"; }
+
+  virtual void execute()
+  {
+    Dictionary& dict = coarse_mesh->geometry_fields();
+    Field& field = dict.field("solution");
+    const Field& coords = dict.coordinates();
+    for(Uint i = 0; i != dict.size(); ++i)
+      field[i][0] = u(coords[i][0], coords[i][1]);
+  }
+
+  Handle<Mesh> coarse_mesh;
+};
+
+/// Unit square, with the blocks partitioned in the given direction
+void create_square(Domain& domain, Mesh& mesh, const Uint nb_segments, const Uint partition_direction)
+{
+  BlockMesh::BlockArrays& blocks = *domain.create_component<BlockMesh::BlockArrays>(mesh.name() + "_blocks");
+
+  (*blocks.create_points(2, 4)) << 0. << 0.
+                                << 1. << 0.
+                                << 0. << 1.
+                                << 1. << 1.;
+
+  (*blocks.create_blocks(1)) << 0 << 1 << 3 << 2;
+  (*blocks.create_block_subdivisions()) << nb_segments << nb_segments;
+  (*blocks.create_block_gradings()) << 1. << 1. << 1. << 1.;
+
+  *blocks.create_patch("bottom", 1) << 0 << 1;
+  *blocks.create_patch("right", 1) << 1 << 3;
+  *blocks.create_patch("top", 1) << 3 << 2;
+  *blocks.create_patch("left", 1) << 2 << 0;
+
+  blocks.partition_blocks(PE::Comm::instance().size(), partition_direction);
+  blocks.create_mesh(mesh);
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE( MeshSequencingMPISuite )
+
+//////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( Init )
+{
+  PE::Comm::instance().init(boost::unit_test::framework::master_test_suite().argc, boost::unit_test::framework::master_test_suite().argv);
+  Core::instance().environment().options().set("log_level", 1u);
+  BOOST_CHECK_EQUAL(PE::Comm::instance().size(), 2);
+}
+
+BOOST_AUTO_TEST_CASE( ProlongateAcrossPartitions )
+{
+  Domain& domain = *Core::instance().root().create_component<Domain>("domain");
+  Mesh& fine_mesh = *domain.create_component<Mesh>("fine_mesh");
+  Mesh& coarse_mesh = *domain.create_component<Mesh>("coarse_mesh");
+
+  // The partitions cross, so about half of the fine points are in the coarse elements of the other rank
+  create_square(domain, fine_mesh, 16, 1);
+  create_square(domain, coarse_mesh, 4, 0);
+  fine_mesh.geometry_fields().create_field("solution");
+  coarse_mesh.geometry_fields().create_field("solution");
+
+  MeshSequencing& sequencing = *domain.create_component<MeshSequencing>("sequencing");
+  sequencing.options().set("mesh", fine_mesh.handle<Mesh>());
+  sequencing.options().set("coarse_mesh", coarse_mesh.handle<Mesh>());
+
+  CoarseSolve& coarse_solve = *sequencing.create_component<CoarseSolve>("coarse_solve");
+  coarse_solve.coarse_mesh = coarse_mesh.handle<Mesh>();
+
+  sequencing.execute();
+
+  const Dictionary& dict = fine_mesh.geometry_fields();
+  const Field& field = *Handle<Field const>(dict.get_child("solution"));
+  const Field& coords = dict.coordinates();
+  for(Uint i = 0; i != dict.size(); ++i)
+    BOOST_CHECK_SMALL(field[i][0] - u(coords[i][0], coords[i][1]), 1e-10);
+}
+
+BOOST_AUTO_TEST_CASE( OutsideOnAllRanks )
+{
+  MeshSequencing& sequencing = *Handle<MeshSequencing>(Core::instance().root().access_component("domain/sequencing"));
+  Mesh& fine_mesh = *Handle<Mesh>(Core::instance().root().access_component("domain/fine_mesh"));
+
+  // Shift the fine mesh partly out of the coarse mesh
+  Field& coords = fine_mesh.geometry_fields().coordinates();
+  for(Uint i = 0; i != coords.size(); ++i)
+    coords[i][0] += 0.5;
+  sequencing.invalidate();
+
+  BOOST_CHECK_THROW(sequencing.prolongate(), SetupError);
+}
+
+BOOST_AUTO_TEST_CASE( Finalize )
+{
+  PE::Comm::instance().finalize();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+//////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,131 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for cf3::solver::actions::MeshSequencing"
+
+#include <boost/test/unit_test.hpp>
+
+#include "common/Action.hpp"
+#include "common/Core.hpp"
+#include "common/Environment.hpp"
+#include "common/OptionList.hpp"
+
+#include "mesh/Dictionary.hpp"
+#include "mesh/Domain.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/Mesh.hpp"
+
+#include "solver/actions/MeshSequencing.hpp"
+
+#include "Tools/MeshGeneration/MeshGeneration.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+using namespace cf3::mesh;
+using namespace cf3::solver::actions;
+
+//////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+/// Linear function, which the interpolation reproduces exactly
+Real u(const Real x, const Real y, const Real scale) { return scale*(1. + 2.*x - y); }
+
+/// Stands in for the solve on the coarse mesh
+class CoarseSolve : public common::Action
+{
+public:
+  CoarseSolve(const std::string& name) : common::Action(name), scale(1.), nb_executions(0) {}
+  static std::string type_name() { return "CoarseSolve"; }
+
+  virtual void execute()
+  {
+    Dictionary& dict = coarse_mesh->geometry_fields();
+    Field& field = dict.field("solution");
+    const Field& coords = dict.coordinates();
+    for(Uint i = 0; i != dict.size(); ++i)
+    {
+      field[i][0] = u(coords[i][0], coords[i][1], scale);
+      field[i][1] = -u(coords[i][0], coords[i][1], scale);
+    }
+    ++nb_executions;
+  }
+
+  Handle<Mesh> coarse_mesh;
+  Real scale;
+  Uint nb_executions;
+};
+
+void check_solution(const Mesh& mesh, const Real scale)
+{
+  const Dictionary& dict = mesh.geometry_fields();
+  const Field& field = *Handle<Field const>(dict.get_child("solution"));
+  const Field& coords = dict.coordinates();
+  for(Uint i = 0; i != dict.size(); ++i)
+  {
+    BOOST_CHECK_SMALL(field[i][0] - u(coords[i][0], coords[i][1], scale), 1e-10);
+    BOOST_CHECK_SMALL(field[i][1] + u(coords[i][0], coords[i][1], scale), 1e-10);
+  }
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE( MeshSequencingSuite )
+
+//////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( Init )
+{
+  Core::instance().environment().options().set("log_level", 1u);
+}
+
+BOOST_AUTO_TEST_CASE( Prolongate )
+{
+  Domain& domain = *Core::instance().root().create_component<Domain>("domain");
+  Mesh& fine_mesh = *domain.create_component<Mesh>("fine_mesh");
+  Mesh& coarse_mesh = *domain.create_component<Mesh>("coarse_mesh");
+  Tools::MeshGeneration::create_rectangle(fine_mesh, 1., 1., 16, 12);
+  Tools::MeshGeneration::create_rectangle(coarse_mesh, 1., 1., 4, 3);
+  fine_mesh.geometry_fields().create_field("solution", "u[vector]");
+  coarse_mesh.geometry_fields().create_field("solution", "u[vector]");
+
+  MeshSequencing& sequencing = *domain.create_component<MeshSequencing>("sequencing");
+  sequencing.options().set("mesh", fine_mesh.handle<Mesh>());
+  sequencing.options().set("coarse_mesh", coarse_mesh.handle<Mesh>());
+
+  CoarseSolve& coarse_solve = *sequencing.create_component<CoarseSolve>("coarse_solve");
+  coarse_solve.coarse_mesh = coarse_mesh.handle<Mesh>();
+
+  sequencing.execute();
+  BOOST_CHECK_EQUAL(coarse_solve.nb_executions, 1u);
+  check_solution(fine_mesh, 1.);
+
+  // Second run uses the cached stencils
+  coarse_solve.scale = 3.;
+  sequencing.execute();
+  BOOST_CHECK_EQUAL(coarse_solve.nb_executions, 2u);
+  check_solution(fine_mesh, 3.);
+}
+
+BOOST_AUTO_TEST_CASE( MissingField )
+{
+  MeshSequencing& sequencing = *Handle<MeshSequencing>(Core::instance().root().access_component("domain/sequencing"));
+  std::vector<std::string> names(1, "missing");
+  sequencing.options().set("field_names", names);
+  BOOST_CHECK_NO_THROW(sequencing.prolongate());
+
+  Handle<Mesh> fine_mesh(Core::instance().root().access_component("domain/fine_mesh"));
+  fine_mesh->geometry_fields().create_field("missing");
+  BOOST_CHECK_THROW(sequencing.prolongate(), SetupError);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+//////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,173 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for cf3::solver::actions::ProbeSet"
+
+#include <algorithm>
+
+#include <boost/test/unit_test.hpp>
+
+#include "common/Core.hpp"
+#include "common/Environment.hpp"
+#include "common/OptionList.hpp"
+#include "common/Table.hpp"
+
+#include "common/PE/Comm.hpp"
+
+#include "mesh/Dictionary.hpp"
+#include "mesh/Domain.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/PointInterpolator.hpp"
+
+#include "solver/History.hpp"
+#include "solver/actions/ProbeSet.hpp"
+
+#include "Tools/MeshGeneration/MeshGeneration.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+using namespace cf3::mesh;
+using namespace cf3::solver;
+using namespace cf3::solver::actions;
+
+//////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+/// Linear functions, which the interpolation reproduces exactly
+Real u(const Real x, const Real y) { return 2.*x + y; }
+Real v(const Real x, const Real y) { return x - 3.*y; }
+Real p(const Real x, const Real y) { return 1. + x + y; }
+
+const Uint nb_probes = 4;
+const Real probe_coords[] = {0.1, 0.2,  0.55, 0.5,  0.9, 0.95,  0.33, 0.77};
+
+Uint column(const ProbeSet& probes, const std::string& name)
+{
+  const std::vector<std::string>& names = probes.column_names();
+  const Uint idx = std::find(names.begin(), names.end(), name) - names.begin();
+  BOOST_REQUIRE(idx != names.size());
+  return idx;
+}
+
+void check_values(const ProbeSet& probes, const Real x_shift)
+{
+  if(PE::Comm::instance().rank() != 0)
+    return;
+
+  const Table<Real>& values = probes.values();
+  BOOST_REQUIRE_EQUAL(values.size(), nb_probes);
+  BOOST_REQUIRE_EQUAL(values.row_size(), probes.column_names().size());
+  const Uint u_col = column(probes, "u[0]");
+  const Uint v_col = column(probes, "u[1]");
+  const Uint p_col = column(probes, "p");
+  for(Uint i = 0; i != nb_probes; ++i)
+  {
+    const Real x = probe_coords[2*i] - x_shift;
+    const Real y = probe_coords[2*i+1];
+    BOOST_CHECK_SMALL(values[i][u_col] - u(x, y), 1e-10);
+    BOOST_CHECK_SMALL(values[i][v_col] - v(x, y), 1e-10);
+    BOOST_CHECK_SMALL(values[i][p_col] - p(x, y), 1e-10);
+  }
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE( ProbeSetSuite )
+
+//////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( Init )
+{
+  Core::instance().initiate(boost::unit_test::framework::master_test_suite().argc, boost::unit_test::framework::master_test_suite().argv);
+  PE::Comm::instance().init(boost::unit_test::framework::master_test_suite().argc, boost::unit_test::framework::master_test_suite().argv);
+  Core::instance().environment().options().set("log_level", 1u);
+}
+
+BOOST_AUTO_TEST_CASE( Interpolate )
+{
+  Domain& domain = *Core::instance().root().create_component<Domain>("domain");
+  Mesh& mesh = *domain.create_component<Mesh>("mesh");
+  Tools::MeshGeneration::create_rectangle(mesh, 1., 1., 10, 10);
+
+  Dictionary& dict = mesh.geometry_fields();
+  Field& field = dict.create_field("solution", "u[vector],p");
+  const Field& coords = dict.coordinates();
+  for(Uint i = 0; i != dict.size(); ++i)
+  {
+    field[i][0] = u(coords[i][0], coords[i][1]);
+    field[i][1] = v(coords[i][0], coords[i][1]);
+    field[i][2] = p(coords[i][0], coords[i][1]);
+  }
+
+  ProbeSet& probes = *domain.create_component<ProbeSet>("probes");
+  probes.get_child("point_interpolator")->options().set("function", std::string("cf3.mesh.ShapeFunctionInterpolation"));
+  probes.options().set("coordinates", std::vector<Real>(probe_coords, probe_coords + 2*nb_probes));
+  probes.options().set("dict", dict.handle<Dictionary>());
+
+  History& history = *domain.create_component<History>("history");
+  history.options().set("dimension", 2u);
+  history.options().set("logging", false);
+  probes.options().set("history", history.handle<History>());
+
+  BOOST_CHECK_EQUAL(probes.nb_probes(), nb_probes);
+
+  probes.execute();
+  check_values(probes, 0.);
+
+  // The coordinates field is part of the geometry dictionary
+  BOOST_CHECK_EQUAL(probes.column_names().size(), 5u);
+  if(PE::Comm::instance().rank() == 0)
+  {
+    BOOST_CHECK_EQUAL(history.table()->size(), 1u);
+    BOOST_CHECK_EQUAL(history.table()->row_size(), 5u*nb_probes);
+  }
+
+  // Values change, locations are cached
+  for(Uint i = 0; i != dict.size(); ++i)
+    field[i][2] *= 2.;
+  probes.execute();
+  if(PE::Comm::instance().rank() == 0)
+    BOOST_CHECK_SMALL(probes.values()[1][column(probes, "p")] - 2.*p(0.55, 0.5), 1e-10);
+  for(Uint i = 0; i != dict.size(); ++i)
+    field[i][2] = p(coords[i][0], coords[i][1]);
+
+  // Move the mesh: the nodal values now belong to shifted coordinates, which is only seen after invalidating the cache
+  Field& moved_coords = dict.coordinates();
+  for(Uint i = 0; i != dict.size(); ++i)
+    moved_coords[i][0] -= 0.05;
+  probes.execute();
+  check_values(probes, 0.);
+
+  probes.invalidate();
+  probes.execute();
+  check_values(probes, -0.05);
+}
+
+BOOST_AUTO_TEST_CASE( OutsideDomain )
+{
+  ProbeSet& probes = *Handle<ProbeSet>(Core::instance().root().access_component("domain/probes"));
+  std::vector<Real> coordinates(probe_coords, probe_coords + 2*nb_probes);
+  coordinates.push_back(2.);
+  coordinates.push_back(0.5);
+  probes.options().set("coordinates", coordinates);
+  BOOST_CHECK_THROW(probes.execute(), SetupError);
+}
+
+BOOST_AUTO_TEST_CASE( Finalize )
+{
+  PE::Comm::instance().finalize();
+  Core::instance().terminate();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+//////////////////////////////////////////////////////////////////////////////
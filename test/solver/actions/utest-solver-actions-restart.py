@@ -101,4 +101,48 @@ if not differ.properties()['arrays_equal']:
   raise Exception('Element GIDS do not match')
 
 if time.current_time != 2. or time.time_step != 0.2 or time.iteration != 10:
-  raise Exception('Error in time data')
\ No newline at end of file
+  raise Exception('Error in time data')
+
+# Read the same file into a mesh that is partitioned in the other direction, matching the rows by their keys
+blocks2 = root.create_component('model2', 'cf3.mesh.BlockMesh.BlockArrays')
+points = blocks2.create_points(dimensions = 2, nb_points = 4)
+points[0]  = [0., 0.]
+points[1]  = [1., 0.]
+points[2]  = [1., 1.]
+points[3]  = [0., 1.]
+block_nodes = blocks2.create_blocks(1)
+block_nodes[0] = [0, 1, 2, 3]
+block_subdivs = blocks2.create_block_subdivisions()
+block_subdivs[0] = [16,16]
+gradings = blocks2.create_block_gradings()
+gradings[0] = [1., 1., 1., 1.]
+blocks2.create_patch_nb_faces(name = 'bottom', nb_faces = 1)[0] = [0, 1]
+blocks2.create_patch_nb_faces(name = 'right', nb_faces = 1)[0] = [1, 2]
+blocks2.create_patch_nb_faces(name = 'top', nb_faces = 1)[0] = [2, 3]
+blocks2.create_patch_nb_faces(name = 'left', nb_faces = 1)[0] = [3, 0]
+blocks2.partition_blocks(nb_partitions = cf.Core.nb_procs(), direction = 0)
+repartitioned_mesh = domain.create_component('RepartitionedMesh','cf3.mesh.Mesh')
+blocks2.create_mesh(repartitioned_mesh.uri())
+
+make_par_data.mesh = repartitioned_mesh
+make_par_data.execute()
+
+# The stored values are the global indices, so they must match the global indices of the new partitioning
+ref_node_gids = copy_and_reset(repartitioned_mesh.geometry.node_gids, domain)
+ref_element_gids = copy_and_reset(repartitioned_mesh.elems_P0.element_gids, domain)
+
+reader.mesh = repartitioned_mesh
+reader.redistribute = True
+reader.execute()
+
+differ.left = ref_node_gids
+differ.right = repartitioned_mesh.geometry.node_gids
+differ.execute()
+if not differ.properties()['arrays_equal']:
+  raise Exception('Redistributed node GIDS do not match')
+
+differ.left = ref_element_gids
+differ.right = repartitioned_mesh.elems_P0.element_gids
+differ.execute()
+if not differ.properties()['arrays_equal']:
+  raise Exception('Redistributed element GIDS do not match')
@@ -66,6 +66,9 @@ dir_avg.field = mesh.geometry.turbulence_statistics
 dir_avg.file = cf.URI('turbulence-statistics-profile.txt')
 
 for i in range(1000):
+  # Triple correlations enabled halfway average over their own samples
+  if i == 500:
+    stats.triple_correlations = True
   init_field.execute()
   randomizer.options.seed = i
   randomizer.execute()
@@ -74,6 +77,29 @@ for i in range(1000):
 
 dir_avg.execute()
 
+if stats.count != 1000 or stats.triple_correlations_count != 500:
+  raise Exception('Expected 1000 samples and 500 triple correlation samples, got {c} and {t}'.format(c=stats.count, t=stats.triple_correlations_count))
+
+# The incremental means must match the plain time average, and the triple correlations must be consistent
+stats_field = mesh.geometry.turbulence_statistics
+triples = mesh.geometry.turbulence_triple_correlations
+average = mesh.geometry.average_velocity
+for i in range(len(stats_field)):
+  for d in range(2):
+    if abs(stats_field[i][d] - average[i][d]) > 1e-8*max(1., abs(average[i][d])):
+      raise Exception('Mean {d} of node {i} is {m}, time average is {a}'.format(d=d, i=i, m=stats_field[i][d], a=average[i][d]))
+  # uuu >= 0 is not guaranteed, but <uuu> is bounded by max|u| * <uu>
+  if abs(triples[i][0]) > Uc*1.3*stats_field[i][2] + 1e-12:
+    raise Exception('Triple correlation uuu of node {i} out of bounds'.format(i=i))
+
+# Sub-sampling: with an interval of 2, half of the executions are counted
+stats.count = 0
+stats.sample_interval = 2
+for i in range(10):
+  stats.execute()
+if stats.count != 5:
+  raise Exception('Expected 5 samples, got {c}'.format(c=stats.count))
+
 writer = domain.create_component('PVWriter', 'cf3.mesh.VTKXML.Writer')
 writer.fields = [velocity.uri(), mesh.geometry.coordinates.uri(), mesh.geometry.turbulence_statistics.uri(), mesh.geometry.average_velocity.uri()]
 writer.mesh = mesh
@@ -39,6 +39,7 @@ corr.field = coords
 corr.coordinate = 1.75
 corr.file = cf.URI('two-point-correlation01-{iteration}.txt')
 corr.interval = 5
+corr.spectrum_file = cf.URI('two-point-spectrum01-{iteration}.txt')
 
 corr2 = domain.create_component('TwoPointCorrelation', 'cf3.solver.actions.TwoPointCorrelation')
 corr2.normal = 1
@@ -0,0 +1,139 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for cf3::solver::ActionDirector"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <algorithm>
+
+#include <boost/test/unit_test.hpp>
+
+#include "common/BasicExceptions.hpp"
+#include "common/Core.hpp"
+#include "common/Environment.hpp"
+#include "common/OptionList.hpp"
+
+#include "solver/Action.hpp"
+#include "solver/ActionDirector.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+using namespace cf3::solver;
+
+//////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+/// Order in which the actions started and finished
+std::vector<std::string> events;
+
+void log_event(const std::string& event)
+{
+  #pragma omp critical(utest_solver_action_director)
+  events.push_back(event);
+}
+
+Uint position(const std::string& event)
+{
+  const Uint pos = std::find(events.begin(), events.end(), event) - events.begin();
+  BOOST_REQUIRE(pos != events.size());
+  return pos;
+}
+
+/// Action that logs when it starts and finishes
+struct LoggingAction : solver::Action
+{
+  LoggingAction(const std::string& name) : solver::Action(name), fail(false), fail_unknown(false) {}
+  static std::string type_name () { return "LoggingAction"; }
+  virtual void execute()
+  {
+    log_event(name() + "_begin");
+    Real sum = 0.;
+    for(Uint i = 0; i != 100000; ++i)
+      sum += 1./static_cast<Real>(i+1);
+    if(fail)
+      throw BadValue(FromHere(), "Failing on purpose");
+    if(fail_unknown)
+      throw 42;
+    log_event(name() + "_end");
+  }
+
+  void declare(const std::string& read, const std::string& written, const bool thread_safe = true)
+  {
+    options().set("read_fields", std::vector<std::string>(1, read));
+    options().set("written_fields", std::vector<std::string>(1, written));
+    options().set("thread_safe", thread_safe);
+  }
+
+  bool fail;
+  bool fail_unknown;
+};
+
+}
+
+BOOST_AUTO_TEST_SUITE( ActionDirectorSuite )
+
+//////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( ConcurrentActions )
+{
+  Handle<solver::ActionDirector> director = Core::instance().root().create_component<solver::ActionDirector>("director");
+  director->options().set("concurrent_actions", true);
+
+  // a and b are independent, c needs the result of a, d declares nothing, e is independent of all others
+  // and f is not thread safe
+  director->create_component<LoggingAction>("a")->declare("mesh", "u");
+  director->create_component<LoggingAction>("b")->declare("mesh", "T");
+  director->create_component<LoggingAction>("c")->declare("u", "p");
+  director->create_component<LoggingAction>("d");
+  director->create_component<LoggingAction>("e")->declare("mesh", "k");
+  director->create_component<LoggingAction>("f")->declare("mesh", "w", false);
+
+  // The first execution runs the actions one after the other
+  director->execute();
+  BOOST_CHECK_EQUAL(events.size(), 12u);
+  for(Uint i = 0; i != events.size(); i += 2)
+    BOOST_CHECK_EQUAL(events[i].substr(0, 2), events[i+1].substr(0, 2));
+
+  events.clear();
+  director->execute();
+
+  BOOST_CHECK_EQUAL(events.size(), 12u);
+  BOOST_CHECK(position("a_end") < position("c_begin"));
+  BOOST_CHECK(position("c_end") < position("d_begin"));
+  BOOST_CHECK(position("b_end") < position("d_begin"));
+  BOOST_CHECK(position("d_end") < position("e_begin"));
+  BOOST_CHECK(position("e_end") < position("f_begin"));
+}
+
+BOOST_AUTO_TEST_CASE( ConcurrentFailure )
+{
+  Handle<solver::ActionDirector> director(Core::instance().root().get_child("director"));
+  Handle<LoggingAction>(director->get_child("b"))->fail = true;
+  Core::instance().environment().options().set("exception_outputs", false);
+  BOOST_CHECK_THROW(director->execute(), Exception);
+
+#ifdef _OPENMP
+  // Exceptions that are not derived from std::exception are reported as well, when the actions run concurrently
+  if(omp_get_max_threads() > 1)
+  {
+    Handle<LoggingAction>(director->get_child("b"))->fail = false;
+    Handle<LoggingAction>(director->get_child("a"))->fail_unknown = true;
+    BOOST_CHECK_THROW(director->execute(), Exception);
+  }
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
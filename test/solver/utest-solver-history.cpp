@@ -0,0 +1,159 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for cf3::solver::History"
+
+#include <boost/test/unit_test.hpp>
+
+#include "common/BoostFilesystem.hpp"
+#include "common/Core.hpp"
+#include "common/OptionList.hpp"
+#include "common/Table.hpp"
+
+#include "solver/History.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+using namespace cf3::solver;
+
+//////////////////////////////////////////////////////////////////////////////
+
+/// Save 10 entries, adding the variable "b" at entry 5
+void fill_history(History& history)
+{
+  for(Uint i = 0; i != 10; ++i)
+  {
+    history.set("a", static_cast<Real>(i));
+    if(i >= 5)
+      history.set("b", 2.*i);
+    history.save_entry();
+  }
+}
+
+/// Read the file in a fresh history and check the contents
+void check_read(const URI& file)
+{
+  boost::shared_ptr<History> history = allocate_component<History>("read_history");
+  history->options().set("dimension", 1u);
+  history->options().set("logging", false);
+
+  boost::filesystem::fstream stream;
+  stream.open(boost::filesystem::path(file.path()), std::ios_base::in | std::ios_base::binary);
+  BOOST_REQUIRE(stream);
+  history->read_file(stream);
+
+  const Table<Real>& table = *history->table();
+  BOOST_REQUIRE_EQUAL(table.size(), 10u);
+  BOOST_REQUIRE_EQUAL(table.row_size(), 2u);
+  for(Uint i = 0; i != 10; ++i)
+  {
+    BOOST_CHECK_EQUAL(table[i][0], static_cast<Real>(i));
+    BOOST_CHECK_EQUAL(table[i][1], i >= 5 ? 2.*i : 0.);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE( HistorySuite )
+
+//////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( TsvLog )
+{
+  const URI file("history-test.tsv");
+  {
+    boost::shared_ptr<History> history = allocate_component<History>("history");
+    history->options().set("dimension", 1u);
+    history->options().set("file", file);
+    fill_history(*history);
+    BOOST_CHECK_EQUAL(history->table()->size(), 10u);
+  }
+  check_read(file);
+}
+
+BOOST_AUTO_TEST_CASE( BinaryBackgroundLog )
+{
+  const URI file("history-test.bin");
+  boost::shared_ptr<History> history = allocate_component<History>("history");
+  history->options().set("dimension", 1u);
+  history->options().set("file", file);
+  history->options().set("format", std::string("binary"));
+  history->options().set("flush_interval", 3u);
+  fill_history(*history);
+
+  // flush waits for the background writer, so the file is complete while the history is still logging
+  history->flush();
+  check_read(file);
+}
+
+BOOST_AUTO_TEST_CASE( RestartLog )
+{
+  const URI file("history-restart.tsv");
+  {
+    boost::shared_ptr<History> history = allocate_component<History>("history");
+    history->options().set("dimension", 1u);
+    history->options().set("file", file);
+    for(Uint i = 0; i != 5; ++i)
+    {
+      history->set("a", static_cast<Real>(i));
+      history->save_entry();
+    }
+  }
+
+  // Continue from the file: the first new entry reopens it, which must keep the entries that were read
+  boost::shared_ptr<History> history = allocate_component<History>("history");
+  history->options().set("dimension", 1u);
+  history->options().set("file", file);
+  {
+    boost::filesystem::fstream stream;
+    stream.open(boost::filesystem::path(file.path()), std::ios_base::in | std::ios_base::binary);
+    BOOST_REQUIRE(stream);
+    history->read_file(stream);
+  }
+  for(Uint i = 5; i != 10; ++i)
+  {
+    history->set("a", static_cast<Real>(i));
+    history->set("b", 2.*i);
+    history->save_entry();
+  }
+  history->flush();
+  check_read(file);
+}
+
+BOOST_AUTO_TEST_CASE( BoundedMemory )
+{
+  boost::shared_ptr<History> history = allocate_component<History>("history");
+  history->options().set("dimension", 1u);
+  history->options().set("logging", false);
+  history->options().set("max_rows", 4u);
+
+  for(Uint i = 0; i != 100; ++i)
+  {
+    history->set("a", static_cast<Real>(i));
+    history->save_entry();
+  }
+
+  // The window contains the most recent entries
+  const Table<Real>& table = *history->table();
+  BOOST_CHECK(table.size() >= 4u && table.size() < 8u);
+  BOOST_CHECK_EQUAL(table[table.size()-1][0], 99.);
+  for(Uint i = 1; i < table.size(); ++i)
+    BOOST_CHECK_EQUAL(table[i][0], table[i-1][0] + 1.);
+
+  // The summary covers the whole history, at a regular stride
+  const Table<Real>& summary = *history->summary();
+  BOOST_CHECK(summary.size() >= 4u && summary.size() < 8u);
+  BOOST_CHECK_EQUAL(summary[0][0], 0.);
+  const Real stride = summary[1][0];
+  BOOST_CHECK(stride >= 16.);
+  for(Uint i = 1; i < summary.size(); ++i)
+    BOOST_CHECK_EQUAL(summary[i][0], summary[i-1][0] + stride);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+//////////////////////////////////////////////////////////////////////////////
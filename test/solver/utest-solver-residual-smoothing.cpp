@@ -0,0 +1,83 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for cf3::solver::ResidualSmoothing"
+
+#include <cmath>
+
+#include <boost/test/unit_test.hpp>
+
+#include "common/Core.hpp"
+#include "common/OptionList.hpp"
+
+#include "mesh/Dictionary.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/MeshGenerator.hpp"
+
+#include "solver/ResidualSmoothing.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+using namespace cf3::mesh;
+using namespace cf3::solver;
+
+//////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE( ResidualSmoothingSuite )
+
+//////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( Smoothing )
+{
+  boost::shared_ptr< MeshGenerator > mesh_generator = build_component_abstract_type<MeshGenerator>("cf3.mesh.SimpleMeshGenerator","mesh_generator");
+  Core::instance().root().add_component(mesh_generator);
+  mesh_generator->options().set("mesh",Core::instance().root().uri()/"mesh");
+  mesh_generator->options().set("lengths",std::vector<Real>(2,1.));
+  mesh_generator->options().set("nb_cells",std::vector<Uint>(2,10));
+  Mesh& mesh = mesh_generator->generate();
+
+  Dictionary& dict = mesh.geometry_fields();
+  Field& rhs = dict.create_field("rhs", 2u);
+  const Field& coords = dict.coordinates();
+
+  // First variable constant, second variable oscillating from point to point
+  Real max_oscillation = 0.;
+  for(Uint i = 0; i != dict.size(); ++i)
+  {
+    rhs[i][0] = 3.;
+    rhs[i][1] = std::cos(10.*M_PI*coords[i][0]) * std::cos(10.*M_PI*coords[i][1]);
+    max_oscillation = std::max(max_oscillation, std::abs(rhs[i][1]));
+  }
+  BOOST_CHECK_CLOSE(max_oscillation, 1., 1e-10);
+
+  ResidualSmoothing& smoothing = *Core::instance().root().create_component<ResidualSmoothing>("smoothing");
+  smoothing.options().set("rhs", rhs.handle<Field>());
+  smoothing.options().set("coefficient", 1.);
+  smoothing.options().set("nb_iterations", 3u);
+  smoothing.execute();
+
+  Real smoothed_oscillation = 0.;
+  for(Uint i = 0; i != dict.size(); ++i)
+  {
+    BOOST_CHECK_CLOSE(rhs[i][0], 3., 1e-10);
+    smoothed_oscillation = std::max(smoothed_oscillation, std::abs(rhs[i][1]));
+  }
+  BOOST_CHECK_LT(smoothed_oscillation, 0.5);
+
+  // No smoothing
+  rhs[0][1] = 1.;
+  smoothing.options().set("coefficient", 0.);
+  smoothing.execute();
+  BOOST_CHECK_EQUAL(rhs[0][1], 1.);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+//////////////////////////////////////////////////////////////////////////////